@@ -64,6 +64,13 @@ class NotificationRequest {
   final List<NotificationAction>? actions;
   final NotificationPayload? payload;
   final String? category;
+
+  /// Notifications sharing a group, e.g. one conversation, can be listed
+  /// together with [NotificationManager.getActiveNotifications] and
+  /// cancelled with [NotificationManager.cancelNotificationsByGroup]
+  /// (Linux). Scheduled notifications keep their group once they fire.
+  final String? group;
+
   final int? badgeNumber;
   final Duration? timeout;
   final String? duplicateKey; // For duplicate prevention
@@ -76,6 +83,7 @@ class NotificationRequest {
     this.actions,
     this.payload,
     this.category,
+    this.group,
     this.badgeNumber,
     this.timeout,
     this.duplicateKey,
@@ -89,6 +97,7 @@ class NotificationRequest {
         'actions': actions?.map((a) => a.toJson()).toList(),
         'payload': payload?.toJson(),
         'category': category,
+        'group': group,
         'badgeNumber': badgeNumber,
         'timeout': timeout?.inSeconds,
         'duplicateKey': duplicateKey,
@@ -107,6 +116,7 @@ class NotificationRequest {
           ? NotificationPayload.fromJson(json['payload'] as Map<String, dynamic>)
           : null,
       category: json['category'] as String?,
+      group: json['group'] as String?,
       badgeNumber: json['badgeNumber'] as int?,
       timeout: json['timeout'] != null 
           ? Duration(seconds: json['timeout'] as int)
@@ -127,12 +137,19 @@ class ScheduledNotification {
   final bool isRepeating;
   final Duration? repeatInterval;
 
+  /// Cron-style rule ("minute hour day-of-month month weekday", e.g.
+  /// `'0 9 * * MON-FRI'`) evaluated in local time. When set it takes over
+  /// from [repeatInterval], and the first occurrence at or after
+  /// [scheduledDate] is the first fire time.
+  final String? recurrence;
+
   const ScheduledNotification({
     required this.id,
     required this.request,
     required this.scheduledDate,
     this.isRepeating = false,
     this.repeatInterval,
+    this.recurrence,
   });
 
   Map<String, dynamic> toJson() => {
@@ -141,6 +158,7 @@ class ScheduledNotification {
         'scheduledDate': scheduledDate.millisecondsSinceEpoch,
         'isRepeating': isRepeating,
         'repeatInterval': repeatInterval?.inSeconds,
+        if (recurrence != null) 'recurrence': recurrence,
       };
 
   factory ScheduledNotification.fromJson(Map<String, dynamic> json) {
@@ -163,10 +181,292 @@ class ScheduledNotification {
       repeatInterval: json['repeatInterval'] != null 
           ? Duration(seconds: json['repeatInterval'] as int)
           : null,
+      recurrence: json['recurrence'] as String?,
+    );
+  }
+}
+
+/// One page of scheduled notifications in fire-time order
+class ScheduledNotificationPage {
+  final List<ScheduledNotification> notifications;
+
+  /// Pass to the next query to continue after this page; null on the last page.
+  final String? nextCursor;
+
+  const ScheduledNotificationPage({
+    required this.notifications,
+    this.nextCursor,
+  });
+
+  factory ScheduledNotificationPage.fromJson(Map<dynamic, dynamic> json) {
+    final list = json['notifications'] as List<dynamic>? ?? const [];
+    return ScheduledNotificationPage(
+      notifications: list
+          .map((n) => ScheduledNotification.fromJson(Map<String, dynamic>.from(n as Map)))
+          .toList(),
+      nextCursor: json['nextCursor'] as String?,
+    );
+  }
+}
+
+/// Scheduled notifications changed since a given version
+class ScheduledNotificationChanges {
+  /// Pass to the next [NotificationManager.getScheduledChanges] call.
+  final int version;
+
+  /// True when the requested version was too old to diff against; [inserted]
+  /// then holds every scheduled notification and the old copy should be dropped.
+  final bool isFullSnapshot;
+  final List<ScheduledNotification> inserted;
+  final List<ScheduledNotification> updated;
+  final List<String> removed;
+
+  const ScheduledNotificationChanges({
+    required this.version,
+    this.isFullSnapshot = false,
+    this.inserted = const [],
+    this.updated = const [],
+    this.removed = const [],
+  });
+
+  factory ScheduledNotificationChanges.fromJson(Map<dynamic, dynamic> json) {
+    List<ScheduledNotification> notifications(Object? list) => (list as List<dynamic>? ?? const [])
+        .map((n) => ScheduledNotification.fromJson(Map<String, dynamic>.from(n as Map)))
+        .toList();
+
+    return ScheduledNotificationChanges(
+      version: json['version'] as int? ?? 0,
+      isFullSnapshot: json['isFullSnapshot'] as bool? ?? true,
+      inserted: notifications(json['inserted']),
+      updated: notifications(json['updated']),
+      removed: (json['removed'] as List<dynamic>? ?? const []).cast<String>(),
+    );
+  }
+}
+
+/// The stored schedule was changed by another process and reloaded
+class ScheduledNotificationsReloaded {
+  /// The new version, to pass to [NotificationManager.getScheduledChanges].
+  final int version;
+
+  /// Ids scheduled or updated by the other process.
+  final List<String> scheduled;
+
+  /// Ids the other process cancelled.
+  final List<String> cancelled;
+
+  const ScheduledNotificationsReloaded({
+    required this.version,
+    this.scheduled = const [],
+    this.cancelled = const [],
+  });
+
+  factory ScheduledNotificationsReloaded.fromJson(Map<dynamic, dynamic> json) {
+    return ScheduledNotificationsReloaded(
+      version: json['version'] as int? ?? 0,
+      scheduled: (json['scheduled'] as List<dynamic>? ?? const []).cast<String>(),
+      cancelled: (json['cancelled'] as List<dynamic>? ?? const []).cast<String>(),
+    );
+  }
+}
+
+/// Progress of an export or import of the scheduled notifications
+class ScheduledTransferProgress {
+  /// The id returned by the call that started the transfer.
+  final int transferId;
+
+  /// Either `export` or `import`.
+  final String direction;
+
+  /// Entries written or scheduled so far.
+  final int processed;
+
+  /// Lines an import could not read as a scheduled notification.
+  final int skipped;
+
+  /// Entries an export will write, or null for an import.
+  final int? total;
+
+  /// Whether this is the last event for the transfer.
+  final bool done;
+
+  /// Why the transfer failed, if it did.
+  final String? error;
+
+  const ScheduledTransferProgress({
+    required this.transferId,
+    required this.direction,
+    this.processed = 0,
+    this.skipped = 0,
+    this.total,
+    this.done = false,
+    this.error,
+  });
+
+  factory ScheduledTransferProgress.fromJson(Map<dynamic, dynamic> json) {
+    return ScheduledTransferProgress(
+      transferId: json['transferId'] as int,
+      direction: json['direction'] as String? ?? '',
+      processed: json['processed'] as int? ?? 0,
+      skipped: json['skipped'] as int? ?? 0,
+      total: json['total'] as int?,
+      done: json['done'] as bool? ?? false,
+      error: json['error'] as String?,
+    );
+  }
+}
+
+/// A notification currently on screen
+class ActiveNotification {
+  final String id;
+  final String title;
+  final String? category;
+  final String? group;
+
+  /// When it was first shown; updating it in place does not change this.
+  final DateTime createdAt;
+
+  /// When it was last shown or updated.
+  final DateTime updatedAt;
+
+  const ActiveNotification({
+    required this.id,
+    required this.title,
+    this.category,
+    this.group,
+    required this.createdAt,
+    required this.updatedAt,
+  });
+
+  factory ActiveNotification.fromJson(Map<dynamic, dynamic> json) {
+    return ActiveNotification(
+      id: json['id'] as String,
+      title: json['title'] as String? ?? '',
+      category: json['category'] as String?,
+      group: json['group'] as String?,
+      createdAt: DateTime.fromMillisecondsSinceEpoch(json['createdAt'] as int),
+      updatedAt: DateTime.fromMillisecondsSinceEpoch(json['updatedAt'] as int),
+    );
+  }
+}
+
+/// One page of notifications on screen, oldest first
+class ActiveNotificationPage {
+  final List<ActiveNotification> notifications;
+
+  /// Pass to the next query to continue after this page; null on the last page.
+  final String? nextCursor;
+
+  const ActiveNotificationPage({
+    required this.notifications,
+    this.nextCursor,
+  });
+
+  factory ActiveNotificationPage.fromJson(Map<dynamic, dynamic> json) {
+    final list = json['notifications'] as List<dynamic>? ?? const [];
+    return ActiveNotificationPage(
+      notifications: list.map((n) => ActiveNotification.fromJson(n as Map)).toList(),
+      nextCursor: json['nextCursor'] as String?,
     );
   }
 }
 
+/// What happened to a notification in its history
+enum NotificationHistoryType {
+  /// It was shown, or updated in place.
+  shown,
+
+  /// The user picked one of its actions.
+  action,
+
+  /// It was closed, by the user, the app or the notification server.
+  closed,
+}
+
+/// One thing that happened to a notification
+class NotificationHistoryEntry {
+  final String notificationId;
+  final NotificationHistoryType type;
+  final DateTime timestamp;
+
+  /// The title it was shown with, for [NotificationHistoryType.shown].
+  final String? title;
+
+  /// The action picked, for [NotificationHistoryType.action].
+  final String? actionId;
+
+  const NotificationHistoryEntry({
+    required this.notificationId,
+    required this.type,
+    required this.timestamp,
+    this.title,
+    this.actionId,
+  });
+
+  factory NotificationHistoryEntry.fromJson(Map<dynamic, dynamic> json) {
+    return NotificationHistoryEntry(
+      notificationId: json['notificationId'] as String,
+      type: NotificationHistoryType.values.firstWhere(
+        (type) => type.name == json['type'],
+        orElse: () => NotificationHistoryType.shown,
+      ),
+      timestamp: DateTime.fromMillisecondsSinceEpoch(json['timestamp'] as int),
+      title: json['title'] as String?,
+      actionId: json['actionId'] as String?,
+    );
+  }
+}
+
+/// One page of notification history, oldest first
+class NotificationHistoryPage {
+  final List<NotificationHistoryEntry> entries;
+
+  /// Pass to the next query to continue after this page; null on the last page.
+  final String? nextCursor;
+
+  const NotificationHistoryPage({
+    required this.entries,
+    this.nextCursor,
+  });
+
+  factory NotificationHistoryPage.fromJson(Map<dynamic, dynamic> json) {
+    final list = json['entries'] as List<dynamic>? ?? const [];
+    return NotificationHistoryPage(
+      entries: list.map((e) => NotificationHistoryEntry.fromJson(e as Map)).toList(),
+      nextCursor: json['nextCursor'] as String?,
+    );
+  }
+}
+
+/// What to show for scheduled notifications that fell due while the device slept
+enum CatchUpPolicy {
+  /// Show every missed notification.
+  fireAll,
+
+  /// Show only the latest missed notification of each repeating notification
+  /// or category.
+  latestPerSeries,
+
+  /// Show one notification listing what was missed, or the missed
+  /// notification itself if there was only one.
+  summary,
+}
+
+/// How durable a change to stored data, such as scheduling, cancelling or
+/// duplicate tracking, must be before the call that made it completes
+enum PersistenceMode {
+  /// Complete as soon as the change is made. The write follows shortly, and
+  /// may be lost if the device loses power before it reaches the disk.
+  none,
+
+  /// Complete once the change is on disk. Changes made within a few
+  /// milliseconds of each other share one disk sync.
+  batched,
+
+  /// Complete once the change is on disk, syncing straight away.
+  immediate,
+}
+
 /// Represents a notification action event
 class NotificationActionEvent {
   final String notificationId;
@@ -237,6 +537,8 @@ class NotificationManager {
     required DateTime scheduledDate,
     bool isRepeating = false,
     Duration? repeatInterval,
+    String? recurrence,
+    PersistenceMode? persistenceMode,
   }) async {
     final scheduledNotification = ScheduledNotification(
       id: request.id,
@@ -244,8 +546,12 @@ class NotificationManager {
       scheduledDate: scheduledDate,
       isRepeating: isRepeating,
       repeatInterval: repeatInterval,
+      recurrence: recurrence,
+    );
+    return await _platform.scheduleNotification(
+      scheduledNotification,
+      persistenceMode: persistenceMode?.name,
     );
-    return await _platform.scheduleNotification(scheduledNotification);
   }
 
   /// Cancel a specific notification
@@ -258,11 +564,49 @@ class NotificationManager {
     return await _platform.cancelAllNotifications();
   }
 
+  /// Cancel every notification on screen in [category], closing them in one
+  /// batch. Returns how many were cancelled (Linux).
+  Future<int> cancelNotificationsByCategory(String category) async {
+    return await _platform.cancelNotificationsByCategory(category);
+  }
+
+  /// Cancel every notification on screen in [group], e.g. a conversation
+  /// the user has just read, closing them in one batch. Returns how many
+  /// were cancelled (Linux).
+  Future<int> cancelNotificationsByGroup(String group) async {
+    return await _platform.cancelNotificationsByGroup(group);
+  }
+
+  /// Cancel every notification on screen whose id starts with [prefix],
+  /// closing them in one batch. Returns how many were cancelled (Linux).
+  Future<int> cancelNotificationsWithPrefix(String prefix) async {
+    return await _platform.cancelNotificationsWithPrefix(prefix);
+  }
+
   /// Cancel all scheduled notifications
   Future<bool> cancelAllScheduledNotifications() async {
     return await _platform.cancelAllScheduledNotifications();
   }
 
+  /// Get up to [limit] of the notifications this app has on screen, oldest
+  /// first, only those in [category] and [group] when given. Pass
+  /// [ActiveNotificationPage.nextCursor] as [cursor] for the next page (Linux).
+  Future<ActiveNotificationPage> getActiveNotifications({
+    String? category,
+    String? group,
+    int limit = 20,
+    String? cursor,
+  }) async {
+    final page = await _platform.getActiveNotifications(
+      category: category,
+      group: group,
+      limit: limit,
+      cursor: cursor,
+    );
+    return ActiveNotificationPage.fromJson(page);
+  }
+
+
   /// Get all scheduled notifications
   Future<List<ScheduledNotification>> getScheduledNotifications() async {
     final dynamic notifications = await _platform.getScheduledNotifications();
@@ -280,6 +624,97 @@ class NotificationManager {
     }).toList();
   }
 
+  /// Get up to [limit] scheduled notifications that fire next, earliest first.
+  /// Pass [ScheduledNotificationPage.nextCursor] as [cursor] for the next page.
+  Future<ScheduledNotificationPage> getNextScheduledNotifications({int limit = 20, String? cursor}) async {
+    final page = await _platform.getNextScheduledNotifications(limit: limit, cursor: cursor);
+    return ScheduledNotificationPage.fromJson(page);
+  }
+
+  /// Get scheduled notifications firing from [start] up to, but not including, [end]
+  Future<ScheduledNotificationPage> getScheduledNotificationsInRange(
+    DateTime start,
+    DateTime end, {
+    int limit = 20,
+    String? cursor,
+  }) async {
+    final page = await _platform.getScheduledNotificationsInRange(start, end, limit: limit, cursor: cursor);
+    return ScheduledNotificationPage.fromJson(page);
+  }
+
+  /// Get what changed in the scheduled notifications since [sinceVersion].
+  /// Start with 0 to get everything, then pass the returned version back.
+  Future<ScheduledNotificationChanges> getScheduledChanges(int sinceVersion) async {
+    final changes = await _platform.getScheduledChanges(sinceVersion);
+    return ScheduledNotificationChanges.fromJson(changes);
+  }
+
+  /// Get what was shown, acted on and closed from [start] up to, but not
+  /// including, [end], oldest first. Kept across restarts until
+  /// `clearNotificationHistory` or until the oldest entries make room for
+  /// new ones (Linux).
+  Future<NotificationHistoryPage> getNotificationHistory(
+    DateTime start,
+    DateTime end, {
+    int limit = 20,
+    String? cursor,
+  }) async {
+    final page = await _platform.getNotificationHistory(start, end, limit: limit, cursor: cursor);
+    return NotificationHistoryPage.fromJson(page);
+  }
+
+  /// Back up every scheduled notification to [path], one
+  /// [ScheduledNotification.toJson] object per line. The file is written a
+  /// chunk of [chunkSize] entries at a time and replaced only once complete.
+  /// Returns the id of the export, or null if it could not start (Linux).
+  /// Progress is reported on [onScheduledTransfer].
+  Future<int?> exportScheduledNotifications(String path, {int chunkSize = 500}) async {
+    return await _platform.exportScheduledNotifications(path, chunkSize: chunkSize);
+  }
+
+  /// Schedule every notification in a file written by
+  /// [exportScheduledNotifications], [chunkSize] lines at a time. Lines that
+  /// are not valid scheduled notifications are skipped. Returns the id of the
+  /// import, or null if it could not start (Linux). Progress is reported on
+  /// [onScheduledTransfer].
+  Future<int?> importScheduledNotifications(String path, {int chunkSize = 500}) async {
+    return await _platform.importScheduledNotifications(path, chunkSize: chunkSize);
+  }
+
+  /// Progress of every export and import, ending with a [ScheduledTransferProgress.done]
+  /// event per transfer (Linux).
+  Stream<ScheduledTransferProgress> get onScheduledTransfer =>
+      _platform.scheduledTransferEvents.map(ScheduledTransferProgress.fromJson);
+
+  /// The new version each time the scheduled notifications change; fetch what
+  /// changed with [getScheduledChanges] (Linux).
+  Stream<int> get onScheduledChanged =>
+      _platform.scheduledChangedEvents.map((event) => event['version'] as int? ?? 0);
+
+  /// Changes another process made to the stored schedule, once they have been
+  /// loaded here (Linux).
+  Stream<ScheduledNotificationsReloaded> get onScheduledReloaded =>
+      _platform.scheduledReloadedEvents.map(ScheduledNotificationsReloaded.fromJson);
+
+  /// Allow scheduled notifications to fire up to [slack] late so that ones due
+  /// close together are delivered in a single wakeup. Defaults to one second.
+  Future<bool> setSchedulerSlack(Duration slack) async {
+    return await _platform.setSchedulerSlack(slack);
+  }
+
+  /// Choose what to show for scheduled notifications missed while the device
+  /// slept. Missed notifications are delivered a few at a time.
+  Future<bool> setCatchUpPolicy(CatchUpPolicy policy) async {
+    return await _platform.setCatchUpPolicy(policy.name);
+  }
+
+  /// Choose whether calls that change stored data wait for the disk write.
+  /// Defaults to [PersistenceMode.batched]. Some calls, such as
+  /// [scheduleNotification], can also choose for themselves.
+  Future<bool> setPersistenceMode(PersistenceMode mode) async {
+    return await _platform.setPersistenceMode(mode.name);
+  }
+
   /// Set the badge count
   Future<bool> setBadgeCount(int count) async {
     return await _platform.setBadgeCount(count);
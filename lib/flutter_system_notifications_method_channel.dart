@@ -1,3 +1,5 @@
+import 'dart:async';
+
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
@@ -13,10 +15,23 @@ class MethodChannelFlutterSystemNotifications extends FlutterSystemNotifications
   @visibleForTesting
   final eventChannel = const EventChannel('flutter_system_notifications_events');
 
+  final _scheduledChangedEvents = StreamController<Map<dynamic, dynamic>>.broadcast();
+  final _scheduledReloadedEvents = StreamController<Map<dynamic, dynamic>>.broadcast();
+  final _scheduledTransferEvents = StreamController<Map<dynamic, dynamic>>.broadcast();
+
   MethodChannelFlutterSystemNotifications() {
     _setupEventChannel();
   }
 
+  @override
+  Stream<Map<dynamic, dynamic>> get scheduledChangedEvents => _scheduledChangedEvents.stream;
+
+  @override
+  Stream<Map<dynamic, dynamic>> get scheduledReloadedEvents => _scheduledReloadedEvents.stream;
+
+  @override
+  Stream<Map<dynamic, dynamic>> get scheduledTransferEvents => _scheduledTransferEvents.stream;
+
   void _setupEventChannel() {
     eventChannel.receiveBroadcastStream().listen((dynamic event) {
       _handlePlatformEvent(event);
@@ -35,6 +50,15 @@ class MethodChannelFlutterSystemNotifications extends FlutterSystemNotifications
           case 'tap':
             // This would be handled by the main NotificationManager class
             break;
+          case 'scheduledChanged':
+            _scheduledChangedEvents.add(event);
+            break;
+          case 'scheduledReloaded':
+            _scheduledReloadedEvents.add(event);
+            break;
+          case 'scheduledTransfer':
+            _scheduledTransferEvents.add(event);
+            break;
         }
       }
     } catch (e) {
@@ -88,9 +112,10 @@ class MethodChannelFlutterSystemNotifications extends FlutterSystemNotifications
   }
 
   @override
-  Future<bool> scheduleNotification(dynamic scheduledNotification) async {
+  Future<bool> scheduleNotification(dynamic scheduledNotification, {String? persistenceMode}) async {
     try {
       final Map<String, dynamic> notificationData = scheduledNotification.toJson();
+      if (persistenceMode != null) notificationData['persistenceMode'] = persistenceMode;
       final result = await methodChannel.invokeMethod<bool>('scheduleNotification', notificationData);
       return result ?? false;
     } on PlatformException catch (e) {
@@ -110,6 +135,140 @@ class MethodChannelFlutterSystemNotifications extends FlutterSystemNotifications
     }
   }
 
+  @override
+  Future<Map<dynamic, dynamic>> getNextScheduledNotifications({int limit = 20, String? cursor}) async {
+    try {
+      final result = await methodChannel.invokeMethod<Map<dynamic, dynamic>>('getNextScheduledNotifications', {
+        'limit': limit,
+        'cursor': cursor,
+      });
+      return result ?? {};
+    } on PlatformException catch (e) {
+      debugPrint('Error getting next scheduled notifications: ${e.message}');
+      return {};
+    }
+  }
+
+  @override
+  Future<Map<dynamic, dynamic>> getScheduledNotificationsInRange(
+    DateTime start,
+    DateTime end, {
+    int limit = 20,
+    String? cursor,
+  }) async {
+    try {
+      final result = await methodChannel.invokeMethod<Map<dynamic, dynamic>>('getScheduledNotificationsInRange', {
+        'start': start.millisecondsSinceEpoch,
+        'end': end.millisecondsSinceEpoch,
+        'limit': limit,
+        'cursor': cursor,
+      });
+      return result ?? {};
+    } on PlatformException catch (e) {
+      debugPrint('Error getting scheduled notifications in range: ${e.message}');
+      return {};
+    }
+  }
+
+  @override
+  Future<Map<dynamic, dynamic>> getNotificationHistory(
+    DateTime start,
+    DateTime end, {
+    int limit = 20,
+    String? cursor,
+  }) async {
+    try {
+      final result = await methodChannel.invokeMethod<Map<dynamic, dynamic>>('getNotificationHistory', {
+        'start': start.millisecondsSinceEpoch,
+        'end': end.millisecondsSinceEpoch,
+        'limit': limit,
+        'cursor': cursor,
+      });
+      return result ?? {};
+    } on PlatformException catch (e) {
+      debugPrint('Error getting notification history: ${e.message}');
+      return {};
+    }
+  }
+
+  @override
+  Future<Map<dynamic, dynamic>> getScheduledChanges(int sinceVersion) async {
+    try {
+      final result = await methodChannel.invokeMethod<Map<dynamic, dynamic>>('getScheduledChanges', {
+        'sinceVersion': sinceVersion,
+      });
+      return result ?? {};
+    } on PlatformException catch (e) {
+      debugPrint('Error getting scheduled changes: ${e.message}');
+      return {};
+    }
+  }
+
+  @override
+  Future<int?> exportScheduledNotifications(String path, {int chunkSize = 500}) async {
+    try {
+      return await methodChannel.invokeMethod<int>('exportScheduledNotifications', {
+        'path': path,
+        'chunkSize': chunkSize,
+      });
+    } on PlatformException catch (e) {
+      debugPrint('Error exporting scheduled notifications: ${e.message}');
+      return null;
+    }
+  }
+
+  @override
+  Future<int?> importScheduledNotifications(String path, {int chunkSize = 500}) async {
+    try {
+      return await methodChannel.invokeMethod<int>('importScheduledNotifications', {
+        'path': path,
+        'chunkSize': chunkSize,
+      });
+    } on PlatformException catch (e) {
+      debugPrint('Error importing scheduled notifications: ${e.message}');
+      return null;
+    }
+  }
+
+  @override
+  Future<bool> setSchedulerSlack(Duration slack) async {
+    try {
+      final result = await methodChannel.invokeMethod<bool>('setSchedulerSlack', {
+        'slackMs': slack.inMilliseconds,
+      });
+      return result ?? false;
+    } on PlatformException catch (e) {
+      debugPrint('Error setting scheduler slack: ${e.message}');
+      return false;
+    }
+  }
+
+  @override
+  Future<bool> setCatchUpPolicy(String policy) async {
+    try {
+      final result = await methodChannel.invokeMethod<bool>('setCatchUpPolicy', {
+        'policy': policy,
+      });
+      return result ?? false;
+    } on PlatformException catch (e) {
+      debugPrint('Error setting catch-up policy: ${e.message}');
+      return false;
+    }
+  }
+
+  @override
+  Future<bool> setPersistenceMode(String mode) async {
+    try {
+      final result = await methodChannel.invokeMethod<bool>('setPersistenceMode', {
+        'mode': mode,
+      });
+      return result ?? false;
+    } on PlatformException catch (e) {
+      debugPrint('Error setting persistence mode: ${e.message}');
+      return false;
+    }
+  }
+
   @override
   Future<bool> updateScheduledNotification(dynamic notification) async {
     try {
@@ -155,6 +314,45 @@ class MethodChannelFlutterSystemNotifications extends FlutterSystemNotifications
     }
   }
 
+  @override
+  Future<int> cancelNotificationsByCategory(String category) async {
+    try {
+      final result = await methodChannel.invokeMethod<int>('cancelNotificationsByCategory', {
+        'category': category,
+      });
+      return result ?? 0;
+    } on PlatformException catch (e) {
+      debugPrint('Error canceling notifications by category: ${e.message}');
+      return 0;
+    }
+  }
+
+  @override
+  Future<int> cancelNotificationsByGroup(String group) async {
+    try {
+      final result = await methodChannel.invokeMethod<int>('cancelNotificationsByGroup', {
+        'group': group,
+      });
+      return result ?? 0;
+    } on PlatformException catch (e) {
+      debugPrint('Error canceling notifications by group: ${e.message}');
+      return 0;
+    }
+  }
+
+  @override
+  Future<int> cancelNotificationsWithPrefix(String prefix) async {
+    try {
+      final result = await methodChannel.invokeMethod<int>('cancelNotificationsWithPrefix', {
+        'prefix': prefix,
+      });
+      return result ?? 0;
+    } on PlatformException catch (e) {
+      debugPrint('Error canceling notifications with prefix: ${e.message}');
+      return 0;
+    }
+  }
+
   @override
   Future<bool> cancelAllScheduledNotifications() async {
     try {
@@ -165,6 +363,27 @@ class MethodChannelFlutterSystemNotifications extends FlutterSystemNotifications
       return false;
     }
   }
+  @override
+  Future<Map<dynamic, dynamic>> getActiveNotifications({
+    String? category,
+    String? group,
+    int limit = 20,
+    String? cursor,
+  }) async {
+    try {
+      final result = await methodChannel.invokeMethod<Map<dynamic, dynamic>>('getActiveNotifications', {
+        'category': category,
+        'group': group,
+        'limit': limit,
+        'cursor': cursor,
+      });
+      return result ?? {};
+    } on PlatformException catch (e) {
+      debugPrint('Error getting active notifications: ${e.message}');
+      return {};
+    }
+  }
+
 
   @override
   Future<int> getBadgeCount() async {
@@ -44,7 +44,7 @@ abstract class FlutterSystemNotificationsPlatform extends PlatformInterface {
   }
 
   /// Schedule a notification
-  Future<bool> scheduleNotification(dynamic scheduledNotification) {
+  Future<bool> scheduleNotification(dynamic scheduledNotification, {String? persistenceMode}) {
     throw UnimplementedError('scheduleNotification() has not been implemented.');
   }
 
@@ -53,6 +53,100 @@ abstract class FlutterSystemNotificationsPlatform extends PlatformInterface {
     throw UnimplementedError('getScheduledNotifications() has not been implemented.');
   }
 
+  /// Get the next scheduled notifications to fire, earliest first.
+  ///
+  /// Returns a map with a `notifications` list and a `nextCursor` to pass
+  /// back for the following page, or null on the last page.
+  Future<Map<dynamic, dynamic>> getNextScheduledNotifications({int limit = 20, String? cursor}) {
+    throw UnimplementedError('getNextScheduledNotifications() has not been implemented.');
+  }
+
+  /// Get scheduled notifications firing in [start, end), earliest first.
+  ///
+  /// Returns a page in the same shape as [getNextScheduledNotifications].
+  Future<Map<dynamic, dynamic>> getScheduledNotificationsInRange(
+    DateTime start,
+    DateTime end, {
+    int limit = 20,
+    String? cursor,
+  }) {
+    throw UnimplementedError('getScheduledNotificationsInRange() has not been implemented.');
+  }
+
+  /// Get the scheduled notifications inserted, updated or removed since [sinceVersion].
+  ///
+  /// Returns a map with the new `version`, `inserted`, `updated` and
+  /// `removed` lists, and `isFullSnapshot` set when [sinceVersion] was too
+  /// old and `inserted` holds every scheduled notification instead.
+  Future<Map<dynamic, dynamic>> getScheduledChanges(int sinceVersion) {
+    throw UnimplementedError('getScheduledChanges() has not been implemented.');
+  }
+
+  /// Get what was shown, acted on and closed from [start] up to, but not
+  /// including, [end], oldest first.
+  ///
+  /// Returns a map with the `entries` and a `nextCursor` to pass back for
+  /// the next page, null on the last one.
+  Future<Map<dynamic, dynamic>> getNotificationHistory(
+    DateTime start,
+    DateTime end, {
+    int limit = 20,
+    String? cursor,
+  }) {
+    throw UnimplementedError('getNotificationHistory() has not been implemented.');
+  }
+
+  /// Start writing every scheduled notification to [path] as newline-delimited JSON.
+  ///
+  /// Returns the id of the export; progress and the outcome are reported as
+  /// `scheduledTransfer` events.
+  Future<int?> exportScheduledNotifications(String path, {int chunkSize = 500}) {
+    throw UnimplementedError('exportScheduledNotifications() has not been implemented.');
+  }
+
+  /// Start scheduling every notification in the newline-delimited JSON file at [path].
+  ///
+  /// Returns the id of the import; progress and the outcome are reported as
+  /// `scheduledTransfer` events.
+  Future<int?> importScheduledNotifications(String path, {int chunkSize = 500}) {
+    throw UnimplementedError('importScheduledNotifications() has not been implemented.');
+  }
+
+  /// `scheduledChanged` events: a map with the new `version` of the schedule,
+  /// to pass to [getScheduledChanges] for the delta.
+  Stream<Map<dynamic, dynamic>> get scheduledChangedEvents {
+    throw UnimplementedError('scheduledChangedEvents has not been implemented.');
+  }
+
+  /// `scheduledReloaded` events, sent when another process changed the stored
+  /// schedule: a map with the `scheduled` and `cancelled` ids and the new
+  /// `version`.
+  Stream<Map<dynamic, dynamic>> get scheduledReloadedEvents {
+    throw UnimplementedError('scheduledReloadedEvents has not been implemented.');
+  }
+
+  /// `scheduledTransfer` events reporting an export or import: a map with the
+  /// `transferId`, `direction`, `processed`, `skipped`, `total` (exports only),
+  /// `done` and, if it failed, `error`.
+  Stream<Map<dynamic, dynamic>> get scheduledTransferEvents {
+    throw UnimplementedError('scheduledTransferEvents has not been implemented.');
+  }
+
+  /// Let scheduled notifications fire up to [slack] late so nearby ones share a wakeup
+  Future<bool> setSchedulerSlack(Duration slack) {
+    throw UnimplementedError('setSchedulerSlack() has not been implemented.');
+  }
+
+  /// Choose what to show for scheduled notifications missed while the device slept
+  Future<bool> setCatchUpPolicy(String policy) {
+    throw UnimplementedError('setCatchUpPolicy() has not been implemented.');
+  }
+
+  /// Choose whether calls that change stored data wait for the disk write
+  Future<bool> setPersistenceMode(String mode) {
+    throw UnimplementedError('setPersistenceMode() has not been implemented.');
+  }
+
   /// Update a scheduled notification
   Future<bool> updateScheduledNotification(dynamic notification) {
     throw UnimplementedError('updateScheduledNotification() has not been implemented.');
@@ -73,11 +167,43 @@ abstract class FlutterSystemNotificationsPlatform extends PlatformInterface {
     throw UnimplementedError('cancelAllNotifications() has not been implemented.');
   }
 
+  /// Cancel every notification on screen in [category], and return how many
+  /// were cancelled
+  Future<int> cancelNotificationsByCategory(String category) {
+    throw UnimplementedError('cancelNotificationsByCategory() has not been implemented.');
+  }
+
+  /// Cancel every notification on screen in [group], and return how many
+  /// were cancelled
+  Future<int> cancelNotificationsByGroup(String group) {
+    throw UnimplementedError('cancelNotificationsByGroup() has not been implemented.');
+  }
+
+  /// Cancel every notification on screen whose id starts with [prefix], and
+  /// return how many were cancelled
+  Future<int> cancelNotificationsWithPrefix(String prefix) {
+    throw UnimplementedError('cancelNotificationsWithPrefix() has not been implemented.');
+  }
+
   /// Cancel all scheduled notifications
   Future<bool> cancelAllScheduledNotifications() {
     throw UnimplementedError('cancelAllScheduledNotifications() has not been implemented.');
   }
 
+  /// Get the notifications currently on screen, oldest first, only those in
+  /// [category] and [group] when given.
+  ///
+  /// Returns a map with the `notifications` and a `nextCursor` to pass back
+  /// for the next page, null on the last one.
+  Future<Map<dynamic, dynamic>> getActiveNotifications({
+    String? category,
+    String? group,
+    int limit = 20,
+    String? cursor,
+  }) {
+    throw UnimplementedError('getActiveNotifications() has not been implemented.');
+  }
+
   /// Get the current badge count
   Future<int> getBadgeCount() {
     throw UnimplementedError('getBadgeCount() has not been implemented.');
@@ -93,7 +219,8 @@ abstract class FlutterSystemNotificationsPlatform extends PlatformInterface {
     throw UnimplementedError('clearBadgeCount() has not been implemented.');
   }
 
-  /// Check if a notification with the same duplicate key exists
+  /// Check if a notification with the same duplicate key was shown within
+  /// [timeWindow], and within the `duplicateWindow` it was shown with
   Future<bool> isDuplicateNotification(String duplicateKey, Duration? timeWindow) {
     throw UnimplementedError('isDuplicateNotification() has not been implemented.');
   }
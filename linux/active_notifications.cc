@@ -0,0 +1,115 @@
+#include "active_notifications.h"
+
+namespace notification_manager {
+
+const ActiveNotification* ActiveNotifications::Find(const std::string& id) const {
+  auto it = by_id_.find(id);
+  return it == by_id_.end() ? nullptr : &it->second;
+}
+
+void ActiveNotifications::Put(const std::string& id,
+                              const std::string& title,
+                              const std::string& category,
+                              const std::string& group,
+                              int64_t now_ms) {
+  auto it = by_id_.find(id);
+  int64_t created_ms = now_ms;
+  if (it != by_id_.end()) {
+    created_ms = it->second.created_ms;
+    Key key(created_ms, id);
+    Unindex(&by_category_, it->second.category, key);
+    Unindex(&by_group_, it->second.group, key);
+    Unindex(&by_category_group_, CategoryGroupKey(it->second.category, it->second.group), key);
+  } else {
+    it = by_id_.emplace(id, ActiveNotification()).first;
+    it->second.id = id;
+    it->second.created_ms = now_ms;
+    by_created_.emplace(now_ms, id);
+  }
+
+  ActiveNotification& notification = it->second;
+  notification.title = title;
+  notification.category = category;
+  notification.group = group;
+  notification.updated_ms = now_ms;
+  if (!category.empty()) by_category_[category].emplace(created_ms, id);
+  if (!group.empty()) by_group_[group].emplace(created_ms, id);
+  std::string category_group = CategoryGroupKey(category, group);
+  if (!category_group.empty()) by_category_group_[category_group].emplace(created_ms, id);
+}
+
+bool ActiveNotifications::Remove(const std::string& id) {
+  auto it = by_id_.find(id);
+  if (it == by_id_.end()) return false;
+  Key key(it->second.created_ms, id);
+  by_created_.erase(key);
+  Unindex(&by_category_, it->second.category, key);
+  Unindex(&by_group_, it->second.group, key);
+  Unindex(&by_category_group_, CategoryGroupKey(it->second.category, it->second.group), key);
+  by_id_.erase(it);
+  return true;
+}
+
+void ActiveNotifications::Clear() {
+  by_id_.clear();
+  by_created_.clear();
+  by_category_.clear();
+  by_group_.clear();
+  by_category_group_.clear();
+}
+
+std::vector<std::string> ActiveNotifications::RemoveCategory(const std::string& category) {
+  return RemoveIndexed(by_category_, category);
+}
+
+std::vector<std::string> ActiveNotifications::RemoveGroup(const std::string& group) {
+  return RemoveIndexed(by_group_, group);
+}
+
+std::vector<std::string> ActiveNotifications::RemovePrefix(const std::string& prefix) {
+  std::vector<std::string> ids;
+  for (auto it = by_id_.lower_bound(prefix);
+       it != by_id_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+    ids.push_back(it->first);
+  }
+  for (const std::string& id : ids) Remove(id);
+  return ids;
+}
+
+std::string ActiveNotifications::CategoryGroupKey(const std::string& category,
+                                                  const std::string& group) {
+  if (category.empty() || group.empty()) return std::string();
+  return std::to_string(category.size()) + ':' + category + group;
+}
+
+const ActiveNotifications::KeySet* ActiveNotifications::Lookup(
+    const std::map<std::string, KeySet>& index,
+    const std::string& name) {
+  auto it = index.find(name);
+  return it == index.end() ? nullptr : &it->second;
+}
+
+void ActiveNotifications::Unindex(std::map<std::string, KeySet>* index,
+                                  const std::string& name,
+                                  const Key& key) {
+  if (name.empty()) return;
+  auto it = index->find(name);
+  if (it == index->end()) return;
+  it->second.erase(key);
+  // Empty sets would pile up as categories and groups come and go.
+  if (it->second.empty()) index->erase(it);
+}
+
+std::vector<std::string> ActiveNotifications::RemoveIndexed(
+    const std::map<std::string, KeySet>& index,
+    const std::string& name) {
+  std::vector<std::string> ids;
+  const KeySet* keys = Lookup(index, name);
+  if (keys == nullptr) return ids;
+  // Copied out first: removing the last one erases |keys| itself.
+  for (const Key& key : *keys) ids.push_back(key.second);
+  for (const std::string& id : ids) Remove(id);
+  return ids;
+}
+
+}  // namespace notification_manager
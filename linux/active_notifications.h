@@ -0,0 +1,131 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_ACTIVE_NOTIFICATIONS_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_ACTIVE_NOTIFICATIONS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace notification_manager {
+
+struct ActiveNotification {
+  std::string id;
+  std::string title;
+  std::string category;
+  std::string group;
+  // Milliseconds since the Unix epoch. Updating a notification in place
+  // keeps its creation time.
+  int64_t created_ms = 0;
+  int64_t updated_ms = 0;
+};
+
+// The notifications this process has on screen, indexed by id, by creation
+// time, and by category, group, and category and group together within it,
+// so pages of any of them cost O(log N + page size) however many are
+// showing. Not thread-safe.
+class ActiveNotifications {
+ public:
+  // A position in creation order. Notifications are ordered by creation
+  // time and then by id, so a cursor stays valid while others come and go.
+  struct Cursor {
+    int64_t created_ms;
+    std::string id;
+  };
+
+  ActiveNotifications() = default;
+
+  // Disallow copy and assign.
+  ActiveNotifications(const ActiveNotifications&) = delete;
+  ActiveNotifications& operator=(const ActiveNotifications&) = delete;
+
+  size_t size() const { return by_id_.size(); }
+  bool empty() const { return by_id_.empty(); }
+  bool Contains(const std::string& id) const { return by_id_.count(id) > 0; }
+  const ActiveNotification* Find(const std::string& id) const;
+
+  // Adds |id| created at |now_ms|, or updates it in place.
+  void Put(const std::string& id,
+           const std::string& title,
+           const std::string& category,
+           const std::string& group,
+           int64_t now_ms);
+
+  // Returns false if |id| was not active.
+  bool Remove(const std::string& id);
+  void Clear();
+
+  // Remove every notification in |category|, in |group|, or whose id starts
+  // with |prefix|, and return their ids in creation order (id order for
+  // RemovePrefix). Each costs O(k log N) for k removed, however many others
+  // are showing. An empty |prefix| removes everything.
+  std::vector<std::string> RemoveCategory(const std::string& category);
+  std::vector<std::string> RemoveGroup(const std::string& group);
+  std::vector<std::string> RemovePrefix(const std::string& prefix);
+
+  // Calls |callback| with every notification, in id order.
+  template <typename Callback>
+  void ForEach(Callback callback) const {
+    for (const auto& pair : by_id_) callback(pair.second);
+  }
+
+  // Calls |callback| with up to |limit| notifications in creation order,
+  // only those in |category| and |group| when they are given, skipping
+  // everything up to and including |after| when it is given. Returns true
+  // if matching notifications remain past the last one visited.
+  template <typename Callback>
+  bool ForEachByCreation(const std::string* category,
+                         const std::string* group,
+                         const Cursor* after,
+                         size_t limit,
+                         Callback callback) const {
+    // Every combination of filters has an index holding exactly its matches.
+    const KeySet* keys = &by_created_;
+    if (category && group) {
+      keys = Lookup(by_category_group_, CategoryGroupKey(*category, *group));
+    } else if (category) {
+      keys = Lookup(by_category_, *category);
+    } else if (group) {
+      keys = Lookup(by_group_, *group);
+    }
+    if (keys == nullptr) return false;
+
+    auto it = after ? keys->upper_bound(Key(after->created_ms, after->id)) : keys->begin();
+    for (size_t visited = 0; it != keys->end(); ++it, visited++) {
+      if (visited == limit) return true;
+      callback(by_id_.at(it->second));
+    }
+    return false;
+  }
+
+ private:
+  using Key = std::pair<int64_t, std::string>;
+  using KeySet = std::set<Key>;
+
+  // The by_category_group_ key for |category| and |group|, or "" unless
+  // both are set. The length prefix keeps ("a:b", "c") apart from ("a",
+  // "b:c").
+  static std::string CategoryGroupKey(const std::string& category, const std::string& group);
+  static const KeySet* Lookup(const std::map<std::string, KeySet>& index,
+                              const std::string& name);
+  static void Unindex(std::map<std::string, KeySet>* index,
+                      const std::string& name,
+                      const Key& key);
+
+  std::vector<std::string> RemoveIndexed(const std::map<std::string, KeySet>& index,
+                                         const std::string& name);
+
+  std::map<std::string, ActiveNotification> by_id_;
+  KeySet by_created_;
+  // Only notifications with a category or group are in these, and only
+  // those with both in by_category_group_.
+  std::map<std::string, KeySet> by_category_;
+  std::map<std::string, KeySet> by_group_;
+  std::map<std::string, KeySet> by_category_group_;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_ACTIVE_NOTIFICATIONS_H_
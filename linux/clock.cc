@@ -0,0 +1,140 @@
+#include "clock.h"
+
+#include <errno.h>
+#include <glib-unix.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace notification_manager {
+
+namespace {
+
+struct RealTimeWatch {
+  int fd;
+  GSourceFunc function;
+  gpointer data;
+};
+
+// Arms |fd| for the far future. With TFD_TIMER_CANCEL_ON_SET, setting the
+// wall clock cancels the timer and wakes the reader instead.
+bool arm_real_time_watch(int fd) {
+  struct itimerspec spec = {};
+  spec.it_value.tv_sec = G_MAXINT32;
+  return timerfd_settime(fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) == 0;
+}
+
+gboolean real_time_watch_cb(gint fd, GIOCondition condition, gpointer user_data) {
+  RealTimeWatch* watch = static_cast<RealTimeWatch*>(user_data);
+  uint64_t expirations;
+  if (read(fd, &expirations, sizeof(expirations)) >= 0) {
+    // The far future arrived; keep watching.
+    arm_real_time_watch(fd);
+    return G_SOURCE_CONTINUE;
+  }
+  if (errno != ECANCELED) return G_SOURCE_CONTINUE;
+  arm_real_time_watch(fd);
+  return watch->function(watch->data);
+}
+
+void real_time_watch_free(gpointer user_data) {
+  RealTimeWatch* watch = static_cast<RealTimeWatch*>(user_data);
+  close(watch->fd);
+  delete watch;
+}
+
+}  // namespace
+
+guint SystemClock::AddRealTimeWatch(GSourceFunc function, gpointer data) {
+  int fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd < 0 || !arm_real_time_watch(fd)) {
+    g_warning("Failed to watch the wall clock: %s", g_strerror(errno));
+    if (fd >= 0) close(fd);
+    return 0;
+  }
+  return g_unix_fd_add_full(G_PRIORITY_DEFAULT, fd, G_IO_IN, real_time_watch_cb,
+                            new RealTimeWatch{fd, function, data}, real_time_watch_free);
+}
+
+VirtualClock::VirtualClock(int64_t real_time_us) : real_time_us_(real_time_us) {}
+
+guint VirtualClock::AddTimeout(guint interval_ms, GSourceFunc function, gpointer data) {
+  return Add(int64_t{interval_ms} * 1000, function, data);
+}
+
+guint VirtualClock::AddTimeoutSeconds(guint interval_s, GSourceFunc function, gpointer data) {
+  return Add(int64_t{interval_s} * G_USEC_PER_SEC, function, data);
+}
+
+guint VirtualClock::AddRealTimeWatch(GSourceFunc function, gpointer data) {
+  guint id = next_id_++;
+  watches_[id] = {function, data};
+  return id;
+}
+
+void VirtualClock::RemoveTimeout(guint id) {
+  if (watches_.erase(id) > 0) return;
+  if (id == running_id_) {
+    running_removed_ = true;
+    return;
+  }
+  auto it = timers_.find(id);
+  if (it == timers_.end()) {
+    g_warning("Removing unknown virtual timer %u", id);
+    return;
+  }
+  due_order_.erase({it->second.due_us, id});
+  timers_.erase(it);
+}
+
+size_t VirtualClock::Advance(int64_t delta_us) {
+  int64_t target_us = monotonic_time_us_ + delta_us;
+  size_t run = 0;
+  while (!due_order_.empty() && due_order_.begin()->first <= target_us) {
+    guint id = due_order_.begin()->second;
+    due_order_.erase(due_order_.begin());
+    Timer timer = timers_[id];
+    timers_.erase(id);
+
+    real_time_us_ += timer.due_us - monotonic_time_us_;
+    monotonic_time_us_ = timer.due_us;
+    running_id_ = id;
+    running_removed_ = false;
+    gboolean again = timer.function(timer.data);
+    running_id_ = 0;
+    run++;
+
+    if (again && !running_removed_) {
+      timer.due_us += timer.interval_us;
+      timers_[id] = timer;
+      due_order_.insert({timer.due_us, id});
+    }
+  }
+  real_time_us_ += target_us - monotonic_time_us_;
+  monotonic_time_us_ = target_us;
+  return run;
+}
+
+void VirtualClock::JumpRealTime(int64_t delta_us) {
+  real_time_us_ += delta_us;
+  // A watch may remove itself or others while running.
+  std::vector<guint> ids;
+  for (const auto& pair : watches_) ids.push_back(pair.first);
+  for (guint id : ids) {
+    auto it = watches_.find(id);
+    if (it == watches_.end()) continue;
+    auto watch = it->second;
+    if (!watch.first(watch.second)) watches_.erase(id);
+  }
+}
+
+guint VirtualClock::Add(int64_t interval_us, GSourceFunc function, gpointer data) {
+  guint id = next_id_++;
+  Timer timer{monotonic_time_us_ + interval_us, interval_us, function, data};
+  timers_[id] = timer;
+  due_order_.insert({timer.due_us, id});
+  return id;
+}
+
+}  // namespace notification_manager
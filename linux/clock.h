@@ -0,0 +1,120 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_CLOCK_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_CLOCK_H_
+
+#include <glib.h>
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace notification_manager {
+
+// The time and timers the plugin runs on. Dedupe windows, the scheduler
+// and the catch-up rate limit all go through a Clock, so tests can swap in
+// a VirtualClock and cover days of behaviour without sleeping.
+class Clock {
+ public:
+  Clock() = default;
+  virtual ~Clock() = default;
+
+  // Disallow copy and assign.
+  Clock(const Clock&) = delete;
+  Clock& operator=(const Clock&) = delete;
+
+  // Wall time in microseconds since the Unix epoch. It may jump when the
+  // user or NTP sets the clock.
+  virtual int64_t RealTimeUs() = 0;
+
+  // Microseconds on a clock that never jumps; only differences matter.
+  virtual int64_t MonotonicTimeUs() = 0;
+
+  // Like g_timeout_add(): calls |function| with |data| every |interval_ms|
+  // on the monotonic clock until it returns G_SOURCE_REMOVE. Returns a
+  // non-zero id for RemoveTimeout().
+  virtual guint AddTimeout(guint interval_ms, GSourceFunc function, gpointer data) = 0;
+
+  // Like g_timeout_add_seconds(), which may run the timer up to a second
+  // early or late so it shares wakeups with other whole-second timers.
+  virtual guint AddTimeoutSeconds(guint interval_s, GSourceFunc function, gpointer data) = 0;
+
+  // Calls |function| with |data| each time the wall clock is set, until it
+  // returns G_SOURCE_REMOVE. Returns a non-zero id for RemoveTimeout(), or
+  // zero if the wall clock cannot be watched.
+  virtual guint AddRealTimeWatch(GSourceFunc function, gpointer data) = 0;
+
+  // Stops the timer or watch |id|. It must still be pending.
+  virtual void RemoveTimeout(guint id) = 0;
+};
+
+// GLib's clocks and the default main context.
+class SystemClock : public Clock {
+ public:
+  SystemClock() = default;
+
+  int64_t RealTimeUs() override { return g_get_real_time(); }
+  int64_t MonotonicTimeUs() override { return g_get_monotonic_time(); }
+  guint AddTimeout(guint interval_ms, GSourceFunc function, gpointer data) override {
+    return g_timeout_add(interval_ms, function, data);
+  }
+  guint AddTimeoutSeconds(guint interval_s, GSourceFunc function, gpointer data) override {
+    return g_timeout_add_seconds(interval_s, function, data);
+  }
+  // Watches a timerfd that the kernel cancels whenever the clock is set.
+  guint AddRealTimeWatch(GSourceFunc function, gpointer data) override;
+  void RemoveTimeout(guint id) override { g_source_remove(id); }
+};
+
+// A clock that only moves when told to. Advance() runs every timer that
+// falls due on the way, in due order and with the clock set to its due
+// time, so a simulated year takes as long as the work done in it.
+// Whole-second timers run exactly on time.
+class VirtualClock : public Clock {
+ public:
+  // Starts the wall clock at |real_time_us| and the monotonic clock at zero.
+  explicit VirtualClock(int64_t real_time_us);
+
+  int64_t RealTimeUs() override { return real_time_us_; }
+  int64_t MonotonicTimeUs() override { return monotonic_time_us_; }
+  guint AddTimeout(guint interval_ms, GSourceFunc function, gpointer data) override;
+  guint AddTimeoutSeconds(guint interval_s, GSourceFunc function, gpointer data) override;
+  guint AddRealTimeWatch(GSourceFunc function, gpointer data) override;
+  void RemoveTimeout(guint id) override;
+
+  // Moves both clocks forward by |delta_us|, running timers as they fall
+  // due, including any they add that are due within the same span. Returns
+  // the number of timer callbacks run.
+  size_t Advance(int64_t delta_us);
+
+  // Moves the wall clock alone, as when the system time is set, and runs
+  // the real time watches. Timers follow the monotonic clock and are not
+  // affected.
+  void JumpRealTime(int64_t delta_us);
+
+  size_t pending_timers() const { return timers_.size(); }
+
+ private:
+  struct Timer {
+    int64_t due_us;
+    int64_t interval_us;
+    GSourceFunc function;
+    gpointer data;
+  };
+
+  guint Add(int64_t interval_us, GSourceFunc function, gpointer data);
+
+  int64_t real_time_us_;
+  int64_t monotonic_time_us_ = 0;
+  guint next_id_ = 1;
+  std::map<guint, Timer> timers_;
+  std::map<guint, std::pair<GSourceFunc, gpointer>> watches_;
+  // Pending timers as (due time, id), so ties run in the order added.
+  std::set<std::pair<int64_t, guint>> due_order_;
+  // The timer whose callback is running, and whether it removed itself.
+  guint running_id_ = 0;
+  bool running_removed_ = false;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_CLOCK_H_
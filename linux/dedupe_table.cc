@@ -0,0 +1,369 @@
+#include "dedupe_table.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace notification_manager {
+
+// The table is shared with other processes, which only works for atomics
+// that need no lock of their own.
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "DedupeTable needs lock-free 32 and 64-bit atomics");
+
+struct DedupeTable::Header {
+  char magic[4];
+  uint32_t version;
+  // A power of two, fixed for the life of the file.
+  uint32_t bucket_count;
+  uint32_t reserved;
+  // Set once a newer file has replaced this one.
+  std::atomic<uint32_t> retired;
+  std::atomic<uint32_t> import_claimed;
+  // Buckets holding a key.
+  std::atomic<uint64_t> used;
+  char padding[32];
+};
+
+struct DedupeTable::Bucket {
+  // Odd while a writer holds the bucket. Readers retry if it changed
+  // under them.
+  std::atomic<uint32_t> sequence;
+  uint32_t reserved;
+  // Zero while the bucket is empty. Buckets are never emptied again,
+  // except by a rebuild, so probe sequences have no holes.
+  std::atomic<uint64_t> hash;
+  std::atomic<int64_t> sent_s;
+  std::atomic<int64_t> expires_s;
+};
+
+struct DedupeTable::Entry {
+  uint64_t hash;
+  int64_t sent_s;
+  int64_t expires_s;
+};
+
+namespace {
+
+constexpr char kMagic[4] = {'N', 'M', 'D', 'T'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kInitialBuckets = 1024;
+// Longest probe sequence before a write gives up and rebuilds the table.
+constexpr uint32_t kMaxProbe = 64;
+// How often to retry a bucket a writer is holding. Writers hold a bucket
+// for a handful of stores, so running out means the writer died.
+constexpr int kMaxSpins = 1000;
+
+// 64-bit FNV-1a. Zero marks an empty bucket, so it is never returned.
+uint64_t hash_key(const std::string& key) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : key) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash == 0 ? 1 : hash;
+}
+
+}  // namespace
+
+DedupeTable::DedupeTable(std::string path)
+    : path_(std::move(path)), lock_path_(path_ + ".lock") {}
+
+DedupeTable::~DedupeTable() {
+  Unmap();
+  if (lock_fd_ >= 0) g_close(lock_fd_, nullptr);
+}
+
+// Reads one bucket, retrying while a writer holds it. Returns false if it
+// stayed held.
+static bool read_bucket(const std::atomic<uint32_t>& sequence,
+                        const std::atomic<uint64_t>& hash,
+                        const std::atomic<int64_t>& sent_s,
+                        const std::atomic<int64_t>& expires_s,
+                        uint64_t* hash_out,
+                        int64_t* sent_out,
+                        int64_t* expires_out) {
+  for (int spin = 0; spin < kMaxSpins; spin++) {
+    uint32_t before = sequence.load(std::memory_order_acquire);
+    if (before & 1) {
+      g_thread_yield();
+      continue;
+    }
+    *hash_out = hash.load(std::memory_order_relaxed);
+    *sent_out = sent_s.load(std::memory_order_relaxed);
+    *expires_out = expires_s.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence.load(std::memory_order_relaxed) == before) return true;
+  }
+  return false;
+}
+
+bool DedupeTable::LastSent(const std::string& key, int64_t* sent_s, int64_t* expires_s) {
+  if (!EnsureMapped(false)) return false;
+
+  uint64_t hash = hash_key(key);
+  uint32_t mask = header_->bucket_count - 1;
+  for (uint32_t probe = 0; probe < kMaxProbe; probe++) {
+    Bucket& bucket = buckets_[(hash + probe) & mask];
+    uint64_t bucket_hash = 0;
+    int64_t bucket_sent_s = 0;
+    int64_t bucket_expires_s = 0;
+    if (!read_bucket(bucket.sequence, bucket.hash, bucket.sent_s, bucket.expires_s, &bucket_hash,
+                     &bucket_sent_s, &bucket_expires_s)) {
+      // The writer died holding it. Once no writer is left, release it;
+      // its contents may be torn, but only the timestamps can be.
+      if (!Lock(LOCK_EX)) return false;
+      uint32_t sequence = bucket.sequence.load(std::memory_order_relaxed);
+      if (sequence & 1) bucket.sequence.store(sequence + 1, std::memory_order_release);
+      Unlock();
+      return LastSent(key, sent_s, expires_s);
+    }
+    if (bucket_hash == 0) return false;
+    if (bucket_hash == hash) {
+      *sent_s = bucket_sent_s;
+      if (expires_s) *expires_s = bucket_expires_s;
+      return true;
+    }
+  }
+  return false;
+}
+
+void DedupeTable::MarkSent(const std::string& key, int64_t sent_s, int64_t window_s) {
+  uint64_t hash = hash_key(key);
+  int64_t expires_s = sent_s + (window_s > 0 ? window_s : 0);
+
+  // A compaction may retire the table between mapping it and locking it.
+  do {
+    if (!EnsureMapped(true) || !Lock(LOCK_SH)) return;
+    if (!header_->retired.load(std::memory_order_acquire)) break;
+    Unlock();
+  } while (true);
+
+  bool stored = Store(hash, sent_s, expires_s);
+  bool crowded = header_->used.load(std::memory_order_relaxed) * 4 >
+                 uint64_t{header_->bucket_count} * 3;
+  Unlock();
+  if (stored && !crowded) return;
+
+  // With the lock held exclusively, EnsureMapped() must not create, which
+  // would take the lock again.
+  if (!Lock(LOCK_EX)) return;
+  if (EnsureMapped(false)) {
+    Compact(sent_s);
+    if (!stored && header_ != nullptr) Store(hash, sent_s, expires_s);
+  }
+  Unlock();
+}
+
+void DedupeTable::Clear() {
+  if (!EnsureMapped(false) || !Lock(LOCK_EX)) return;
+  // Nothing has expired by the end of time.
+  if (EnsureMapped(false)) Compact(std::numeric_limits<int64_t>::max());
+  Unlock();
+}
+
+bool DedupeTable::ClaimImport() {
+  do {
+    if (!EnsureMapped(true) || !Lock(LOCK_SH)) return false;
+    if (!header_->retired.load(std::memory_order_acquire)) break;
+    Unlock();
+  } while (true);
+  bool claimed = header_->import_claimed.exchange(1) == 0;
+  Unlock();
+  return claimed;
+}
+
+size_t DedupeTable::capacity() const {
+  return header_ ? header_->bucket_count : 0;
+}
+
+bool DedupeTable::Store(uint64_t hash, int64_t sent_s, int64_t expires_s) {
+  uint32_t mask = header_->bucket_count - 1;
+  for (uint32_t probe = 0; probe < kMaxProbe; probe++) {
+    Bucket& bucket = buckets_[(hash + probe) & mask];
+    uint64_t current = bucket.hash.load(std::memory_order_relaxed);
+    if (current != 0 && current != hash) continue;
+
+    uint32_t sequence = bucket.sequence.load(std::memory_order_relaxed);
+    int spins = 0;
+    while ((sequence & 1) ||
+           !bucket.sequence.compare_exchange_weak(sequence, sequence + 1,
+                                                  std::memory_order_acquire)) {
+      // A bucket held this long belongs to a dead writer; the rebuild
+      // clears it.
+      if (++spins == kMaxSpins) return false;
+      g_thread_yield();
+      sequence = bucket.sequence.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Another writer may have claimed the bucket while this one waited.
+    current = bucket.hash.load(std::memory_order_relaxed);
+    bool stored = current == 0 || current == hash;
+    if (stored) {
+      if (current == 0) header_->used.fetch_add(1, std::memory_order_relaxed);
+      bucket.hash.store(hash, std::memory_order_relaxed);
+      bucket.sent_s.store(sent_s, std::memory_order_relaxed);
+      bucket.expires_s.store(expires_s, std::memory_order_relaxed);
+    }
+    bucket.sequence.store(sequence + 2, std::memory_order_release);
+    if (stored) return true;
+  }
+  return false;
+}
+
+bool DedupeTable::WriteTable(const std::string& path,
+                             uint32_t bucket_count,
+                             uint32_t import_claimed,
+                             const std::vector<Entry>& entries) {
+  g_autofree gchar* dir = g_path_get_dirname(path.c_str());
+  g_mkdir_with_parents(dir, 0755);
+
+  std::string temp = path + ".tmp";
+  int fd = g_open(temp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    g_warning("Failed to create %s: %s", temp.c_str(), g_strerror(errno));
+    return false;
+  }
+  size_t bytes = sizeof(Header) + size_t{bucket_count} * sizeof(Bucket);
+  void* table = MAP_FAILED;
+  if (ftruncate(fd, bytes) == 0) {
+    table = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  g_close(fd, nullptr);
+  if (table == MAP_FAILED) {
+    g_warning("Failed to map %s: %s", temp.c_str(), g_strerror(errno));
+    g_remove(temp.c_str());
+    return false;
+  }
+
+  // Nothing else has the file open yet, and ftruncate() zeroed it, which
+  // leaves every bucket empty.
+  Header* header = static_cast<Header*>(table);
+  Bucket* buckets = reinterpret_cast<Bucket*>(header + 1);
+  memcpy(header->magic, kMagic, sizeof(kMagic));
+  header->version = kVersion;
+  header->bucket_count = bucket_count;
+  header->import_claimed.store(import_claimed, std::memory_order_relaxed);
+  header->used.store(entries.size(), std::memory_order_relaxed);
+  for (const Entry& entry : entries) {
+    uint32_t index = entry.hash & (bucket_count - 1);
+    while (buckets[index].hash.load(std::memory_order_relaxed) != 0) {
+      index = (index + 1) & (bucket_count - 1);
+    }
+    buckets[index].hash.store(entry.hash, std::memory_order_relaxed);
+    buckets[index].sent_s.store(entry.sent_s, std::memory_order_relaxed);
+    buckets[index].expires_s.store(entry.expires_s, std::memory_order_relaxed);
+  }
+  munmap(table, bytes);
+
+  if (g_rename(temp.c_str(), path.c_str()) != 0) {
+    g_warning("Failed to replace %s: %s", path.c_str(), g_strerror(errno));
+    g_remove(temp.c_str());
+    return false;
+  }
+  return true;
+}
+
+void DedupeTable::Compact(int64_t now_s) {
+  std::vector<Entry> live;
+  for (uint32_t i = 0; i < header_->bucket_count; i++) {
+    const Bucket& bucket = buckets_[i];
+    uint64_t hash = bucket.hash.load(std::memory_order_relaxed);
+    int64_t expires_s = bucket.expires_s.load(std::memory_order_relaxed);
+    if (hash != 0 && expires_s >= now_s) {
+      live.push_back({hash, bucket.sent_s.load(std::memory_order_relaxed), expires_s});
+    }
+  }
+  uint32_t bucket_count = kInitialBuckets;
+  while (live.size() * 2 >= bucket_count) bucket_count *= 2;
+
+  if (!WriteTable(path_, bucket_count, header_->import_claimed.load(), live)) return;
+  header_->retired.store(1, std::memory_order_release);
+  compactions_++;
+  Unmap();
+  MapExisting();
+}
+
+bool DedupeTable::EnsureMapped(bool create) {
+  if (header_ != nullptr && header_->retired.load(std::memory_order_acquire)) Unmap();
+  return header_ != nullptr || Map(create);
+}
+
+bool DedupeTable::Map(bool create) {
+  if (MapExisting()) return true;
+  // Missing, or not a table this version understands: start afresh.
+  // Tables are only ever renamed into place whole, so an unreadable one
+  // is not another process half way through writing it.
+  if (!create || !Lock(LOCK_EX)) return false;
+  // Another process may have created it while this one waited.
+  bool mapped = MapExisting() ||
+                (WriteTable(path_, kInitialBuckets, 0, std::vector<Entry>()) && MapExisting());
+  Unlock();
+  return mapped;
+}
+
+bool DedupeTable::MapExisting() {
+  int fd = g_open(path_.c_str(), O_RDWR | O_CLOEXEC, 0);
+  if (fd < 0) return false;
+  struct stat info;
+  void* table = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(Header)) {
+    table = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  g_close(fd, nullptr);
+  if (table == MAP_FAILED) return false;
+
+  Header* header = static_cast<Header*>(table);
+  uint32_t bucket_count = header->bucket_count;
+  if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion ||
+      bucket_count == 0 || (bucket_count & (bucket_count - 1)) != 0 ||
+      static_cast<size_t>(info.st_size) != sizeof(Header) + size_t{bucket_count} * sizeof(Bucket)) {
+    munmap(table, info.st_size);
+    return false;
+  }
+  header_ = header;
+  buckets_ = reinterpret_cast<Bucket*>(header + 1);
+  mapped_bytes_ = info.st_size;
+  return true;
+}
+
+void DedupeTable::Unmap() {
+  if (header_ == nullptr) return;
+  munmap(header_, mapped_bytes_);
+  header_ = nullptr;
+  buckets_ = nullptr;
+  mapped_bytes_ = 0;
+}
+
+bool DedupeTable::Lock(int operation) {
+  if (lock_fd_ < 0) {
+    g_autofree gchar* dir = g_path_get_dirname(lock_path_.c_str());
+    g_mkdir_with_parents(dir, 0755);
+    lock_fd_ = g_open(lock_path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lock_fd_ < 0) {
+      g_warning("Failed to open %s: %s", lock_path_.c_str(), g_strerror(errno));
+      return false;
+    }
+  }
+  while (flock(lock_fd_, operation) != 0) {
+    if (errno != EINTR) return false;
+  }
+  return true;
+}
+
+void DedupeTable::Unlock() {
+  flock(lock_fd_, LOCK_UN);
+}
+
+}  // namespace notification_manager
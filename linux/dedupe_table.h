@@ -0,0 +1,105 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_DEDUPE_TABLE_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_DEDUPE_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace notification_manager {
+
+// When each duplicate key was last shown, shared by every process that
+// opens the same file, e.g. two instances of an app or an app and its tray
+// helper.
+//
+// The table is an open-addressed hash table in a memory-mapped file. Each
+// bucket is guarded by a sequence lock, so a lookup is a few reads of
+// shared memory with no system call and no parsing. Writers lock one
+// bucket at a time and hold a shared flock() on a lock file next to the
+// table while they do. When the table fills up, one writer takes the lock
+// exclusively, copies the live entries into a new file and renames it over
+// the old one; the old mapping is marked retired so the other processes
+// reopen the table on their next access.
+//
+// Keys are stored as 64-bit hashes. Nothing is mapped until the first
+// access, and the file is not created until the first write.
+class DedupeTable {
+ public:
+  explicit DedupeTable(std::string path);
+  ~DedupeTable();
+
+  // Disallow copy and assign.
+  DedupeTable(const DedupeTable&) = delete;
+  DedupeTable& operator=(const DedupeTable&) = delete;
+
+  // Sets |sent_s| to when |key| was last marked as sent, in seconds since
+  // the epoch, and |expires_s|, if given, to the end of the window it was
+  // marked with. Returns false if it never was, or the table is unreadable.
+  bool LastSent(const std::string& key, int64_t* sent_s, int64_t* expires_s = nullptr);
+
+  // Records that |key| was sent at |sent_s|. The entry is kept for at
+  // least |window_s| seconds after that, and may be dropped by any
+  // compaction once they have passed, so callers must not look further
+  // back than the window it was marked with.
+  void MarkSent(const std::string& key, int64_t sent_s, int64_t window_s);
+
+  // Forgets every key, in every process.
+  void Clear();
+
+  // Returns true for exactly one caller across all processes sharing the
+  // table, so a one-time import into it runs once. Returns false if the
+  // table cannot be created.
+  bool ClaimImport();
+
+  const std::string& path() const { return path_; }
+
+  // Buckets in the current table, or zero if none is mapped.
+  size_t capacity() const;
+
+  // Times this process has rebuilt the table.
+  uint64_t compactions() const { return compactions_; }
+
+ private:
+  struct Header;
+  struct Bucket;
+  struct Entry;
+
+  // Maps the current table, reopening it if it was retired. With |create|,
+  // a missing or unreadable table is replaced with an empty one. Returns
+  // false if there is none to use.
+  bool EnsureMapped(bool create);
+  bool Map(bool create);
+  bool MapExisting();
+  void Unmap();
+
+  // Writes a table of |bucket_count| buckets holding |entries| to a
+  // temporary file and renames it over |path|.
+  static bool WriteTable(const std::string& path,
+                         uint32_t bucket_count,
+                         uint32_t import_claimed,
+                         const std::vector<Entry>& entries);
+
+  // Takes the lock file with flock(), or returns false.
+  bool Lock(int operation);
+  void Unlock();
+
+  // Writes |hash| into its bucket with the writer lock held. Returns
+  // false if the probe sequence is full.
+  bool Store(uint64_t hash, int64_t sent_s, int64_t expires_s);
+
+  // Rebuilds the table without the entries expired by |now_s|, growing it
+  // if it is still over half full, with the writer lock held exclusively.
+  void Compact(int64_t now_s);
+
+  std::string path_;
+  std::string lock_path_;
+  int lock_fd_ = -1;
+  Header* header_ = nullptr;
+  Bucket* buckets_ = nullptr;
+  size_t mapped_bytes_ = 0;
+  uint64_t compactions_ = 0;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_DEDUPE_TABLE_H_
@@ -0,0 +1,344 @@
+#include "history_log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace notification_manager {
+
+// Offsets are logical: they only ever grow, and a record at offset |o|
+// lives at o % data_capacity in the ring. Only touched with the lock held.
+struct HistoryLog::Header {
+  char magic[4];
+  uint32_t version;
+  // A multiple of 8, fixed for the life of the file.
+  uint64_t data_capacity;
+  uint32_t index_capacity;
+  uint32_t reserved;
+  // The oldest live record, and where the next one goes.
+  uint64_t head;
+  uint64_t tail;
+  uint64_t next_sequence;
+  // Live index entries are [index_head, index_tail), also logical.
+  uint64_t index_head;
+  uint64_t index_tail;
+  // Time of the newest record.
+  int64_t last_time_ms;
+};
+
+struct HistoryLog::IndexEntry {
+  int64_t time_ms;
+  uint64_t sequence;
+  uint64_t offset;
+};
+
+// Followed by the id, title and action, then padding to a multiple of 8.
+struct HistoryLog::RecordHeader {
+  uint64_t sequence;
+  int64_t time_ms;
+  // The whole record, padding included.
+  uint32_t size;
+  uint16_t id_length;
+  uint16_t title_length;
+  uint16_t action_length;
+  uint8_t kind;
+  uint8_t reserved[5];
+};
+
+namespace {
+
+constexpr char kMagic[4] = {'N', 'M', 'H', 'L'};
+constexpr uint32_t kVersion = 1;
+// Smallest ring, so that the largest record always fits.
+constexpr size_t kMinCapacity = 16 * 1024;
+// Longest id, title or action kept.
+constexpr size_t kHistoryMaxFieldBytes = 1024;
+// Bytes of records between index entries, so a query reads at most this
+// much it does not return.
+constexpr uint64_t kHistoryIndexSpacing = 1024;
+
+size_t align8(size_t bytes) {
+  return (bytes + 7) & ~size_t{7};
+}
+
+// Cuts |value| to at most kHistoryMaxFieldBytes without splitting a UTF-8
+// character.
+size_t field_length(const std::string& value) {
+  if (value.size() <= kHistoryMaxFieldBytes) return value.size();
+  size_t length = kHistoryMaxFieldBytes;
+  while (length > 0 && (static_cast<unsigned char>(value[length]) & 0xC0) == 0x80) length--;
+  return length;
+}
+
+}  // namespace
+
+HistoryLog::HistoryLog(std::string path, size_t capacity)
+    : path_(std::move(path)),
+      requested_capacity_(align8(std::max(capacity, kMinCapacity))) {}
+
+HistoryLog::~HistoryLog() {
+  Unmap();
+  if (fd_ >= 0) g_close(fd_, nullptr);
+}
+
+bool HistoryLog::Append(HistoryKind kind,
+                        int64_t time_ms,
+                        const std::string& id,
+                        const std::string& title,
+                        const std::string& action) {
+  if (!Lock(LOCK_EX, true)) return false;
+  if (!EnsureMapped(true)) {
+    Unlock();
+    return false;
+  }
+
+  RecordHeader record = {};
+  record.id_length = field_length(id);
+  record.title_length = field_length(title);
+  record.action_length = field_length(action);
+  record.size = align8(sizeof(RecordHeader) + record.id_length + record.title_length +
+                       record.action_length);
+  record.kind = static_cast<uint8_t>(kind);
+  record.sequence = header_->next_sequence;
+  record.time_ms = std::max(time_ms, header_->last_time_ms);
+
+  // Make room. The head moves before anything is overwritten, so a crash
+  // part way through leaves a shorter log rather than a torn one.
+  while (header_->tail + record.size - header_->head > header_->data_capacity) {
+    RecordHeader oldest;
+    if (!ReadRecordHeader(header_->head, &oldest)) {
+      // Unreadable; start again from here.
+      header_->head = header_->tail;
+      break;
+    }
+    header_->head += oldest.size;
+  }
+  while (header_->index_head < header_->index_tail &&
+         index_[header_->index_head % header_->index_capacity].offset < header_->head) {
+    header_->index_head++;
+  }
+
+  uint64_t offset = header_->tail;
+  CopyIn(offset, &record, sizeof(record));
+  uint64_t field = offset + sizeof(record);
+  CopyIn(field, id.data(), record.id_length);
+  field += record.id_length;
+  CopyIn(field, title.data(), record.title_length);
+  field += record.title_length;
+  CopyIn(field, action.data(), record.action_length);
+
+  // Published only once written.
+  header_->tail = offset + record.size;
+  header_->next_sequence++;
+  header_->last_time_ms = record.time_ms;
+
+  bool index = header_->index_head == header_->index_tail ||
+               offset - index_[(header_->index_tail - 1) % header_->index_capacity].offset >=
+                   kHistoryIndexSpacing;
+  if (index) {
+    if (header_->index_tail - header_->index_head == header_->index_capacity) {
+      header_->index_head++;
+    }
+    index_[header_->index_tail % header_->index_capacity] = {record.time_ms, record.sequence,
+                                                             offset};
+    header_->index_tail++;
+  }
+  Unlock();
+  return true;
+}
+
+bool HistoryLog::Query(int64_t from_ms,
+                       int64_t to_ms,
+                       uint64_t after_sequence,
+                       size_t limit,
+                       std::vector<HistoryRecord>* out) {
+  if (!Lock(LOCK_SH, false)) return false;
+  if (!EnsureMapped(false)) {
+    Unlock();
+    return false;
+  }
+
+  bool more = false;
+  size_t added = 0;
+  std::string fields;
+  RecordHeader record;
+  for (uint64_t offset = Seek(from_ms, after_sequence);
+       offset < header_->tail && ReadRecordHeader(offset, &record); offset += record.size) {
+    if (record.time_ms >= to_ms) break;
+    if (record.time_ms < from_ms || record.sequence <= after_sequence) continue;
+    if (added == limit) {
+      more = true;
+      break;
+    }
+
+    fields.resize(record.id_length + record.title_length + record.action_length);
+    CopyOut(offset + sizeof(record), &fields[0], fields.size());
+    HistoryRecord entry;
+    entry.sequence = record.sequence;
+    entry.time_ms = record.time_ms;
+    entry.kind = static_cast<HistoryKind>(record.kind);
+    entry.id = fields.substr(0, record.id_length);
+    entry.title = fields.substr(record.id_length, record.title_length);
+    entry.action = fields.substr(record.id_length + record.title_length);
+    out->push_back(std::move(entry));
+    added++;
+  }
+  Unlock();
+  return more;
+}
+
+void HistoryLog::Clear() {
+  if (!Lock(LOCK_EX, false)) return;
+  if (EnsureMapped(false)) {
+    header_->head = header_->tail;
+    header_->index_head = header_->index_tail;
+    // With nothing left to keep in order, a clock that was wrong stops
+    // holding later times back.
+    header_->last_time_ms = 0;
+  }
+  Unlock();
+}
+
+size_t HistoryLog::capacity() const {
+  return header_ ? header_->data_capacity : 0;
+}
+
+uint64_t HistoryLog::Seek(int64_t from_ms, uint64_t after_sequence) const {
+  // Every record before the last index entry earlier than |from_ms|, or
+  // not after |after_sequence|, is outside the query.
+  uint64_t low = header_->index_head;
+  uint64_t high = header_->index_tail;
+  while (low < high) {
+    uint64_t middle = low + (high - low) / 2;
+    const IndexEntry& entry = index_[middle % header_->index_capacity];
+    if (entry.time_ms < from_ms || entry.sequence <= after_sequence) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if (low == header_->index_head) return header_->head;
+  uint64_t offset = index_[(low - 1) % header_->index_capacity].offset;
+  return std::max(offset, header_->head);
+}
+
+bool HistoryLog::ReadRecordHeader(uint64_t offset, RecordHeader* record) const {
+  uint64_t available = header_->tail - offset;
+  if (available < sizeof(RecordHeader)) return false;
+  CopyOut(offset, record, sizeof(RecordHeader));
+  size_t fields = size_t{record->id_length} + record->title_length + record->action_length;
+  return record->size % 8 == 0 && record->size <= available &&
+         record->size >= sizeof(RecordHeader) + fields;
+}
+
+void HistoryLog::CopyIn(uint64_t offset, const void* data, size_t length) {
+  size_t start = offset % header_->data_capacity;
+  size_t first = std::min<size_t>(length, header_->data_capacity - start);
+  memcpy(ring_ + start, data, first);
+  memcpy(ring_, static_cast<const uint8_t*>(data) + first, length - first);
+}
+
+void HistoryLog::CopyOut(uint64_t offset, void* data, size_t length) const {
+  size_t start = offset % header_->data_capacity;
+  size_t first = std::min<size_t>(length, header_->data_capacity - start);
+  memcpy(data, ring_ + start, first);
+  memcpy(static_cast<uint8_t*>(data) + first, ring_, length - first);
+}
+
+bool HistoryLog::EnsureMapped(bool initialize) {
+  if (header_ != nullptr) return true;
+
+  struct stat info;
+  if (fstat(fd_, &info) != 0) return false;
+  size_t bytes = static_cast<size_t>(info.st_size);
+  if (bytes >= sizeof(Header)) {
+    void* log = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (log != MAP_FAILED) {
+      Header* header = static_cast<Header*>(log);
+      bool valid =
+          memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 && header->version == kVersion &&
+          header->data_capacity >= kMinCapacity && header->data_capacity % 8 == 0 &&
+          header->index_capacity > 0 &&
+          bytes == sizeof(Header) + header->index_capacity * sizeof(IndexEntry) +
+                       header->data_capacity &&
+          header->head <= header->tail && header->tail - header->head <= header->data_capacity &&
+          header->index_head <= header->index_tail &&
+          header->index_tail - header->index_head <= header->index_capacity;
+      if (valid) {
+        header_ = header;
+        index_ = reinterpret_cast<IndexEntry*>(header + 1);
+        ring_ = reinterpret_cast<uint8_t*>(index_ + header->index_capacity);
+        mapped_bytes_ = bytes;
+        return true;
+      }
+      munmap(log, bytes);
+    }
+  }
+  if (!initialize) return false;
+
+  // Missing, or not a log this version understands: start afresh. The
+  // lock is held exclusively, so no other process is using the file.
+  uint32_t index_capacity = static_cast<uint32_t>(requested_capacity_ / kHistoryIndexSpacing + 2);
+  bytes = sizeof(Header) + index_capacity * sizeof(IndexEntry) + requested_capacity_;
+  void* log = MAP_FAILED;
+  if (ftruncate(fd_, 0) == 0 && ftruncate(fd_, bytes) == 0) {
+    log = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  }
+  if (log == MAP_FAILED) {
+    g_warning("Failed to create %s: %s", path_.c_str(), g_strerror(errno));
+    return false;
+  }
+  // ftruncate() zeroed the file, which leaves the log empty.
+  header_ = static_cast<Header*>(log);
+  memcpy(header_->magic, kMagic, sizeof(kMagic));
+  header_->version = kVersion;
+  header_->data_capacity = requested_capacity_;
+  header_->index_capacity = index_capacity;
+  header_->next_sequence = 1;
+  index_ = reinterpret_cast<IndexEntry*>(header_ + 1);
+  ring_ = reinterpret_cast<uint8_t*>(index_ + index_capacity);
+  mapped_bytes_ = bytes;
+  return true;
+}
+
+void HistoryLog::Unmap() {
+  if (header_ == nullptr) return;
+  munmap(header_, mapped_bytes_);
+  header_ = nullptr;
+  index_ = nullptr;
+  ring_ = nullptr;
+  mapped_bytes_ = 0;
+}
+
+bool HistoryLog::Lock(int operation, bool create) {
+  if (fd_ < 0) {
+    if (create) {
+      g_autofree gchar* dir = g_path_get_dirname(path_.c_str());
+      g_mkdir_with_parents(dir, 0755);
+    }
+    fd_ = g_open(path_.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0644);
+    if (fd_ < 0) {
+      if (create) g_warning("Failed to open %s: %s", path_.c_str(), g_strerror(errno));
+      return false;
+    }
+  }
+  while (flock(fd_, operation) != 0) {
+    if (errno != EINTR) return false;
+  }
+  return true;
+}
+
+void HistoryLog::Unlock() {
+  flock(fd_, LOCK_UN);
+}
+
+}  // namespace notification_manager
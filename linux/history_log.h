@@ -0,0 +1,125 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_HISTORY_LOG_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_HISTORY_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace notification_manager {
+
+// Bytes of records a new history log holds before the oldest are dropped.
+constexpr size_t kDefaultHistoryCapacity = 1024 * 1024;
+
+enum class HistoryKind : uint8_t {
+  kShown = 1,
+  kAction = 2,
+  kClosed = 3,
+};
+
+struct HistoryRecord {
+  // Increases by one with every record, across every process.
+  uint64_t sequence = 0;
+  // Milliseconds since the Unix epoch.
+  int64_t time_ms = 0;
+  HistoryKind kind = HistoryKind::kShown;
+  std::string id;
+  std::string title;
+  // The action invoked, for kAction records.
+  std::string action;
+};
+
+// What was shown, acted on and closed, shared by every process that opens
+// the same file.
+//
+// The log is a ring of variable-length records in a memory-mapped file of
+// fixed size. Appending copies a record to the tail and, once the ring is
+// full, drops whole records from the head to make room, so the file is
+// never rewritten or grown. Every kilobyte or so, a record also gets an
+// entry in a sparse index of (time, sequence, offset), which lets a range
+// query binary-search to within a few records of its start and then read
+// only what it returns.
+//
+// Times never go backwards in the log: a record appended after the wall
+// clock was set back takes the time of the record before it, which keeps
+// the index sorted. Writers hold an exclusive flock() on the file and
+// readers a shared one. Nothing is mapped until the first access, and the
+// file is not created until the first append.
+class HistoryLog {
+ public:
+  // |capacity| is only used when creating the file; an existing log keeps
+  // its size.
+  explicit HistoryLog(std::string path, size_t capacity = kDefaultHistoryCapacity);
+  ~HistoryLog();
+
+  // Disallow copy and assign.
+  HistoryLog(const HistoryLog&) = delete;
+  HistoryLog& operator=(const HistoryLog&) = delete;
+
+  // Appends a record, dropping the oldest ones if there is no room. Strings
+  // longer than a kilobyte are cut short. Returns false if the log cannot
+  // be written.
+  bool Append(HistoryKind kind,
+              int64_t time_ms,
+              const std::string& id,
+              const std::string& title,
+              const std::string& action);
+
+  // Appends to |out| up to |limit| records from [from_ms, to_ms), oldest
+  // first, skipping those up to and including |after_sequence|. Returns
+  // true if more records in the range follow the last one appended.
+  bool Query(int64_t from_ms,
+             int64_t to_ms,
+             uint64_t after_sequence,
+             size_t limit,
+             std::vector<HistoryRecord>* out);
+
+  // Drops every record, in every process. Sequence numbers carry on.
+  void Clear();
+
+  const std::string& path() const { return path_; }
+
+  // Bytes of records the mapped log holds, or zero if none is mapped.
+  size_t capacity() const;
+
+ private:
+  struct Header;
+  struct IndexEntry;
+  struct RecordHeader;
+
+  // Opens the file, creating it with |create|, and takes the lock with
+  // flock(). Returns false if there is no file or it cannot be locked.
+  bool Lock(int operation, bool create);
+  void Unlock();
+
+  // Maps the locked file. With |initialize|, which needs the lock held
+  // exclusively, a file that is empty or not a log this version
+  // understands is replaced with an empty log.
+  bool EnsureMapped(bool initialize);
+  void Unmap();
+
+  // Copies between the ring and memory at logical |offset|, wrapping
+  // around its end.
+  void CopyIn(uint64_t offset, const void* data, size_t length);
+  void CopyOut(uint64_t offset, void* data, size_t length) const;
+
+  // Reads the record header at |offset|, or returns false if it does not
+  // fit between |offset| and the tail.
+  bool ReadRecordHeader(uint64_t offset, RecordHeader* record) const;
+
+  // Offset of the record to start a query for [from_ms, ...) after
+  // |after_sequence| at.
+  uint64_t Seek(int64_t from_ms, uint64_t after_sequence) const;
+
+  std::string path_;
+  size_t requested_capacity_;
+  int fd_ = -1;
+  Header* header_ = nullptr;
+  IndexEntry* index_ = nullptr;
+  uint8_t* ring_ = nullptr;
+  size_t mapped_bytes_ = 0;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_HISTORY_LOG_H_
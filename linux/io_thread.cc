@@ -0,0 +1,395 @@
+#include "io_thread.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+namespace notification_manager {
+
+namespace {
+
+gboolean run_done_cb(gpointer user_data) {
+  (*static_cast<IoThread::Task*>(user_data))();
+  return G_SOURCE_REMOVE;
+}
+
+void delete_task(gpointer user_data) {
+  delete static_cast<IoThread::Task*>(user_data);
+}
+
+std::string temp_path(const std::string& path) {
+  return path + ".tmp";
+}
+
+// Writes |contents| to the temporary file next to |path|, syncing it if
+// asked. A temporary file left by a crash is simply overwritten.
+bool write_temp(const std::string& path, const std::string& contents, bool sync) {
+  g_autofree gchar* dir = g_path_get_dirname(path.c_str());
+  g_mkdir_with_parents(dir, 0755);
+
+  std::string temp = temp_path(path);
+  int fd = g_open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    g_warning("Failed to open %s: %s", temp.c_str(), g_strerror(errno));
+    return false;
+  }
+  const char* data = contents.data();
+  size_t remaining = contents.size();
+  bool ok = true;
+  while (remaining > 0) {
+    ssize_t written = write(fd, data, remaining);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      ok = false;
+      break;
+    }
+    data += written;
+    remaining -= written;
+  }
+  if (ok && sync) ok = g_fsync(fd) == 0;
+  if (!ok) g_warning("Failed to write %s: %s", temp.c_str(), g_strerror(errno));
+  ok = g_close(fd, nullptr) && ok;
+  if (!ok) g_remove(temp.c_str());
+  return ok;
+}
+
+bool rename_temp(const std::string& path) {
+  if (g_rename(temp_path(path).c_str(), path.c_str()) != 0) {
+    g_warning("Failed to replace %s: %s", path.c_str(), g_strerror(errno));
+    g_remove(temp_path(path).c_str());
+    return false;
+  }
+  return true;
+}
+
+// Makes the renames into |dir| durable.
+void sync_dir(const std::string& dir) {
+  int fd = g_open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0);
+  if (fd < 0) return;
+  g_fsync(fd);
+  g_close(fd, nullptr);
+}
+
+std::string dir_of(const std::string& path) {
+  g_autofree gchar* dir = g_path_get_dirname(path.c_str());
+  return dir;
+}
+
+}  // namespace
+
+bool ReplaceFile(const std::string& path, const std::string& contents, bool sync) {
+  if (!write_temp(path, contents, sync) || !rename_temp(path)) return false;
+  if (sync) sync_dir(dir_of(path));
+  return true;
+}
+
+IoThread::IoThread(GMainContext* main_context)
+    : main_context_(main_context ? g_main_context_ref(main_context)
+                                 : g_main_context_ref_thread_default()),
+      head_(&stub_),
+      tail_(&stub_) {
+  g_mutex_init(&sleep_mutex_);
+  g_cond_init(&wake_cond_);
+  g_mutex_init(&writes_mutex_);
+}
+
+IoThread::~IoThread() {
+  if (thread_ != nullptr) {
+    Node* stop = new Node;
+    stop->kind = Kind::kStop;
+    Push(stop);
+    g_thread_join(thread_);
+  }
+  g_mutex_clear(&writes_mutex_);
+  g_cond_clear(&wake_cond_);
+  g_mutex_clear(&sleep_mutex_);
+  g_main_context_unref(main_context_);
+}
+
+void IoThread::Post(Task task, Task done) {
+  Node* node = new Node;
+  node->task = std::move(task);
+  node->done = std::move(done);
+  Post(node);
+}
+
+void IoThread::Post(Node* node) {
+  if (g_once_init_enter(&started_)) {
+    thread_ = g_thread_new("notification_io", ThreadMain, this);
+    g_once_init_leave(&started_, 1);
+  }
+
+  posted_.fetch_add(1, std::memory_order_relaxed);
+  Push(node);
+}
+
+void IoThread::PostReplaceFile(const std::string& path,
+                               std::string contents,
+                               Durability durability,
+                               Task done) {
+  Node* node = new Node;
+  node->kind = Kind::kWrite;
+  node->done = std::move(done);
+  node->path = path;
+  node->contents = std::move(contents);
+  node->durability = durability;
+  g_mutex_lock(&writes_mutex_);
+  node->generation = ++write_generation_;
+  latest_writes_[path] = node->generation;
+  g_mutex_unlock(&writes_mutex_);
+  Post(node);
+}
+
+void IoThread::PostRemoveFile(const std::string& path, Task done) {
+  Node* node = new Node;
+  node->kind = Kind::kRemove;
+  node->done = std::move(done);
+  node->path = path;
+  // Any write still queued is moot once the file is gone.
+  g_mutex_lock(&writes_mutex_);
+  latest_writes_[path] = ++write_generation_;
+  g_mutex_unlock(&writes_mutex_);
+  Post(node);
+}
+
+void IoThread::Flush() {
+  if (posted() == 0) return;
+
+  struct Barrier {
+    GMutex mutex;
+    GCond cond;
+    bool reached = false;
+  } barrier;
+  g_mutex_init(&barrier.mutex);
+  g_cond_init(&barrier.cond);
+
+  Post([&barrier]() {
+    g_mutex_lock(&barrier.mutex);
+    barrier.reached = true;
+    g_cond_signal(&barrier.cond);
+    g_mutex_unlock(&barrier.mutex);
+  });
+
+  g_mutex_lock(&barrier.mutex);
+  while (!barrier.reached) g_cond_wait(&barrier.cond, &barrier.mutex);
+  g_mutex_unlock(&barrier.mutex);
+  g_cond_clear(&barrier.cond);
+  g_mutex_clear(&barrier.mutex);
+}
+
+void IoThread::Push(Node* node) {
+  // Count the node before it is linked in, so the consumer never sleeps
+  // while a push is under way.
+  if (pending_.fetch_add(1) == 0) {
+    g_mutex_lock(&sleep_mutex_);
+    g_cond_signal(&wake_cond_);
+    g_mutex_unlock(&sleep_mutex_);
+  }
+  node->next.store(nullptr, std::memory_order_relaxed);
+  Node* previous = head_.exchange(node, std::memory_order_acq_rel);
+  previous->next.store(node, std::memory_order_release);
+}
+
+IoThread::Node* IoThread::Pop() {
+  Node* tail = tail_;
+  Node* next = tail->next.load(std::memory_order_acquire);
+  if (tail == &stub_) {
+    if (next == nullptr) return nullptr;
+    tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next != nullptr) {
+    tail_ = next;
+    return tail;
+  }
+  // |tail| is the last node linked in. Unless a push is half done, put the
+  // stub back behind it so it can be taken.
+  if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+  stub_.next.store(nullptr, std::memory_order_relaxed);
+  Node* previous = head_.exchange(&stub_, std::memory_order_acq_rel);
+  previous->next.store(&stub_, std::memory_order_release);
+  next = tail->next.load(std::memory_order_acquire);
+  if (next != nullptr) {
+    tail_ = next;
+    return tail;
+  }
+  return nullptr;
+}
+
+void IoThread::Run() {
+  while (true) {
+    if (!batch_.empty() && g_get_monotonic_time() >= batch_deadline_us_) CommitBatch();
+
+    Node* node = Pop();
+    if (node == nullptr) {
+      if (pending_.load() == 0) {
+        g_mutex_lock(&sleep_mutex_);
+        while (pending_.load() == 0) {
+          if (batch_.empty()) {
+            g_cond_wait(&wake_cond_, &sleep_mutex_);
+          } else if (!g_cond_wait_until(&wake_cond_, &sleep_mutex_, batch_deadline_us_)) {
+            break;
+          }
+        }
+        g_mutex_unlock(&sleep_mutex_);
+      } else {
+        // A producer has counted its node but not linked it in yet.
+        g_thread_yield();
+      }
+      continue;
+    }
+
+    pending_.fetch_sub(1);
+    switch (node->kind) {
+      case Kind::kStop:
+        CommitBatch();
+        delete node;
+        return;
+      case Kind::kWrite:
+        RunWrite(node);
+        break;
+      case Kind::kRemove:
+        CommitBatch();
+        g_remove(node->path.c_str());
+        completed_.fetch_add(1, std::memory_order_release);
+        CompleteWrites(node->path, node->done);
+        break;
+      case Kind::kTask:
+        if (!node->task && !batch_.empty()) {
+          // A barrier is reached once the batch it follows is committed.
+          batch_nodes_++;
+          if (node->done) batch_barriers_.push_back(std::move(node->done));
+          break;
+        }
+        CommitBatch();
+        if (node->task) node->task();
+        completed_.fetch_add(1, std::memory_order_release);
+        if (node->done) Complete(std::move(node->done));
+        break;
+    }
+    delete node;
+  }
+}
+
+void IoThread::RunWrite(Node* node) {
+  g_mutex_lock(&writes_mutex_);
+  bool superseded = latest_writes_[node->path] != node->generation;
+  g_mutex_unlock(&writes_mutex_);
+  if (superseded) {
+    // The later write carries these contents too, so it owes them this
+    // write's durability, and reports for both.
+    auto owed = owed_.emplace(node->path, node->durability).first;
+    owed->second = std::max(owed->second, node->durability);
+    skipped_writes_.fetch_add(1, std::memory_order_relaxed);
+    completed_.fetch_add(1, std::memory_order_release);
+    if (node->done) Complete(std::move(node->done));
+    return;
+  }
+
+  Durability durability = node->durability;
+  auto owed = owed_.find(node->path);
+  if (owed != owed_.end()) durability = std::max(durability, owed->second);
+  auto batched = batch_.find(node->path);
+  if (durability == Durability::kNone && batched == batch_.end()) {
+    ReplaceFile(node->path, node->contents, false);
+    completed_.fetch_add(1, std::memory_order_release);
+    CompleteWrites(node->path, node->done);
+    return;
+  }
+
+  // Joins the open batch, replacing an earlier write to the same path
+  // whose callers are still owed a sync.
+  if (batch_.empty()) {
+    batch_deadline_us_ =
+        g_get_monotonic_time() + commit_window_us_.load(std::memory_order_relaxed);
+  }
+  if (batched != batch_.end()) {
+    skipped_writes_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    batched = batch_.emplace(node->path, BatchedWrite()).first;
+  }
+  BatchedWrite& write = batched->second;
+  write.contents = std::move(node->contents);
+  write.sync = write.sync || durability != Durability::kNone;
+  if (node->done) write.done.push_back(std::move(node->done));
+  batch_nodes_++;
+
+  if (durability == Durability::kImmediate) CommitBatch();
+}
+
+void IoThread::CommitBatch() {
+  if (batch_.empty()) return;
+
+  // Every file is written and synced before any is renamed, then each
+  // directory is synced once for all the renames into it.
+  std::set<std::string> written;
+  std::set<std::string> dirs;
+  for (auto& entry : batch_) {
+    if (write_temp(entry.first, entry.second.contents, entry.second.sync)) {
+      written.insert(entry.first);
+    }
+  }
+  for (auto& entry : batch_) {
+    if (written.count(entry.first) > 0 && rename_temp(entry.first) && entry.second.sync) {
+      dirs.insert(dir_of(entry.first));
+    }
+  }
+  for (const auto& dir : dirs) sync_dir(dir);
+  commits_.fetch_add(1, std::memory_order_relaxed);
+
+  std::map<std::string, BatchedWrite> batch;
+  batch.swap(batch_);
+  std::vector<Task> barriers;
+  barriers.swap(batch_barriers_);
+  completed_.fetch_add(batch_nodes_, std::memory_order_release);
+  batch_nodes_ = 0;
+  for (auto& entry : batch) {
+    std::vector<Task> done;
+    done.swap(entry.second.done);
+    Task report = nullptr;
+    if (!done.empty()) {
+      report = [done]() {
+        for (const auto& task : done) task();
+      };
+    }
+    CompleteWrites(entry.first, report);
+  }
+  for (auto& barrier : barriers) Complete(std::move(barrier));
+}
+
+void IoThread::CompleteWrites(const std::string& path, const Task& done) {
+  owed_.erase(path);
+  if (owed_.empty()) {
+    std::vector<Task> held;
+    held.swap(held_done_);
+    for (auto& task : held) Complete(std::move(task));
+  }
+  if (done) Complete(done);
+}
+
+gpointer IoThread::ThreadMain(gpointer data) {
+  static_cast<IoThread*>(data)->Run();
+  return nullptr;
+}
+
+void IoThread::Complete(Task done) {
+  if (!owed_.empty()) {
+    held_done_.push_back(std::move(done));
+    return;
+  }
+  // Always through a source, never g_main_context_invoke(), which would
+  // run |done| right here if no one owned the main context.
+  GSource* source = g_idle_source_new();
+  g_source_set_priority(source, G_PRIORITY_DEFAULT);
+  g_source_set_callback(source, run_done_cb, new Task(std::move(done)), delete_task);
+  g_source_attach(source, main_context_);
+  g_source_unref(source);
+}
+
+}  // namespace notification_manager
@@ -0,0 +1,188 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_IO_THREAD_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_IO_THREAD_H_
+
+#include <glib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace notification_manager {
+
+// How far a write has to get before it is reported as done.
+enum class Durability {
+  // Renamed into place without waiting for the disk. A crash may lose the
+  // write, but never leaves a partial file behind.
+  kNone,
+  // Synced to disk along with every other write made within the commit
+  // window, so a burst of changes costs one sync per file.
+  kBatched,
+  // Synced to disk straight away, together with any batch still open.
+  kImmediate,
+};
+
+// Replaces |path| with |contents|, creating its directory if needed. The
+// contents go to a temporary file that is renamed over |path|, so readers
+// and crashes never see a partial write. With |sync|, both the file and
+// the rename are on disk before this returns.
+bool ReplaceFile(const std::string& path, const std::string& contents, bool sync = true);
+
+// A single thread that does the plugin's file writes, so a slow disk or
+// NFS home never stalls the main loop.
+//
+// Tasks may be posted from any thread onto a lock-free queue and run one
+// at a time in the order posted. The thread is started by the first Post()
+// and sleeps whenever the queue is empty. Destroying the IoThread runs
+// every task already posted before it returns.
+//
+// Batched writes are group committed: the first one opens a batch, and
+// every write made within the commit window joins it. The batch is then
+// written to temporary files, synced once per file and renamed into place.
+// Any other task, and any immediate write, commits the open batch first.
+class IoThread {
+ public:
+  using Task = std::function<void()>;
+
+  static constexpr gint64 kDefaultCommitWindowUs = 10 * G_TIME_SPAN_MILLISECOND;
+
+  // Completion callbacks run on |main_context|, or on the thread-default
+  // context of the caller when it is nullptr.
+  explicit IoThread(GMainContext* main_context = nullptr);
+  ~IoThread();
+
+  // Disallow copy and assign.
+  IoThread(const IoThread&) = delete;
+  IoThread& operator=(const IoThread&) = delete;
+
+  // Queues |task| to run on the I/O thread after every task posted before
+  // it. If |done| is given, it is called on the main context once |task|
+  // has run. Either may be empty; an empty |task| with a |done| is a
+  // barrier that reports when everything posted earlier has run, and
+  // joins the open batch rather than committing it.
+  void Post(Task task, Task done = nullptr);
+
+  // Queues a write of |contents| to |path|, reported through |done| once
+  // it is as durable as |durability| asks. A write still waiting when a
+  // later one to the same path is posted is skipped, so a burst of
+  // changes costs one write. The later write is then made at least as
+  // durable as the skipped one, and until it has landed no completion
+  // runs, so none reports ahead of the skipped contents.
+  void PostReplaceFile(const std::string& path,
+                       std::string contents,
+                       Durability durability = Durability::kBatched,
+                       Task done = nullptr);
+
+  // Queues the removal of |path|, after any write to it already posted.
+  void PostRemoveFile(const std::string& path, Task done = nullptr);
+
+  // Blocks until every task posted so far has run, committing the open
+  // batch. Completion callbacks are not waited for.
+  void Flush();
+
+  // How long a batch stays open for more writes. Takes effect from the
+  // next batch.
+  void set_commit_window_us(gint64 window_us) {
+    commit_window_us_.store(window_us, std::memory_order_relaxed);
+  }
+
+  // Tasks posted so far, for telling whether a call queued any work.
+  uint64_t posted() const { return posted_.load(std::memory_order_relaxed); }
+
+  // Whether every task posted so far has run.
+  bool idle() const {
+    return completed_.load(std::memory_order_acquire) == posted_.load(std::memory_order_relaxed);
+  }
+
+  // Writes skipped because a later write to the same path superseded them.
+  uint64_t skipped_writes() const { return skipped_writes_.load(std::memory_order_relaxed); }
+
+  // Batches committed so far.
+  uint64_t commits() const { return commits_.load(std::memory_order_relaxed); }
+
+ private:
+  enum class Kind { kTask, kWrite, kRemove, kStop };
+
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    Kind kind = Kind::kTask;
+    Task task;
+    Task done;
+    // For kWrite and kRemove.
+    std::string path;
+    std::string contents;
+    Durability durability = Durability::kBatched;
+    uint64_t generation = 0;
+  };
+
+  // The latest contents for one path in the open batch.
+  struct BatchedWrite {
+    std::string contents;
+    bool sync = false;
+    std::vector<Task> done;
+  };
+
+  void Post(Node* node);
+  void Push(Node* node);
+  // Takes the oldest node, or returns nullptr if none is ready. Only the
+  // I/O thread calls this.
+  Node* Pop();
+  void Run();
+  static gpointer ThreadMain(gpointer data);
+  void RunWrite(Node* node);
+  // Writes out the open batch, if any, and reports everything in it.
+  void CommitBatch();
+  void Complete(Task done);
+  // Reports a write or removal of |path|, which settles what the writes to
+  // it that were skipped in its favour are owed.
+  void CompleteWrites(const std::string& path, const Task& done);
+
+  GMainContext* main_context_;
+  // Set once the thread has been started.
+  gsize started_ = 0;
+  GThread* thread_ = nullptr;
+
+  // Intrusive multi-producer, single-consumer queue: producers swap
+  // themselves in at head_, and the consumer follows next links from
+  // tail_. stub_ keeps the list non-empty.
+  std::atomic<Node*> head_;
+  Node* tail_;
+  Node stub_;
+
+  // Nodes posted but not yet taken. The I/O thread only sleeps when this
+  // is zero, and a producer that raises it from zero wakes it.
+  std::atomic<uint64_t> pending_{0};
+  std::atomic<uint64_t> posted_{0};
+  std::atomic<uint64_t> completed_{0};
+  std::atomic<uint64_t> skipped_writes_{0};
+  std::atomic<uint64_t> commits_{0};
+  std::atomic<gint64> commit_window_us_{kDefaultCommitWindowUs};
+  GMutex sleep_mutex_;
+  GCond wake_cond_;
+
+  // Latest write generation by path. Guarded by writes_mutex_, which is
+  // never held across I/O.
+  GMutex writes_mutex_;
+  std::map<std::string, uint64_t> latest_writes_;
+  uint64_t write_generation_ = 0;
+
+  // The strongest durability asked for by skipped writes whose contents a
+  // later write to the same path still has to land, and the completions
+  // held back, in order, until none is owed. Only the I/O thread touches
+  // these.
+  std::map<std::string, Durability> owed_;
+  std::vector<Task> held_done_;
+
+  // The open batch, by path, and the barriers and tasks waiting on it.
+  // Only the I/O thread touches these.
+  std::map<std::string, BatchedWrite> batch_;
+  std::vector<Task> batch_barriers_;
+  uint64_t batch_nodes_ = 0;
+  gint64 batch_deadline_us_ = 0;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_IO_THREAD_H_
@@ -0,0 +1,36 @@
+#include "method_args.h"
+
+namespace notification_manager {
+
+const char* fl_value_type_name(FlValueType type) {
+  switch (type) {
+    case FL_VALUE_TYPE_NULL:
+      return "null";
+    case FL_VALUE_TYPE_BOOL:
+      return "a bool";
+    case FL_VALUE_TYPE_INT:
+      return "an int";
+    case FL_VALUE_TYPE_FLOAT:
+      return "a double";
+    case FL_VALUE_TYPE_STRING:
+      return "a string";
+    case FL_VALUE_TYPE_LIST:
+      return "a list";
+    case FL_VALUE_TYPE_MAP:
+      return "a map";
+    default:
+      return "a typed list";
+  }
+}
+
+FlMethodResponse* arg_error_response(const ArgError& error) {
+  g_autoptr(FlValue) details = nullptr;
+  if (!error.key.empty()) {
+    details = fl_value_new_map();
+    fl_value_set_string_take(details, "key", fl_value_new_string(error.key.c_str()));
+  }
+  return FL_METHOD_RESPONSE(
+      fl_method_error_response_new("INVALID_ARGUMENTS", error.message.c_str(), details));
+}
+
+}  // namespace notification_manager
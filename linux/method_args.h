@@ -0,0 +1,183 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_METHOD_ARGS_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_METHOD_ARGS_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// Decodes method-call argument maps into plain C++ structs.
+//
+// A schema lists the keys a handler understands and the struct member each
+// one fills. Decode() walks the FlValue map once, checks every value's type
+// and reports the first problem with the offending key:
+//
+//   struct CancelArgs {
+//     std::string id;
+//   };
+//   static const ArgSchema<CancelArgs> kCancelSchema = {
+//       ArgSchema<CancelArgs>::Required("id", &CancelArgs::id),
+//   };
+//
+//   CancelArgs decoded;
+//   ArgError error;
+//   if (!kCancelSchema.Decode(args, &decoded, &error)) {
+//     return arg_error_response(error);
+//   }
+//
+// Optional keys that are absent or null leave the member at the default
+// given in the struct. Keys the schema does not know are ignored.
+
+namespace notification_manager {
+
+struct ArgError {
+  std::string key;
+  std::string message;
+};
+
+// Maps a member type to the FlValue type it is decoded from.
+template <typename T>
+struct ArgTraits;
+
+template <>
+struct ArgTraits<std::string> {
+  static FlValueType type() { return FL_VALUE_TYPE_STRING; }
+  static void Assign(FlValue* value, std::string* out) { *out = fl_value_get_string(value); }
+};
+
+template <>
+struct ArgTraits<int64_t> {
+  static FlValueType type() { return FL_VALUE_TYPE_INT; }
+  static void Assign(FlValue* value, int64_t* out) { *out = fl_value_get_int(value); }
+};
+
+template <>
+struct ArgTraits<bool> {
+  static FlValueType type() { return FL_VALUE_TYPE_BOOL; }
+  static void Assign(FlValue* value, bool* out) { *out = fl_value_get_bool(value); }
+};
+
+// Borrowed reference into the argument map, for nested lists and maps. The
+// expected container type is given when the field is declared.
+template <>
+struct ArgTraits<FlValue*> {
+  static FlValueType type() { return FL_VALUE_TYPE_NULL; }
+  static void Assign(FlValue* value, FlValue** out) { *out = value; }
+};
+
+const char* fl_value_type_name(FlValueType type);
+
+template <typename Args>
+class ArgSchema {
+ public:
+  struct Field {
+    const char* key;
+    bool required;
+    // FL_VALUE_TYPE_NULL accepts any type.
+    FlValueType type;
+    std::function<void(FlValue*, Args*)> assign;
+  };
+
+  template <typename T>
+  static Field Required(const char* key, T Args::*member,
+                        FlValueType type = ArgTraits<T>::type()) {
+    return MakeField(key, member, true, type);
+  }
+
+  template <typename T>
+  static Field Optional(const char* key, T Args::*member,
+                        FlValueType type = ArgTraits<T>::type()) {
+    return MakeField(key, member, false, type);
+  }
+
+  ArgSchema(std::initializer_list<Field> fields) : fields_(fields) {
+    g_assert(fields_.size() <= 64);
+    std::sort(fields_.begin(), fields_.end(), [](const Field& a, const Field& b) {
+      return strcmp(a.key, b.key) < 0;
+    });
+    for (size_t i = 0; i < fields_.size(); i++) {
+      if (fields_[i].required) required_mask_ |= uint64_t{1} << i;
+    }
+  }
+
+  // Fills |out| from |args|. Returns false and sets |error| if |args| is not
+  // a map, a required key is missing or a value has the wrong type.
+  bool Decode(FlValue* args, Args* out, ArgError* error) const {
+    if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+      error->key.clear();
+      error->message = "Arguments must be a map";
+      return false;
+    }
+
+    uint64_t seen = 0;
+    size_t length = fl_value_get_length(args);
+    for (size_t i = 0; i < length; i++) {
+      FlValue* key = fl_value_get_map_key(args, i);
+      if (fl_value_get_type(key) != FL_VALUE_TYPE_STRING) continue;
+
+      int index = Find(fl_value_get_string(key));
+      if (index < 0) continue;
+
+      const Field& field = fields_[index];
+      FlValue* value = fl_value_get_map_value(args, i);
+      FlValueType value_type = fl_value_get_type(value);
+      if (value_type == FL_VALUE_TYPE_NULL) continue;
+      if (field.type != FL_VALUE_TYPE_NULL && value_type != field.type) {
+        error->key = field.key;
+        error->message = std::string("Argument '") + field.key + "' must be " +
+                         fl_value_type_name(field.type) + ", got " +
+                         fl_value_type_name(value_type);
+        return false;
+      }
+      field.assign(value, out);
+      seen |= uint64_t{1} << index;
+    }
+
+    uint64_t missing = required_mask_ & ~seen;
+    if (missing != 0) {
+      const Field& field = fields_[__builtin_ctzll(missing)];
+      error->key = field.key;
+      error->message = std::string("Missing required argument '") + field.key + "'";
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  template <typename T>
+  static Field MakeField(const char* key, T Args::*member, bool required, FlValueType type) {
+    return Field{key, required, type,
+                 [member](FlValue* value, Args* out) { ArgTraits<T>::Assign(value, &(out->*member)); }};
+  }
+
+  int Find(const char* key) const {
+    size_t low = 0;
+    size_t high = fields_.size();
+    while (low < high) {
+      size_t mid = low + (high - low) / 2;
+      int order = strcmp(key, fields_[mid].key);
+      if (order == 0) return static_cast<int>(mid);
+      if (order < 0) {
+        high = mid;
+      } else {
+        low = mid + 1;
+      }
+    }
+    return -1;
+  }
+
+  std::vector<Field> fields_;
+  uint64_t required_mask_ = 0;
+};
+
+// Builds the error response handlers return when decoding fails.
+FlMethodResponse* arg_error_response(const ArgError& error);
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_METHOD_ARGS_H_
@@ -0,0 +1,228 @@
+#include "notification_backend.h"
+
+#define NOTIFICATION_ID_KEY "notification-manager-id"
+
+#define NOTIFICATIONS_BUS_NAME "org.freedesktop.Notifications"
+#define NOTIFICATIONS_OBJECT_PATH "/org/freedesktop/Notifications"
+#define NOTIFICATIONS_INTERFACE "org.freedesktop.Notifications"
+
+namespace notification_manager {
+
+LibnotifyBackend::~LibnotifyBackend() {
+  for (auto& pair : notifications_) {
+    g_signal_handlers_disconnect_by_data(pair.second, this);
+    g_object_unref(pair.second);
+  }
+  g_clear_object(&connection_);
+}
+
+void LibnotifyBackend::Initialize() {
+  if (notify_is_initted()) return;
+
+  gint64 start = g_get_monotonic_time();
+  notify_init("notification_manager");
+  init_time_us_ = g_get_monotonic_time() - start;
+  g_debug("notify_init took %" G_GINT64_FORMAT " us", init_time_us_);
+}
+
+bool LibnotifyBackend::Show(const std::string& id, const NotificationContent& content) {
+  Initialize();
+
+  auto it = notifications_.find(id);
+  if (it != notifications_.end()) {
+    return Update(id, content);
+  }
+
+  NotifyNotification* notification =
+      notify_notification_new(content.title.c_str(), content.body.c_str(), nullptr);
+  // The id travels with the object so signal handlers find it without a scan.
+  g_object_set_data_full(G_OBJECT(notification), NOTIFICATION_ID_KEY, g_strdup(id.c_str()),
+                         g_free);
+  SetActions(notification, content);
+  g_signal_connect(notification, "closed", G_CALLBACK(OnClosed), this);
+
+  GError* error = nullptr;
+  gboolean success = notify_notification_show(notification, &error);
+  if (error) {
+    g_error_free(error);
+    success = FALSE;
+  }
+  if (!success) {
+    g_signal_handlers_disconnect_by_data(notification, this);
+    g_object_unref(notification);
+    return false;
+  }
+
+  notifications_[id] = notification;
+  return true;
+}
+
+bool LibnotifyBackend::Update(const std::string& id, const NotificationContent& content) {
+  auto it = notifications_.find(id);
+  if (it == notifications_.end()) {
+    return Show(id, content);
+  }
+
+  NotifyNotification* notification = it->second;
+  notify_notification_update(notification, content.title.c_str(), content.body.c_str(), nullptr);
+  notify_notification_clear_actions(notification);
+  SetActions(notification, content);
+
+  GError* error = nullptr;
+  gboolean success = notify_notification_show(notification, &error);
+  if (error) {
+    g_error_free(error);
+    return false;
+  }
+  return success;
+}
+
+void LibnotifyBackend::Close(const std::string& id) {
+  auto it = notifications_.find(id);
+  if (it == notifications_.end()) return;
+
+  notify_notification_close(it->second, nullptr);
+  g_object_unref(Forget(id));
+}
+
+static void on_close_notification_reply(GObject* source, GAsyncResult* result,
+                                        gpointer user_data) {
+  GError* error = nullptr;
+  GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+  if (reply) {
+    g_variant_unref(reply);
+  } else {
+    g_debug("CloseNotification failed: %s", error->message);
+    g_error_free(error);
+  }
+}
+
+void LibnotifyBackend::CloseMany(const std::vector<std::string>& ids) {
+  if (connection_ == nullptr) {
+    GError* error = nullptr;
+    connection_ = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, &error);
+    if (connection_ == nullptr) {
+      g_warning("Failed to connect to the session bus: %s", error->message);
+      g_error_free(error);
+      NotificationBackend::CloseMany(ids);
+      return;
+    }
+  }
+
+  // notify_notification_close() waits for each reply in turn. Queuing the
+  // calls instead sends them back to back, so closing k notifications costs
+  // one round trip rather than k.
+  for (const std::string& id : ids) {
+    NotifyNotification* notification = Forget(id);
+    if (notification == nullptr) continue;
+    gint daemon_id = 0;
+    g_object_get(notification, "id", &daemon_id, nullptr);
+    g_object_unref(notification);
+    if (daemon_id <= 0) continue;
+
+    g_dbus_connection_call(connection_, NOTIFICATIONS_BUS_NAME, NOTIFICATIONS_OBJECT_PATH,
+                           NOTIFICATIONS_INTERFACE, "CloseNotification",
+                           g_variant_new("(u)", static_cast<guint32>(daemon_id)), nullptr,
+                           G_DBUS_CALL_FLAGS_NONE, -1, nullptr, on_close_notification_reply,
+                           nullptr);
+  }
+}
+
+std::vector<std::string> LibnotifyBackend::GetCapabilities() {
+  Initialize();
+
+  std::vector<std::string> capabilities;
+  GList* caps = notify_get_server_caps();
+  for (GList* iter = caps; iter != nullptr; iter = iter->next) {
+    capabilities.push_back(static_cast<const char*>(iter->data));
+  }
+  g_list_free_full(caps, g_free);
+  return capabilities;
+}
+
+void LibnotifyBackend::SetActions(NotifyNotification* notification,
+                                  const NotificationContent& content) {
+  for (const auto& action : content.actions) {
+    notify_notification_add_action(notification, action.first.c_str(), action.second.c_str(),
+                                   OnAction, this, nullptr);
+  }
+}
+
+NotifyNotification* LibnotifyBackend::Forget(const std::string& id) {
+  auto it = notifications_.find(id);
+  if (it == notifications_.end()) return nullptr;
+
+  NotifyNotification* notification = it->second;
+  g_signal_handlers_disconnect_by_data(notification, this);
+  notifications_.erase(it);
+  return notification;
+}
+
+static gboolean unref_notification_idle(gpointer user_data) {
+  g_object_unref(user_data);
+  return G_SOURCE_REMOVE;
+}
+
+// static
+void LibnotifyBackend::OnAction(NotifyNotification* notification, char* action,
+                                gpointer user_data) {
+  LibnotifyBackend* self = static_cast<LibnotifyBackend*>(user_data);
+  const char* id =
+      static_cast<const char*>(g_object_get_data(G_OBJECT(notification), NOTIFICATION_ID_KEY));
+  if (id) {
+    self->DeliverActionInvoked(id, action);
+  }
+}
+
+// static
+void LibnotifyBackend::OnClosed(NotifyNotification* notification, gpointer user_data) {
+  LibnotifyBackend* self = static_cast<LibnotifyBackend*>(user_data);
+  const char* id =
+      static_cast<const char*>(g_object_get_data(G_OBJECT(notification), NOTIFICATION_ID_KEY));
+  if (!id) return;
+
+  // The notification is still mid-emission, so drop our reference later.
+  std::string notification_id = id;
+  NotifyNotification* forgotten = self->Forget(notification_id);
+  if (forgotten) {
+    g_idle_add(unref_notification_idle, forgotten);
+  }
+  self->DeliverClosed(notification_id);
+}
+
+bool RecordingBackend::Show(const std::string& id, const NotificationContent& content) {
+  calls_.push_back({CallType::kShow, id, content});
+  if (fail_) return false;
+  open_.insert(id);
+  return true;
+}
+
+bool RecordingBackend::Update(const std::string& id, const NotificationContent& content) {
+  calls_.push_back({CallType::kUpdate, id, content});
+  if (fail_) return false;
+  open_.insert(id);
+  return true;
+}
+
+void RecordingBackend::Close(const std::string& id) {
+  calls_.push_back({CallType::kClose, id, {}});
+  open_.erase(id);
+}
+
+void RecordingBackend::CloseMany(const std::vector<std::string>& ids) {
+  close_batches_++;
+  for (const std::string& id : ids) {
+    calls_.push_back({CallType::kClose, id, {}});
+    open_.erase(id);
+  }
+}
+
+size_t RecordingBackend::CountCalls(CallType type) const {
+  size_t count = 0;
+  for (const auto& call : calls_) {
+    if (call.type == type) count++;
+  }
+  return count;
+}
+
+}  // namespace notification_manager
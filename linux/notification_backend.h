@@ -0,0 +1,175 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_NOTIFICATION_BACKEND_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_NOTIFICATION_BACKEND_H_
+
+#include <gio/gio.h>
+#include <libnotify/notify.h>
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace notification_manager {
+
+// What a backend needs to put a notification on screen.
+struct NotificationContent {
+  std::string title;
+  std::string body;
+  // Action buttons as (action id, label) pairs.
+  std::vector<std::pair<std::string, std::string>> actions;
+  // Not sent to the daemon; the plugin looks active notifications up by
+  // them.
+  std::string category;
+  std::string group;
+};
+
+// Everything the plugin needs from a notification daemon. Notifications are
+// addressed by the plugin's string ids; mapping them to daemon handles is the
+// backend's job.
+class NotificationBackend {
+ public:
+  // Called when the user activates an action on notification |id|.
+  using ActionCallback = std::function<void(const std::string& id, const std::string& action_id)>;
+  // Called when notification |id| is closed by the daemon or the user.
+  using ClosedCallback = std::function<void(const std::string& id)>;
+
+  NotificationBackend() = default;
+  virtual ~NotificationBackend() = default;
+
+  // Disallow copy and assign.
+  NotificationBackend(const NotificationBackend&) = delete;
+  NotificationBackend& operator=(const NotificationBackend&) = delete;
+
+  // Connects to the daemon. Backends do this lazily on first use; calling it
+  // earlier moves that cost out of the first Show.
+  virtual void Initialize() {}
+
+  // Shows a new notification. Returns false if the daemon rejected it.
+  virtual bool Show(const std::string& id, const NotificationContent& content) = 0;
+
+  // Replaces the content of the already shown notification |id|.
+  virtual bool Update(const std::string& id, const NotificationContent& content) = 0;
+
+  // Closes notification |id|. Closing an unknown id is a no-op.
+  virtual void Close(const std::string& id) = 0;
+
+  // Closes every notification in |ids| as one batch. Backends that can
+  // should send the requests without waiting for each reply.
+  virtual void CloseMany(const std::vector<std::string>& ids) {
+    for (const std::string& id : ids) Close(id);
+  }
+
+  // Returns the daemon's capability strings, e.g. "actions" or "body-markup".
+  virtual std::vector<std::string> GetCapabilities() = 0;
+
+  void set_action_callback(ActionCallback callback) { action_callback_ = std::move(callback); }
+  void set_closed_callback(ClosedCallback callback) { closed_callback_ = std::move(callback); }
+
+  // Wall time spent connecting to the daemon, in microseconds. Zero until
+  // the backend has been initialized.
+  gint64 init_time_us() const { return init_time_us_; }
+
+ protected:
+  gint64 init_time_us_ = 0;
+
+  void DeliverActionInvoked(const std::string& id, const std::string& action_id) {
+    if (action_callback_) action_callback_(id, action_id);
+  }
+
+  void DeliverClosed(const std::string& id) {
+    if (closed_callback_) closed_callback_(id);
+  }
+
+ private:
+  ActionCallback action_callback_;
+  ClosedCallback closed_callback_;
+};
+
+// Talks to org.freedesktop.Notifications through libnotify.
+class LibnotifyBackend : public NotificationBackend {
+ public:
+  LibnotifyBackend() = default;
+  ~LibnotifyBackend() override;
+
+  void Initialize() override;
+  bool Show(const std::string& id, const NotificationContent& content) override;
+  bool Update(const std::string& id, const NotificationContent& content) override;
+  void Close(const std::string& id) override;
+  void CloseMany(const std::vector<std::string>& ids) override;
+  std::vector<std::string> GetCapabilities() override;
+
+ private:
+  static void OnAction(NotifyNotification* notification, char* action, gpointer user_data);
+  static void OnClosed(NotifyNotification* notification, gpointer user_data);
+
+  void SetActions(NotifyNotification* notification, const NotificationContent& content);
+  // Stops tracking |id| and returns the caller-owned notification, or
+  // nullptr if it was not shown.
+  NotifyNotification* Forget(const std::string& id);
+
+  std::map<std::string, NotifyNotification*> notifications_;
+  // The session bus, for batched closes. libnotify shares the same one.
+  GDBusConnection* connection_ = nullptr;
+};
+
+// Accepts everything and keeps no state, so benchmarks measure only the
+// plugin's own overhead. Daemon signals can be simulated with the Simulate*
+// methods.
+class NullBackend : public NotificationBackend {
+ public:
+  NullBackend() = default;
+
+  bool Show(const std::string& id, const NotificationContent& content) override { return true; }
+  bool Update(const std::string& id, const NotificationContent& content) override {
+    return true;
+  }
+  void Close(const std::string& id) override {}
+  std::vector<std::string> GetCapabilities() override { return {"actions", "body"}; }
+
+  void SimulateActionInvoked(const std::string& id, const std::string& action_id) {
+    DeliverActionInvoked(id, action_id);
+  }
+  void SimulateClosed(const std::string& id) { DeliverClosed(id); }
+};
+
+// Records every call for assertions in tests, and tracks which
+// notifications are open.
+class RecordingBackend : public NullBackend {
+ public:
+  enum class CallType { kShow, kUpdate, kClose };
+
+  struct Call {
+    CallType type;
+    std::string id;
+    NotificationContent content;
+  };
+
+  RecordingBackend() = default;
+
+  bool Show(const std::string& id, const NotificationContent& content) override;
+  bool Update(const std::string& id, const NotificationContent& content) override;
+  void Close(const std::string& id) override;
+  void CloseMany(const std::vector<std::string>& ids) override;
+
+  // Makes subsequent Show/Update calls fail.
+  void set_fail(bool fail) { fail_ = fail; }
+
+  const std::vector<Call>& calls() const { return calls_; }
+  const std::set<std::string>& open() const { return open_; }
+  size_t CountCalls(CallType type) const;
+  // CloseMany calls, each recorded in calls() as one kClose per id.
+  size_t close_batches() const { return close_batches_; }
+  void Clear() { calls_.clear(); }
+
+ private:
+  bool fail_ = false;
+  size_t close_batches_ = 0;
+  std::vector<Call> calls_;
+  std::set<std::string> open_;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_NOTIFICATION_BACKEND_H_
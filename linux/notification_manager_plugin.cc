@@ -10,14 +10,65 @@
 #include <glib/gstdio.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <functional>
 #include <string>
 #include <map>
+#include <memory>
+#include <new>
+#include <set>
+#include <unordered_set>
 #include <vector>
-#include <chrono>
+#include <deque>
 #include <thread>
 
+#include "method_args.h"
+#include "active_notifications.h"
+#include "clock.h"
+#include "dedupe_table.h"
+#include "history_log.h"
+#include "io_thread.h"
+#include "notification_backend.h"
 #include "notification_manager_plugin_private.h"
+#include "preferences_store.h"
+#include "recurrence_rule.h"
+#include "scheduled_ndjson.h"
+#include "scheduled_snapshot.h"
+#include "scheduled_store.h"
+#include "sleep_monitor.h"
+
+using notification_manager::ActiveNotification;
+using notification_manager::ActiveNotifications;
+using notification_manager::AppendScheduledJsonLine;
+using notification_manager::ArgError;
+using notification_manager::ArgSchema;
+using notification_manager::Clock;
+using notification_manager::DedupeTable;
+using notification_manager::HistoryKind;
+using notification_manager::HistoryLog;
+using notification_manager::HistoryRecord;
+using notification_manager::Durability;
+using notification_manager::IoThread;
+using notification_manager::LibnotifyBackend;
+using notification_manager::NdjsonReader;
+using notification_manager::NdjsonWriter;
+using notification_manager::NotificationBackend;
+using notification_manager::NotificationContent;
+using notification_manager::PreferencesStore;
+using notification_manager::RecurrenceRule;
+using notification_manager::ScheduledRequest;
+using notification_manager::ScheduledStore;
+using notification_manager::SleepMonitor;
+using notification_manager::ScheduledShardOf;
+using notification_manager::ScheduledShardPath;
+using notification_manager::SnapshotReload;
+using notification_manager::SnapshotShard;
+using notification_manager::kScheduledShardCount;
+using notification_manager::SystemClock;
+using notification_manager::arg_error_response;
+using notification_manager::GetDataDir;
 
 #define NOTIFICATION_MANAGER_PLUGIN(obj) \
   (G_TYPE_CHECK_INSTANCE_CAST((obj), notification_manager_plugin_get_type(), \
@@ -26,563 +77,2006 @@
 #define PREF_FILE "notification_manager_prefs.json"
 #define DUPLICATE_KEY_PREFIX "notification_duplicate_"
 #define SCHEDULED_KEY_PREFIX "scheduled_notification_"
+#define SCHEDULED_SHARD_DIR "scheduled"
+// Earlier versions kept every scheduled entry in this one snapshot.
+#define LEGACY_SCHEDULED_SNAPSHOT_FILE "scheduled_notifications.bin"
+#define DEDUPE_TABLE_FILE "notification_dedupe.table"
+#define HISTORY_LOG_FILE "notification_history.log"
+// How long duplicate keys imported from the preferences are kept. Their
+// window was not recorded.
+#define LEGACY_DUPLICATE_WINDOW_S (7 * 24 * 3600)
+
+// Longest single wait of the scheduler timer. The timer runs on the
+// monotonic clock, so long waits are split to notice a suspend logind did
+// not report, or a wall clock set while it could not be watched, at least
+// this often.
+#define MAX_SCHEDULER_WAIT_MS (15 * 60 * 1000)
+// How late a scheduled notification may fire so it can share a wakeup
+// with others. Configurable with setSchedulerSlack.
+#define DEFAULT_SCHEDULER_SLACK_MS 1000
+// Entries later than the slack plus this were missed, e.g. while the
+// machine slept, and are shown according to the catch-up policy.
+#define MISSED_GRACE_MS 5000
+// Missed entries are shown at most this many per interval.
+#define CATCH_UP_BURST 4
+#define CATCH_UP_INTERVAL_MS 1000
+#define MISSED_SUMMARY_ID "missed_scheduled_notifications"
+// Titles listed in the summary before it says "and N more".
+#define MISSED_SUMMARY_MAX_TITLES 5
+
+// What to show for scheduled notifications that were missed.
+enum class CatchUpPolicy {
+  // Every missed entry.
+  kFireAll,
+  // Only the latest missed entry of each series: repeating entries and
+  // one-shot entries sharing a category.
+  kLatestPerSeries,
+  // One notification listing what was missed.
+  kSummary,
+};
+
+typedef FlMethodResponse* (*MethodHandler)(NotificationManagerPlugin* self, FlValue* args);
+
+typedef struct {
+  const gchar* name;
+  MethodHandler handler;
+} MethodEntry;
+
+// Every method on the channel, sorted by name so lookup is a binary search.
+// New methods only need an entry here.
+static constexpr MethodEntry kMethodTable[] = {
+  {"areNotificationsEnabled", are_notifications_enabled},
+  {"cancelAllNotifications", cancel_all_notifications},
+  {"cancelAllScheduledNotifications", cancel_all_scheduled_notifications},
+  {"cancelNotification", cancel_notification},
+  {"cancelNotificationsByCategory", cancel_notifications_by_category},
+  {"cancelNotificationsByGroup", cancel_notifications_by_group},
+  {"cancelNotificationsWithPrefix", cancel_notifications_with_prefix},
+  {"cancelScheduledNotification", cancel_scheduled_notification},
+  {"clearBadgeCount", clear_badge_count},
+  {"clearNotificationHistory", clear_notification_history},
+  {"exportScheduledNotifications", export_scheduled_notifications},
+  {"getActiveNotifications", get_active_notifications},
+  {"getBadgeCount", get_badge_count},
+  {"getNextScheduledNotifications", get_next_scheduled_notifications},
+  {"getNotificationHistory", get_notification_history},
+  {"getScheduledChanges", get_scheduled_changes},
+  {"getScheduledNotifications", get_scheduled_notifications},
+  {"getScheduledNotificationsInRange", get_scheduled_notifications_in_range},
+  {"importScheduledNotifications", import_scheduled_notifications},
+  {"initialize", initialize_notification_manager},
+  {"isDuplicateNotification", is_duplicate_notification_method},
+  {"requestPermissions", request_permissions},
+  {"scheduleNotification", schedule_notification},
+  {"setBadgeCount", set_badge_count},
+  {"setCatchUpPolicy", set_catch_up_policy},
+  {"setPersistenceMode", set_persistence_mode},
+  {"setSchedulerSlack", set_scheduler_slack},
+  {"showNotification", show_notification},
+  {"updateScheduledNotification", update_scheduled_notification},
+};
+
+static constexpr size_t kMethodCount = G_N_ELEMENTS(kMethodTable);
+
+static constexpr int compare_method_names(const char* a, const char* b) {
+  while (*a != '\0' && *a == *b) {
+    a++;
+    b++;
+  }
+  return static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b);
+}
+
+static constexpr bool method_table_is_sorted() {
+  for (size_t i = 1; i < kMethodCount; i++) {
+    if (compare_method_names(kMethodTable[i - 1].name, kMethodTable[i].name) >= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(method_table_is_sorted(), "kMethodTable must be sorted by name");
+
+// A lookup takes at most floor(log2(kMethodCount)) + 1 string comparisons:
+// five for the 29 methods today, and five for up to 31.
+static const MethodEntry* find_method(const gchar* name) {
+  size_t low = 0;
+  size_t high = kMethodCount;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    int order = strcmp(name, kMethodTable[mid].name);
+    if (order == 0) return &kMethodTable[mid];
+    if (order < 0) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return nullptr;
+}
+
+// Arguments of each method, decoded in one pass over the call's map.
+struct ShowArgs {
+  std::string id;
+  std::string title;
+  std::string body;
+  FlValue* actions = nullptr;
+  std::string category;
+  std::string group;
+  std::string duplicate_key;
+  int64_t duplicate_window = 300;
+};
+
+static const ArgSchema<ShowArgs> kShowSchema = {
+  ArgSchema<ShowArgs>::Required("id", &ShowArgs::id),
+  ArgSchema<ShowArgs>::Required("title", &ShowArgs::title),
+  ArgSchema<ShowArgs>::Required("body", &ShowArgs::body),
+  ArgSchema<ShowArgs>::Optional("actions", &ShowArgs::actions, FL_VALUE_TYPE_LIST),
+  ArgSchema<ShowArgs>::Optional("category", &ShowArgs::category),
+  ArgSchema<ShowArgs>::Optional("group", &ShowArgs::group),
+  ArgSchema<ShowArgs>::Optional("duplicateKey", &ShowArgs::duplicate_key),
+  ArgSchema<ShowArgs>::Optional("duplicateWindow", &ShowArgs::duplicate_window),
+};
+
+struct ActionArgs {
+  std::string id;
+  std::string title;
+};
+
+static const ArgSchema<ActionArgs> kActionSchema = {
+  ArgSchema<ActionArgs>::Required("id", &ActionArgs::id),
+  ArgSchema<ActionArgs>::Required("title", &ActionArgs::title),
+};
+
+// The NotificationRequest nested in a scheduled notification.
+struct RequestArgs {
+  std::string title;
+  std::string body;
+  std::string category;
+  std::string group;
+  FlValue* actions = nullptr;
+  FlValue* payload = nullptr;
+  int64_t timeout = 0;
+  int64_t badge_number = -1;
+};
+
+static const ArgSchema<RequestArgs> kRequestSchema = {
+  ArgSchema<RequestArgs>::Required("title", &RequestArgs::title),
+  ArgSchema<RequestArgs>::Required("body", &RequestArgs::body),
+  ArgSchema<RequestArgs>::Optional("category", &RequestArgs::category),
+  ArgSchema<RequestArgs>::Optional("group", &RequestArgs::group),
+  ArgSchema<RequestArgs>::Optional("actions", &RequestArgs::actions, FL_VALUE_TYPE_LIST),
+  ArgSchema<RequestArgs>::Optional("payload", &RequestArgs::payload, FL_VALUE_TYPE_MAP),
+  ArgSchema<RequestArgs>::Optional("timeout", &RequestArgs::timeout),
+  ArgSchema<RequestArgs>::Optional("badgeNumber", &RequestArgs::badge_number),
+};
+
+struct ScheduleArgs {
+  std::string id;
+  FlValue* request = nullptr;
+  int64_t scheduled_date = 0;
+  bool is_repeating = false;
+  int64_t repeat_interval = 0;
+  std::string recurrence;
+};
+
+static const ArgSchema<ScheduleArgs> kScheduleSchema = {
+  ArgSchema<ScheduleArgs>::Required("id", &ScheduleArgs::id),
+  ArgSchema<ScheduleArgs>::Required("request", &ScheduleArgs::request, FL_VALUE_TYPE_MAP),
+  ArgSchema<ScheduleArgs>::Required("scheduledDate", &ScheduleArgs::scheduled_date),
+  ArgSchema<ScheduleArgs>::Optional("isRepeating", &ScheduleArgs::is_repeating),
+  ArgSchema<ScheduleArgs>::Optional("repeatInterval", &ScheduleArgs::repeat_interval),
+  ArgSchema<ScheduleArgs>::Optional("recurrence", &ScheduleArgs::recurrence),
+};
+
+// Default page size for the paginated scheduled queries.
+#define DEFAULT_SCHEDULED_PAGE_SIZE 20
+
+struct PageArgs {
+  int64_t limit = DEFAULT_SCHEDULED_PAGE_SIZE;
+  std::string cursor;
+};
+
+static const ArgSchema<PageArgs> kPageSchema = {
+  ArgSchema<PageArgs>::Optional("limit", &PageArgs::limit),
+  ArgSchema<PageArgs>::Optional("cursor", &PageArgs::cursor),
+};
+
+// Milliseconds since the Unix epoch; |end| is exclusive.
+struct RangeArgs {
+  int64_t start = 0;
+  int64_t end = 0;
+  int64_t limit = DEFAULT_SCHEDULED_PAGE_SIZE;
+  std::string cursor;
+};
+
+static const ArgSchema<RangeArgs> kRangeSchema = {
+  ArgSchema<RangeArgs>::Required("start", &RangeArgs::start),
+  ArgSchema<RangeArgs>::Required("end", &RangeArgs::end),
+  ArgSchema<RangeArgs>::Optional("limit", &RangeArgs::limit),
+  ArgSchema<RangeArgs>::Optional("cursor", &RangeArgs::cursor),
+};
+
+// Empty filters match every notification.
+struct ActiveArgs {
+  std::string category;
+  std::string group;
+  int64_t limit = DEFAULT_SCHEDULED_PAGE_SIZE;
+  std::string cursor;
+};
+
+static const ArgSchema<ActiveArgs> kActiveSchema = {
+  ArgSchema<ActiveArgs>::Optional("category", &ActiveArgs::category),
+  ArgSchema<ActiveArgs>::Optional("group", &ActiveArgs::group),
+  ArgSchema<ActiveArgs>::Optional("limit", &ActiveArgs::limit),
+  ArgSchema<ActiveArgs>::Optional("cursor", &ActiveArgs::cursor),
+};
+
+struct ChangesArgs {
+  int64_t since_version = 0;
+};
+
+static const ArgSchema<ChangesArgs> kChangesSchema = {
+  ArgSchema<ChangesArgs>::Required("sinceVersion", &ChangesArgs::since_version),
+};
+
+// Default entries, or lines, per chunk of an export or import.
+#define DEFAULT_TRANSFER_CHUNK_SIZE 500
+
+struct TransferArgs {
+  std::string path;
+  int64_t chunk_size = DEFAULT_TRANSFER_CHUNK_SIZE;
+};
+
+static const ArgSchema<TransferArgs> kTransferSchema = {
+  ArgSchema<TransferArgs>::Required("path", &TransferArgs::path),
+  ArgSchema<TransferArgs>::Optional("chunkSize", &TransferArgs::chunk_size),
+};
+
+struct SlackArgs {
+  int64_t slack_ms = 0;
+};
+
+static const ArgSchema<SlackArgs> kSlackSchema = {
+  ArgSchema<SlackArgs>::Required("slackMs", &SlackArgs::slack_ms),
+};
+
+struct PolicyArgs {
+  std::string policy;
+};
+
+static const ArgSchema<PolicyArgs> kPolicySchema = {
+  ArgSchema<PolicyArgs>::Required("policy", &PolicyArgs::policy),
+};
+
+struct PersistenceModeArgs {
+  std::string mode;
+};
+
+static const ArgSchema<PersistenceModeArgs> kPersistenceModeSchema = {
+  ArgSchema<PersistenceModeArgs>::Required("mode", &PersistenceModeArgs::mode),
+};
+
+// Arguments any method that stores data may take on top of its own.
+static const ArgSchema<PersistenceModeArgs> kCallPersistenceModeSchema = {
+  ArgSchema<PersistenceModeArgs>::Optional("persistenceMode", &PersistenceModeArgs::mode),
+};
+
+// Parses a persistenceMode argument: "none", "batched" or "immediate".
+static bool parse_durability(const std::string& mode, Durability* durability) {
+  if (mode == "none") {
+    *durability = Durability::kNone;
+  } else if (mode == "batched") {
+    *durability = Durability::kBatched;
+  } else if (mode == "immediate") {
+    *durability = Durability::kImmediate;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static Durability stronger(Durability a, Durability b) {
+  return static_cast<int>(a) > static_cast<int>(b) ? a : b;
+}
+
+struct IdArgs {
+  std::string id;
+};
+
+static const ArgSchema<IdArgs> kIdSchema = {
+  ArgSchema<IdArgs>::Required("id", &IdArgs::id),
+};
+
+struct CategoryArgs {
+  std::string category;
+};
+
+static const ArgSchema<CategoryArgs> kCategorySchema = {
+  ArgSchema<CategoryArgs>::Required("category", &CategoryArgs::category),
+};
+
+struct GroupArgs {
+  std::string group;
+};
+
+static const ArgSchema<GroupArgs> kGroupSchema = {
+  ArgSchema<GroupArgs>::Required("group", &GroupArgs::group),
+};
+
+struct PrefixArgs {
+  std::string prefix;
+};
+
+static const ArgSchema<PrefixArgs> kPrefixSchema = {
+  ArgSchema<PrefixArgs>::Required("prefix", &PrefixArgs::prefix),
+};
+
+struct DuplicateCheckArgs {
+  std::string id;
+  int64_t time_window_seconds = 0;
+};
+
+static const ArgSchema<DuplicateCheckArgs> kDuplicateCheckSchema = {
+  ArgSchema<DuplicateCheckArgs>::Required("id", &DuplicateCheckArgs::id),
+  ArgSchema<DuplicateCheckArgs>::Required("timeWindowSeconds",
+                                          &DuplicateCheckArgs::time_window_seconds),
+};
 
 struct _NotificationManagerPlugin {
   GObject parent_instance;
   FlEventChannel* event_channel;
-  FlEventSink* event_sink;
-  std::map<std::string, NotifyNotification*> active_notifications;
-  std::map<std::string, std::chrono::system_clock::time_point> duplicate_tracking;
-  std::map<std::string, std::string> scheduled_notifications;
+  bool event_listening;
+  std::unique_ptr<NotificationBackend> backend;
+  // Source of time and timers for dedupe, scheduling and catch-up.
+  std::unique_ptr<Clock> clock;
+  // Writes the preferences and the scheduled snapshot off the main thread.
+  std::unique_ptr<IoThread> io_thread;
+  // How durable a change must be before the call that made it is
+  // answered, unless the call asks otherwise. Calls answered at kNone do
+  // not wait for the write at all.
+  Durability durability;
+  // The strongest durability asked of the changes not yet in the snapshot.
+  Durability snapshot_durability;
+  // Loaded from disk on first access.
+  std::unique_ptr<PreferencesStore> preferences;
+  // Shared with other processes using the same data directory.
+  std::unique_ptr<DedupeTable> dedupe_table;
+  // Whether keys from earlier versions have been moved out of the
+  // preferences, by this process or another.
+  bool dedupe_imported;
+  // What was shown, acted on and closed; also shared with other processes.
+  std::unique_ptr<HistoryLog> history_log;
+  ActiveNotifications active_notifications;
+  ScheduledStore scheduled_notifications;
+  // Holds the snapshot shards (see kScheduledShardCount).
+  std::string scheduled_shard_dir;
+  // Whether the snapshot has been read into scheduled_notifications.
+  bool scheduled_restored;
+  // Whether scheduled_notifications has changes not yet in the snapshot.
+  bool scheduled_dirty;
+  // Store version at the last flush; only shards holding entries changed
+  // since then are rewritten.
+  guint64 snapshot_flushed_version;
+  // Whether the next flush rewrites every shard, e.g. after a migration.
+  bool snapshot_rewrite_all;
+  guint snapshot_write_source;
+  // Called once the next snapshot write reaches the disk.
+  std::vector<IoThread::Task> snapshot_waiters;
+  // Written into every snapshot, so the monitor can tell this process's
+  // writes from those of another one sharing the data directory.
+  guint64 snapshot_writer;
+  // Store version the snapshot on disk holds, as of the last write that
+  // landed. Shared with the write's completion callback.
+  std::shared_ptr<guint64> snapshot_landed_version;
+  // Watches the shards for writes by other processes; set up on restore.
+  GFileMonitor* snapshot_monitor;
+  guint scheduler_source;
+  // Fire time the scheduler timer is armed for, or 0 if it is not armed.
+  gint64 scheduler_fire_at_ms;
+  gint64 scheduler_slack_ms;
+  guint64 scheduler_wakeups;
+  // Re-arms the scheduler when the wall clock is set.
+  guint clock_watch_source;
+  std::unique_ptr<SleepMonitor> sleep_monitor;
+  CatchUpPolicy catch_up_policy;
+  // Missed entries waiting for their turn under the catch-up rate limit.
+  std::deque<std::pair<std::string, NotificationContent>> catch_up_queue;
+  guint catch_up_source;
+  // Exports and imports still running, and the id of the latest one.
+  guint transfers_in_progress;
+  guint64 last_transfer_id;
+  // Compiled recurrence rules by their text; entries often share a rule.
+  std::map<std::string, RecurrenceRule> recurrence_rules;
+  // Recurrence rules are evaluated in local wall time. Loaded on first
+  // use, and dropped when the system zone changes; see local_time_zone().
+  GTimeZone* local_time_zone;
+  GFileMonitor* time_zone_monitor;
+  // Indexed like kMethodTable.
+  guint64 dispatch_counts[kMethodCount];
+  guint64 unknown_dispatch_count;
 };
 
 G_DEFINE_TYPE(NotificationManagerPlugin, notification_manager_plugin, g_object_get_type())
 
-// Helper function to get user data directory
-static std::string get_user_data_dir() {
-  const char* home = g_getenv("HOME");
-  if (!home) home = g_getenv("USERPROFILE");
-  if (!home) return "/tmp";
-  
-  std::string data_dir = std::string(home) + "/.local/share/notification_manager";
-  g_mkdir_with_parents(data_dir.c_str(), 0755);
-  return data_dir;
-}
+static void on_notification_action(NotificationManagerPlugin* self, const std::string& id,
+                                   const std::string& action);
+static void on_notification_closed(NotificationManagerPlugin* self, const std::string& id);
 
 // Helper function to save preferences
-static void save_preferences(const std::string& key, const std::string& value) {
-  std::string data_dir = get_user_data_dir();
-  std::string pref_file = data_dir + "/" + PREF_FILE;
-  
-  JsonNode* root = json_node_new(JSON_NODE_OBJECT);
-  JsonObject* root_obj = json_object_new();
-  json_node_set_object(root, root_obj);
-  
-  // Load existing data if file exists
-  if (g_file_test(pref_file.c_str(), G_FILE_TEST_EXISTS)) {
-    JsonParser* parser = json_parser_new();
-    if (json_parser_load_from_file(parser, pref_file.c_str(), nullptr)) {
-      JsonNode* existing = json_parser_get_root(parser);
-      if (json_node_get_node_type(existing) == JSON_NODE_OBJECT) {
-        JsonObject* existing_obj = json_node_get_object(existing);
-        json_object_foreach(existing_obj, key_name, value_node) {
-          json_object_set_member(root_obj, key_name, json_node_copy(value_node));
-        }
-      }
-      g_object_unref(parser);
-    }
-  }
-  
-  // Add new key-value pair
-  json_object_set_string_member(root_obj, key.c_str(), value.c_str());
-  
-  // Save to file
-  JsonGenerator* generator = json_generator_new();
-  json_generator_set_root(generator, root);
-  json_generator_to_file(generator, pref_file.c_str(), nullptr);
-  
-  g_object_unref(generator);
-  json_node_free(root);
+void save_preferences(NotificationManagerPlugin* self, const std::string& key,
+                      const std::string& value) {
+  self->preferences->Set(key, value);
 }
 
 // Helper function to load preferences
-static std::string load_preference(const std::string& key) {
-  std::string data_dir = get_user_data_dir();
-  std::string pref_file = data_dir + "/" + PREF_FILE;
-  
-  if (!g_file_test(pref_file.c_str(), G_FILE_TEST_EXISTS)) {
-    return "";
-  }
-  
-  JsonParser* parser = json_parser_new();
-  if (!json_parser_load_from_file(parser, pref_file.c_str(), nullptr)) {
-    g_object_unref(parser);
-    return "";
-  }
-  
-  JsonNode* root = json_parser_get_root(parser);
-  if (json_node_get_node_type(root) != JSON_NODE_OBJECT) {
-    g_object_unref(parser);
-    return "";
+std::string load_preference(NotificationManagerPlugin* self, const std::string& key) {
+  return self->preferences->Get(key);
+}
+
+// Earlier versions kept duplicate keys in the preferences, where other
+// processes could not see them safely. The first process to get here moves
+// them into the table.
+static void import_legacy_duplicates(NotificationManagerPlugin* self) {
+  if (self->dedupe_imported) return;
+  self->dedupe_imported = true;
+  if (!self->dedupe_table->ClaimImport()) return;
+
+  auto legacy = self->preferences->GetWithPrefix(DUPLICATE_KEY_PREFIX);
+  if (legacy.empty()) return;
+  for (const auto& pair : legacy) {
+    gint64 sent_s = g_ascii_strtoll(pair.second.c_str(), nullptr, 10);
+    self->dedupe_table->MarkSent(pair.first.substr(strlen(DUPLICATE_KEY_PREFIX)), sent_s,
+                                 LEGACY_DUPLICATE_WINDOW_S);
   }
-  
-  JsonObject* root_obj = json_node_get_object(root);
-  const char* value = json_object_get_string_member(root_obj, key.c_str());
-  
-  std::string result = value ? value : "";
-  g_object_unref(parser);
-  return result;
+  self->preferences->RemoveWithPrefix(DUPLICATE_KEY_PREFIX);
 }
 
-// Helper function to check for duplicate notifications
-static bool is_duplicate_notification(const std::string& duplicate_key, int time_window_seconds) {
+// Whether |duplicate_key| was sent within the last |time_window_seconds|.
+// The window is capped at the one the key was marked with: past that its
+// entry may be compacted away at any time, and whether it counted would
+// depend on when another process last rebuilt the table.
+static bool is_duplicate_notification(NotificationManagerPlugin* self,
+                                      const std::string& duplicate_key,
+                                      int64_t time_window_seconds) {
   if (duplicate_key.empty()) return false;
-  
-  std::string key = DUPLICATE_KEY_PREFIX + duplicate_key;
-  std::string last_sent_str = load_preference(key);
-  
-  if (last_sent_str.empty()) return false;
-  
-  auto last_sent = std::chrono::system_clock::from_time_t(std::stoll(last_sent_str));
-  auto now = std::chrono::system_clock::now();
-  auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - last_sent);
-  
-  return duration.count() < time_window_seconds;
+  import_legacy_duplicates(self);
+
+  int64_t last_sent_s = 0;
+  int64_t expires_s = 0;
+  if (!self->dedupe_table->LastSent(duplicate_key, &last_sent_s, &expires_s)) return false;
+
+  gint64 now_s = self->clock->RealTimeUs() / G_USEC_PER_SEC;
+  return now_s - last_sent_s < time_window_seconds && now_s < expires_s;
 }
 
 // Helper function to mark notification as sent
-static void mark_notification_as_sent(const std::string& duplicate_key) {
+static void mark_notification_as_sent(NotificationManagerPlugin* self,
+                                      const std::string& duplicate_key, int64_t window_s) {
   if (duplicate_key.empty()) return;
-  
-  std::string key = DUPLICATE_KEY_PREFIX + duplicate_key;
-  auto now = std::chrono::system_clock::now();
-  auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
-  
-  save_preferences(key, std::to_string(timestamp));
+  import_legacy_duplicates(self);
+
+  gint64 now_s = self->clock->RealTimeUs() / G_USEC_PER_SEC;
+  self->dedupe_table->MarkSent(duplicate_key, now_s, window_s);
 }
 
+static void record_history(NotificationManagerPlugin* self, HistoryKind kind,
+                           const std::string& id, const std::string& title,
+                           const std::string& action) {
+  self->history_log->Append(kind, self->clock->RealTimeUs() / 1000, id, title, action);
+}
+
+// Closes |ids|, already dropped from the active notifications, as one
+// batch.
+static void close_notifications(NotificationManagerPlugin* self,
+                                const std::vector<std::string>& ids) {
+  if (ids.empty()) return;
+  self->backend->CloseMany(ids);
+  for (const std::string& id : ids) {
+    record_history(self, HistoryKind::kClosed, id, "", "");
+  }
+}
+
+// Shows |content|, replacing it in place if |id| is already on screen.
+static bool display_notification(NotificationManagerPlugin* self, const std::string& id,
+                                 const NotificationContent& content) {
+  bool success = self->active_notifications.Contains(id)
+                     ? self->backend->Update(id, content)
+                     : self->backend->Show(id, content);
+  if (success) {
+    self->active_notifications.Put(id, content.title, content.category, content.group,
+                                   self->clock->RealTimeUs() / 1000);
+    record_history(self, HistoryKind::kShown, id, content.title, "");
+  }
+  return success;
+}
+
+FlMethodResponse* notification_manager_plugin_dispatch(NotificationManagerPlugin* self,
+                                                        const gchar* method, FlValue* args) {
+  const MethodEntry* entry = find_method(method);
+  if (entry == nullptr) {
+    self->unknown_dispatch_count++;
+    return FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+  self->dispatch_counts[entry - kMethodTable]++;
+  return entry->handler(self, args);
+}
+
+guint64 notification_manager_plugin_get_dispatch_count(NotificationManagerPlugin* self,
+                                                       const gchar* method) {
+  const MethodEntry* entry = find_method(method);
+  return entry ? self->dispatch_counts[entry - kMethodTable] : self->unknown_dispatch_count;
+}
+
+static gboolean snapshot_write_cb(gpointer user_data);
+
 // Called when a method call is received from Flutter.
 static void notification_manager_plugin_handle_method_call(
     NotificationManagerPlugin* self,
     FlMethodCall* method_call) {
-  g_autoptr(FlMethodResponse) response = nullptr;
-
-  const gchar* method = fl_method_call_get_name(method_call);
-
-  if (strcmp(method, "initialize") == 0) {
-    response = initialize_notification_manager();
-  } else if (strcmp(method, "requestPermissions") == 0) {
-    response = request_permissions();
-  } else if (strcmp(method, "areNotificationsEnabled") == 0) {
-    response = are_notifications_enabled();
-  } else if (strcmp(method, "showNotification") == 0) {
-    response = show_notification(self, method_call);
-  } else if (strcmp(method, "scheduleNotification") == 0) {
-    response = schedule_notification(self, method_call);
-  } else if (strcmp(method, "getScheduledNotifications") == 0) {
-    response = get_scheduled_notifications(self);
-  } else if (strcmp(method, "updateScheduledNotification") == 0) {
-    response = update_scheduled_notification(self, method_call);
-  } else if (strcmp(method, "cancelNotification") == 0) {
-    response = cancel_notification(self, method_call);
-  } else if (strcmp(method, "cancelScheduledNotification") == 0) {
-    response = cancel_scheduled_notification(self, method_call);
-  } else if (strcmp(method, "cancelAllNotifications") == 0) {
-    response = cancel_all_notifications(self);
-  } else if (strcmp(method, "cancelAllScheduledNotifications") == 0) {
-    response = cancel_all_scheduled_notifications(self);
-  } else if (strcmp(method, "getBadgeCount") == 0) {
-    response = get_badge_count();
-  } else if (strcmp(method, "setBadgeCount") == 0) {
-    response = set_badge_count(method_call);
-  } else if (strcmp(method, "clearBadgeCount") == 0) {
-    response = clear_badge_count();
-  } else if (strcmp(method, "isDuplicateNotification") == 0) {
-    response = is_duplicate_notification_method(self, method_call);
-  } else if (strcmp(method, "clearNotificationHistory") == 0) {
-    response = clear_notification_history(self);
-  } else {
-    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  FlValue* args = fl_method_call_get_args(method_call);
+  Durability durability = self->durability;
+  // Methods without arguments take no mode either.
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    PersistenceModeArgs decoded;
+    ArgError error;
+    g_autoptr(FlMethodResponse) rejected = nullptr;
+    if (!kCallPersistenceModeSchema.Decode(args, &decoded, &error)) {
+      rejected = arg_error_response(error);
+    } else if (!decoded.mode.empty() && !parse_durability(decoded.mode, &durability)) {
+      rejected = FL_METHOD_RESPONSE(fl_method_error_response_new(
+          "INVALID_ARGUMENTS", ("Unknown persistence mode '" + decoded.mode + "'").c_str(),
+          nullptr));
+    }
+    if (rejected != nullptr) {
+      fl_method_call_respond(method_call, rejected, nullptr);
+      return;
+    }
+  }
+
+  uint64_t posted = self->io_thread->posted();
+  uint64_t version = self->scheduled_notifications.version();
+  self->preferences->set_durability(durability);
+  FlMethodResponse* response =
+      notification_manager_plugin_dispatch(self, fl_method_call_get_name(method_call), args);
+  self->preferences->set_durability(self->durability);
+
+  bool scheduled_changed = self->scheduled_notifications.version() != version;
+  if (scheduled_changed) {
+    self->snapshot_durability = stronger(self->snapshot_durability, durability);
+    if (durability == Durability::kImmediate && self->snapshot_write_source != 0) {
+      g_source_remove(self->snapshot_write_source);
+      snapshot_write_cb(self);
+    }
+  }
+  bool persisted = self->io_thread->posted() != posted || scheduled_changed;
+  if (!persisted || durability == Durability::kNone) {
+    fl_method_call_respond(method_call, response, nullptr);
+    g_object_unref(response);
+    return;
   }
 
-  fl_method_call_respond(method_call, response, nullptr);
+  g_object_ref(method_call);
+  notification_manager_plugin_when_persisted(self, [method_call, response]() {
+    fl_method_call_respond(method_call, response, nullptr);
+    g_object_unref(response);
+    g_object_unref(method_call);
+  });
 }
 
-FlMethodResponse* initialize_notification_manager() {
-  if (!notify_is_initted()) {
-    notify_init("notification_manager");
-  }
+FlMethodResponse* initialize_notification_manager(NotificationManagerPlugin* self, FlValue* args) {
+  // Connecting to the daemon would otherwise happen on the first show.
+  self->backend->Initialize();
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* request_permissions() {
+FlMethodResponse* request_permissions(NotificationManagerPlugin* self, FlValue* args) {
   // Linux doesn't require explicit permissions for notifications
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* are_notifications_enabled() {
+FlMethodResponse* are_notifications_enabled(NotificationManagerPlugin* self, FlValue* args) {
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* show_notification(NotificationManagerPlugin* self, FlMethodCall* method_call) {
-  FlValue* args = fl_method_call_get_args(method_call);
-  
-  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+// Decodes a list of {id, title} action maps. |key| names the list in errors.
+static bool decode_actions(FlValue* actions, const char* key,
+                           std::vector<std::pair<std::string, std::string>>* out,
+                           ArgError* error) {
+  if (actions == nullptr) return true;
+
+  gsize actions_length = fl_value_get_length(actions);
+  for (gsize i = 0; i < actions_length; i++) {
+    ActionArgs action;
+    if (!kActionSchema.Decode(fl_value_get_list_value(actions, i), &action, error)) {
+      error->key = std::string(key) + "[" + std::to_string(i) + "]" +
+                   (error->key.empty() ? "" : "." + error->key);
+      error->message = "Invalid " + error->key + ": " + error->message;
+      return false;
+    }
+    out->emplace_back(action.id, action.title);
   }
+  return true;
+}
 
-  FlValue* id_value = fl_value_lookup_string(args, "id");
-  FlValue* title_value = fl_value_lookup_string(args, "title");
-  FlValue* body_value = fl_value_lookup_string(args, "body");
-  FlValue* actions_value = fl_value_lookup_string(args, "actions");
-  FlValue* payload_value = fl_value_lookup_string(args, "payload");
-  FlValue* duplicate_key_value = fl_value_lookup_string(args, "duplicateKey");
-  FlValue* duplicate_window_value = fl_value_lookup_int(args, "duplicateWindow");
-
-  if (!id_value || !title_value || !body_value) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+FlMethodResponse* show_notification(NotificationManagerPlugin* self, FlValue* args) {
+  ShowArgs decoded;
+  ArgError error;
+  if (!kShowSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
   }
 
-  const gchar* id = fl_value_get_string(id_value);
-  const gchar* title = fl_value_get_string(title_value);
-  const gchar* body = fl_value_get_string(body_value);
-  
-  // Check for duplicate notifications
-  if (duplicate_key_value) {
-    const gchar* duplicate_key = fl_value_get_string(duplicate_key_value);
-    int time_window = duplicate_window_value ? fl_value_get_int(duplicate_window_value) : 300; // Default 5 minutes
-    
-    if (is_duplicate_notification(duplicate_key, time_window)) {
-      g_autoptr(FlValue) result = fl_value_new_bool(false);
-      return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
-    }
-    
-    // Mark notification as sent
-    mark_notification_as_sent(duplicate_key);
-  }
+  NotificationContent content;
+  content.title = decoded.title;
+  content.body = decoded.body;
+  content.category = decoded.category;
+  content.group = decoded.group;
 
-  // Create notification
-  NotifyNotification* notification = notify_notification_new(title, body, nullptr);
-  
-  // Store notification reference
-  self->active_notifications[id] = notification;
-
-  // Set up action callbacks if actions are provided
-  if (actions_value && fl_value_get_type(actions_value) == FL_VALUE_TYPE_LIST) {
-    gsize actions_length = fl_value_get_length(actions_value);
-    
-    for (gsize i = 0; i < actions_length; i++) {
-      FlValue* action_value = fl_value_get_list_value(actions_value, i);
-      if (fl_value_get_type(action_value) == FL_VALUE_TYPE_MAP) {
-        FlValue* action_id_value = fl_value_lookup_string(action_value, "id");
-        FlValue* action_title_value = fl_value_lookup_string(action_value, "title");
-        
-        if (action_id_value && action_title_value) {
-          const gchar* action_id = fl_value_get_string(action_id_value);
-          const gchar* action_title = fl_value_get_string(action_title_value);
-          
-          // Add action to notification
-          notify_notification_add_action(notification, action_id, action_title, 
-                                       nullptr, nullptr, nullptr);
-        }
-      }
-    }
+  // Collect action buttons if actions are provided
+  if (!decode_actions(decoded.actions, "actions", &content.actions, &error)) {
+    return arg_error_response(error);
   }
 
-  // Set up notification callback
-  g_signal_connect(notification, "action-invoked", G_CALLBACK(on_notification_action), self);
-  g_signal_connect(notification, "closed", G_CALLBACK(on_notification_closed), self);
-
-  // Show notification
-  GError* error = nullptr;
-  gboolean success = notify_notification_show(notification, &error);
-  
-  if (error) {
-    g_error_free(error);
+  // The key is only marked once the notification is on screen, so a call
+  // that is rejected or fails to show does not swallow its retry.
+  if (is_duplicate_notification(self, decoded.duplicate_key, decoded.duplicate_window)) {
     g_autoptr(FlValue) result = fl_value_new_bool(false);
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
+  bool success = display_notification(self, decoded.id, content);
+  if (success) {
+    mark_notification_as_sent(self, decoded.duplicate_key, decoded.duplicate_window);
+  }
+
   g_autoptr(FlValue) result = fl_value_new_bool(success);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* cancel_notification(NotificationManagerPlugin* self, FlMethodCall* method_call) {
-  FlValue* args = fl_method_call_get_args(method_call);
-  
-  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
-  }
+// Drops a missed entry still waiting under the catch-up rate limit, so a
+// cancelled notification is not shown after all.
+static void drop_catch_up(NotificationManagerPlugin* self, const std::string& id) {
+  auto& queue = self->catch_up_queue;
+  queue.erase(std::remove_if(queue.begin(), queue.end(),
+                             [&id](const std::pair<std::string, NotificationContent>& entry) {
+                               return entry.first == id;
+                             }),
+              queue.end());
+}
 
-  FlValue* id_value = fl_value_lookup_string(args, "id");
-  if (!id_value) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+FlMethodResponse* cancel_notification(NotificationManagerPlugin* self, FlValue* args) {
+  IdArgs decoded;
+  ArgError error;
+  if (!kIdSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
   }
 
-  const gchar* id = fl_value_get_string(id_value);
-  auto it = self->active_notifications.find(id);
-  
-  if (it != self->active_notifications.end()) {
-    notify_notification_close(it->second, nullptr);
-    self->active_notifications.erase(it);
+  drop_catch_up(self, decoded.id);
+  if (self->active_notifications.Remove(decoded.id)) {
+    self->backend->Close(decoded.id);
+    record_history(self, HistoryKind::kClosed, decoded.id, "", "");
   }
 
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* cancel_all_notifications(NotificationManagerPlugin* self) {
-  for (auto& pair : self->active_notifications) {
-    notify_notification_close(pair.second, nullptr);
-  }
-  self->active_notifications.clear();
+FlMethodResponse* cancel_all_notifications(NotificationManagerPlugin* self, FlValue* args) {
+  std::vector<std::string> ids;
+  ids.reserve(self->active_notifications.size());
+  self->active_notifications.ForEach(
+      [&ids](const ActiveNotification& notification) { ids.push_back(notification.id); });
+  self->active_notifications.Clear();
+  close_notifications(self, ids);
 
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* get_badge_count() {
+static FlMethodResponse* cancelled_count_response(NotificationManagerPlugin* self,
+                                                  const std::vector<std::string>& ids) {
+  close_notifications(self, ids);
+  g_autoptr(FlValue) result = fl_value_new_int(static_cast<int64_t>(ids.size()));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// The cancelNotifications* methods return how many notifications they
+// closed.
+FlMethodResponse* cancel_notifications_by_category(NotificationManagerPlugin* self,
+                                                   FlValue* args) {
+  CategoryArgs decoded;
+  ArgError error;
+  if (!kCategorySchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  if (decoded.category.empty()) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'category' must not be empty", nullptr));
+  }
+  return cancelled_count_response(self,
+                                  self->active_notifications.RemoveCategory(decoded.category));
+}
+
+FlMethodResponse* cancel_notifications_by_group(NotificationManagerPlugin* self, FlValue* args) {
+  GroupArgs decoded;
+  ArgError error;
+  if (!kGroupSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  if (decoded.group.empty()) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'group' must not be empty", nullptr));
+  }
+  return cancelled_count_response(self, self->active_notifications.RemoveGroup(decoded.group));
+}
+
+FlMethodResponse* cancel_notifications_with_prefix(NotificationManagerPlugin* self,
+                                                   FlValue* args) {
+  PrefixArgs decoded;
+  ArgError error;
+  if (!kPrefixSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  // cancelAllNotifications already says "everything" more plainly.
+  if (decoded.prefix.empty()) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'prefix' must not be empty", nullptr));
+  }
+  return cancelled_count_response(self, self->active_notifications.RemovePrefix(decoded.prefix));
+}
+
+// Cursors are "<creation time>:<id>" of the last notification on the
+// previous page. Dart treats them as opaque.
+static bool parse_active_cursor(const std::string& cursor, ActiveNotifications::Cursor* out) {
+  const char* start = cursor.c_str();
+  gchar* end = nullptr;
+  gint64 created_ms = g_ascii_strtoll(start, &end, 10);
+  if (end == start || *end != ':') return false;
+  out->created_ms = created_ms;
+  out->id = end + 1;
+  return true;
+}
+
+// Returns {notifications, nextCursor} with up to |limit| of the
+// notifications on screen, oldest first, optionally only those in a
+// category or group.
+FlMethodResponse* get_active_notifications(NotificationManagerPlugin* self, FlValue* args) {
+  ActiveArgs decoded;
+  ArgError error;
+  if (!kActiveSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  if (decoded.limit <= 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'limit' must be positive", nullptr));
+  }
+  ActiveNotifications::Cursor after;
+  if (!decoded.cursor.empty() && !parse_active_cursor(decoded.cursor, &after)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'cursor' is not a valid cursor", nullptr));
+  }
+
+  g_autoptr(FlValue) notifications = fl_value_new_list();
+  std::string last_cursor;
+  bool more = self->active_notifications.ForEachByCreation(
+      decoded.category.empty() ? nullptr : &decoded.category,
+      decoded.group.empty() ? nullptr : &decoded.group,
+      decoded.cursor.empty() ? nullptr : &after, static_cast<size_t>(decoded.limit),
+      [&](const ActiveNotification& notification) {
+        FlValue* value = fl_value_new_map();
+        fl_value_set_string_take(value, "id", fl_value_new_string(notification.id.c_str()));
+        fl_value_set_string_take(value, "title", fl_value_new_string(notification.title.c_str()));
+        if (!notification.category.empty()) {
+          fl_value_set_string_take(value, "category",
+                                   fl_value_new_string(notification.category.c_str()));
+        }
+        if (!notification.group.empty()) {
+          fl_value_set_string_take(value, "group",
+                                   fl_value_new_string(notification.group.c_str()));
+        }
+        fl_value_set_string_take(value, "createdAt", fl_value_new_int(notification.created_ms));
+        fl_value_set_string_take(value, "updatedAt", fl_value_new_int(notification.updated_ms));
+        fl_value_append_take(notifications, value);
+        last_cursor = std::to_string(notification.created_ms) + ":" + notification.id;
+      });
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string(result, "notifications", notifications);
+  if (more && !last_cursor.empty()) {
+    fl_value_set_string_take(result, "nextCursor", fl_value_new_string(last_cursor.c_str()));
+  } else {
+    fl_value_set_string_take(result, "nextCursor", fl_value_new_null());
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* get_badge_count(NotificationManagerPlugin* self, FlValue* args) {
   // Linux doesn't have a built-in badge count
   g_autoptr(FlValue) result = fl_value_new_int(0);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* set_badge_count(FlMethodCall* method_call) {
+FlMethodResponse* set_badge_count(NotificationManagerPlugin* self, FlValue* args) {
   // Linux doesn't have a built-in badge count
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* clear_badge_count() {
+FlMethodResponse* clear_badge_count(NotificationManagerPlugin* self, FlValue* args) {
   // Linux doesn't have a built-in badge count
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* is_duplicate_notification_method(NotificationManagerPlugin* self, FlMethodCall* method_call) {
-  FlValue* args = fl_method_call_get_args(method_call);
-  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+FlMethodResponse* is_duplicate_notification_method(NotificationManagerPlugin* self, FlValue* args) {
+  DuplicateCheckArgs decoded;
+  ArgError error;
+  if (!kDuplicateCheckSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
   }
 
-  FlValue* id_value = fl_value_lookup_string(args, "id");
-  FlValue* time_window_value = fl_value_lookup_int(args, "timeWindowSeconds");
+  bool is_duplicate = is_duplicate_notification(self, decoded.id, decoded.time_window_seconds);
+  g_autoptr(FlValue) result = fl_value_new_bool(is_duplicate);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* clear_notification_history(NotificationManagerPlugin* self, FlValue* args) {
+  self->preferences->Clear();
+  self->dedupe_table->Clear();
+  self->history_log->Clear();
 
-  if (!id_value || !time_window_value) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static const char* history_kind_name(HistoryKind kind) {
+  switch (kind) {
+    case HistoryKind::kAction:
+      return "action";
+    case HistoryKind::kClosed:
+      return "closed";
+    default:
+      return "shown";
+  }
+}
+
+// Cursors are the sequence number of the last record on the previous page.
+// Dart treats them as opaque.
+FlMethodResponse* get_notification_history(NotificationManagerPlugin* self, FlValue* args) {
+  RangeArgs decoded;
+  ArgError error;
+  if (!kRangeSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  if (decoded.limit <= 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'limit' must be positive", nullptr));
+  }
+  guint64 after = 0;
+  if (!decoded.cursor.empty()) {
+    gchar* end = nullptr;
+    after = g_ascii_strtoull(decoded.cursor.c_str(), &end, 10);
+    if (end == decoded.cursor.c_str() || *end != '\0') after = 0;
+  }
+  if (!decoded.cursor.empty() && after == 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'cursor' is not a valid cursor", nullptr));
   }
 
-  const gchar* id = fl_value_get_string(id_value);
-  int time_window_seconds = fl_value_get_int(time_window_value);
+  std::vector<HistoryRecord> records;
+  bool more = self->history_log->Query(decoded.start, decoded.end, after,
+                                       static_cast<size_t>(decoded.limit), &records);
+
+  g_autoptr(FlValue) entries = fl_value_new_list();
+  for (const HistoryRecord& record : records) {
+    FlValue* entry = fl_value_new_map();
+    fl_value_set_string_take(entry, "type", fl_value_new_string(history_kind_name(record.kind)));
+    fl_value_set_string_take(entry, "notificationId", fl_value_new_string(record.id.c_str()));
+    if (!record.title.empty()) {
+      fl_value_set_string_take(entry, "title", fl_value_new_string(record.title.c_str()));
+    }
+    if (!record.action.empty()) {
+      fl_value_set_string_take(entry, "actionId", fl_value_new_string(record.action.c_str()));
+    }
+    fl_value_set_string_take(entry, "timestamp", fl_value_new_int(record.time_ms));
+    fl_value_append_take(entries, entry);
+  }
 
-  bool is_duplicate = is_duplicate_notification(id, time_window_seconds);
-  g_autoptr(FlValue) result = fl_value_new_bool(is_duplicate);
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string(result, "entries", entries);
+  if (more && !records.empty()) {
+    fl_value_set_string_take(result, "nextCursor",
+                             fl_value_new_string(std::to_string(records.back().sequence).c_str()));
+  } else {
+    fl_value_set_string_take(result, "nextCursor", fl_value_new_null());
+  }
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* clear_notification_history(NotificationManagerPlugin* self) {
-  std::string data_dir = get_user_data_dir();
-  std::string pref_file = data_dir + "/" + PREF_FILE;
+static gint64 now_ms(NotificationManagerPlugin* self) {
+  return self->clock->RealTimeUs() / 1000;
+}
 
-  if (g_file_test(pref_file.c_str(), G_FILE_TEST_EXISTS)) {
-    g_remove(pref_file.c_str());
+// Encodes the snapshot here and leaves the write to the I/O thread.
+static void flush_scheduled_snapshot(NotificationManagerPlugin* self) {
+  if (self->snapshot_write_source != 0) {
+    g_source_remove(self->snapshot_write_source);
+    self->snapshot_write_source = 0;
+  }
+  if (!self->scheduled_dirty) return;
+
+  std::vector<IoThread::Task> waiters;
+  waiters.swap(self->snapshot_waiters);
+  IoThread::Task done = nullptr;
+  if (!waiters.empty()) {
+    done = [waiters]() {
+      for (const auto& waiter : waiters) waiter();
+    };
+  }
+  // Rewrite only the shards whose entries changed. Clear() drops the
+  // change log, so cancelling everything rewrites every shard, each empty.
+  const ScheduledStore& store = self->scheduled_notifications;
+  std::vector<bool> dirty(kScheduledShardCount, self->snapshot_rewrite_all);
+  std::vector<ScheduledStore::Change> changes;
+  if (!self->snapshot_rewrite_all) {
+    if (store.ChangesSince(self->snapshot_flushed_version, &changes)) {
+      for (const auto& change : changes) {
+        dirty[ScheduledShardOf(change.id, kScheduledShardCount)] = true;
+      }
+    } else {
+      dirty.assign(kScheduledShardCount, true);
+    }
   }
 
-  g_autoptr(FlValue) result = fl_value_new_bool(true);
-  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  // Changes made after this one are still ahead of the files once they
+  // land. Writes complete in order, so the last one reports for all.
+  std::shared_ptr<guint64> landed = self->snapshot_landed_version;
+  guint64 version = store.version();
+  IoThread::Task landed_done = [landed, version, done]() {
+    *landed = MAX(*landed, version);
+    if (done) done();
+  };
+  uint32_t last = kScheduledShardCount;
+  while (last > 0 && !dirty[last - 1]) last--;
+  Durability durability = stronger(self->durability, self->snapshot_durability);
+  for (uint32_t shard = 0; shard < last; shard++) {
+    if (!dirty[shard]) continue;
+    self->io_thread->PostReplaceFile(
+        ScheduledShardPath(self->scheduled_shard_dir, shard),
+        notification_manager::EncodeScheduledSnapshot(store, self->snapshot_writer,
+                                                      SnapshotShard{shard, kScheduledShardCount}),
+        durability, shard + 1 == last ? landed_done : nullptr);
+  }
+  if (last == 0) self->io_thread->Post(nullptr, landed_done);
+  if (self->snapshot_rewrite_all) {
+    // Queued after the shards, so the old snapshot goes only once they are
+    // written.
+    self->io_thread->PostRemoveFile(GetDataDir() + "/" + LEGACY_SCHEDULED_SNAPSHOT_FILE);
+  }
+  self->snapshot_flushed_version = version;
+  self->snapshot_rewrite_all = false;
+  self->scheduled_dirty = false;
+  self->snapshot_durability = Durability::kNone;
 }
 
-FlMethodResponse* schedule_notification(NotificationManagerPlugin* self, FlMethodCall* method_call) {
-  FlValue* args = fl_method_call_get_args(method_call);
-  
-  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+void notification_manager_plugin_when_persisted(NotificationManagerPlugin* self,
+                                                std::function<void()> done) {
+  if (self->scheduled_dirty) {
+    // The snapshot write is queued after every earlier preference write.
+    self->snapshot_waiters.push_back(std::move(done));
+  } else if (!self->io_thread->idle()) {
+    self->io_thread->Post(nullptr, std::move(done));
+  } else {
+    done();
   }
+}
 
-  FlValue* id_value = fl_value_lookup_string(args, "id");
-  FlValue* request_value = fl_value_lookup_string(args, "request");
-  FlValue* scheduled_date_value = fl_value_lookup_int(args, "scheduledDate");
-  FlValue* is_repeating_value = fl_value_lookup_bool(args, "isRepeating");
-  FlValue* repeat_interval_value = fl_value_lookup_int(args, "repeatInterval");
+static gboolean snapshot_write_cb(gpointer user_data) {
+  NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(user_data);
+  self->snapshot_write_source = 0;
+  flush_scheduled_snapshot(self);
 
-  if (!id_value || !request_value || !scheduled_date_value) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  // Tell listeners there is something new to fetch with
+  // getScheduledChanges, once per burst of changes.
+  if (self->event_listening) {
+    g_autoptr(FlValue) event = fl_value_new_map();
+    fl_value_set_string_take(event, "type", fl_value_new_string("scheduledChanged"));
+    fl_value_set_string_take(
+        event, "version",
+        fl_value_new_int(static_cast<int64_t>(self->scheduled_notifications.version())));
+    fl_event_channel_send(self->event_channel, event, nullptr, nullptr);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+// Writes the snapshot once the main loop is idle, so a burst of schedule
+// or cancel calls costs a single write.
+static void mark_scheduled_dirty(NotificationManagerPlugin* self) {
+  self->scheduled_dirty = true;
+  if (self->snapshot_write_source == 0) {
+    self->snapshot_write_source = g_idle_add(snapshot_write_cb, self);
   }
+}
+
+static gboolean scheduler_cb(gpointer user_data);
+
+// Arms the timer for the next batch of entries, replacing any timer armed
+// for a different time. With a slack of a second or more, the timer is a
+// whole-second one so it shares wakeups with the rest of the process.
+static void arm_scheduler(NotificationManagerPlugin* self) {
+  gint64 fire_at_ms = self->scheduled_notifications.CoalescedFireTime(self->scheduler_slack_ms);
+  if (self->scheduler_source != 0) {
+    if (self->scheduler_fire_at_ms == fire_at_ms) return;
+    self->clock->RemoveTimeout(self->scheduler_source);
+    self->scheduler_source = 0;
+    self->scheduler_fire_at_ms = 0;
+  }
+  if (fire_at_ms <= 0) return;
+
+  gint64 delay_ms = CLAMP(fire_at_ms - now_ms(self), 0, MAX_SCHEDULER_WAIT_MS);
+  self->scheduler_fire_at_ms = fire_at_ms;
+  if (self->scheduler_slack_ms >= 1000 && delay_ms >= 1000) {
+    self->scheduler_source = self->clock->AddTimeoutSeconds(
+        static_cast<guint>((delay_ms + 999) / 1000), scheduler_cb, self);
+  } else {
+    self->scheduler_source =
+        self->clock->AddTimeout(static_cast<guint>(delay_ms), scheduler_cb, self);
+  }
+}
+
+struct MissedEntry {
+  std::string id;
+  std::string category;
+  bool repeating;
+  NotificationContent content;
+};
+
+static gboolean catch_up_cb(gpointer user_data);
+
+// Shows the next burst of missed entries and keeps a timer running while
+// more are queued.
+static void drain_catch_up(NotificationManagerPlugin* self) {
+  for (int i = 0; i < CATCH_UP_BURST && !self->catch_up_queue.empty(); i++) {
+    auto entry = std::move(self->catch_up_queue.front());
+    self->catch_up_queue.pop_front();
+    display_notification(self, entry.first, entry.second);
+  }
+  if (!self->catch_up_queue.empty() && self->catch_up_source == 0) {
+    self->catch_up_source = self->clock->AddTimeout(CATCH_UP_INTERVAL_MS, catch_up_cb, self);
+  }
+}
+
+static gboolean catch_up_cb(gpointer user_data) {
+  NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(user_data);
+  self->catch_up_source = 0;
+  drain_catch_up(self);
+  return G_SOURCE_REMOVE;
+}
+
+// Stops the scheduler and catch-up timers and the clock watch, e.g. before
+// the clock they run on goes away.
+static void remove_timers(NotificationManagerPlugin* self) {
+  if (self->clock_watch_source != 0) {
+    self->clock->RemoveTimeout(self->clock_watch_source);
+    self->clock_watch_source = 0;
+  }
+  if (self->scheduler_source != 0) {
+    self->clock->RemoveTimeout(self->scheduler_source);
+    self->scheduler_source = 0;
+    self->scheduler_fire_at_ms = 0;
+  }
+  if (self->catch_up_source != 0) {
+    self->clock->RemoveTimeout(self->catch_up_source);
+    self->catch_up_source = 0;
+  }
+}
+
+// Applies the catch-up policy to |missed|, which is in fire-time order, and
+// queues the result to go out under the rate limit.
+static void queue_catch_up(NotificationManagerPlugin* self, std::vector<MissedEntry> missed) {
+  switch (self->catch_up_policy) {
+    case CatchUpPolicy::kFireAll:
+      for (auto& entry : missed) {
+        self->catch_up_queue.emplace_back(std::move(entry.id), std::move(entry.content));
+      }
+      break;
+
+    case CatchUpPolicy::kLatestPerSeries: {
+      // A repeating entry is its own series and shows once anyway. Keys of
+      // single-entry series start with a NUL so they never meet a category.
+      std::map<std::string, size_t> latest;
+      for (size_t i = 0; i < missed.size(); i++) {
+        if (missed[i].repeating || missed[i].category.empty()) {
+          latest[std::string(1, '\0') + missed[i].id] = i;
+        } else {
+          latest[missed[i].category] = i;
+        }
+      }
+      std::vector<size_t> kept;
+      for (const auto& pair : latest) kept.push_back(pair.second);
+      std::sort(kept.begin(), kept.end());
+      for (size_t i : kept) {
+        self->catch_up_queue.emplace_back(std::move(missed[i].id), std::move(missed[i].content));
+      }
+      break;
+    }
+
+    case CatchUpPolicy::kSummary: {
+      // A summary of one entry says less than the entry itself.
+      if (missed.size() == 1) {
+        self->catch_up_queue.emplace_back(std::move(missed[0].id), std::move(missed[0].content));
+        break;
+      }
+      NotificationContent summary;
+      summary.title = std::to_string(missed.size()) + " missed notifications";
+      for (size_t i = 0; i < missed.size() && i < MISSED_SUMMARY_MAX_TITLES; i++) {
+        if (i > 0) summary.body += "\n";
+        summary.body += missed[i].content.title;
+      }
+      if (missed.size() > MISSED_SUMMARY_MAX_TITLES) {
+        summary.body +=
+            "\nand " + std::to_string(missed.size() - MISSED_SUMMARY_MAX_TITLES) + " more";
+      }
+      self->catch_up_queue.emplace_back(MISSED_SUMMARY_ID, std::move(summary));
+      break;
+    }
+  }
+  drain_catch_up(self);
+}
+
+#define LOCAL_TIME_ZONE_FILE "/etc/localtime"
+
+static void time_zone_changed_cb(GFileMonitor* monitor, GFile* file, GFile* other_file,
+                                 GFileMonitorEvent event_type, gpointer user_data) {
+  NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(user_data);
+  g_clear_pointer(&self->local_time_zone, g_time_zone_unref);
+}
+
+// The local time zone. Reading it costs file I/O, so it is loaded when a
+// recurrence rule first needs it rather than at registration, and loaded
+// again after /etc/localtime changes, e.g. through timedatectl.
+static GTimeZone* local_time_zone(NotificationManagerPlugin* self) {
+  if (self->local_time_zone != nullptr) return self->local_time_zone;
+
+  if (self->time_zone_monitor == nullptr) {
+    g_autoptr(GFile) file = g_file_new_for_path(LOCAL_TIME_ZONE_FILE);
+    self->time_zone_monitor = g_file_monitor_file(file, G_FILE_MONITOR_NONE, nullptr, nullptr);
+    if (self->time_zone_monitor != nullptr) {
+      g_signal_connect(self->time_zone_monitor, "changed", G_CALLBACK(time_zone_changed_cb),
+                       self);
+    }
+  }
+  // Unlike g_time_zone_new_local(), not served from GLib's cache, which
+  // only notices a changed TZ variable.
+  self->local_time_zone = g_time_zone_new_identifier(nullptr);
+  return self->local_time_zone;
+}
+
+static const RecurrenceRule* compile_recurrence(NotificationManagerPlugin* self,
+                                                const std::string& spec, std::string* error) {
+  auto it = self->recurrence_rules.find(spec);
+  if (it != self->recurrence_rules.end()) return &it->second;
+
+  RecurrenceRule rule;
+  if (!RecurrenceRule::Parse(spec, &rule, error)) return nullptr;
+  return &self->recurrence_rules.emplace(spec, rule).first->second;
+}
+
+// Next fire time of |record| after it fired at |now|, or 0 if it does not
+// repeat. Missed repeats are collapsed into the one just shown.
+static gint64 next_fire_time(NotificationManagerPlugin* self,
+                             const ScheduledStore::Record& record, gint64 now) {
+  if (record.recurrence.length > 0) {
+    std::string error;
+    const RecurrenceRule* rule = compile_recurrence(
+        self, self->scheduled_notifications.GetString(record.recurrence), &error);
+    return rule ? rule->NextAfter(MAX(now, record.fire_at_ms), local_time_zone(self)) : 0;
+  }
+  if (record.repeat_interval_s <= 0) return 0;
+
+  gint64 interval_ms = record.repeat_interval_s * 1000;
+  return record.fire_at_ms + (MAX(now - record.fire_at_ms, 0) / interval_ms + 1) * interval_ms;
+}
+
+// Shows every entry due by |due_by_ms| as one batch. One-shot entries are
+// removed and repeating ones move to their next future fire time. The
+// timer is then re-armed for the next batch.
+static guint fire_due_scheduled(NotificationManagerPlugin* self, gint64 due_by_ms) {
+  gint64 now = now_ms(self);
+
+  std::vector<std::string> due;
+  self->scheduled_notifications.ForEachByFireTime(
+      0, due_by_ms + 1, nullptr, SIZE_MAX, [&](const ScheduledStore::Record& record) {
+        due.push_back(self->scheduled_notifications.GetString(record.id));
+      });
+
+  gint64 missed_before_ms = now - self->scheduler_slack_ms - MISSED_GRACE_MS;
+  std::vector<MissedEntry> missed;
+  for (const auto& id : due) {
+    ScheduledStore::Record record;
+    self->scheduled_notifications.Find(id, &record);
+    if (record.fire_at_ms < missed_before_ms) {
+      bool repeating = record.repeat_interval_s > 0 || record.recurrence.length > 0;
+      missed.push_back(MissedEntry{id, self->scheduled_notifications.GetString(record.category),
+                                   repeating, self->scheduled_notifications.ContentOf(record)});
+    } else {
+      display_notification(self, id, self->scheduled_notifications.ContentOf(record));
+    }
+
+    gint64 next_fire_at_ms = next_fire_time(self, record, now);
+    if (next_fire_at_ms == 0) {
+      self->scheduled_notifications.Remove(id);
+    } else {
+      self->scheduled_notifications.SetFireTime(id, next_fire_at_ms);
+    }
+  }
+
+  if (!due.empty()) {
+    mark_scheduled_dirty(self);
+  }
+  if (!missed.empty()) {
+    queue_catch_up(self, std::move(missed));
+  }
+  arm_scheduler(self);
+  return due.size();
+}
+
+static gboolean scheduler_cb(gpointer user_data) {
+  NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(user_data);
+  // Whole-second timers may run up to a second early; what they were armed
+  // for counts as due rather than costing another wakeup. A timer cut short
+  // by MAX_SCHEDULER_WAIT_MS is not near its target and only re-arms.
+  gint64 due_by_ms = now_ms(self);
+  if (self->scheduler_fire_at_ms - due_by_ms <= 1000) {
+    due_by_ms = MAX(due_by_ms, self->scheduler_fire_at_ms);
+  }
+  self->scheduler_source = 0;
+  self->scheduler_fire_at_ms = 0;
+  self->scheduler_wakeups++;
+  fire_due_scheduled(self, due_by_ms);
+  return G_SOURCE_REMOVE;
+}
+
+// The scheduler timer counts monotonic time, so once the wall clock has
+// moved against it, e.g. over a sleep or when the time is set, the armed
+// wait is wrong. Drops it and fires what is due now, which re-arms.
+static guint refire_scheduled(NotificationManagerPlugin* self) {
+  if (self->scheduler_source != 0) {
+    self->clock->RemoveTimeout(self->scheduler_source);
+    self->scheduler_source = 0;
+    self->scheduler_fire_at_ms = 0;
+  }
+  return fire_due_scheduled(self, now_ms(self));
+}
+
+static gboolean clock_set_cb(gpointer user_data) {
+  NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(user_data);
+  guint fired = refire_scheduled(self);
+  g_debug("Wall clock was set, %u scheduled notifications were due", fired);
+  return G_SOURCE_CONTINUE;
+}
+
+// Entries written by versions without a snapshot only exist in the
+// preferences and have no fire time. They are kept so they can still be
+// listed and cancelled, but are never armed.
+static void migrate_legacy_scheduled(NotificationManagerPlugin* self) {
+  auto legacy = self->preferences->GetWithPrefix(SCHEDULED_KEY_PREFIX);
+  if (legacy.empty()) return;
+
+  for (const auto& pair : legacy) {
+    ScheduledRequest request;
+    request.id = pair.first.substr(strlen(SCHEDULED_KEY_PREFIX));
+    notification_manager::ScheduledRequestFromJson(pair.second, &request);
+    if (!self->scheduled_notifications.Contains(request.id)) {
+      self->scheduled_notifications.Put(request);
+    }
+    if (request.payload) fl_value_unref(request.payload);
+  }
+  self->preferences->RemoveWithPrefix(SCHEDULED_KEY_PREFIX);
+  self->snapshot_rewrite_all = true;
+  mark_scheduled_dirty(self);
+}
+
+static FlValue* string_list(const std::vector<std::string>& values) {
+  FlValue* list = fl_value_new_list();
+  for (const auto& value : values) fl_value_append_take(list, fl_value_new_string(value.c_str()));
+  return list;
+}
+
+// Applies what other processes wrote to shards [first, last).
+static void reload_scheduled_shards(NotificationManagerPlugin* self, uint32_t first,
+                                    uint32_t last) {
+  if (!self->scheduled_restored) return;
+
+  // Entries changed here since the last write that landed are about to be
+  // written out, and win over whatever the other process wrote.
+  std::vector<ScheduledStore::Change> changes;
+  if (!self->scheduled_notifications.ChangesSince(*self->snapshot_landed_version, &changes)) {
+    // Too much changed here to tell what; the pending write replaces the
+    // file wholesale.
+    return;
+  }
+  std::unordered_set<std::string> local;
+  for (auto& change : changes) local.insert(std::move(change.id));
+
+  gint64 start = g_get_monotonic_time();
+  std::vector<std::string> upserted;
+  std::vector<std::string> removed;
+  size_t decoded = 0;
+  for (uint32_t shard = first; shard < last; shard++) {
+    SnapshotReload reload;
+    if (!notification_manager::ReloadScheduledSnapshot(
+            ScheduledShardPath(self->scheduled_shard_dir, shard), self->snapshot_writer, local,
+            &self->scheduled_notifications, &reload, SnapshotShard{shard, kScheduledShardCount})) {
+      continue;
+    }
+    upserted.insert(upserted.end(), reload.upserted.begin(), reload.upserted.end());
+    removed.insert(removed.end(), reload.removed.begin(), reload.removed.end());
+    decoded += reload.decoded;
+  }
+  if (upserted.empty() && removed.empty()) return;
+
+  // The file already holds what was just applied, so it does not make the
+  // store dirty.
+  if (local.empty()) {
+    *self->snapshot_landed_version = self->scheduled_notifications.version();
+    self->snapshot_flushed_version = MAX(self->snapshot_flushed_version,
+                                         *self->snapshot_landed_version);
+  }
+  arm_scheduler(self);
+  g_debug("Reloaded %zu scheduled and %zu cancelled entries (%zu decoded) in %" G_GINT64_FORMAT
+          " us",
+          upserted.size(), removed.size(), decoded, g_get_monotonic_time() - start);
+
+  if (self->event_listening) {
+    g_autoptr(FlValue) event = fl_value_new_map();
+    fl_value_set_string_take(event, "type", fl_value_new_string("scheduledReloaded"));
+    fl_value_set_string_take(
+        event, "version",
+        fl_value_new_int(static_cast<int64_t>(self->scheduled_notifications.version())));
+    fl_value_set_string_take(event, "scheduled", string_list(upserted));
+    fl_value_set_string_take(event, "cancelled", string_list(removed));
+    fl_event_channel_send(self->event_channel, event, nullptr, nullptr);
+  }
+}
 
-  const gchar* id = fl_value_get_string(id_value);
-  const gchar* request_json = fl_value_get_string(request_value);
-  int64_t scheduled_date = fl_value_get_int(scheduled_date_value);
-  bool is_repeating = is_repeating_value ? fl_value_get_bool(is_repeating_value) : false;
-  int repeat_interval = repeat_interval_value ? fl_value_get_int(repeat_interval_value) : 0;
+void notification_manager_plugin_reload_scheduled(NotificationManagerPlugin* self) {
+  reload_scheduled_shards(self, 0, kScheduledShardCount);
+}
+
+static void snapshot_changed_cb(GFileMonitor* monitor, GFile* file, GFile* other_file,
+                                GFileMonitorEvent event_type, gpointer user_data) {
+  // Shards are renamed into place, which shows up as a new file; a rewrite
+  // in place ends with a hint once it is done.
+  if (event_type != G_FILE_MONITOR_EVENT_CREATED &&
+      event_type != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT) {
+    return;
+  }
+  NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(user_data);
+  g_autofree gchar* path = g_file_get_path(file);
+  for (uint32_t shard = 0; shard < kScheduledShardCount; shard++) {
+    if (ScheduledShardPath(self->scheduled_shard_dir, shard) == path) {
+      reload_scheduled_shards(self, shard, shard + 1);
+      return;
+    }
+  }
+}
+
+static void start_snapshot_monitor(NotificationManagerPlugin* self) {
+  g_mkdir_with_parents(self->scheduled_shard_dir.c_str(), 0755);
+  g_autoptr(GFile) dir = g_file_new_for_path(self->scheduled_shard_dir.c_str());
+  g_autoptr(GError) error = nullptr;
+  self->snapshot_monitor = g_file_monitor_directory(dir, G_FILE_MONITOR_NONE, nullptr, &error);
+  if (self->snapshot_monitor == nullptr) {
+    g_warning("Failed to watch %s: %s", self->scheduled_shard_dir.c_str(), error->message);
+    return;
+  }
+  g_signal_connect(self->snapshot_monitor, "changed", G_CALLBACK(snapshot_changed_cb), self);
+}
+
+void notification_manager_plugin_restore_scheduled(NotificationManagerPlugin* self) {
+  if (self->scheduled_restored) return;
+  self->scheduled_restored = true;
+
+  gint64 start = g_get_monotonic_time();
+  bool found = false;
+  for (uint32_t shard = 0; shard < kScheduledShardCount; shard++) {
+    std::string path = ScheduledShardPath(self->scheduled_shard_dir, shard);
+    if (notification_manager::ReadScheduledSnapshot(path, &self->scheduled_notifications) ||
+        g_file_test(path.c_str(), G_FILE_TEST_EXISTS)) {
+      found = true;
+    }
+  }
+  if (!found) {
+    // Move what earlier versions stored into the shards: first the single
+    // snapshot, or failing that the preferences it once replaced.
+    std::string legacy_path = GetDataDir() + "/" + LEGACY_SCHEDULED_SNAPSHOT_FILE;
+    if (notification_manager::ReadScheduledSnapshot(legacy_path,
+                                                    &self->scheduled_notifications) ||
+        g_file_test(legacy_path.c_str(), G_FILE_TEST_EXISTS)) {
+      self->snapshot_rewrite_all = true;
+      mark_scheduled_dirty(self);
+    } else {
+      migrate_legacy_scheduled(self);
+    }
+  }
+  // Versions continue from the wall clock, so one handed out by a previous
+  // run is always behind and gets a full listing.
+  self->scheduled_notifications.ResetChangeLog(
+      static_cast<uint64_t>(self->clock->RealTimeUs()));
+  self->snapshot_flushed_version = self->scheduled_notifications.version();
+  // Until a migration has been written out, the shards do not hold the
+  // store, and reloading them is held off.
+  if (!self->snapshot_rewrite_all) {
+    *self->snapshot_landed_version = self->scheduled_notifications.version();
+  }
+
+  self->sleep_monitor->Start();
+  self->clock_watch_source = self->clock->AddRealTimeWatch(clock_set_cb, self);
+  start_snapshot_monitor(self);
+
+  guint fired = fire_due_scheduled(self, now_ms(self));
+  g_debug("Restored %zu scheduled notifications (%u caught up) in %" G_GINT64_FORMAT " us",
+          self->scheduled_notifications.size(), fired, g_get_monotonic_time() - start);
+}
+
+void notification_manager_plugin_handle_sleep(NotificationManagerPlugin* self, bool sleeping) {
+  if (!self->scheduled_restored) return;
+  if (sleeping) {
+    // The machine may not come back; keep the snapshot current.
+    flush_scheduled_snapshot(self);
+    return;
+  }
+  // The timer counts monotonic time, which stood still during the sleep.
+  guint fired = refire_scheduled(self);
+  g_debug("Resumed from sleep, %u scheduled notifications were due", fired);
+}
+
+static gboolean restore_scheduled_cb(gpointer user_data) {
+  notification_manager_plugin_restore_scheduled(NOTIFICATION_MANAGER_PLUGIN(user_data));
+  return G_SOURCE_REMOVE;
+}
+
+// Decodes a ScheduledNotification, as passed to scheduleNotification and
+// found on each line of an import. The payload in |request| is borrowed
+// from |args|.
+static bool decode_scheduled_request(NotificationManagerPlugin* self, FlValue* args,
+                                     ScheduledRequest* request, ArgError* error) {
+  ScheduleArgs decoded;
+  RequestArgs request_args;
+  if (!kScheduleSchema.Decode(args, &decoded, error)) {
+    return false;
+  }
+  if (!kRequestSchema.Decode(decoded.request, &request_args, error)) {
+    error->key = "request." + error->key;
+    return false;
+  }
+
+  request->id = decoded.id;
+  request->title = request_args.title;
+  request->body = request_args.body;
+  request->category = request_args.category;
+  request->group = request_args.group;
+  if (!decode_actions(request_args.actions, "request.actions", &request->actions, error)) {
+    return false;
+  }
+  request->payload = request_args.payload;
+  request->timeout_s = request_args.timeout;
+  request->badge_number = request_args.badge_number;
+  request->fire_at_ms = decoded.scheduled_date;
+  request->repeat_interval_s = decoded.is_repeating ? decoded.repeat_interval : 0;
+  if (!decoded.recurrence.empty()) {
+    const RecurrenceRule* rule = compile_recurrence(self, decoded.recurrence, &error->message);
+    if (rule == nullptr) {
+      error->key = "recurrence";
+      return false;
+    }
+    // The rule takes over from the interval; scheduledDate is where it
+    // starts.
+    request->recurrence = decoded.recurrence;
+    request->repeat_interval_s = 0;
+    request->fire_at_ms = rule->NextAfter(decoded.scheduled_date - 1, local_time_zone(self));
+    if (request->fire_at_ms == 0) {
+      *error = ArgError{"recurrence", "Recurrence rule never matches"};
+      return false;
+    }
+  }
+  return true;
+}
+
+FlMethodResponse* schedule_notification(NotificationManagerPlugin* self, FlValue* args) {
+  ScheduledRequest request;
+  ArgError error;
+  if (!decode_scheduled_request(self, args, &request, &error)) {
+    return arg_error_response(error);
+  }
 
   // Store scheduled notification
-  std::string key = SCHEDULED_KEY_PREFIX + std::string(id);
-  std::string notification_data = std::string(request_json);
-  self->scheduled_notifications[id] = notification_data;
-  save_preferences(key, notification_data);
+  notification_manager_plugin_restore_scheduled(self);
+  self->scheduled_notifications.Put(request);
+  mark_scheduled_dirty(self);
+  arm_scheduler(self);
 
-  // For Linux, we'll simulate scheduling by showing the notification immediately
-  // In a production environment, you might want to use a proper scheduler
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* get_scheduled_notifications(NotificationManagerPlugin* self) {
+FlMethodResponse* get_scheduled_notifications(NotificationManagerPlugin* self, FlValue* args) {
+  notification_manager_plugin_restore_scheduled(self);
   g_autoptr(FlValue) result_list = fl_value_new_list();
   
-  for (const auto& pair : self->scheduled_notifications) {
-    g_autoptr(FlValue) notification_obj = fl_value_new_map();
-    fl_value_set_string_take(notification_obj, "id", g_strdup(pair.first.c_str()));
-    fl_value_set_string_take(notification_obj, "data", g_strdup(pair.second.c_str()));
-    fl_value_append_take(result_list, fl_value_ref(notification_obj));
-  }
+  self->scheduled_notifications.ForEach([&](const ScheduledStore::Record& record) {
+    fl_value_append_take(result_list, self->scheduled_notifications.ToFlValue(record));
+  });
   
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result_list));
 }
 
-FlMethodResponse* update_scheduled_notification(NotificationManagerPlugin* self, FlMethodCall* method_call) {
-  FlValue* args = fl_method_call_get_args(method_call);
-  
-  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+// Cursors are "<fire time>:<id>" of the last entry on the previous page.
+// Dart treats them as opaque.
+static bool parse_fire_cursor(const std::string& cursor, ScheduledStore::FireCursor* out) {
+  const char* start = cursor.c_str();
+  gchar* end = nullptr;
+  gint64 fire_at_ms = g_ascii_strtoll(start, &end, 10);
+  if (end == start || *end != ':') return false;
+  out->fire_at_ms = fire_at_ms;
+  out->id = end + 1;
+  return true;
+}
+
+// Returns {notifications, nextCursor} with up to |limit| entries firing in
+// [from_ms, to_ms), continuing after |cursor| when it is set.
+static FlMethodResponse* scheduled_page_response(NotificationManagerPlugin* self, int64_t from_ms,
+                                                 int64_t to_ms, const std::string& cursor,
+                                                 int64_t limit) {
+  if (limit <= 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'limit' must be positive", nullptr));
+  }
+  ScheduledStore::FireCursor after;
+  if (!cursor.empty() && !parse_fire_cursor(cursor, &after)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'cursor' is not a valid cursor", nullptr));
+  }
+  notification_manager_plugin_restore_scheduled(self);
+
+  g_autoptr(FlValue) notifications = fl_value_new_list();
+  std::string last_cursor;
+  bool more = self->scheduled_notifications.ForEachByFireTime(
+      from_ms, to_ms, cursor.empty() ? nullptr : &after, static_cast<size_t>(limit),
+      [&](const ScheduledStore::Record& record) {
+        fl_value_append_take(notifications, self->scheduled_notifications.ToFlValue(record));
+        last_cursor = std::to_string(record.fire_at_ms) + ":" +
+                      self->scheduled_notifications.GetString(record.id);
+      });
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string(result, "notifications", notifications);
+  if (more && !last_cursor.empty()) {
+    fl_value_set_string_take(result, "nextCursor", fl_value_new_string(last_cursor.c_str()));
+  } else {
+    fl_value_set_string_take(result, "nextCursor", fl_value_new_null());
   }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
 
-  FlValue* id_value = fl_value_lookup_string(args, "id");
-  if (!id_value) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+FlMethodResponse* get_next_scheduled_notifications(NotificationManagerPlugin* self, FlValue* args) {
+  PageArgs decoded;
+  ArgError error;
+  if (!kPageSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
   }
+  return scheduled_page_response(self, 0, G_MAXINT64, decoded.cursor, decoded.limit);
+}
 
-  const gchar* id = fl_value_get_string(id_value);
-  
-  // Update the scheduled notification
-  std::string key = SCHEDULED_KEY_PREFIX + std::string(id);
-  std::string notification_data = "{}"; // Simplified for demo
-  self->scheduled_notifications[id] = notification_data;
-  save_preferences(key, notification_data);
+FlMethodResponse* get_scheduled_notifications_in_range(NotificationManagerPlugin* self,
+                                                      FlValue* args) {
+  RangeArgs decoded;
+  ArgError error;
+  if (!kRangeSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  return scheduled_page_response(self, decoded.start, decoded.end, decoded.cursor, decoded.limit);
+}
 
-  g_autoptr(FlValue) result = fl_value_new_bool(true);
+FlMethodResponse* get_scheduled_changes(NotificationManagerPlugin* self, FlValue* args) {
+  ChangesArgs decoded;
+  ArgError error;
+  if (!kChangesSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  notification_manager_plugin_restore_scheduled(self);
+
+  ScheduledStore& store = self->scheduled_notifications;
+  g_autoptr(FlValue) inserted = fl_value_new_list();
+  g_autoptr(FlValue) updated = fl_value_new_list();
+  g_autoptr(FlValue) removed = fl_value_new_list();
+  std::vector<ScheduledStore::Change> changes;
+  bool full_snapshot =
+      decoded.since_version < 0 ||
+      !store.ChangesSince(static_cast<uint64_t>(decoded.since_version), &changes);
+  if (full_snapshot) {
+    // Too far behind for the change log: the reader replaces its copy.
+    store.ForEach([&](const ScheduledStore::Record& record) {
+      fl_value_append_take(inserted, store.ToFlValue(record));
+    });
+  }
+  for (const auto& change : changes) {
+    if (change.kind == ScheduledStore::ChangeKind::kRemove) {
+      fl_value_append_take(removed, fl_value_new_string(change.id.c_str()));
+      continue;
+    }
+    ScheduledStore::Record record;
+    store.Find(change.id, &record);
+    fl_value_append_take(change.kind == ScheduledStore::ChangeKind::kInsert ? inserted : updated,
+                         store.ToFlValue(record));
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "version",
+                           fl_value_new_int(static_cast<int64_t>(store.version())));
+  fl_value_set_string_take(result, "isFullSnapshot", fl_value_new_bool(full_snapshot));
+  fl_value_set_string(result, "inserted", inserted);
+  fl_value_set_string(result, "updated", updated);
+  fl_value_set_string(result, "removed", removed);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* cancel_scheduled_notification(NotificationManagerPlugin* self, FlMethodCall* method_call) {
-  FlValue* args = fl_method_call_get_args(method_call);
-  
-  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
-  }
+FlMethodResponse* update_scheduled_notification(NotificationManagerPlugin* self, FlValue* args) {
+  // An update carries the whole scheduled notification, so it is stored
+  // exactly like a new one.
+  return schedule_notification(self, args);
+}
 
-  FlValue* id_value = fl_value_lookup_string(args, "id");
-  if (!id_value) {
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+FlMethodResponse* cancel_scheduled_notification(NotificationManagerPlugin* self, FlValue* args) {
+  IdArgs decoded;
+  ArgError error;
+  if (!kIdSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
   }
+  notification_manager_plugin_restore_scheduled(self);
 
-  const gchar* id = fl_value_get_string(id_value);
-  
+  drop_catch_up(self, decoded.id);
   // Remove from scheduled notifications
-  self->scheduled_notifications.erase(id);
-  
-  // Remove from preferences
-  std::string key = SCHEDULED_KEY_PREFIX + std::string(id);
-  std::string data_dir = get_user_data_dir();
-  std::string pref_file = data_dir + "/" + PREF_FILE;
-  
-  if (g_file_test(pref_file.c_str(), G_FILE_TEST_EXISTS)) {
-    JsonParser* parser = json_parser_new();
-    if (json_parser_load_from_file(parser, pref_file.c_str(), nullptr)) {
-      JsonNode* root = json_parser_get_root(parser);
-      if (json_node_get_node_type(root) == JSON_NODE_OBJECT) {
-        JsonObject* root_obj = json_node_get_object(root);
-        json_object_remove_member(root_obj, key.c_str());
-        
-        JsonGenerator* generator = json_generator_new();
-        json_generator_set_root(generator, root);
-        json_generator_to_file(generator, pref_file.c_str(), nullptr);
-        g_object_unref(generator);
-      }
-    }
-    g_object_unref(parser);
+  if (self->scheduled_notifications.Remove(decoded.id)) {
+    mark_scheduled_dirty(self);
+    arm_scheduler(self);
   }
 
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* cancel_all_scheduled_notifications(NotificationManagerPlugin* self) {
+FlMethodResponse* cancel_all_scheduled_notifications(NotificationManagerPlugin* self, FlValue* args) {
+  notification_manager_plugin_restore_scheduled(self);
+
   // Clear all scheduled notifications
-  self->scheduled_notifications.clear();
-  
-  // Clear all scheduled notification preferences
-  std::string data_dir = get_user_data_dir();
-  std::string pref_file = data_dir + "/" + PREF_FILE;
-  
-  if (g_file_test(pref_file.c_str(), G_FILE_TEST_EXISTS)) {
-    JsonParser* parser = json_parser_new();
-    if (json_parser_load_from_file(parser, pref_file.c_str(), nullptr)) {
-      JsonNode* root = json_parser_get_root(parser);
-      if (json_node_get_node_type(root) == JSON_NODE_OBJECT) {
-        JsonObject* root_obj = json_node_get_object(root);
-        
-        // Get all keys and remove scheduled ones
-        g_autoptr(GList) keys = json_object_get_members(root_obj);
-        for (GList* iter = keys; iter != nullptr; iter = iter->next) {
-          const char* key = static_cast<const char*>(iter->data);
-          if (g_str_has_prefix(key, SCHEDULED_KEY_PREFIX)) {
-            json_object_remove_member(root_obj, key);
+  self->scheduled_notifications.Clear();
+  self->catch_up_queue.clear();
+  mark_scheduled_dirty(self);
+  arm_scheduler(self);
+
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// An export or import of scheduled notifications. Only one chunk is in
+// memory at a time: the next is encoded or read once the I/O thread is done
+// with the last one. Holds a reference on the plugin until it finishes.
+struct ScheduledTransfer {
+  NotificationManagerPlugin* self;
+  guint64 id;
+  bool exporting;
+  std::string path;
+  size_t chunk_size;
+  // Entries written or scheduled, and lines skipped as invalid.
+  size_t processed = 0;
+  size_t skipped = 0;
+  // Export only: entries when it started, and the id of the last one
+  // encoded.
+  size_t total = 0;
+  bool started = false;
+  std::string after_id;
+  // Used on the I/O thread only.
+  NdjsonWriter writer;
+  NdjsonReader reader;
+  // Filled on the I/O thread and taken by the completion that follows.
+  std::vector<FlValue*> parsed;
+  size_t invalid = 0;
+  std::string error;
+
+  ~ScheduledTransfer() {
+    for (FlValue* value : parsed) fl_value_unref(value);
+  }
+};
+
+static void send_transfer_event(const ScheduledTransfer& transfer, bool done) {
+  NotificationManagerPlugin* self = transfer.self;
+  if (!self->event_listening) return;
+
+  g_autoptr(FlValue) event = fl_value_new_map();
+  fl_value_set_string_take(event, "type", fl_value_new_string("scheduledTransfer"));
+  fl_value_set_string_take(event, "transferId",
+                           fl_value_new_int(static_cast<int64_t>(transfer.id)));
+  fl_value_set_string_take(event, "direction",
+                           fl_value_new_string(transfer.exporting ? "export" : "import"));
+  fl_value_set_string_take(event, "processed",
+                           fl_value_new_int(static_cast<int64_t>(transfer.processed)));
+  fl_value_set_string_take(event, "skipped",
+                           fl_value_new_int(static_cast<int64_t>(transfer.skipped)));
+  if (transfer.exporting) {
+    fl_value_set_string_take(event, "total",
+                             fl_value_new_int(static_cast<int64_t>(transfer.total)));
+  }
+  fl_value_set_string_take(event, "done", fl_value_new_bool(done));
+  if (!transfer.error.empty()) {
+    fl_value_set_string_take(event, "error", fl_value_new_string(transfer.error.c_str()));
+  }
+  fl_event_channel_send(self->event_channel, event, nullptr, nullptr);
+}
+
+static void finish_transfer(const std::shared_ptr<ScheduledTransfer>& transfer) {
+  NotificationManagerPlugin* self = transfer->self;
+  if (!transfer->error.empty()) {
+    g_warning("Scheduled notification %s failed: %s",
+              transfer->exporting ? "export" : "import", transfer->error.c_str());
+  }
+  send_transfer_event(*transfer, true);
+  self->transfers_in_progress--;
+  g_object_unref(self);
+}
+
+static void export_next_chunk(std::shared_ptr<ScheduledTransfer> transfer) {
+  NotificationManagerPlugin* self = transfer->self;
+  const ScheduledStore& store = self->scheduled_notifications;
+  std::string chunk;
+  size_t count = 0;
+  // Walking by id keeps the place however the store changes in between.
+  const std::string* after = transfer->started ? &transfer->after_id : nullptr;
+  bool more =
+      store.ForEachAfter(after, transfer->chunk_size, [&](const ScheduledStore::Record& record) {
+        AppendScheduledJsonLine(store, record, &chunk);
+        transfer->after_id = store.GetString(record.id);
+        count++;
+      });
+  transfer->started = true;
+
+  self->io_thread->Post(
+      [transfer, chunk = std::move(chunk), more]() {
+        std::string* error = &transfer->error;
+        bool ok = transfer->writer.is_open() || transfer->writer.Open(transfer->path, error);
+        ok = ok && transfer->writer.Append(chunk, error);
+        if (ok && !more) transfer->writer.Commit(error);
+      },
+      [transfer, count, more]() {
+        transfer->processed += count;
+        if (!transfer->error.empty() || !more) {
+          finish_transfer(transfer);
+          return;
+        }
+        send_transfer_event(*transfer, false);
+        export_next_chunk(transfer);
+      });
+}
+
+static void import_next_chunk(std::shared_ptr<ScheduledTransfer> transfer) {
+  transfer->self->io_thread->Post(
+      [transfer]() {
+        std::string* error = &transfer->error;
+        if (!transfer->reader.is_open() && !transfer->reader.Open(transfer->path, error)) return;
+        transfer->reader.ReadChunk(transfer->chunk_size, &transfer->parsed, &transfer->invalid,
+                                   error);
+      },
+      [transfer]() {
+        NotificationManagerPlugin* self = transfer->self;
+        size_t scheduled = 0;
+        for (FlValue* value : transfer->parsed) {
+          ScheduledRequest request;
+          ArgError error;
+          if (decode_scheduled_request(self, value, &request, &error)) {
+            self->scheduled_notifications.Put(request);
+            scheduled++;
+          } else {
+            transfer->skipped++;
           }
+          fl_value_unref(value);
         }
-        
-        JsonGenerator* generator = json_generator_new();
-        json_generator_set_root(generator, root);
-        json_generator_to_file(generator, pref_file.c_str(), nullptr);
-        g_object_unref(generator);
-      }
-    }
-    g_object_unref(parser);
+        transfer->parsed.clear();
+        transfer->processed += scheduled;
+        transfer->skipped += transfer->invalid;
+        transfer->invalid = 0;
+        if (scheduled > 0) {
+          mark_scheduled_dirty(self);
+          arm_scheduler(self);
+        }
+
+        if (!transfer->error.empty() || transfer->reader.at_end()) {
+          finish_transfer(transfer);
+          return;
+        }
+        send_transfer_event(*transfer, false);
+        import_next_chunk(transfer);
+      });
+}
+
+// Starts an export or import and answers with its id; progress and the
+// outcome follow as "scheduledTransfer" events.
+static FlMethodResponse* start_transfer(NotificationManagerPlugin* self, FlValue* args,
+                                        bool exporting) {
+  TransferArgs decoded;
+  ArgError error;
+  if (!kTransferSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  if (!g_path_is_absolute(decoded.path.c_str())) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'path' must be an absolute path", nullptr));
+  }
+  if (decoded.chunk_size <= 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'chunkSize' must be positive", nullptr));
+  }
+  notification_manager_plugin_restore_scheduled(self);
+
+  auto transfer = std::make_shared<ScheduledTransfer>();
+  transfer->self = NOTIFICATION_MANAGER_PLUGIN(g_object_ref(self));
+  transfer->id = ++self->last_transfer_id;
+  transfer->exporting = exporting;
+  transfer->path = decoded.path;
+  transfer->chunk_size = static_cast<size_t>(decoded.chunk_size);
+  transfer->total = exporting ? self->scheduled_notifications.size() : 0;
+  self->transfers_in_progress++;
+  if (exporting) {
+    export_next_chunk(transfer);
+  } else {
+    import_next_chunk(transfer);
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_int(static_cast<int64_t>(transfer->id));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* export_scheduled_notifications(NotificationManagerPlugin* self, FlValue* args) {
+  return start_transfer(self, args, true);
+}
+
+FlMethodResponse* import_scheduled_notifications(NotificationManagerPlugin* self, FlValue* args) {
+  return start_transfer(self, args, false);
+}
+
+guint notification_manager_plugin_get_transfers_in_progress(NotificationManagerPlugin* self) {
+  return self->transfers_in_progress;
+}
+
+FlMethodResponse* set_scheduler_slack(NotificationManagerPlugin* self, FlValue* args) {
+  SlackArgs decoded;
+  ArgError error;
+  if (!kSlackSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  if (decoded.slack_ms < 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", "Argument 'slackMs' must not be negative", nullptr));
+  }
+  notification_manager_plugin_set_scheduler_slack(self, decoded.slack_ms);
+
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* set_catch_up_policy(NotificationManagerPlugin* self, FlValue* args) {
+  PolicyArgs decoded;
+  ArgError error;
+  if (!kPolicySchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  if (decoded.policy == "fireAll") {
+    self->catch_up_policy = CatchUpPolicy::kFireAll;
+  } else if (decoded.policy == "latestPerSeries") {
+    self->catch_up_policy = CatchUpPolicy::kLatestPerSeries;
+  } else if (decoded.policy == "summary") {
+    self->catch_up_policy = CatchUpPolicy::kSummary;
+  } else {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", ("Unknown catch-up policy '" + decoded.policy + "'").c_str(),
+        nullptr));
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+FlMethodResponse* set_persistence_mode(NotificationManagerPlugin* self, FlValue* args) {
+  PersistenceModeArgs decoded;
+  ArgError error;
+  if (!kPersistenceModeSchema.Decode(args, &decoded, &error)) {
+    return arg_error_response(error);
+  }
+  if (!parse_durability(decoded.mode, &self->durability)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "INVALID_ARGUMENTS", ("Unknown persistence mode '" + decoded.mode + "'").c_str(),
+        nullptr));
   }
 
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
+void notification_manager_plugin_set_scheduler_slack(NotificationManagerPlugin* self,
+                                                     gint64 slack_ms) {
+  self->scheduler_slack_ms = MIN(slack_ms, MAX_SCHEDULER_WAIT_MS);
+  arm_scheduler(self);
+}
+
+guint64 notification_manager_plugin_get_scheduler_wakeups(NotificationManagerPlugin* self) {
+  return self->scheduler_wakeups;
+}
+
 // Notification action callback
-static void on_notification_action(NotifyNotification* notification, gchar* action, gpointer user_data) {
-  NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(user_data);
-  
-  if (self->event_sink) {
+static void on_notification_action(NotificationManagerPlugin* self, const std::string& id,
+                                   const std::string& action) {
+  record_history(self, HistoryKind::kAction, id, "", action);
+  if (self->event_listening) {
     g_autoptr(FlValue) event = fl_value_new_map();
     fl_value_set_string_take(event, "type", fl_value_new_string("action"));
-    fl_value_set_string_take(event, "actionId", fl_value_new_string(action));
-    
-    // Find notification ID
-    for (const auto& pair : self->active_notifications) {
-      if (pair.second == notification) {
-        fl_value_set_string_take(event, "notificationId", fl_value_new_string(pair.first.c_str()));
-        break;
-      }
-    }
-    
-    fl_event_sink_success(self->event_sink, event);
+    fl_value_set_string_take(event, "actionId", fl_value_new_string(action.c_str()));
+    fl_value_set_string_take(event, "notificationId", fl_value_new_string(id.c_str()));
+    fl_event_channel_send(self->event_channel, event, nullptr, nullptr);
   }
 }
 
 // Notification closed callback
-static void on_notification_closed(NotifyNotification* notification, gpointer user_data) {
-  NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(user_data);
-  
+static void on_notification_closed(NotificationManagerPlugin* self, const std::string& id) {
   // Remove from active notifications
-  for (auto it = self->active_notifications.begin(); it != self->active_notifications.end(); ++it) {
-    if (it->second == notification) {
-      self->active_notifications.erase(it);
-      break;
-    }
+  self->active_notifications.Remove(id);
+  record_history(self, HistoryKind::kClosed, id, "", "");
+}
+
+void notification_manager_plugin_set_backend(NotificationManagerPlugin* self,
+                                             std::unique_ptr<NotificationBackend> backend) {
+  self->backend = std::move(backend);
+  self->backend->set_action_callback(
+      [self](const std::string& id, const std::string& action) {
+        on_notification_action(self, id, action);
+      });
+  self->backend->set_closed_callback(
+      [self](const std::string& id) { on_notification_closed(self, id); });
+}
+
+void notification_manager_plugin_set_clock(NotificationManagerPlugin* self,
+                                           std::unique_ptr<Clock> clock) {
+  remove_timers(self);
+  self->clock = std::move(clock);
+  if (self->scheduled_restored) {
+    self->clock_watch_source = self->clock->AddRealTimeWatch(clock_set_cb, self);
+    arm_scheduler(self);
+  }
+  if (!self->catch_up_queue.empty()) {
+    self->catch_up_source = self->clock->AddTimeout(CATCH_UP_INTERVAL_MS, catch_up_cb, self);
   }
 }
 
+NotificationManagerStartupCosts notification_manager_plugin_get_startup_costs(
+    NotificationManagerPlugin* self) {
+  NotificationManagerStartupCosts costs;
+  costs.notify_init_us = self->backend ? self->backend->init_time_us() : 0;
+  costs.preferences_load_us = self->preferences->load_time_us();
+  return costs;
+}
+
 // Event channel handlers
-static FlMethodResponse* on_listen(FlEventChannel* channel, FlValue* arguments, FlEventSink* events, gpointer user_data) {
+static FlMethodErrorResponse* on_listen(FlEventChannel* channel, FlValue* arguments, gpointer user_data) {
   NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(user_data);
-  self->event_sink = events;
+  self->event_listening = true;
   return nullptr;
 }
 
-static FlMethodResponse* on_cancel(FlEventChannel* channel, FlValue* arguments, gpointer user_data) {
+static FlMethodErrorResponse* on_cancel(FlEventChannel* channel, FlValue* arguments, gpointer user_data) {
   NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(user_data);
-  self->event_sink = nullptr;
+  self->event_listening = false;
   return nullptr;
 }
 
@@ -598,25 +2092,113 @@ static void notification_manager_plugin_dispose(GObject* object) {
   NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(object);
   
   // Clean up active notifications
-  for (auto& pair : self->active_notifications) {
-    notify_notification_close(pair.second, nullptr);
+  if (self->backend) {
+    self->active_notifications.ForEach(
+        [self](const ActiveNotification& notification) { self->backend->Close(notification.id); });
+    self->backend.reset();
   }
-  self->active_notifications.clear();
+  self->active_notifications.Clear();
+
+  remove_timers(self);
+  self->sleep_monitor.reset();
+  if (self->snapshot_monitor) {
+    g_file_monitor_cancel(self->snapshot_monitor);
+    g_signal_handlers_disconnect_by_data(self->snapshot_monitor, self);
+    g_clear_object(&self->snapshot_monitor);
+  }
+  if (self->time_zone_monitor) {
+    g_file_monitor_cancel(self->time_zone_monitor);
+    g_signal_handlers_disconnect_by_data(self->time_zone_monitor, self);
+    g_clear_object(&self->time_zone_monitor);
+  }
+  flush_scheduled_snapshot(self);
+  // Quitting must not lose writes still in the queue.
+  self->io_thread->Flush();
   
   if (notify_is_initted()) {
     notify_uninit();
   }
   
+  g_clear_object(&self->event_channel);
+  
   G_OBJECT_CLASS(notification_manager_plugin_parent_class)->dispose(object);
 }
 
+static void notification_manager_plugin_finalize(GObject* object) {
+  NotificationManagerPlugin* self = NOTIFICATION_MANAGER_PLUGIN(object);
+  
+  // The C++ members were placement-constructed in init.
+  self->backend.~unique_ptr();
+  self->preferences.~unique_ptr();
+  self->dedupe_table.~unique_ptr();
+  self->history_log.~unique_ptr();
+  self->io_thread.~unique_ptr();
+  self->active_notifications.~ActiveNotifications();
+  self->clock.~unique_ptr();
+  self->scheduled_notifications.~ScheduledStore();
+  self->scheduled_shard_dir.~basic_string();
+  self->snapshot_waiters.~vector();
+  self->snapshot_landed_version.~shared_ptr();
+  self->sleep_monitor.~unique_ptr();
+  self->catch_up_queue.~deque();
+  self->recurrence_rules.~map();
+  g_clear_pointer(&self->local_time_zone, g_time_zone_unref);
+  
+  G_OBJECT_CLASS(notification_manager_plugin_parent_class)->finalize(object);
+}
+
 static void notification_manager_plugin_class_init(NotificationManagerPluginClass* klass) {
   G_OBJECT_CLASS(klass)->dispose = notification_manager_plugin_dispose;
+  G_OBJECT_CLASS(klass)->finalize = notification_manager_plugin_finalize;
 }
 
 static void notification_manager_plugin_init(NotificationManagerPlugin* self) {
   self->event_channel = nullptr;
-  self->event_sink = nullptr;
+  self->event_listening = false;
+  
+  // GObject allocates instances with g_malloc0, so C++ members need explicit
+  // construction.
+  new (&self->backend) std::unique_ptr<NotificationBackend>();
+  new (&self->io_thread) std::unique_ptr<IoThread>(new IoThread());
+  self->durability = Durability::kBatched;
+  self->snapshot_durability = Durability::kNone;
+  new (&self->preferences) std::unique_ptr<PreferencesStore>(
+      new PreferencesStore(GetDataDir() + "/" + PREF_FILE, self->io_thread.get()));
+  new (&self->dedupe_table) std::unique_ptr<DedupeTable>(
+      new DedupeTable(GetDataDir() + "/" + DEDUPE_TABLE_FILE));
+  self->dedupe_imported = false;
+  new (&self->history_log) std::unique_ptr<HistoryLog>(
+      new HistoryLog(GetDataDir() + "/" + HISTORY_LOG_FILE));
+  new (&self->active_notifications) ActiveNotifications();
+  new (&self->clock) std::unique_ptr<Clock>(new SystemClock());
+  new (&self->scheduled_notifications) ScheduledStore();
+  new (&self->scheduled_shard_dir) std::string(GetDataDir() + "/" + SCHEDULED_SHARD_DIR);
+  self->scheduled_restored = false;
+  self->scheduled_dirty = false;
+  self->snapshot_flushed_version = 0;
+  self->snapshot_rewrite_all = false;
+  self->snapshot_write_source = 0;
+  new (&self->snapshot_waiters) std::vector<IoThread::Task>();
+  self->snapshot_writer = (static_cast<guint64>(g_random_int()) << 32) | g_random_int();
+  new (&self->snapshot_landed_version) std::shared_ptr<guint64>(new guint64(0));
+  self->snapshot_monitor = nullptr;
+  self->scheduler_source = 0;
+  self->scheduler_fire_at_ms = 0;
+  self->scheduler_slack_ms = DEFAULT_SCHEDULER_SLACK_MS;
+  self->scheduler_wakeups = 0;
+  self->clock_watch_source = 0;
+  new (&self->sleep_monitor) std::unique_ptr<SleepMonitor>(new SleepMonitor(
+      [self](bool sleeping) { notification_manager_plugin_handle_sleep(self, sleeping); }));
+  self->catch_up_policy = CatchUpPolicy::kFireAll;
+  new (&self->catch_up_queue) std::deque<std::pair<std::string, NotificationContent>>();
+  self->catch_up_source = 0;
+  self->transfers_in_progress = 0;
+  self->last_transfer_id = 0;
+  new (&self->recurrence_rules) std::map<std::string, RecurrenceRule>();
+  self->local_time_zone = nullptr;
+  self->time_zone_monitor = nullptr;
+  
+  notification_manager_plugin_set_backend(self, std::make_unique<LibnotifyBackend>());
 }
 
 static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
@@ -643,8 +2225,13 @@ void notification_manager_plugin_register_with_registrar(FlPluginRegistrar* regi
       fl_event_channel_new(fl_plugin_registrar_get_messenger(registrar),
                            "notification_manager_events",
                            FL_METHOD_CODEC(codec));
-  fl_event_channel_set_stream_handler(event_channel, on_listen, on_cancel, plugin, nullptr);
-  plugin->event_channel = event_channel;
+  fl_event_channel_set_stream_handlers(event_channel, on_listen, on_cancel, plugin, nullptr);
+  plugin->event_channel = FL_EVENT_CHANNEL(g_object_ref(event_channel));
+
+  // Re-arm scheduled notifications once the app is up rather than during
+  // registration.
+  g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, restore_scheduled_cb, g_object_ref(plugin),
+                  g_object_unref);
 
   g_object_unref(plugin);
 }
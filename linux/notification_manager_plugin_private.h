@@ -3,28 +3,121 @@
 
 #include <flutter_linux/flutter_linux.h>
 
-G_DECLARE_FINAL_TYPE(NotificationManagerPlugin, notification_manager_plugin,
-                     NOTIFICATION_MANAGER, PLUGIN, GObject)
-
-G_BEGIN_DECLS
-
-FlMethodResponse* initialize_notification_manager();
-FlMethodResponse* request_permissions();
-FlMethodResponse* are_notifications_enabled();
-FlMethodResponse* show_notification(NotificationManagerPlugin* self, FlMethodCall* method_call);
-FlMethodResponse* schedule_notification(NotificationManagerPlugin* self, FlMethodCall* method_call);
-FlMethodResponse* get_scheduled_notifications(NotificationManagerPlugin* self);
-FlMethodResponse* update_scheduled_notification(NotificationManagerPlugin* self, FlMethodCall* method_call);
-FlMethodResponse* cancel_notification(NotificationManagerPlugin* self, FlMethodCall* method_call);
-FlMethodResponse* cancel_scheduled_notification(NotificationManagerPlugin* self, FlMethodCall* method_call);
-FlMethodResponse* cancel_all_notifications(NotificationManagerPlugin* self);
-FlMethodResponse* cancel_all_scheduled_notifications(NotificationManagerPlugin* self);
-FlMethodResponse* get_badge_count();
-FlMethodResponse* set_badge_count(FlMethodCall* method_call);
-FlMethodResponse* clear_badge_count();
-FlMethodResponse* is_duplicate_notification_method(NotificationManagerPlugin* self, FlMethodCall* method_call);
-FlMethodResponse* clear_notification_history(NotificationManagerPlugin* self);
-
-G_END_DECLS
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "clock.h"
+#include "include/notification_manager/notification_manager_plugin.h"
+#include "notification_backend.h"
+
+// This file exposes some plugin internals for unit testing and benchmarks.
+// Handlers take the decoded method arguments rather than the FlMethodCall,
+// since FlMethodCall cannot be constructed outside of the engine.
+
+FlMethodResponse* get_platform_version();
+
+// Method channel handlers. All share one signature so they can live in the
+// dispatch table; |args| may be nullptr for methods that take none.
+FlMethodResponse* initialize_notification_manager(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* request_permissions(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* are_notifications_enabled(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* show_notification(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* schedule_notification(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* get_scheduled_notifications(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* get_next_scheduled_notifications(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* get_scheduled_notifications_in_range(NotificationManagerPlugin* self,
+                                                      FlValue* args);
+FlMethodResponse* get_scheduled_changes(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* update_scheduled_notification(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* cancel_notification(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* cancel_scheduled_notification(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* cancel_all_notifications(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* cancel_notifications_by_category(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* cancel_notifications_by_group(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* cancel_notifications_with_prefix(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* get_active_notifications(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* cancel_all_scheduled_notifications(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* get_badge_count(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* set_badge_count(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* clear_badge_count(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* is_duplicate_notification_method(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* clear_notification_history(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* get_notification_history(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* set_scheduler_slack(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* set_catch_up_policy(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* set_persistence_mode(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* export_scheduled_notifications(NotificationManagerPlugin* self, FlValue* args);
+FlMethodResponse* import_scheduled_notifications(NotificationManagerPlugin* self, FlValue* args);
+
+// Looks |method| up in the dispatch table and runs its handler. Unknown
+// methods get a not-implemented response.
+FlMethodResponse* notification_manager_plugin_dispatch(NotificationManagerPlugin* self,
+                                                        const gchar* method, FlValue* args);
+
+// How often |method| has been dispatched on |self|. Names that are not in the
+// dispatch table share a single counter.
+guint64 notification_manager_plugin_get_dispatch_count(NotificationManagerPlugin* self,
+                                                       const gchar* method);
+
+// Replaces the daemon backend, e.g. with a NullBackend or RecordingBackend.
+void notification_manager_plugin_set_backend(
+    NotificationManagerPlugin* self,
+    std::unique_ptr<notification_manager::NotificationBackend> backend);
+
+// Replaces the source of time and timers, e.g. with a VirtualClock. Pending
+// timers move over to the new clock.
+void notification_manager_plugin_set_clock(NotificationManagerPlugin* self,
+                                           std::unique_ptr<notification_manager::Clock> clock);
+
+// Loads scheduled notifications from the snapshot, shows the ones that fell
+// due while the app was not running as one batch and arms the timer for the
+// rest. Runs once per plugin; registration queues it for when the main loop
+// is idle and every scheduled method runs it first.
+void notification_manager_plugin_restore_scheduled(NotificationManagerPlugin* self);
+
+// Applies changes another process made to the scheduled snapshot, re-arms
+// the timer and reports them to event listeners as a "scheduledReloaded"
+// event. Entries changed here and not yet written keep their local state.
+// Called by the file monitor whenever the snapshot is replaced.
+void notification_manager_plugin_reload_scheduled(NotificationManagerPlugin* self);
+
+// Called by the sleep monitor before the system sleeps and after it
+// resumes. On resume, entries that fell due while asleep are shown under
+// the catch-up policy and the timer is re-armed.
+void notification_manager_plugin_handle_sleep(NotificationManagerPlugin* self, bool sleeping);
+
+// Lets scheduled notifications fire up to |slack_ms| late so that ones
+// due close together share a single wakeup.
+void notification_manager_plugin_set_scheduler_slack(NotificationManagerPlugin* self,
+                                                     gint64 slack_ms);
+
+// Calls |done| on the main thread once everything changed so far has been
+// written to disk, or right away if nothing is waiting to be written. In
+// batched and immediate modes, method calls that change something are
+// answered this way.
+void notification_manager_plugin_when_persisted(NotificationManagerPlugin* self,
+                                                std::function<void()> done);
+
+// Scheduled notification exports and imports that have not finished yet.
+guint notification_manager_plugin_get_transfers_in_progress(NotificationManagerPlugin* self);
+
+// How often the scheduler timer has woken the main loop.
+guint64 notification_manager_plugin_get_scheduler_wakeups(NotificationManagerPlugin* self);
+
+// Time spent in work deferred from registration to first use, in
+// microseconds. Each field stays zero until that work has happened.
+typedef struct {
+  gint64 notify_init_us;
+  gint64 preferences_load_us;
+} NotificationManagerStartupCosts;
+
+NotificationManagerStartupCosts notification_manager_plugin_get_startup_costs(
+    NotificationManagerPlugin* self);
+
+// Preference storage used by dedupe and scheduling.
+void save_preferences(NotificationManagerPlugin* self, const std::string& key,
+                      const std::string& value);
+std::string load_preference(NotificationManagerPlugin* self, const std::string& key);
 
 #endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_PLUGIN_PRIVATE_H_
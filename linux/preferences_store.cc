@@ -0,0 +1,137 @@
+#include "preferences_store.h"
+
+#include <glib/gstdio.h>
+#include <json-glib/json-glib.h>
+
+#include <utility>
+
+namespace notification_manager {
+
+namespace {
+
+std::string& data_dir() {
+  // g_get_user_data_dir() honours XDG_DATA_HOME and falls back to
+  // ~/.local/share, which is where earlier versions kept their data.
+  static std::string dir = std::string(g_get_user_data_dir()) + "/notification_manager";
+  return dir;
+}
+
+}  // namespace
+
+const std::string& GetDataDir() {
+  return data_dir();
+}
+
+void SetDataDirForTesting(std::string dir) {
+  data_dir() = std::move(dir);
+}
+
+PreferencesStore::PreferencesStore(std::string path, IoThread* io)
+    : path_(std::move(path)), io_(io) {}
+
+std::string PreferencesStore::Get(const std::string& key) {
+  EnsureLoaded();
+  auto it = values_.find(key);
+  return it == values_.end() ? std::string() : it->second;
+}
+
+std::vector<std::pair<std::string, std::string>> PreferencesStore::GetWithPrefix(
+    const std::string& prefix) {
+  EnsureLoaded();
+  std::vector<std::pair<std::string, std::string>> matches;
+  for (auto it = values_.lower_bound(prefix);
+       it != values_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+    matches.push_back(*it);
+  }
+  return matches;
+}
+
+void PreferencesStore::Set(const std::string& key, const std::string& value) {
+  EnsureLoaded();
+  values_[key] = value;
+  Flush();
+}
+
+void PreferencesStore::Remove(const std::string& key) {
+  EnsureLoaded();
+  if (values_.erase(key) > 0) {
+    Flush();
+  }
+}
+
+void PreferencesStore::RemoveWithPrefix(const std::string& prefix) {
+  EnsureLoaded();
+  // Keys are sorted, so the matches form one contiguous range.
+  auto begin = values_.lower_bound(prefix);
+  auto end = begin;
+  while (end != values_.end() && end->first.compare(0, prefix.size(), prefix) == 0) {
+    ++end;
+  }
+  if (begin != end) {
+    values_.erase(begin, end);
+    Flush();
+  }
+}
+
+void PreferencesStore::Clear() {
+  values_.clear();
+  loaded_ = true;
+  if (io_) {
+    io_->PostRemoveFile(path_);
+  } else {
+    g_remove(path_.c_str());
+  }
+}
+
+static void collect_string_member(JsonObject* object, const gchar* key, JsonNode* node,
+                                  gpointer user_data) {
+  auto* values = static_cast<std::map<std::string, std::string>*>(user_data);
+  if (json_node_get_node_type(node) == JSON_NODE_VALUE &&
+      json_node_get_value_type(node) == G_TYPE_STRING) {
+    (*values)[key] = json_node_get_string(node);
+  }
+}
+
+void PreferencesStore::EnsureLoaded() {
+  if (loaded_) return;
+  loaded_ = true;
+
+  gint64 start = g_get_monotonic_time();
+  JsonParser* parser = json_parser_new();
+  if (json_parser_load_from_file(parser, path_.c_str(), nullptr)) {
+    JsonNode* root = json_parser_get_root(parser);
+    if (root && json_node_get_node_type(root) == JSON_NODE_OBJECT) {
+      json_object_foreach_member(json_node_get_object(root), collect_string_member, &values_);
+    }
+  }
+  g_object_unref(parser);
+  load_time_us_ = g_get_monotonic_time() - start;
+  g_debug("Loaded %zu preferences from %s in %" G_GINT64_FORMAT " us", values_.size(),
+          path_.c_str(), load_time_us_);
+}
+
+void PreferencesStore::Flush() {
+  JsonObject* object = json_object_new();
+  for (const auto& pair : values_) {
+    json_object_set_string_member(object, pair.first.c_str(), pair.second.c_str());
+  }
+  JsonNode* root = json_node_new(JSON_NODE_OBJECT);
+  json_node_take_object(root, object);
+
+  JsonGenerator* generator = json_generator_new();
+  json_generator_set_root(generator, root);
+  gsize length = 0;
+  g_autofree gchar* data = json_generator_to_data(generator, &length);
+  std::string contents(data, length);
+
+  g_object_unref(generator);
+  json_node_free(root);
+
+  if (io_) {
+    io_->PostReplaceFile(path_, std::move(contents), durability_);
+  } else {
+    ReplaceFile(path_, contents, durability_ != Durability::kNone);
+  }
+}
+
+}  // namespace notification_manager
@@ -0,0 +1,79 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_PREFERENCES_STORE_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_PREFERENCES_STORE_H_
+
+#include <glib.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "io_thread.h"
+
+namespace notification_manager {
+
+// Returns the plugin's data directory, $XDG_DATA_HOME/notification_manager
+// (by default ~/.local/share/notification_manager). Resolved once per
+// process; the directory is not created until something is written to it.
+const std::string& GetDataDir();
+
+// Points GetDataDir() at |dir| instead. Only for tests: stores and plugins
+// already constructed keep the paths they were given.
+void SetDataDirForTesting(std::string dir);
+
+// Key/value preferences persisted as a flat JSON object.
+//
+// Nothing is read until the first access, so constructing a store is free.
+// After that, reads are served from memory and every mutation rewrites the
+// file from the in-memory copy instead of re-parsing it. The copy is
+// encoded on the caller's thread; with an IoThread, the file is written
+// there and mutations return without waiting for the disk.
+class PreferencesStore {
+ public:
+  // Writes go through |io| if given, which must outlive the store, and
+  // happen before each mutation returns otherwise.
+  explicit PreferencesStore(std::string path, IoThread* io = nullptr);
+
+  // Disallow copy and assign.
+  PreferencesStore(const PreferencesStore&) = delete;
+  PreferencesStore& operator=(const PreferencesStore&) = delete;
+
+  // Returns the value stored under |key|, or an empty string.
+  std::string Get(const std::string& key);
+
+  // Returns every (key, value) pair whose key starts with |prefix|.
+  std::vector<std::pair<std::string, std::string>> GetWithPrefix(const std::string& prefix);
+
+  void Set(const std::string& key, const std::string& value);
+  void Remove(const std::string& key);
+  void RemoveWithPrefix(const std::string& prefix);
+
+  // Forgets every value and deletes the file.
+  void Clear();
+
+  // How durable the writes made from now on must be. Defaults to
+  // Durability::kBatched.
+  void set_durability(Durability durability) { durability_ = durability; }
+
+  const std::string& path() const { return path_; }
+  bool loaded() const { return loaded_; }
+
+  // Wall time spent on the deferred load, in microseconds. Zero until the
+  // store has been loaded.
+  gint64 load_time_us() const { return load_time_us_; }
+
+ private:
+  void EnsureLoaded();
+  void Flush();
+
+  std::string path_;
+  IoThread* io_;
+  Durability durability_ = Durability::kBatched;
+  bool loaded_ = false;
+  gint64 load_time_us_ = 0;
+  std::map<std::string, std::string> values_;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_PREFERENCES_STORE_H_
@@ -0,0 +1,272 @@
+#include "recurrence_rule.h"
+
+#include <cstring>
+#include <vector>
+
+namespace notification_manager {
+
+namespace {
+
+// February 29th comes round at least once in any eight years.
+constexpr int kMaxSearchYears = 8;
+// Bits 0, 7, 14, 21 and 28, shifted onto the first matching day.
+constexpr uint32_t kEveryWeek = 0x10204081u;
+
+const char* const kMonthNames[] = {"JAN", "FEB", "MAR", "APR", "MAY", "JUN",
+                                   "JUL", "AUG", "SEP", "OCT", "NOV", "DEC"};
+const char* const kWeekdayNames[] = {"SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT"};
+
+struct FieldSpec {
+  const char* name;
+  int min;
+  int max;
+  // Names for min, min + 1, ..., or nullptr.
+  const char* const* names;
+  size_t name_count;
+};
+
+const FieldSpec kFields[] = {
+    {"minute", 0, 59, nullptr, 0},
+    {"hour", 0, 23, nullptr, 0},
+    {"day of month", 1, 31, nullptr, 0},
+    {"month", 1, 12, kMonthNames, G_N_ELEMENTS(kMonthNames)},
+    // 7 is Sunday again.
+    {"weekday", 0, 7, kWeekdayNames, G_N_ELEMENTS(kWeekdayNames)},
+};
+
+const struct {
+  const char* name;
+  const char* spec;
+} kShorthands[] = {
+    {"@yearly", "0 0 1 1 *"},  {"@annually", "0 0 1 1 *"}, {"@monthly", "0 0 1 * *"},
+    {"@weekly", "0 0 * * 0"},  {"@daily", "0 0 * * *"},    {"@midnight", "0 0 * * *"},
+    {"@hourly", "0 * * * *"},
+};
+
+// Position of the lowest set bit of |mask| at or above |from|, or -1.
+int NextBit(uint64_t mask, int from) {
+  if (from >= 64) return -1;
+  uint64_t rest = mask & (~uint64_t{0} << from);
+  return rest ? __builtin_ctzll(rest) : -1;
+}
+
+std::vector<std::string> Split(const std::string& text, char separator) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (true) {
+    size_t end = text.find(separator, start);
+    parts.push_back(text.substr(start, end - start));
+    if (end == std::string::npos) return parts;
+    start = end + 1;
+  }
+}
+
+bool ParseNumber(const std::string& text, int min, int max, int* value) {
+  gint64 number = 0;
+  if (!g_ascii_string_to_signed(text.c_str(), 10, min, max, &number, nullptr)) return false;
+  *value = static_cast<int>(number);
+  return true;
+}
+
+bool ParseValue(const std::string& text, const FieldSpec& field, int* value) {
+  for (size_t i = 0; i < field.name_count; i++) {
+    if (g_ascii_strcasecmp(text.c_str(), field.names[i]) == 0) {
+      *value = field.min + static_cast<int>(i);
+      return true;
+    }
+  }
+  return ParseNumber(text, field.min, field.max, value);
+}
+
+// Parses one comma-separated field into |mask|. "#n" items, only allowed
+// for weekdays, go into |nth| instead.
+bool ParseField(const std::string& text, const FieldSpec& field, uint64_t* mask, uint8_t* nth,
+                std::string* error) {
+  for (const std::string& item : Split(text, ',')) {
+    std::string range = item;
+    int step = 1;
+    size_t slash = item.find('/');
+    if (slash != std::string::npos) {
+      range = item.substr(0, slash);
+      if (!ParseNumber(item.substr(slash + 1), 1, field.max, &step)) {
+        *error = std::string("Invalid step in ") + field.name + " '" + item + "'";
+        return false;
+      }
+    }
+
+    size_t hash = range.find('#');
+    if (hash != std::string::npos) {
+      int weekday = 0;
+      int occurrence = 0;
+      if (nth == nullptr || slash != std::string::npos ||
+          !ParseValue(range.substr(0, hash), field, &weekday) ||
+          !ParseNumber(range.substr(hash + 1), 1, 5, &occurrence)) {
+        *error = std::string("Invalid ") + field.name + " '" + item + "'";
+        return false;
+      }
+      nth[weekday % 7] |= 1u << occurrence;
+      continue;
+    }
+
+    int low = field.min;
+    int high = field.max;
+    if (range != "*" && range != "?") {
+      size_t dash = range.find('-');
+      bool valid = dash == std::string::npos
+                       ? ParseValue(range, field, &low)
+                       : ParseValue(range.substr(0, dash), field, &low) &&
+                             ParseValue(range.substr(dash + 1), field, &high);
+      if (dash == std::string::npos) {
+        // "5/15" means from 5 to the end in steps of 15.
+        high = slash == std::string::npos ? low : field.max;
+      }
+      if (!valid || low > high) {
+        *error = std::string("Invalid ") + field.name + " '" + item + "'";
+        return false;
+      }
+    }
+    for (int value = low; value <= high; value += step) *mask |= uint64_t{1} << value;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool RecurrenceRule::Parse(const std::string& spec, RecurrenceRule* rule, std::string* error) {
+  std::string expanded = spec;
+  for (const auto& shorthand : kShorthands) {
+    if (g_ascii_strcasecmp(spec.c_str(), shorthand.name) == 0) expanded = shorthand.spec;
+  }
+
+  g_auto(GStrv) tokens = g_strsplit_set(expanded.c_str(), " \t", -1);
+  std::vector<std::string> fields;
+  for (gchar** token = tokens; *token != nullptr; token++) {
+    if (**token != '\0') fields.push_back(*token);
+  }
+  if (fields.size() != G_N_ELEMENTS(kFields)) {
+    *error = "Expected 5 fields (minute hour day-of-month month weekday), got " +
+             std::to_string(fields.size());
+    return false;
+  }
+
+  RecurrenceRule parsed;
+  uint64_t masks[G_N_ELEMENTS(kFields)] = {};
+  for (size_t i = 0; i < fields.size(); i++) {
+    uint8_t* nth = i == 4 ? parsed.nth_weekdays_ : nullptr;
+    if (!ParseField(fields[i], kFields[i], &masks[i], nth, error)) return false;
+  }
+  // Sunday may be given as 7.
+  if (masks[4] & (uint64_t{1} << 7)) masks[4] = (masks[4] & 0x7f) | 1;
+
+  parsed.minutes_ = masks[0];
+  parsed.hours_ = static_cast<uint32_t>(masks[1]);
+  parsed.days_of_month_ = static_cast<uint32_t>(masks[2]);
+  parsed.months_ = static_cast<uint16_t>(masks[3]);
+  parsed.weekdays_ = static_cast<uint8_t>(masks[4]);
+  parsed.any_day_of_month_ = fields[2] == "*" || fields[2] == "?";
+  parsed.any_weekday_ = fields[4] == "*" || fields[4] == "?";
+  *rule = parsed;
+  return true;
+}
+
+int64_t RecurrenceRule::NextAfter(int64_t after_ms, GTimeZone* tz) const {
+  g_autoptr(GDateTime) utc = g_date_time_new_from_unix_utc(after_ms / 1000);
+  if (utc == nullptr) return 0;
+  g_autoptr(GDateTime) local = g_date_time_to_timezone(utc, tz);
+
+  // Search from the minute after |after_ms|; each field that has no match
+  // left carries into the next larger one.
+  int year = g_date_time_get_year(local);
+  int month = g_date_time_get_month(local);
+  int day = g_date_time_get_day_of_month(local);
+  int hour = g_date_time_get_hour(local);
+  int minute = g_date_time_get_minute(local) + 1;
+  int last_year = year + kMaxSearchYears;
+  while (year <= last_year) {
+    int next_month = NextBit(months_, month);
+    if (next_month < 0) {
+      year++;
+      month = day = 1;
+      hour = minute = 0;
+      continue;
+    }
+    if (next_month != month) {
+      month = next_month;
+      day = 1;
+      hour = minute = 0;
+    }
+
+    int next_day = NextBit(DaysOfMonth(year, month), day);
+    if (next_day < 0) {
+      month++;
+      day = 1;
+      hour = minute = 0;
+      continue;
+    }
+    if (next_day != day) {
+      day = next_day;
+      hour = minute = 0;
+    }
+
+    int next_hour = NextBit(hours_, hour);
+    if (next_hour < 0) {
+      day++;
+      hour = minute = 0;
+      continue;
+    }
+    if (next_hour != hour) {
+      hour = next_hour;
+      minute = 0;
+    }
+
+    int next_minute = NextBit(minutes_, minute);
+    if (next_minute < 0) {
+      hour++;
+      minute = 0;
+      continue;
+    }
+    minute = next_minute;
+
+    // GLib moves a wall time inside a daylight-saving gap to the end of the
+    // gap, and picks standard time for one that occurs twice.
+    g_autoptr(GDateTime) candidate = g_date_time_new(tz, year, month, day, hour, minute, 0);
+    if (candidate != nullptr) {
+      int64_t candidate_ms = g_date_time_to_unix(candidate) * 1000;
+      if (candidate_ms > after_ms) return candidate_ms;
+    }
+    minute++;
+  }
+  return 0;
+}
+
+uint32_t RecurrenceRule::DaysOfMonth(int year, int month) const {
+  int length = g_date_get_days_in_month(static_cast<GDateMonth>(month),
+                                        static_cast<GDateYear>(year));
+  uint32_t valid = ((uint32_t{1} << length) - 1) << 1;
+  if (any_day_of_month_ && any_weekday_) return valid;
+
+  GDate first;
+  g_date_clear(&first, 1);
+  g_date_set_dmy(&first, 1, static_cast<GDateMonth>(month), static_cast<GDateYear>(year));
+  // GDate counts Monday as 1 and Sunday as 7.
+  int first_weekday = g_date_get_weekday(&first) % 7;
+
+  uint32_t by_weekday = 0;
+  for (int weekday = 0; weekday < 7; weekday++) {
+    int first_day = 1 + (weekday - first_weekday + 7) % 7;
+    if (weekdays_ & (1u << weekday)) by_weekday |= kEveryWeek << first_day;
+    for (int occurrence = 1; occurrence <= 5; occurrence++) {
+      int day = first_day + 7 * (occurrence - 1);
+      if ((nth_weekdays_[weekday] & (1u << occurrence)) && day <= 31) {
+        by_weekday |= 1u << day;
+      }
+    }
+  }
+  by_weekday &= valid;
+
+  if (any_day_of_month_) return by_weekday;
+  if (any_weekday_) return days_of_month_ & valid;
+  return (days_of_month_ & valid) | by_weekday;
+}
+
+}  // namespace notification_manager
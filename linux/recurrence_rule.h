@@ -0,0 +1,64 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_RECURRENCE_RULE_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_RECURRENCE_RULE_H_
+
+#include <glib.h>
+
+#include <cstdint>
+#include <string>
+
+namespace notification_manager {
+
+// A cron-style recurrence rule compiled into one bitset per field.
+//
+// Rules use the five cron fields "minute hour day-of-month month weekday",
+// each a list of values, ranges ("1-5") and steps ("*/15", "0-30/10").
+// Months and weekdays also take names ("JAN", "MON"), and Sunday is 0 or 7.
+// A weekday may be limited to its n-th occurrence in the month with "#n",
+// so "0 9 * * MON#1" is nine o'clock on the first Monday of every month.
+// As in cron, when both day fields are restricted a day matching either
+// one matches. "@hourly", "@daily", "@weekly", "@monthly" and "@yearly"
+// are accepted as shorthands.
+//
+//   RecurrenceRule weekdays;
+//   std::string error;
+//   RecurrenceRule::Parse("0 9 * * 1-5", &weekdays, &error);
+//   int64_t next_ms = weekdays.NextAfter(now_ms, local_tz);
+//
+// NextAfter() finds each field by scanning its bitset for the next set bit,
+// so the cost does not depend on how far away the next occurrence is.
+class RecurrenceRule {
+ public:
+  // Parses |spec| into |rule|. Returns false and describes the problem in
+  // |error| if |spec| is not a valid rule.
+  static bool Parse(const std::string& spec, RecurrenceRule* rule, std::string* error);
+
+  // First occurrence strictly after |after_ms| (milliseconds since the Unix
+  // epoch), evaluated in the wall time of |tz|. Returns zero if the rule
+  // never matches, e.g. "0 0 30 2 *".
+  //
+  // A wall time skipped by a daylight-saving change fires at the first
+  // instant after the gap. A wall time that occurs twice fires once, at the
+  // second of the two instants (standard time).
+  int64_t NextAfter(int64_t after_ms, GTimeZone* tz) const;
+
+ private:
+  // Days of |month| in |year| that match, with bit d set for day d.
+  uint32_t DaysOfMonth(int year, int month) const;
+
+  uint64_t minutes_ = 0;
+  uint32_t hours_ = 0;
+  // Bits 1-31.
+  uint32_t days_of_month_ = 0;
+  // Bits 1-12.
+  uint16_t months_ = 0;
+  // Bits 0-6, Sunday first, for weekdays matching every week.
+  uint8_t weekdays_ = 0;
+  // For each weekday, bits 1-5 for the occurrences in the month that match.
+  uint8_t nth_weekdays_[7] = {};
+  bool any_day_of_month_ = false;
+  bool any_weekday_ = false;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_RECURRENCE_RULE_H_
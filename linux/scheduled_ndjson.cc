@@ -0,0 +1,266 @@
+#include "scheduled_ndjson.h"
+
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace notification_manager {
+
+namespace {
+
+// Exports append straight into the chunk being written rather than build a
+// JsonNode tree per entry and serialize it with json-glib.
+void AppendJsonString(const char* value, std::string* out) {
+  // Strings restored from an old snapshot or an import are not guaranteed
+  // to be UTF-8, which JSON requires; bad bytes become U+FFFD rather than
+  // leaving a line no reader accepts.
+  g_autofree gchar* valid = nullptr;
+  if (!g_utf8_validate(value, -1, nullptr)) {
+    valid = g_utf8_make_valid(value, -1);
+    value = valid;
+  }
+
+  out->push_back('"');
+  for (const char* c = value; *c != '\0'; c++) {
+    switch (*c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\r':
+        out->append("\\r");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) {
+          char escaped[8];
+          g_snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(*c));
+          out->append(escaped);
+        } else {
+          out->push_back(*c);
+        }
+    }
+  }
+  out->push_back('"');
+}
+
+void AppendJsonFloat(double value, std::string* out) {
+  if (!std::isfinite(value)) {
+    out->append("null");
+    return;
+  }
+  char buffer[G_ASCII_DTOSTR_BUF_SIZE];
+  g_ascii_dtostr(buffer, sizeof(buffer), value);
+  out->append(buffer);
+  // Keep whole floats floats when read back.
+  if (strpbrk(buffer, ".eE") == nullptr) out->append(".0");
+}
+
+template <typename T, typename Append>
+void AppendJsonArray(const T* values, size_t length, Append append, std::string* out) {
+  out->push_back('[');
+  for (size_t i = 0; i < length; i++) {
+    if (i > 0) out->push_back(',');
+    append(values[i]);
+  }
+  out->push_back(']');
+}
+
+}  // namespace
+
+FlValue* FlValueFromJson(JsonNode* node) {
+  switch (json_node_get_node_type(node)) {
+    case JSON_NODE_OBJECT: {
+      FlValue* map = fl_value_new_map();
+      JsonObject* object = json_node_get_object(node);
+      GList* members = json_object_get_members(object);
+      for (GList* iter = members; iter != nullptr; iter = iter->next) {
+        const char* key = static_cast<const char*>(iter->data);
+        fl_value_set_string_take(map, key, FlValueFromJson(json_object_get_member(object, key)));
+      }
+      g_list_free(members);
+      return map;
+    }
+    case JSON_NODE_ARRAY: {
+      FlValue* list = fl_value_new_list();
+      JsonArray* array = json_node_get_array(node);
+      for (guint i = 0; i < json_array_get_length(array); i++) {
+        fl_value_append_take(list, FlValueFromJson(json_array_get_element(array, i)));
+      }
+      return list;
+    }
+    case JSON_NODE_VALUE: {
+      GType type = json_node_get_value_type(node);
+      if (type == G_TYPE_STRING) return fl_value_new_string(json_node_get_string(node));
+      if (type == G_TYPE_BOOLEAN) return fl_value_new_bool(json_node_get_boolean(node));
+      if (type == G_TYPE_INT64) return fl_value_new_int(json_node_get_int(node));
+      return fl_value_new_float(json_node_get_double(node));
+    }
+    default:
+      return fl_value_new_null();
+  }
+}
+
+void AppendJson(FlValue* value, std::string* out) {
+  size_t length = fl_value_get_length(value);
+  auto append_int = [out](int64_t element) { out->append(std::to_string(element)); };
+  switch (fl_value_get_type(value)) {
+    case FL_VALUE_TYPE_BOOL:
+      out->append(fl_value_get_bool(value) ? "true" : "false");
+      break;
+    case FL_VALUE_TYPE_INT:
+      append_int(fl_value_get_int(value));
+      break;
+    case FL_VALUE_TYPE_FLOAT:
+      AppendJsonFloat(fl_value_get_float(value), out);
+      break;
+    case FL_VALUE_TYPE_STRING:
+      AppendJsonString(fl_value_get_string(value), out);
+      break;
+    case FL_VALUE_TYPE_UINT8_LIST:
+      AppendJsonArray(fl_value_get_uint8_list(value), length, append_int, out);
+      break;
+    case FL_VALUE_TYPE_INT32_LIST:
+      AppendJsonArray(fl_value_get_int32_list(value), length, append_int, out);
+      break;
+    case FL_VALUE_TYPE_INT64_LIST:
+      AppendJsonArray(fl_value_get_int64_list(value), length, append_int, out);
+      break;
+    case FL_VALUE_TYPE_FLOAT_LIST:
+      AppendJsonArray(fl_value_get_float_list(value), length,
+                      [out](double element) { AppendJsonFloat(element, out); }, out);
+      break;
+    case FL_VALUE_TYPE_LIST:
+      out->push_back('[');
+      for (size_t i = 0; i < length; i++) {
+        if (i > 0) out->push_back(',');
+        AppendJson(fl_value_get_list_value(value, i), out);
+      }
+      out->push_back(']');
+      break;
+    case FL_VALUE_TYPE_MAP: {
+      out->push_back('{');
+      bool first = true;
+      for (size_t i = 0; i < length; i++) {
+        FlValue* key = fl_value_get_map_key(value, i);
+        if (fl_value_get_type(key) != FL_VALUE_TYPE_STRING) continue;
+        if (!first) out->push_back(',');
+        first = false;
+        AppendJsonString(fl_value_get_string(key), out);
+        out->push_back(':');
+        AppendJson(fl_value_get_map_value(value, i), out);
+      }
+      out->push_back('}');
+      break;
+    }
+    default:
+      out->append("null");
+  }
+}
+
+void AppendScheduledJsonLine(const ScheduledStore& store,
+                             const ScheduledStore::Record& record,
+                             std::string* out) {
+  g_autoptr(FlValue) value = store.ToFlValue(record);
+  AppendJson(value, out);
+  out->push_back('\n');
+}
+
+NdjsonWriter::~NdjsonWriter() {
+  if (file_ != nullptr) {
+    fclose(file_);
+    g_remove(temp_path_.c_str());
+  }
+}
+
+bool NdjsonWriter::Open(const std::string& path, std::string* error) {
+  g_autofree gchar* dir = g_path_get_dirname(path.c_str());
+  g_mkdir_with_parents(dir, 0755);
+
+  path_ = path;
+  temp_path_ = path + ".tmp";
+  file_ = g_fopen(temp_path_.c_str(), "we");
+  if (file_ == nullptr) {
+    *error = "Failed to open " + temp_path_ + ": " + g_strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+bool NdjsonWriter::Append(const std::string& chunk, std::string* error) {
+  if (fwrite(chunk.data(), 1, chunk.size(), file_) != chunk.size()) {
+    *error = "Failed to write " + temp_path_ + ": " + g_strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+bool NdjsonWriter::Commit(std::string* error) {
+  bool ok = fflush(file_) == 0 && g_fsync(fileno(file_)) == 0;
+  if (!ok) *error = "Failed to write " + temp_path_ + ": " + g_strerror(errno);
+  ok = fclose(file_) == 0 && ok;
+  file_ = nullptr;
+  if (ok && g_rename(temp_path_.c_str(), path_.c_str()) != 0) {
+    *error = "Failed to replace " + path_ + ": " + g_strerror(errno);
+    ok = false;
+  }
+  if (!ok) g_remove(temp_path_.c_str());
+  return ok;
+}
+
+NdjsonReader::~NdjsonReader() {
+  if (file_ != nullptr) fclose(file_);
+  free(line_);
+}
+
+bool NdjsonReader::Open(const std::string& path, std::string* error) {
+  file_ = g_fopen(path.c_str(), "re");
+  if (file_ == nullptr) {
+    *error = "Failed to open " + path + ": " + g_strerror(errno);
+    return false;
+  }
+  at_end_ = false;
+  return true;
+}
+
+bool NdjsonReader::ReadChunk(size_t max_lines,
+                             std::vector<FlValue*>* values,
+                             size_t* invalid,
+                             std::string* error) {
+  for (size_t lines = 0; lines < max_lines && !at_end_; lines++) {
+    ssize_t length = getline(&line_, &line_capacity_, file_);
+    if (length < 0) {
+      if (ferror(file_)) {
+        *error = std::string("Failed to read: ") + g_strerror(errno);
+        return false;
+      }
+      at_end_ = true;
+      break;
+    }
+    // getline() keeps the newline; Windows line ends are accepted too.
+    while (length > 0 && g_ascii_isspace(line_[length - 1])) line_[--length] = '\0';
+    if (length == 0) continue;
+
+    JsonNode* root = json_from_string(line_, nullptr);
+    if (root != nullptr && json_node_get_node_type(root) == JSON_NODE_OBJECT) {
+      values->push_back(FlValueFromJson(root));
+    } else {
+      (*invalid)++;
+    }
+    if (root != nullptr) json_node_free(root);
+  }
+  return true;
+}
+
+}  // namespace notification_manager
@@ -0,0 +1,96 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SCHEDULED_NDJSON_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SCHEDULED_NDJSON_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <json-glib/json-glib.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "scheduled_store.h"
+
+namespace notification_manager {
+
+// Converts parsed JSON to what the method channel would carry: objects
+// become maps, arrays lists, and integers stay integers.
+FlValue* FlValueFromJson(JsonNode* node);
+
+// Appends |value| to |out| as JSON. Typed lists become arrays, map entries
+// whose key is not a string are dropped, floats that are not finite become
+// null, and bytes in strings that are not valid UTF-8 become U+FFFD.
+void AppendJson(FlValue* value, std::string* out);
+
+// Appends |record| to |out| as one line of JSON, newline included, in the
+// shape of the Dart ScheduledNotification's toJson(). The line can be read
+// back by an import or decoded with ScheduledNotification.fromJson().
+void AppendScheduledJsonLine(const ScheduledStore& store,
+                             const ScheduledStore::Record& record,
+                             std::string* out);
+
+// Writes newline-delimited JSON a chunk at a time to a temporary file that
+// replaces the target on Commit(), so a failed or abandoned export never
+// leaves a partial file behind. Not thread-safe.
+class NdjsonWriter {
+ public:
+  NdjsonWriter() = default;
+  // Removes the temporary file unless the writer was committed.
+  ~NdjsonWriter();
+
+  // Disallow copy and assign.
+  NdjsonWriter(const NdjsonWriter&) = delete;
+  NdjsonWriter& operator=(const NdjsonWriter&) = delete;
+
+  // Starts writing to a temporary file next to |path|, creating its
+  // directory if needed.
+  bool Open(const std::string& path, std::string* error);
+  bool is_open() const { return file_ != nullptr; }
+
+  bool Append(const std::string& chunk, std::string* error);
+
+  // Syncs what was written and renames it over the target.
+  bool Commit(std::string* error);
+
+ private:
+  std::string path_;
+  std::string temp_path_;
+  FILE* file_ = nullptr;
+};
+
+// Reads newline-delimited JSON a chunk of lines at a time, so memory stays
+// bounded however large the file is. Not thread-safe.
+class NdjsonReader {
+ public:
+  NdjsonReader() = default;
+  ~NdjsonReader();
+
+  // Disallow copy and assign.
+  NdjsonReader(const NdjsonReader&) = delete;
+  NdjsonReader& operator=(const NdjsonReader&) = delete;
+
+  bool Open(const std::string& path, std::string* error);
+  bool is_open() const { return file_ != nullptr; }
+
+  // Parses up to |max_lines| more lines, appending a map to |values| for
+  // each one holding a JSON object; the caller takes ownership of them.
+  // Blank lines are skipped and any other line is counted in |invalid|.
+  // Returns false if the file cannot be read.
+  bool ReadChunk(size_t max_lines,
+                 std::vector<FlValue*>* values,
+                 size_t* invalid,
+                 std::string* error);
+
+  // Whether every line has been read.
+  bool at_end() const { return at_end_; }
+
+ private:
+  FILE* file_ = nullptr;
+  char* line_ = nullptr;
+  size_t line_capacity_ = 0;
+  bool at_end_ = false;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SCHEDULED_NDJSON_H_
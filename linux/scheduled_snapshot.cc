@@ -0,0 +1,418 @@
+#include "scheduled_snapshot.h"
+
+#include <glib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "io_thread.h"
+#include "zlib_block_codec.h"
+
+namespace notification_manager {
+
+namespace {
+
+constexpr char kMagic[4] = {'N', 'M', 'S', 'S'};
+// Version 1 stored (fire_at_ms, repeat_interval_s, id, request JSON).
+constexpr uint32_t kJsonRequestVersion = 1;
+// Version 2 had no recurrence rule.
+constexpr uint32_t kNoRecurrenceVersion = 2;
+// Version 3 had no writer, revisions or record lengths.
+constexpr uint32_t kNoRevisionVersion = 3;
+// Version 4 never compressed the tail of a record.
+constexpr uint32_t kNoPackingVersion = 4;
+// Version 5 had no group.
+constexpr uint32_t kNoGroupVersion = 5;
+constexpr uint32_t kVersion = 6;
+constexpr size_t kHeaderSize = sizeof(kMagic) + sizeof(uint32_t) + 2 * sizeof(uint64_t);
+// The smallest possible record, used to reject impossible counts up front.
+constexpr size_t kMinRecordSize = 2 * sizeof(int64_t) + 2 * sizeof(uint32_t);
+// The fields between a record's revision and its id.
+constexpr size_t kFixedFieldsSize = 4 * sizeof(int64_t) + 2 * sizeof(uint32_t);
+// Set in a record's payload length when its actions and payload are
+// stored as one zlib block.
+constexpr uint32_t kPackedTail = 1u << 31;
+// zlib cannot inflate beyond about 1032:1, so anything claiming more is
+// corrupt and is rejected before allocating for it.
+constexpr size_t kMaxInflation = 1032;
+
+template <typename T>
+void Append(std::string* buffer, T value) {
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void AppendString(std::string* buffer, const char* data, size_t length) {
+  Append<uint32_t>(buffer, static_cast<uint32_t>(length));
+  buffer->append(data, length);
+}
+
+// Sequential reader over the mapped file. Every read is bounds-checked, so a
+// truncated snapshot fails instead of reading past the mapping.
+class Cursor {
+ public:
+  Cursor(const char* data, size_t length) : data_(data), remaining_(length) {}
+
+  template <typename T>
+  bool Read(T* value) {
+    if (remaining_ < sizeof(T)) return false;
+    memcpy(value, data_, sizeof(T));
+    Skip(sizeof(T));
+    return true;
+  }
+
+  bool ReadBytes(size_t length, std::string* value) {
+    if (remaining_ < length) return false;
+    value->assign(data_, length);
+    Skip(length);
+    return true;
+  }
+
+  bool ReadString(std::string* value) {
+    uint32_t length = 0;
+    return Read(&length) && ReadBytes(length, value);
+  }
+
+  bool SkipBytes(size_t length) {
+    if (remaining_ < length) return false;
+    Skip(length);
+    return true;
+  }
+
+  // Moves the next |length| bytes into |part|, a cursor of their own.
+  bool Split(size_t length, Cursor* part) {
+    if (remaining_ < length) return false;
+    *part = Cursor(data_, length);
+    Skip(length);
+    return true;
+  }
+
+  const char* data() const { return data_; }
+  size_t remaining() const { return remaining_; }
+
+ private:
+  void Skip(size_t length) {
+    data_ += length;
+    remaining_ -= length;
+  }
+
+  const char* data_;
+  size_t remaining_;
+};
+
+// Reads the actions and payload that end a record.
+bool ReadTail(Cursor* cursor, FlMessageCodec* codec, uint32_t action_count,
+              uint32_t payload_length, ScheduledRequest* request) {
+  if (action_count > cursor->remaining() / (2 * sizeof(uint32_t))) return false;
+
+  request->actions.resize(action_count);
+  for (auto& action : request->actions) {
+    if (!cursor->ReadString(&action.first) || !cursor->ReadString(&action.second)) return false;
+  }
+
+  if (payload_length > 0) {
+    std::string payload;
+    if (!cursor->ReadBytes(payload_length, &payload)) return false;
+    g_autoptr(GBytes) bytes = g_bytes_new(payload.data(), payload.size());
+    request->payload = fl_message_codec_decode_message(codec, bytes, nullptr);
+    if (request->payload == nullptr) return false;
+  }
+  return true;
+}
+
+bool ReadRecord(Cursor* cursor, FlMessageCodec* codec, ZlibBlockCodec* zlib, uint32_t version,
+                ScheduledRequest* request) {
+  uint32_t action_count = 0;
+  uint32_t payload_length = 0;
+  if (!cursor->Read(&request->fire_at_ms) || !cursor->Read(&request->repeat_interval_s) ||
+      !cursor->Read(&request->timeout_s) || !cursor->Read(&request->badge_number) ||
+      !cursor->Read(&action_count) || !cursor->Read(&payload_length) ||
+      !cursor->ReadString(&request->id) || !cursor->ReadString(&request->title) ||
+      !cursor->ReadString(&request->body) || !cursor->ReadString(&request->category) ||
+      (version > kNoRecurrenceVersion && !cursor->ReadString(&request->recurrence)) ||
+      (version > kNoGroupVersion && !cursor->ReadString(&request->group))) {
+    return false;
+  }
+  if (version <= kNoPackingVersion || !(payload_length & kPackedTail)) {
+    return ReadTail(cursor, codec, action_count, payload_length, request);
+  }
+
+  // A packed tail runs to the end of the record.
+  uint32_t raw_length = 0;
+  std::string tail;
+  if (!cursor->Read(&raw_length) || raw_length > kMaxInflation * cursor->remaining() ||
+      !zlib->Decompress(cursor->data(), cursor->remaining(), raw_length, &tail)) {
+    return false;
+  }
+  cursor->SkipBytes(cursor->remaining());
+  Cursor unpacked(tail.data(), tail.size());
+  return ReadTail(&unpacked, codec, action_count, payload_length & ~kPackedTail, request) &&
+         unpacked.remaining() == 0;
+}
+
+// Reads a record of the current version, which starts with its length.
+bool ReadRevisionRecord(Cursor* cursor, FlMessageCodec* codec, ZlibBlockCodec* zlib,
+                        uint32_t version, ScheduledRequest* request) {
+  uint32_t length = 0;
+  Cursor record(nullptr, 0);
+  return cursor->Read(&length) && cursor->Split(length, &record) &&
+         record.Read(&request->revision) && ReadRecord(&record, codec, zlib, version, request);
+}
+
+bool ReadJsonRequestRecord(Cursor* cursor, ScheduledRequest* request) {
+  uint32_t id_length = 0;
+  uint32_t json_length = 0;
+  std::string json;
+  if (!cursor->Read(&request->fire_at_ms) || !cursor->Read(&request->repeat_interval_s) ||
+      !cursor->Read(&id_length) || !cursor->Read(&json_length) ||
+      !cursor->ReadBytes(id_length, &request->id) || !cursor->ReadBytes(json_length, &json)) {
+    return false;
+  }
+  // An unreadable request still keeps its id and timing.
+  ScheduledRequestFromJson(json, request);
+  return true;
+}
+
+struct Header {
+  uint32_t version = 0;
+  uint64_t count = 0;
+  uint64_t writer = 0;
+};
+
+bool ReadHeader(Cursor* cursor, Header* header) {
+  std::string magic;
+  return cursor->ReadBytes(sizeof(kMagic), &magic) &&
+         memcmp(magic.data(), kMagic, sizeof(kMagic)) == 0 && cursor->Read(&header->version) &&
+         header->version >= kJsonRequestVersion && header->version <= kVersion &&
+         cursor->Read(&header->count) &&
+         (header->version <= kNoRevisionVersion || cursor->Read(&header->writer)) &&
+         header->count <= cursor->remaining() / kMinRecordSize;
+}
+
+// Maps |path| read-only, or returns nullptr. A missing file is expected and
+// not logged.
+GMappedFile* MapSnapshot(const std::string& path) {
+  g_autoptr(GError) error = nullptr;
+  GMappedFile* file = g_mapped_file_new(path.c_str(), FALSE, &error);
+  if (file == nullptr && !g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+    g_warning("Failed to open %s: %s", path.c_str(), error->message);
+  }
+  return file;
+}
+
+void UnrefPayloads(std::vector<ScheduledRequest>* requests) {
+  for (auto& request : *requests) {
+    if (request.payload) fl_value_unref(request.payload);
+  }
+}
+
+}  // namespace
+
+uint32_t ScheduledShardOf(const std::string& id, uint32_t shard_count) {
+  // FNV-1a, which spreads short, similar ids well.
+  uint32_t hash = 2166136261u;
+  for (unsigned char c : id) {
+    hash ^= c;
+    hash *= 16777619u;
+  }
+  return hash % shard_count;
+}
+
+std::string ScheduledShardPath(const std::string& dir, uint32_t shard) {
+  g_autofree gchar* name = g_strdup_printf("%02u.bin", shard);
+  return dir + "/" + name;
+}
+
+std::string EncodeScheduledSnapshot(const ScheduledStore& store,
+                                    uint64_t writer,
+                                    const SnapshotShard& shard,
+                                    size_t compress_threshold) {
+  g_autoptr(FlStandardMessageCodec) codec = fl_standard_message_codec_new();
+  ZlibBlockCodec zlib;
+  std::string tail;
+  std::string packed;
+
+  std::string buffer;
+  // A shard holds about its share of the entries.
+  size_t entry_bytes = store.arena_bytes() - store.garbage_bytes() +
+                       store.size() * (kMinRecordSize + 7 * sizeof(int64_t));
+  buffer.reserve(kHeaderSize + entry_bytes / std::max<uint32_t>(shard.count, 1));
+  buffer.append(kMagic, sizeof(kMagic));
+  Append<uint32_t>(&buffer, kVersion);
+  size_t count_offset = buffer.size();
+  Append<uint64_t>(&buffer, 0);
+  Append<uint64_t>(&buffer, writer);
+
+  uint64_t count = 0;
+  store.ForEach([&](const ScheduledStore::Record& record) {
+    std::string id = store.GetString(record.id);
+    if (!shard.Contains(id)) return;
+    count++;
+
+    g_autoptr(GBytes) payload = nullptr;
+    gsize payload_length = 0;
+    const void* payload_data = nullptr;
+    if (record.payload) {
+      payload = fl_message_codec_encode_message(FL_MESSAGE_CODEC(codec), record.payload, nullptr);
+      if (payload) payload_data = g_bytes_get_data(payload, &payload_length);
+    }
+
+    tail.clear();
+    for (const auto& action : store.ActionsOf(record)) {
+      AppendString(&tail, action.first.data(), action.first.size());
+      AppendString(&tail, action.second.data(), action.second.size());
+    }
+    if (payload_data) tail.append(static_cast<const char*>(payload_data), payload_length);
+    // Small tails stay raw, as do those zlib cannot shrink.
+    bool pack = tail.size() >= compress_threshold &&
+                zlib.Compress(tail.data(), tail.size(), &packed) &&
+                packed.size() + sizeof(uint32_t) < tail.size();
+
+    size_t length_offset = buffer.size();
+    Append<uint32_t>(&buffer, 0);
+    Append<uint64_t>(&buffer, record.revision);
+    Append<int64_t>(&buffer, record.fire_at_ms);
+    Append<int64_t>(&buffer, record.repeat_interval_s);
+    Append<int64_t>(&buffer, record.timeout_s);
+    Append<int64_t>(&buffer, record.badge_number);
+    Append<uint32_t>(&buffer, record.action_count);
+    Append<uint32_t>(&buffer, static_cast<uint32_t>(payload_length) | (pack ? kPackedTail : 0));
+    AppendString(&buffer, id.data(), id.size());
+    for (ScheduledStore::StringRef ref :
+         {record.title, record.body, record.category, record.recurrence, record.group}) {
+      std::string value = store.GetString(ref);
+      AppendString(&buffer, value.data(), value.size());
+    }
+    if (pack) {
+      Append<uint32_t>(&buffer, static_cast<uint32_t>(tail.size()));
+      buffer.append(packed);
+    } else {
+      buffer.append(tail);
+    }
+
+    uint32_t length = static_cast<uint32_t>(buffer.size() - length_offset - sizeof(uint32_t));
+    memcpy(&buffer[length_offset], &length, sizeof(length));
+  });
+  memcpy(&buffer[count_offset], &count, sizeof(count));
+  return buffer;
+}
+
+bool WriteScheduledSnapshot(const std::string& path,
+                            const ScheduledStore& store,
+                            uint64_t writer,
+                            const SnapshotShard& shard,
+                            size_t compress_threshold) {
+  return ReplaceFile(path, EncodeScheduledSnapshot(store, writer, shard, compress_threshold));
+}
+
+bool ReadScheduledSnapshot(const std::string& path, ScheduledStore* store) {
+  GMappedFile* file = MapSnapshot(path);
+  if (file == nullptr) return false;
+
+  g_autoptr(FlStandardMessageCodec) codec = fl_standard_message_codec_new();
+  ZlibBlockCodec zlib;
+  Cursor cursor(g_mapped_file_get_contents(file), g_mapped_file_get_length(file));
+  Header header;
+  bool valid = ReadHeader(&cursor, &header);
+
+  // Decode everything before touching |store|, so a bad file adds nothing.
+  std::vector<ScheduledRequest> requests;
+  if (valid) {
+    requests.resize(header.count);
+    for (auto& request : requests) {
+      if (header.version == kJsonRequestVersion) {
+        valid = ReadJsonRequestRecord(&cursor, &request);
+      } else if (header.version <= kNoRevisionVersion) {
+        valid = ReadRecord(&cursor, FL_MESSAGE_CODEC(codec), &zlib, header.version, &request);
+      } else {
+        valid = ReadRevisionRecord(&cursor, FL_MESSAGE_CODEC(codec), &zlib, header.version, &request);
+      }
+      if (!valid) break;
+    }
+  }
+  g_mapped_file_unref(file);
+
+  if (valid) {
+    for (const auto& request : requests) {
+      // Calls made before the snapshot was read win over it.
+      if (!store->Contains(request.id)) store->Put(request);
+    }
+  } else {
+    g_warning("Ignoring malformed scheduled snapshot %s", path.c_str());
+  }
+  UnrefPayloads(&requests);
+  return valid;
+}
+
+bool ReloadScheduledSnapshot(const std::string& path,
+                             uint64_t writer,
+                             const std::unordered_set<std::string>& local,
+                             ScheduledStore* store,
+                             SnapshotReload* reload,
+                             const SnapshotShard& shard) {
+  *reload = SnapshotReload();
+  GMappedFile* file = MapSnapshot(path);
+  if (file == nullptr) return false;
+
+  Cursor cursor(g_mapped_file_get_contents(file), g_mapped_file_get_length(file));
+  Header header;
+  bool valid = ReadHeader(&cursor, &header) && header.version > kNoRevisionVersion;
+  if (valid && writer != 0 && header.writer == writer) {
+    g_mapped_file_unref(file);
+    reload->own_write = true;
+    return true;
+  }
+
+  // Only the id and revision of each record are read, unless the revision
+  // differs from the one in |store|. As in ReadScheduledSnapshot(), nothing
+  // is applied until the whole file has checked out.
+  g_autoptr(FlStandardMessageCodec) codec = fl_standard_message_codec_new();
+  ZlibBlockCodec zlib;
+  std::unordered_set<std::string> in_file;
+  std::vector<ScheduledRequest> changed;
+  for (uint64_t i = 0; valid && i < header.count; i++) {
+    uint32_t length = 0;
+    uint64_t revision = 0;
+    std::string id;
+    Cursor record(nullptr, 0);
+    valid = cursor.Read(&length) && cursor.Split(length, &record);
+    if (!valid) break;
+    Cursor fields = record;
+    valid = fields.Read(&revision) && fields.SkipBytes(kFixedFieldsSize) && fields.ReadString(&id);
+    if (!valid) break;
+
+    ScheduledStore::Record existing;
+    bool unchanged = local.count(id) > 0 ||
+                     (store->Find(id, &existing) && existing.revision == revision);
+    in_file.insert(std::move(id));
+    if (unchanged) continue;
+
+    changed.emplace_back();
+    valid = record.Read(&changed.back().revision) &&
+            ReadRecord(&record, FL_MESSAGE_CODEC(codec), &zlib, header.version, &changed.back());
+    reload->decoded++;
+  }
+  g_mapped_file_unref(file);
+
+  if (!valid) {
+    g_warning("Ignoring malformed scheduled snapshot %s", path.c_str());
+    UnrefPayloads(&changed);
+    return false;
+  }
+
+  for (const auto& request : changed) {
+    store->Put(request);
+    reload->upserted.push_back(request.id);
+  }
+  store->ForEach([&](const ScheduledStore::Record& record) {
+    std::string id = store->GetString(record.id);
+    if (in_file.count(id) == 0 && local.count(id) == 0 && shard.Contains(id)) {
+      reload->removed.push_back(std::move(id));
+    }
+  });
+  for (const auto& id : reload->removed) store->Remove(id);
+  UnrefPayloads(&changed);
+  return true;
+}
+
+}  // namespace notification_manager
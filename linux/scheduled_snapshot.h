@@ -0,0 +1,108 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SCHEDULED_SNAPSHOT_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SCHEDULED_SNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "scheduled_store.h"
+
+namespace notification_manager {
+
+// Scheduled entries are spread over this many snapshot files by a hash of
+// their id, so a change rewrites one small file instead of every entry.
+constexpr uint32_t kScheduledShardCount = 16;
+
+// Which of |shard_count| shards the entry with |id| is kept in.
+uint32_t ScheduledShardOf(const std::string& id, uint32_t shard_count);
+
+// Path of the snapshot file for |shard| in |dir|.
+std::string ScheduledShardPath(const std::string& dir, uint32_t shard);
+
+// The entries of one shard. The default covers every entry.
+struct SnapshotShard {
+  uint32_t index = 0;
+  uint32_t count = 1;
+
+  bool Contains(const std::string& id) const {
+    return count <= 1 || ScheduledShardOf(id, count) == index;
+  }
+};
+
+// Records whose actions and payload together take at least this many
+// bytes have them compressed with zlib.
+constexpr size_t kSnapshotCompressThreshold = 256;
+
+// Writes every entry of |store| to |path| as a compact binary snapshot. The
+// file is replaced atomically, so readers never see a partial snapshot.
+//
+// Layout, in host byte order:
+//   header:  "NMSS" | uint32 version | uint64 count | uint64 writer
+//   record:  uint32 record_length | uint64 revision |
+//            int64 fire_at_ms | int64 repeat_interval_s | int64 timeout_s |
+//            int64 badge_number | uint32 action_count | uint32 payload_length |
+//            id | title | body | category | recurrence | group |
+//            (action id | action label)... |
+//            payload
+// where each string is a uint32 length followed by its bytes, and the
+// payload is encoded with the standard message codec. |writer| identifies
+// the process that wrote the file, and |record_length| counts the bytes
+// after it, so a reader can step over a record without decoding it. Only
+// the entries in |shard| are written.
+//
+// When the actions and payload of a record take |compress_threshold| bytes
+// or more and zlib shrinks them, the top bit of payload_length is set and
+// they are replaced by a uint32 raw length followed by one zlib stream that
+// runs to the end of the record. The id stays raw either way, so reloads can
+// still compare records without inflating them.
+bool WriteScheduledSnapshot(const std::string& path,
+                            const ScheduledStore& store,
+                            uint64_t writer = 0,
+                            const SnapshotShard& shard = SnapshotShard(),
+                            size_t compress_threshold = kSnapshotCompressThreshold);
+
+// The bytes WriteScheduledSnapshot() would write, for writing elsewhere,
+// e.g. on an IoThread.
+std::string EncodeScheduledSnapshot(const ScheduledStore& store,
+                                    uint64_t writer = 0,
+                                    const SnapshotShard& shard = SnapshotShard(),
+                                    size_t compress_threshold = kSnapshotCompressThreshold);
+
+// Reads a snapshot written by WriteScheduledSnapshot() into |store| with one
+// sequential pass over a read-only mapping of the file. Entries already in
+// |store| are kept. Returns false, adding nothing, if the file is missing or
+// malformed. Snapshots from earlier versions, without groups, compression,
+// recurrence rules or with each request kept as JSON, are still read.
+bool ReadScheduledSnapshot(const std::string& path, ScheduledStore* store);
+
+// What ReloadScheduledSnapshot() did.
+struct SnapshotReload {
+  // The snapshot was written by the reloading process, so nothing was read.
+  bool own_write = false;
+  // Ids inserted or replaced, and ids removed, in file and id order.
+  std::vector<std::string> upserted;
+  std::vector<std::string> removed;
+  // Records decoded; unchanged ones are stepped over.
+  size_t decoded = 0;
+};
+
+// Brings |store| up to date with a snapshot that another process may have
+// rewritten since it was read. Records whose revision matches the entry in
+// |store| are skipped without decoding, the others replace their entries,
+// and entries of |shard| missing from the file are removed. Ids in |local|,
+// changed here since this process last wrote the file, are left alone.
+// Nothing is read if the file was written by |writer|. Returns false,
+// changing nothing, if the file is missing, malformed or older than
+// version 4.
+bool ReloadScheduledSnapshot(const std::string& path,
+                             uint64_t writer,
+                             const std::unordered_set<std::string>& local,
+                             ScheduledStore* store,
+                             SnapshotReload* reload,
+                             const SnapshotShard& shard = SnapshotShard());
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SCHEDULED_SNAPSHOT_H_
@@ -0,0 +1,487 @@
+#include "scheduled_store.h"
+
+#include <json-glib/json-glib.h>
+
+#include <map>
+
+#include "scheduled_ndjson.h"
+
+namespace notification_manager {
+
+namespace {
+
+// Compaction is skipped for small arenas and columns, where the copy is
+// not worth it.
+constexpr size_t kMinCompactBytes = 64 * 1024;
+constexpr size_t kMinCompactSlots = 4096;
+
+}  // namespace
+
+bool ScheduledRequestFromJson(const std::string& json, ScheduledRequest* request) {
+  JsonNode* root = json_from_string(json.c_str(), nullptr);
+  if (root == nullptr) return false;
+
+  bool valid = json_node_get_node_type(root) == JSON_NODE_OBJECT;
+  if (valid) {
+    JsonObject* object = json_node_get_object(root);
+    request->title = json_object_get_string_member_with_default(object, "title", "");
+    request->body = json_object_get_string_member_with_default(object, "body", "");
+    request->category = json_object_get_string_member_with_default(object, "category", "");
+    request->group = json_object_get_string_member_with_default(object, "group", "");
+    request->timeout_s = json_object_get_int_member_with_default(object, "timeout", 0);
+    request->badge_number = json_object_get_int_member_with_default(object, "badgeNumber", -1);
+
+    JsonNode* actions = json_object_get_member(object, "actions");
+    if (actions && json_node_get_node_type(actions) == JSON_NODE_ARRAY) {
+      JsonArray* array = json_node_get_array(actions);
+      for (guint i = 0; i < json_array_get_length(array); i++) {
+        JsonNode* action = json_array_get_element(array, i);
+        if (json_node_get_node_type(action) != JSON_NODE_OBJECT) continue;
+        JsonObject* action_object = json_node_get_object(action);
+        request->actions.emplace_back(
+            json_object_get_string_member_with_default(action_object, "id", ""),
+            json_object_get_string_member_with_default(action_object, "title", ""));
+      }
+    }
+
+    JsonNode* payload = json_object_get_member(object, "payload");
+    if (payload && json_node_get_node_type(payload) == JSON_NODE_OBJECT) {
+      request->payload = FlValueFromJson(payload);
+    }
+  }
+  json_node_free(root);
+  return valid;
+}
+
+ScheduledStore::ScheduledStore(size_t change_log_capacity)
+    : index_(IdLess{this}),
+      by_fire_time_(FireLess{this}),
+      change_log_capacity_(change_log_capacity) {}
+
+ScheduledStore::~ScheduledStore() {
+  Clear();
+}
+
+void ScheduledStore::Put(const ScheduledRequest& request) {
+  auto existing = index_.find(IdKey{request.id.data(), request.id.size()});
+  uint32_t slot;
+  if (existing != index_.end()) {
+    // Keep the slot, and with it the id's position in the index.
+    slot = *existing;
+    by_fire_time_.erase(slot);
+    Release(slot);
+    Fill(slot, request);
+    LogChange(ChangeKind::kUpdate, request.id);
+  } else {
+    slot = AllocateSlot();
+    Fill(slot, request);
+    index_.insert(slot);
+    LogChange(ChangeKind::kInsert, request.id);
+  }
+
+  fire_at_ms_[slot] = request.fire_at_ms;
+  if (request.fire_at_ms > 0) by_fire_time_.insert(slot);
+  MaybeCompact();
+}
+
+bool ScheduledStore::Remove(const std::string& id) {
+  auto it = index_.find(IdKey{id.data(), id.size()});
+  if (it == index_.end()) return false;
+
+  uint32_t slot = *it;
+  if (fire_at_ms_[slot] > 0) by_fire_time_.erase(slot);
+  index_.erase(slot);
+  Release(slot);
+  flags_[slot] = 0;
+  free_slots_.push_back(slot);
+  LogChange(ChangeKind::kRemove, id);
+  MaybeCompact();
+  return true;
+}
+
+void ScheduledStore::Clear() {
+  for (const auto& pair : payloads_) fl_value_unref(pair.second);
+  payloads_.clear();
+  by_fire_time_.clear();
+  index_.clear();
+  fire_at_ms_.clear();
+  repeat_interval_s_.clear();
+  revisions_.clear();
+  timeout_s_.clear();
+  badge_number_.clear();
+  strings_.clear();
+  actions_begin_.clear();
+  action_count_.clear();
+  flags_.clear();
+  free_slots_.clear();
+  actions_.clear();
+  arena_.clear();
+  garbage_bytes_ = 0;
+  garbage_actions_ = 0;
+  // Logging every removal could flood the log; a full listing of the empty
+  // store is cheaper for readers.
+  ResetChangeLog(version_ + 1);
+}
+
+bool ScheduledStore::SetFireTime(const std::string& id, int64_t fire_at_ms) {
+  auto it = index_.find(IdKey{id.data(), id.size()});
+  if (it == index_.end()) return false;
+
+  uint32_t slot = *it;
+  if (fire_at_ms_[slot] > 0) by_fire_time_.erase(slot);
+  fire_at_ms_[slot] = fire_at_ms;
+  if (fire_at_ms > 0) by_fire_time_.insert(slot);
+  revisions_[slot] = NewRevision();
+  LogChange(ChangeKind::kUpdate, id);
+  return true;
+}
+
+int64_t ScheduledStore::CoalescedFireTime(int64_t slack_ms) const {
+  int64_t first = NextFireTime();
+  if (first == 0 || slack_ms <= 0) return first;
+
+  auto it = by_fire_time_.lower_bound(FireKey{first + slack_ms + 1, IdKey{"", 0}});
+  return fire_at_ms_[by_fire_time_.Before(it)];
+}
+
+void ScheduledStore::ResetChangeLog(uint64_t version) {
+  version_ = std::max(version_, version);
+  log_floor_ = version_;
+  change_log_.clear();
+}
+
+bool ScheduledStore::ChangesSince(uint64_t since, std::vector<Change>* out) const {
+  out->clear();
+  if (since < log_floor_ || since > version_) return false;
+
+  // Walk backwards so the first change seen for an id is its last one, and
+  // remember the earliest kind seen for it along the way.
+  std::map<std::string, size_t> latest;
+  std::vector<Change> reversed;
+  std::vector<ChangeKind> first_kind;
+  for (size_t i = change_log_.size(); i > since - log_floor_; i--) {
+    const Change& change = change_log_[i - 1];
+    auto inserted = latest.emplace(change.id, reversed.size());
+    if (inserted.second) {
+      reversed.push_back(change);
+      first_kind.push_back(change.kind);
+    } else {
+      first_kind[inserted.first->second] = change.kind;
+    }
+  }
+
+  for (size_t i = reversed.size(); i > 0; i--) {
+    Change& change = reversed[i - 1];
+    bool reader_has_id = first_kind[i - 1] != ChangeKind::kInsert;
+    if (change.kind == ChangeKind::kRemove) {
+      if (!reader_has_id) continue;
+    } else {
+      change.kind = reader_has_id ? ChangeKind::kUpdate : ChangeKind::kInsert;
+    }
+    out->push_back(std::move(change));
+  }
+  return true;
+}
+
+void ScheduledStore::LogChange(ChangeKind kind, const std::string& id) {
+  change_log_.push_back(Change{++version_, kind, id});
+  if (change_log_.size() > change_log_capacity_) {
+    change_log_.pop_front();
+    log_floor_++;
+  }
+}
+
+uint64_t ScheduledStore::NewRevision() {
+  // Random rather than counted, so revisions made by different processes
+  // never collide. Zero is left for "none".
+  uint64_t revision = (static_cast<uint64_t>(g_random_int()) << 32) | g_random_int();
+  return revision != 0 ? revision : 1;
+}
+
+int64_t ScheduledStore::NextFireTime() const {
+  return by_fire_time_.empty() ? 0 : fire_at_ms_[*by_fire_time_.begin()];
+}
+
+bool ScheduledStore::Find(const std::string& id, Record* record) const {
+  auto it = index_.find(IdKey{id.data(), id.size()});
+  if (it == index_.end()) return false;
+  *record = RecordAt(*it);
+  return true;
+}
+
+NotificationContent ScheduledStore::ContentOf(const Record& record) const {
+  NotificationContent content;
+  content.title = GetString(record.title);
+  content.body = GetString(record.body);
+  content.actions = ActionsOf(record);
+  content.category = GetString(record.category);
+  content.group = GetString(record.group);
+  return content;
+}
+
+std::vector<std::pair<std::string, std::string>> ScheduledStore::ActionsOf(
+    const Record& record) const {
+  std::vector<std::pair<std::string, std::string>> actions;
+  actions.reserve(record.action_count);
+  for (uint32_t i = 0; i < record.action_count; i++) {
+    uint32_t index = record.actions_begin + 2 * i;
+    actions.emplace_back(GetString(actions_[index]), GetString(actions_[index + 1]));
+  }
+  return actions;
+}
+
+FlValue* ScheduledStore::ToFlValue(const Record& record) const {
+  std::string id = GetString(record.id);
+
+  FlValue* request = fl_value_new_map();
+  fl_value_set_string_take(request, "id", fl_value_new_string(id.c_str()));
+  fl_value_set_string_take(request, "title", fl_value_new_string(GetString(record.title).c_str()));
+  fl_value_set_string_take(request, "body", fl_value_new_string(GetString(record.body).c_str()));
+  if (record.action_count > 0) {
+    FlValue* actions = fl_value_new_list();
+    for (const auto& action : ActionsOf(record)) {
+      FlValue* entry = fl_value_new_map();
+      fl_value_set_string_take(entry, "id", fl_value_new_string(action.first.c_str()));
+      fl_value_set_string_take(entry, "title", fl_value_new_string(action.second.c_str()));
+      fl_value_append_take(actions, entry);
+    }
+    fl_value_set_string_take(request, "actions", actions);
+  }
+  if (record.payload) {
+    fl_value_set_string(request, "payload", record.payload);
+  }
+  if (record.category.length > 0) {
+    fl_value_set_string_take(request, "category",
+                             fl_value_new_string(GetString(record.category).c_str()));
+  }
+  if (record.group.length > 0) {
+    fl_value_set_string_take(request, "group",
+                             fl_value_new_string(GetString(record.group).c_str()));
+  }
+  if (record.badge_number >= 0) {
+    fl_value_set_string_take(request, "badgeNumber", fl_value_new_int(record.badge_number));
+  }
+  if (record.timeout_s > 0) {
+    fl_value_set_string_take(request, "timeout", fl_value_new_int(record.timeout_s));
+  }
+
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "id", fl_value_new_string(id.c_str()));
+  fl_value_set_string_take(value, "request", request);
+  fl_value_set_string_take(value, "scheduledDate", fl_value_new_int(record.fire_at_ms));
+  fl_value_set_string_take(value, "isRepeating",
+                           fl_value_new_bool(record.repeat_interval_s > 0 ||
+                                             record.recurrence.length > 0));
+  if (record.repeat_interval_s > 0) {
+    fl_value_set_string_take(value, "repeatInterval", fl_value_new_int(record.repeat_interval_s));
+  }
+  if (record.recurrence.length > 0) {
+    fl_value_set_string_take(value, "recurrence",
+                             fl_value_new_string(GetString(record.recurrence).c_str()));
+  }
+  return value;
+}
+
+ScheduledStore::MemoryUsage ScheduledStore::memory_usage() const {
+  MemoryUsage usage;
+  usage.columns = fire_at_ms_.capacity() * sizeof(int64_t) +
+                  repeat_interval_s_.capacity() * sizeof(int64_t) +
+                  revisions_.capacity() * sizeof(uint64_t) +
+                  timeout_s_.capacity() * sizeof(int32_t) +
+                  badge_number_.capacity() * sizeof(int32_t) +
+                  strings_.capacity() * sizeof(Strings) +
+                  actions_begin_.capacity() * sizeof(uint32_t) +
+                  action_count_.capacity() * sizeof(uint32_t) +
+                  flags_.capacity() * sizeof(uint8_t) +
+                  free_slots_.capacity() * sizeof(uint32_t);
+  usage.strings = arena_.capacity();
+  usage.actions = actions_.capacity() * sizeof(StringRef);
+  // A bucket pointer plus a node per payload; the maps themselves are
+  // owned by the payloads.
+  usage.payload_index = payloads_.bucket_count() * sizeof(void*) +
+                        payloads_.size() * (sizeof(void*) + sizeof(std::pair<uint32_t, FlValue*>));
+  usage.indexes = index_.memory_bytes() + by_fire_time_.memory_bytes();
+  return usage;
+}
+
+ScheduledStore::Record ScheduledStore::RecordAt(uint32_t slot) const {
+  Record record;
+  StringRef* fields[kStringFieldCount] = {&record.id, &record.title, &record.body,
+                                          &record.category, &record.group, &record.recurrence};
+  uint32_t offset = strings_[slot].offset;
+  for (int i = 0; i < kStringFieldCount; i++) {
+    *fields[i] = StringRef{offset, strings_[slot].lengths[i]};
+    offset += strings_[slot].lengths[i];
+  }
+  record.actions_begin = actions_begin_[slot];
+  record.action_count = action_count_[slot];
+  record.payload = (flags_[slot] & kHasPayload) ? payloads_.at(slot) : nullptr;
+  record.timeout_s = timeout_s_[slot];
+  record.badge_number = badge_number_[slot];
+  record.fire_at_ms = fire_at_ms_[slot];
+  record.repeat_interval_s = repeat_interval_s_[slot];
+  record.revision = revisions_[slot];
+  return record;
+}
+
+ScheduledStore::StringRef ScheduledStore::Append(const std::string& value) {
+  StringRef ref{static_cast<uint32_t>(arena_.size()), static_cast<uint32_t>(value.size())};
+  arena_.append(value);
+  return ref;
+}
+
+uint32_t ScheduledStore::AllocateSlot() {
+  if (!free_slots_.empty()) {
+    uint32_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+  }
+  fire_at_ms_.push_back(0);
+  repeat_interval_s_.push_back(0);
+  revisions_.push_back(0);
+  timeout_s_.push_back(0);
+  badge_number_.push_back(-1);
+  strings_.push_back(Strings{});
+  actions_begin_.push_back(0);
+  action_count_.push_back(0);
+  flags_.push_back(0);
+  return static_cast<uint32_t>(fire_at_ms_.size() - 1);
+}
+
+void ScheduledStore::Fill(uint32_t slot, const ScheduledRequest& request) {
+  const std::string* values[kStringFieldCount] = {&request.id, &request.title, &request.body,
+                                                  &request.category, &request.group,
+                                                  &request.recurrence};
+  Strings& strings = strings_[slot];
+  strings.offset = static_cast<uint32_t>(arena_.size());
+  for (int i = 0; i < kStringFieldCount; i++) {
+    strings.lengths[i] = Append(*values[i]).length;
+  }
+
+  actions_begin_[slot] = static_cast<uint32_t>(actions_.size());
+  action_count_[slot] = static_cast<uint32_t>(request.actions.size());
+  for (const auto& action : request.actions) {
+    actions_.push_back(Append(action.first));
+    actions_.push_back(Append(action.second));
+  }
+
+  flags_[slot] = kLive;
+  if (request.payload) {
+    payloads_[slot] = fl_value_ref(request.payload);
+    flags_[slot] |= kHasPayload;
+  }
+  timeout_s_[slot] = static_cast<int32_t>(CLAMP(request.timeout_s, 0, G_MAXINT32));
+  badge_number_[slot] = static_cast<int32_t>(CLAMP(request.badge_number, -1, G_MAXINT32));
+  repeat_interval_s_[slot] = request.repeat_interval_s;
+  revisions_[slot] = request.revision != 0 ? request.revision : NewRevision();
+}
+
+void ScheduledStore::Release(uint32_t slot) {
+  for (uint32_t length : strings_[slot].lengths) garbage_bytes_ += length;
+  for (uint32_t i = 0; i < 2 * action_count_[slot]; i++) {
+    garbage_bytes_ += actions_[actions_begin_[slot] + i].length;
+  }
+  garbage_actions_ += 2 * action_count_[slot];
+  if (flags_[slot] & kHasPayload) {
+    auto it = payloads_.find(slot);
+    fl_value_unref(it->second);
+    payloads_.erase(it);
+    flags_[slot] &= ~kHasPayload;
+  }
+}
+
+void ScheduledStore::MaybeCompact() {
+  if (garbage_bytes_ >= kMinCompactBytes && garbage_bytes_ * 2 >= arena_.size()) {
+    CompactArena();
+  }
+  if (free_slots_.size() >= kMinCompactSlots && free_slots_.size() * 2 >= slot_count()) {
+    CompactSlots();
+  }
+}
+
+void ScheduledStore::CompactArena() {
+  // Copy every live string into a fresh arena, in slot order. The indexes
+  // stay valid: they hold slots, and ids compare the same wherever they
+  // live.
+  std::string arena;
+  arena.reserve(arena_.size() - garbage_bytes_);
+  std::vector<StringRef> actions;
+  actions.reserve(actions_.size() - garbage_actions_);
+  auto move = [&](StringRef ref) {
+    StringRef moved{static_cast<uint32_t>(arena.size()), ref.length};
+    arena.append(Data(ref), ref.length);
+    return moved;
+  };
+  for (uint32_t slot = 0; slot < slot_count(); slot++) {
+    if (!(flags_[slot] & kLive)) continue;
+    Strings& strings = strings_[slot];
+    uint32_t length = 0;
+    for (uint32_t field_length : strings.lengths) length += field_length;
+    strings.offset = move(StringRef{strings.offset, length}).offset;
+
+    uint32_t actions_begin = static_cast<uint32_t>(actions.size());
+    for (uint32_t i = 0; i < 2 * action_count_[slot]; i++) {
+      actions.push_back(move(actions_[actions_begin_[slot] + i]));
+    }
+    actions_begin_[slot] = actions_begin;
+  }
+
+  arena_.swap(arena);
+  actions_.swap(actions);
+  garbage_bytes_ = 0;
+  garbage_actions_ = 0;
+}
+
+void ScheduledStore::CompactSlots() {
+  // Read both orders out before any slot moves; the comparators look keys
+  // up by slot.
+  std::vector<uint32_t> by_id(index_.begin(), index_.end());
+  std::vector<uint32_t> by_fire_time(by_fire_time_.begin(), by_fire_time_.end());
+
+  // Live entries keep their relative order, so each moves down or stays.
+  std::vector<uint32_t> moved_to(slot_count());
+  uint32_t live = 0;
+  for (uint32_t slot = 0; slot < slot_count(); slot++) {
+    if (!(flags_[slot] & kLive)) continue;
+    moved_to[slot] = live;
+    if (slot != live) {
+      fire_at_ms_[live] = fire_at_ms_[slot];
+      repeat_interval_s_[live] = repeat_interval_s_[slot];
+      revisions_[live] = revisions_[slot];
+      timeout_s_[live] = timeout_s_[slot];
+      badge_number_[live] = badge_number_[slot];
+      strings_[live] = strings_[slot];
+      actions_begin_[live] = actions_begin_[slot];
+      action_count_[live] = action_count_[slot];
+      flags_[live] = flags_[slot];
+      if (flags_[slot] & kHasPayload) {
+        payloads_[live] = payloads_[slot];
+        payloads_.erase(slot);
+      }
+    }
+    live++;
+  }
+
+  auto shrink = [live](auto* column) {
+    column->resize(live);
+    column->shrink_to_fit();
+  };
+  shrink(&fire_at_ms_);
+  shrink(&repeat_interval_s_);
+  shrink(&revisions_);
+  shrink(&timeout_s_);
+  shrink(&badge_number_);
+  shrink(&strings_);
+  shrink(&actions_begin_);
+  shrink(&action_count_);
+  shrink(&flags_);
+  free_slots_.clear();
+  free_slots_.shrink_to_fit();
+
+  for (uint32_t& slot : by_id) slot = moved_to[slot];
+  for (uint32_t& slot : by_fire_time) slot = moved_to[slot];
+  index_.Assign(by_id);
+  by_fire_time_.Assign(by_fire_time);
+}
+
+}  // namespace notification_manager
@@ -0,0 +1,352 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SCHEDULED_STORE_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SCHEDULED_STORE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "notification_backend.h"
+#include "slot_index.h"
+
+namespace notification_manager {
+
+// A scheduled notification in unpacked form, used to insert into the store.
+struct ScheduledRequest {
+  std::string id;
+  std::string title;
+  std::string body;
+  std::string category;
+  // Group the notification joins once shown, e.g. one conversation.
+  std::string group;
+  // Action buttons as (action id, label) pairs.
+  std::vector<std::pair<std::string, std::string>> actions;
+  // Free-form payload map, or nullptr. Borrowed; the store keeps its own
+  // reference.
+  FlValue* payload = nullptr;
+  // Seconds before the notification expires, or zero for the default.
+  // Stored as 32 bits; larger values are clamped.
+  int64_t timeout_s = 0;
+  // Badge to set when shown, or -1 to leave it alone. Stored as 32 bits;
+  // larger values are clamped.
+  int64_t badge_number = -1;
+  // Milliseconds since the Unix epoch. Entries without a known fire time
+  // (zero) are kept but never armed.
+  int64_t fire_at_ms = 0;
+  // Seconds between repeats, or zero for a one-shot entry.
+  int64_t repeat_interval_s = 0;
+  // Cron-style rule for the following fire times (see RecurrenceRule), or
+  // empty.
+  std::string recurrence;
+  // Identifies this version of the entry across processes. Zero gives the
+  // entry a new random revision; a snapshot reader passes the stored one so
+  // the entry can later be recognized as unchanged.
+  uint64_t revision = 0;
+};
+
+// Fills |request| (except the id and timing) from a JSON-encoded
+// NotificationRequest, as stored by earlier versions. Returns false if
+// |json| is not an object.
+bool ScheduledRequestFromJson(const std::string& json, ScheduledRequest* request);
+
+// Scheduled notifications stored column by column.
+//
+// Each entry is a slot in a set of parallel arrays (fire time, interval,
+// flags, string offsets and so on), and every string of every entry lives
+// in one arena, so the store holds no per-entry allocations. Entries are
+// addressed by id through an index that compares ids in place in the
+// arena, and kept in fire-time order by a second one; both are chunked
+// arrays of slots rather than trees. Slots of removed entries go on a free
+// list for reuse. Garbage left in the arena, and slots left empty, are
+// reclaimed by compaction once they make up most of the store. Entries
+// with short strings take about 140 bytes each, under half of what a map
+// of JSON-encoded requests took.
+//
+// Every change bumps a version and is noted in a bounded change log, so a
+// reader that remembers the version it last saw can fetch just the
+// changes since then.
+class ScheduledStore {
+ public:
+  enum class ChangeKind { kInsert, kUpdate, kRemove };
+
+  struct Change {
+    uint64_t version;
+    ChangeKind kind;
+    std::string id;
+  };
+
+  static constexpr size_t kDefaultChangeLogCapacity = 1024;
+
+  struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  // One entry's fields, read out of the columns. A Record is a copy and
+  // its StringRefs stay valid until the next Put, Remove or Clear.
+  struct Record {
+    StringRef id;
+    StringRef title;
+    StringRef body;
+    StringRef category;
+    StringRef group;
+    StringRef recurrence;
+    // Index into the action list; each action is an (id, label) pair.
+    uint32_t actions_begin;
+    uint32_t action_count;
+    FlValue* payload;
+    int64_t timeout_s;
+    int64_t badge_number;
+    int64_t fire_at_ms;
+    int64_t repeat_interval_s;
+    uint64_t revision;
+  };
+
+  explicit ScheduledStore(size_t change_log_capacity = kDefaultChangeLogCapacity);
+  ~ScheduledStore();
+
+  // Disallow copy and assign.
+  ScheduledStore(const ScheduledStore&) = delete;
+  ScheduledStore& operator=(const ScheduledStore&) = delete;
+
+  // Inserts |request|, replacing any entry with the same id.
+  void Put(const ScheduledRequest& request);
+
+  // Returns false if there was no entry with |id|.
+  bool Remove(const std::string& id);
+
+  void Clear();
+
+  size_t size() const { return index_.size(); }
+
+  // Copies the entry with |id| into |record|. Returns false if there is no
+  // such entry.
+  bool Find(const std::string& id, Record* record) const;
+
+  bool Contains(const std::string& id) const {
+    return index_.find(IdKey{id.data(), id.size()}) != index_.end();
+  }
+
+  // Moves the entry with |id| to |fire_at_ms|, giving it a new revision.
+  // Returns false if there is no such entry.
+  bool SetFireTime(const std::string& id, int64_t fire_at_ms);
+
+  // Earliest fire time of any armed entry, or zero if none is armed.
+  int64_t NextFireTime() const;
+
+  // Latest fire time within |slack_ms| of the earliest one, or zero if none
+  // is armed. Waking up then lets every entry up to it fire as one batch,
+  // none of them more than |slack_ms| late.
+  int64_t CoalescedFireTime(int64_t slack_ms) const;
+
+  // Version of the latest change. Starts at zero and only grows.
+  uint64_t version() const { return version_; }
+
+  // Drops the change log and moves the version to at least |version|, so
+  // readers holding any older version fall back to a full listing.
+  void ResetChangeLog(uint64_t version);
+
+  // Fills |out| with the net change of every id touched after |since|, in
+  // the order of each id's last change: an id inserted and then updated is
+  // one insert, and one inserted and then removed is left out. Returns
+  // false if the log no longer reaches back to |since|, in which case the
+  // reader has to start over from a full listing.
+  bool ChangesSince(uint64_t since, std::vector<Change>* out) const;
+
+  // Calls |callback| with every record in id order. |callback| must not
+  // modify the store.
+  template <typename Callback>
+  void ForEach(Callback callback) const {
+    for (uint32_t slot : index_) callback(RecordAt(slot));
+  }
+
+  // Calls |callback| with up to |limit| records in id order, skipping
+  // everything up to and including |after| when it is given, so a long
+  // walk can be split into pieces while entries come and go. Returns true
+  // if records remain past the last one visited.
+  template <typename Callback>
+  bool ForEachAfter(const std::string* after, size_t limit, Callback callback) const {
+    auto it = after ? index_.upper_bound(IdKey{after->data(), after->size()}) : index_.begin();
+    for (size_t visited = 0; it != index_.end(); ++it, ++visited) {
+      if (visited == limit) return true;
+      callback(RecordAt(*it));
+    }
+    return false;
+  }
+
+  // A position in fire-time order. Entries are ordered by fire time and
+  // then by id, so a cursor stays valid while other entries come and go.
+  struct FireCursor {
+    int64_t fire_at_ms;
+    std::string id;
+  };
+
+  // Calls |callback| with up to |limit| armed records whose fire time is in
+  // [from_ms, to_ms), in fire-time order, skipping everything up to and
+  // including |after| when it is given. Returns true if matching records
+  // remain past the last one visited. Costs O(log N + limit).
+  template <typename Callback>
+  bool ForEachByFireTime(int64_t from_ms, int64_t to_ms, const FireCursor* after, size_t limit,
+                         Callback callback) const {
+    from_ms = std::max<int64_t>(from_ms, 1);
+    auto it = after && after->fire_at_ms >= from_ms
+                  ? by_fire_time_.upper_bound(
+                        FireKey{after->fire_at_ms, IdKey{after->id.data(), after->id.size()}})
+                  : by_fire_time_.lower_bound(FireKey{from_ms, IdKey{"", 0}});
+    for (size_t visited = 0; it != by_fire_time_.end(); ++it, ++visited) {
+      if (fire_at_ms_[*it] >= to_ms) return false;
+      if (visited == limit) return true;
+      callback(RecordAt(*it));
+    }
+    return false;
+  }
+
+  std::string GetString(StringRef ref) const { return std::string(Data(ref), ref.length); }
+
+  // What the backend needs to show |record|, read straight from the arena.
+  NotificationContent ContentOf(const Record& record) const;
+
+  // The action list of |record| as (id, label) pairs.
+  std::vector<std::pair<std::string, std::string>> ActionsOf(const Record& record) const;
+
+  // Serializes |record| in the shape of the Dart ScheduledNotification's
+  // toJson(), so it can be decoded with ScheduledNotification.fromJson().
+  FlValue* ToFlValue(const Record& record) const;
+
+  // Bytes held by the arena, including garbage not yet compacted.
+  size_t arena_bytes() const { return arena_.size(); }
+  size_t garbage_bytes() const { return garbage_bytes_; }
+  // Slots in the columns, including free ones not yet compacted away.
+  size_t slot_count() const { return fire_at_ms_.size(); }
+
+  // Heap bytes held, by part, including spare capacity.
+  struct MemoryUsage {
+    size_t columns;
+    size_t strings;
+    size_t actions;
+    size_t payload_index;
+    size_t indexes;
+
+    size_t total() const { return columns + strings + actions + payload_index + indexes; }
+  };
+  MemoryUsage memory_usage() const;
+
+ private:
+  // Transparent comparator so the index can be searched by id without
+  // materializing a std::string for every slot.
+  struct IdKey {
+    const char* data;
+    size_t length;
+  };
+
+  struct IdLess {
+    using is_transparent = void;
+    const ScheduledStore* store;
+
+    bool operator()(uint32_t a, uint32_t b) const { return Compare(Key(a), Key(b)) < 0; }
+    bool operator()(uint32_t a, const IdKey& b) const { return Compare(Key(a), b) < 0; }
+    bool operator()(const IdKey& a, uint32_t b) const { return Compare(a, Key(b)) < 0; }
+
+    IdKey Key(uint32_t slot) const { return store->IdOf(slot); }
+
+    static int Compare(const IdKey& a, const IdKey& b) {
+      int order = memcmp(a.data, b.data, std::min(a.length, b.length));
+      if (order != 0) return order;
+      return a.length < b.length ? -1 : (a.length > b.length ? 1 : 0);
+    }
+  };
+
+  struct FireKey {
+    int64_t fire_at_ms;
+    IdKey id;
+  };
+
+  // Orders armed entries by fire time, then by id.
+  struct FireLess {
+    using is_transparent = void;
+    const ScheduledStore* store;
+
+    bool operator()(uint32_t a, uint32_t b) const { return Less(Key(a), Key(b)); }
+    bool operator()(uint32_t a, const FireKey& b) const { return Less(Key(a), b); }
+    bool operator()(const FireKey& a, uint32_t b) const { return Less(a, Key(b)); }
+
+    FireKey Key(uint32_t slot) const {
+      return FireKey{store->fire_at_ms_[slot], store->IdOf(slot)};
+    }
+
+    static bool Less(const FireKey& a, const FireKey& b) {
+      if (a.fire_at_ms != b.fire_at_ms) return a.fire_at_ms < b.fire_at_ms;
+      return IdLess::Compare(a.id, b.id) < 0;
+    }
+  };
+
+  // The strings of an entry, back to back in the arena from |offset|.
+  enum StringField { kId, kTitle, kBody, kCategory, kGroup, kRecurrence, kStringFieldCount };
+  struct Strings {
+    uint32_t offset;
+    uint32_t lengths[kStringFieldCount];
+  };
+
+  enum Flags : uint8_t {
+    kLive = 1 << 0,
+    kHasPayload = 1 << 1,
+  };
+
+  const char* Data(StringRef ref) const { return arena_.data() + ref.offset; }
+  IdKey IdOf(uint32_t slot) const {
+    return IdKey{arena_.data() + strings_[slot].offset, strings_[slot].lengths[kId]};
+  }
+  Record RecordAt(uint32_t slot) const;
+  StringRef Append(const std::string& value);
+  uint32_t AllocateSlot();
+  // Writes |request| into |slot|, except for the fire time.
+  void Fill(uint32_t slot, const ScheduledRequest& request);
+  // Marks the strings and actions of the entry in |slot| as garbage.
+  void Release(uint32_t slot);
+  void MaybeCompact();
+  // Copies live strings into a fresh arena.
+  void CompactArena();
+  // Moves live entries to the lowest slots and drops the free ones.
+  void CompactSlots();
+  void LogChange(ChangeKind kind, const std::string& id);
+  static uint64_t NewRevision();
+
+  std::string arena_;
+  size_t garbage_bytes_ = 0;
+  std::vector<StringRef> actions_;
+  size_t garbage_actions_ = 0;
+
+  // Columns, one element per slot.
+  std::vector<int64_t> fire_at_ms_;
+  std::vector<int64_t> repeat_interval_s_;
+  std::vector<uint64_t> revisions_;
+  std::vector<int32_t> timeout_s_;
+  std::vector<int32_t> badge_number_;
+  std::vector<Strings> strings_;
+  std::vector<uint32_t> actions_begin_;
+  std::vector<uint32_t> action_count_;
+  std::vector<uint8_t> flags_;
+  // Payload maps by slot; most entries have none.
+  std::unordered_map<uint32_t, FlValue*> payloads_;
+  std::vector<uint32_t> free_slots_;
+
+  SlotIndex<IdLess> index_;
+  // Armed entries only; those without a fire time are never due.
+  SlotIndex<FireLess> by_fire_time_;
+
+  uint64_t version_ = 0;
+  // Versions in the log run contiguously from log_floor_ + 1 to version_.
+  uint64_t log_floor_ = 0;
+  size_t change_log_capacity_;
+  std::deque<Change> change_log_;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SCHEDULED_STORE_H_
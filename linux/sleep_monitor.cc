@@ -0,0 +1,69 @@
+#include "sleep_monitor.h"
+
+#include <utility>
+
+namespace notification_manager {
+
+SleepMonitor::SleepMonitor(Callback callback) : callback_(std::move(callback)) {}
+
+namespace {
+
+constexpr char kMonitorKey[] = "sleep-monitor";
+
+}  // namespace
+
+SleepMonitor::~SleepMonitor() {
+  if (cancellable_) {
+    // The bus may still be connecting; the pending callback holds its own
+    // reference to the cancellable and finds no monitor on it.
+    g_object_set_data(G_OBJECT(cancellable_), kMonitorKey, nullptr);
+    g_cancellable_cancel(cancellable_);
+    g_object_unref(cancellable_);
+  }
+  if (subscription_id_ != 0) {
+    g_dbus_connection_signal_unsubscribe(connection_, subscription_id_);
+  }
+  g_clear_object(&connection_);
+}
+
+void SleepMonitor::Start() {
+  if (cancellable_) return;
+  cancellable_ = g_cancellable_new();
+  g_object_set_data(G_OBJECT(cancellable_), kMonitorKey, this);
+  g_bus_get(G_BUS_TYPE_SYSTEM, cancellable_, OnBusReady, g_object_ref(cancellable_));
+}
+
+void SleepMonitor::OnBusReady(GObject* source, GAsyncResult* result, gpointer user_data) {
+  g_autoptr(GCancellable) cancellable = G_CANCELLABLE(user_data);
+  g_autoptr(GError) error = nullptr;
+  GDBusConnection* connection = g_bus_get_finish(result, &error);
+  SleepMonitor* self =
+      static_cast<SleepMonitor*>(g_object_get_data(G_OBJECT(cancellable), kMonitorKey));
+  if (self == nullptr) {
+    g_clear_object(&connection);
+    return;
+  }
+  if (connection == nullptr) {
+    g_debug("No system bus, suspend and resume go unnoticed: %s", error->message);
+    return;
+  }
+
+  self->connection_ = connection;
+  self->subscription_id_ = g_dbus_connection_signal_subscribe(
+      self->connection_, "org.freedesktop.login1", "org.freedesktop.login1.Manager",
+      "PrepareForSleep", "/org/freedesktop/login1", nullptr, G_DBUS_SIGNAL_FLAGS_NONE,
+      OnPrepareForSleep, self, nullptr);
+}
+
+void SleepMonitor::OnPrepareForSleep(GDBusConnection* connection, const gchar* sender_name,
+                                     const gchar* object_path, const gchar* interface_name,
+                                     const gchar* signal_name, GVariant* parameters,
+                                     gpointer user_data) {
+  if (!g_variant_is_of_type(parameters, G_VARIANT_TYPE("(b)"))) return;
+
+  gboolean sleeping = FALSE;
+  g_variant_get(parameters, "(b)", &sleeping);
+  static_cast<SleepMonitor*>(user_data)->callback_(sleeping);
+}
+
+}  // namespace notification_manager
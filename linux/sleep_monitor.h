@@ -0,0 +1,47 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SLEEP_MONITOR_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SLEEP_MONITOR_H_
+
+#include <gio/gio.h>
+
+#include <functional>
+
+namespace notification_manager {
+
+// Reports system suspend and resume from logind's PrepareForSleep signal on
+// the system bus.
+//
+// The bus is connected asynchronously by Start(), so nothing blocks the
+// caller. Without logind (containers, other init systems) the monitor
+// stays silent and callers have to notice clock jumps on their own.
+class SleepMonitor {
+ public:
+  // Called with true just before the system sleeps and with false once it
+  // has resumed.
+  using Callback = std::function<void(bool sleeping)>;
+
+  explicit SleepMonitor(Callback callback);
+  ~SleepMonitor();
+
+  // Disallow copy and assign.
+  SleepMonitor(const SleepMonitor&) = delete;
+  SleepMonitor& operator=(const SleepMonitor&) = delete;
+
+  // Connects to the system bus and subscribes. Later calls do nothing.
+  void Start();
+
+ private:
+  static void OnBusReady(GObject* source, GAsyncResult* result, gpointer user_data);
+  static void OnPrepareForSleep(GDBusConnection* connection, const gchar* sender_name,
+                                const gchar* object_path, const gchar* interface_name,
+                                const gchar* signal_name, GVariant* parameters,
+                                gpointer user_data);
+
+  Callback callback_;
+  GCancellable* cancellable_ = nullptr;
+  GDBusConnection* connection_ = nullptr;
+  guint subscription_id_ = 0;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SLEEP_MONITOR_H_
@@ -0,0 +1,181 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SLOT_INDEX_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SLOT_INDEX_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace notification_manager {
+
+// An ordered set of record slots, kept as a list of sorted chunks.
+//
+// Slots are ordered by |Less|, which looks the keys up in the records it
+// indexes and may also compare slots against a search key, as a
+// transparent std::set comparator would. Unlike std::set there is no node
+// per entry: a million slots take about 4 MB, where a set would take over
+// 40 MB. Inserting or erasing moves at most one chunk's worth of slots.
+template <typename Less>
+class SlotIndex {
+ public:
+  // Chunks are split when they grow past this, and merged with a neighbour
+  // when they shrink below a quarter of it.
+  static constexpr size_t kMaxChunk = 512;
+
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = uint32_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const uint32_t*;
+    using reference = uint32_t;
+
+    uint32_t operator*() const { return index_->chunks_[chunk_][position_]; }
+
+    Iterator& operator++() {
+      if (++position_ == index_->chunks_[chunk_].size()) {
+        chunk_++;
+        position_ = 0;
+      }
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return chunk_ == other.chunk_ && position_ == other.position_;
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    friend class SlotIndex;
+
+    Iterator(const SlotIndex* index, size_t chunk, size_t position)
+        : index_(index), chunk_(chunk), position_(position) {}
+
+    const SlotIndex* index_;
+    size_t chunk_;
+    size_t position_;
+  };
+
+  explicit SlotIndex(Less less) : less_(less) {}
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  Iterator begin() const { return Iterator(this, 0, 0); }
+  Iterator end() const { return Iterator(this, chunks_.size(), 0); }
+
+  // First slot not ordered before |key|.
+  template <typename Key>
+  Iterator lower_bound(const Key& key) const {
+    size_t chunk = FirstChunk([&](uint32_t last) { return less_(last, key); });
+    if (chunk == chunks_.size()) return end();
+    const std::vector<uint32_t>& slots = chunks_[chunk];
+    return Iterator(this, chunk,
+                    std::lower_bound(slots.begin(), slots.end(), key, less_) - slots.begin());
+  }
+
+  // First slot ordered after |key|.
+  template <typename Key>
+  Iterator upper_bound(const Key& key) const {
+    size_t chunk = FirstChunk([&](uint32_t last) { return !less_(key, last); });
+    if (chunk == chunks_.size()) return end();
+    const std::vector<uint32_t>& slots = chunks_[chunk];
+    return Iterator(this, chunk,
+                    std::upper_bound(slots.begin(), slots.end(), key, less_) - slots.begin());
+  }
+
+  template <typename Key>
+  Iterator find(const Key& key) const {
+    Iterator it = lower_bound(key);
+    return it != end() && !less_(key, *it) ? it : end();
+  }
+
+  // The slot just before |it|, which must not be begin().
+  uint32_t Before(Iterator it) const {
+    return it.position_ > 0 ? chunks_[it.chunk_][it.position_ - 1] : chunks_[it.chunk_ - 1].back();
+  }
+
+  // Adds |slot|, whose key must not already be present.
+  void insert(uint32_t slot) {
+    size_++;
+    if (chunks_.empty()) {
+      chunks_.emplace_back(1, slot);
+      return;
+    }
+    size_t chunk = FirstChunk([&](uint32_t last) { return less_(last, slot); });
+    if (chunk == chunks_.size()) chunk--;
+    std::vector<uint32_t>& slots = chunks_[chunk];
+    slots.insert(std::upper_bound(slots.begin(), slots.end(), slot, less_), slot);
+
+    if (slots.size() > kMaxChunk) {
+      std::vector<uint32_t> upper(slots.begin() + slots.size() / 2, slots.end());
+      slots.resize(slots.size() / 2);
+      slots.shrink_to_fit();
+      chunks_.insert(chunks_.begin() + chunk + 1, std::move(upper));
+    }
+  }
+
+  // Removes |slot|, looking it up by its current key. Returns false if it
+  // was not present.
+  bool erase(uint32_t slot) {
+    Iterator it = lower_bound(slot);
+    if (it == end() || *it != slot) return false;
+
+    std::vector<uint32_t>& slots = chunks_[it.chunk_];
+    slots.erase(slots.begin() + it.position_);
+    size_--;
+    if (slots.empty()) {
+      chunks_.erase(chunks_.begin() + it.chunk_);
+    } else if (slots.size() < kMaxChunk / 4 && it.chunk_ + 1 < chunks_.size() &&
+               slots.size() + chunks_[it.chunk_ + 1].size() <= kMaxChunk) {
+      std::vector<uint32_t>& next = chunks_[it.chunk_ + 1];
+      slots.insert(slots.end(), next.begin(), next.end());
+      chunks_.erase(chunks_.begin() + it.chunk_ + 1);
+    }
+    return true;
+  }
+
+  void clear() {
+    chunks_.clear();
+    size_ = 0;
+  }
+
+  // Replaces the contents with |slots|, which must already be in order.
+  // Chunks are left half full, so the next inserts do not split them.
+  void Assign(const std::vector<uint32_t>& slots) {
+    clear();
+    for (size_t begin = 0; begin < slots.size(); begin += kMaxChunk / 2) {
+      size_t end = std::min(begin + kMaxChunk / 2, slots.size());
+      chunks_.emplace_back(slots.begin() + begin, slots.begin() + end);
+    }
+    chunks_.shrink_to_fit();
+    size_ = slots.size();
+  }
+
+  // Heap bytes held, including spare capacity.
+  size_t memory_bytes() const {
+    size_t bytes = chunks_.capacity() * sizeof(std::vector<uint32_t>);
+    for (const auto& slots : chunks_) bytes += slots.capacity() * sizeof(uint32_t);
+    return bytes;
+  }
+
+ private:
+  // Index of the first chunk whose last slot does not satisfy |before|, or
+  // chunks_.size() if every chunk does.
+  template <typename Predicate>
+  size_t FirstChunk(Predicate before) const {
+    return std::partition_point(
+               chunks_.begin(), chunks_.end(),
+               [&](const std::vector<uint32_t>& slots) { return before(slots.back()); }) -
+           chunks_.begin();
+  }
+
+  Less less_;
+  std::vector<std::vector<uint32_t>> chunks_;
+  size_t size_ = 0;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_SLOT_INDEX_H_
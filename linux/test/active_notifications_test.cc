@@ -0,0 +1,261 @@
+#include <flutter_linux/flutter_linux.h>
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "active_notifications.h"
+#include "plugin_test_fixture.h"
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+std::vector<std::string> page(const ActiveNotifications& active,
+                              const std::string* category,
+                              const std::string* group,
+                              const ActiveNotifications::Cursor* after,
+                              size_t limit,
+                              bool* more) {
+  std::vector<std::string> ids;
+  *more = active.ForEachByCreation(category, group, after, limit,
+                                   [&](const ActiveNotification& notification) {
+                                     ids.push_back(notification.id);
+                                   });
+  return ids;
+}
+
+}  // namespace
+
+TEST(ActiveNotificationsTest, PagesInCreationOrder) {
+  ActiveNotifications active;
+  active.Put("c", "C", "", "", 100);
+  active.Put("a", "A", "", "", 200);
+  active.Put("b", "B", "", "", 200);
+
+  bool more = false;
+  EXPECT_EQ(page(active, nullptr, nullptr, nullptr, 2, &more),
+            std::vector<std::string>({"c", "a"}));
+  EXPECT_TRUE(more);
+  ActiveNotifications::Cursor after{200, "a"};
+  EXPECT_EQ(page(active, nullptr, nullptr, &after, 2, &more), std::vector<std::string>({"b"}));
+  EXPECT_FALSE(more);
+}
+
+TEST(ActiveNotificationsTest, UpdatesKeepTheirCreationTime) {
+  ActiveNotifications active;
+  active.Put("a", "First", "chat", "", 100);
+  active.Put("a", "Second", "mail", "inbox", 300);
+
+  const ActiveNotification* notification = active.Find("a");
+  ASSERT_NE(notification, nullptr);
+  EXPECT_EQ(notification->title, "Second");
+  EXPECT_EQ(notification->created_ms, 100);
+  EXPECT_EQ(notification->updated_ms, 300);
+  EXPECT_EQ(active.size(), 1u);
+
+  bool more = false;
+  std::string chat = "chat";
+  std::string mail = "mail";
+  EXPECT_TRUE(page(active, &chat, nullptr, nullptr, 10, &more).empty());
+  EXPECT_EQ(page(active, &mail, nullptr, nullptr, 10, &more), std::vector<std::string>({"a"}));
+}
+
+TEST(ActiveNotificationsTest, FiltersByCategoryAndGroup) {
+  ActiveNotifications active;
+  for (int i = 0; i < 10; i++) {
+    active.Put("chat" + std::to_string(i), "", "message", i % 2 ? "alice" : "bob", i);
+  }
+  active.Put("mail", "", "email", "alice", 20);
+
+  std::string message = "message";
+  std::string alice = "alice";
+  std::string nobody = "nobody";
+  bool more = false;
+  EXPECT_EQ(page(active, &message, nullptr, nullptr, 100, &more).size(), 10u);
+  EXPECT_EQ(page(active, nullptr, &alice, nullptr, 100, &more),
+            std::vector<std::string>({"chat1", "chat3", "chat5", "chat7", "chat9", "mail"}));
+  EXPECT_EQ(page(active, &message, &alice, nullptr, 2, &more),
+            std::vector<std::string>({"chat1", "chat3"}));
+  EXPECT_TRUE(more);
+  ActiveNotifications::Cursor after{3, "chat3"};
+  EXPECT_EQ(page(active, &message, &alice, &after, 10, &more),
+            std::vector<std::string>({"chat5", "chat7", "chat9"}));
+  EXPECT_FALSE(more);
+  EXPECT_TRUE(page(active, &message, &nobody, nullptr, 10, &more).empty());
+  EXPECT_TRUE(page(active, &nobody, nullptr, nullptr, 10, &more).empty());
+}
+
+TEST(ActiveNotificationsTest, CategoryAndGroupPagesSkipOtherMatches) {
+  ActiveNotifications active;
+  // Both single indexes are much larger than the pair that matches.
+  for (int i = 0; i < 100; i++) {
+    active.Put("chat" + std::to_string(i), "", "message", "bob", i);
+    active.Put("mail" + std::to_string(i), "", "email", "alice", i);
+  }
+  active.Put("a", "", "message", "alice", 200);
+  active.Put("b", "", "message:alice", "", 201);
+  active.Put("c", "", "message", "alice", 202);
+
+  std::string message = "message";
+  std::string alice = "alice";
+  bool more = false;
+  EXPECT_EQ(page(active, &message, &alice, nullptr, 10, &more),
+            std::vector<std::string>({"a", "c"}));
+  EXPECT_FALSE(more);
+
+  active.Put("a", "", "message", "bob", 300);
+  EXPECT_TRUE(active.Remove("c"));
+  EXPECT_TRUE(page(active, &message, &alice, nullptr, 10, &more).empty());
+  EXPECT_EQ(active.RemoveGroup("bob").size(), 101u);
+  EXPECT_EQ(active.size(), 101u);
+}
+
+TEST(ActiveNotificationsTest, RemoveDropsEveryIndexEntry) {
+  ActiveNotifications active;
+  active.Put("a", "", "chat", "alice", 100);
+  active.Put("b", "", "chat", "bob", 200);
+
+  EXPECT_TRUE(active.Remove("a"));
+  EXPECT_FALSE(active.Remove("a"));
+  EXPECT_FALSE(active.Contains("a"));
+
+  std::string chat = "chat";
+  std::string alice = "alice";
+  bool more = false;
+  EXPECT_EQ(page(active, &chat, nullptr, nullptr, 10, &more), std::vector<std::string>({"b"}));
+  EXPECT_TRUE(page(active, nullptr, &alice, nullptr, 10, &more).empty());
+
+  active.Clear();
+  EXPECT_TRUE(active.empty());
+  EXPECT_TRUE(page(active, nullptr, nullptr, nullptr, 10, &more).empty());
+}
+
+TEST(ActiveNotificationsTest, BulkRemovalTakesOnlyMatches) {
+  ActiveNotifications active;
+  active.Put("chat:alice:2", "", "message", "alice", 300);
+  active.Put("chat:alice:1", "", "message", "alice", 100);
+  active.Put("chat:bob:1", "", "message", "bob", 200);
+  active.Put("chat:alicia:1", "", "message", "alicia", 400);
+  active.Put("mail:1", "", "email", "alice", 500);
+
+  EXPECT_EQ(active.RemovePrefix("chat:alice:"),
+            std::vector<std::string>({"chat:alice:1", "chat:alice:2"}));
+  EXPECT_TRUE(active.Contains("chat:alicia:1"));
+  EXPECT_TRUE(active.RemovePrefix("chat:alice:").empty());
+
+  EXPECT_EQ(active.RemoveGroup("alice"), std::vector<std::string>({"mail:1"}));
+  EXPECT_TRUE(active.RemoveGroup("alice").empty());
+  EXPECT_EQ(active.RemoveCategory("message"),
+            std::vector<std::string>({"chat:bob:1", "chat:alicia:1"}));
+  EXPECT_TRUE(active.RemoveCategory("nothing").empty());
+  EXPECT_TRUE(active.empty());
+
+  bool more = false;
+  std::string message = "message";
+  EXPECT_TRUE(page(active, &message, nullptr, nullptr, 10, &more).empty());
+}
+
+// getActiveNotifications and the bulk cancel methods on top of the index.
+using ActiveNotificationsPluginTest = PluginTest;
+
+TEST_F(ActiveNotificationsPluginTest, BulkCancelClosesMatchesInOneBatch) {
+  for (int i = 0; i < 4; i++) {
+    std::string id = "chat:" + std::to_string(i);
+    g_autoptr(FlValue) args = make_show_args(id.c_str());
+    fl_value_set_string_take(args, "category", fl_value_new_string(i < 2 ? "message" : "call"));
+    fl_value_set_string_take(args, "group", fl_value_new_string(i % 2 ? "alice" : "bob"));
+    g_autoptr(FlMethodResponse) response = show_notification(plugin_, args);
+  }
+  Show("mail:0");
+  Show("mail:1");
+
+  g_autoptr(FlValue) group = fl_value_new_map();
+  fl_value_set_string_take(group, "group", fl_value_new_string("alice"));
+  g_autoptr(FlMethodResponse) by_group = cancel_notifications_by_group(plugin_, group);
+  EXPECT_EQ(fl_value_get_int(
+                fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(by_group))),
+            2);
+  EXPECT_EQ(backend_->close_batches(), 1u);
+  EXPECT_EQ(backend_->open(), std::set<std::string>({"chat:0", "chat:2", "mail:0", "mail:1"}));
+
+  g_autoptr(FlValue) category = fl_value_new_map();
+  fl_value_set_string_take(category, "category", fl_value_new_string("message"));
+  g_autoptr(FlMethodResponse) by_category = cancel_notifications_by_category(plugin_, category);
+  EXPECT_EQ(backend_->open(), std::set<std::string>({"chat:2", "mail:0", "mail:1"}));
+
+  g_autoptr(FlValue) prefix = fl_value_new_map();
+  fl_value_set_string_take(prefix, "prefix", fl_value_new_string("mail:"));
+  g_autoptr(FlMethodResponse) by_prefix = cancel_notifications_with_prefix(plugin_, prefix);
+  EXPECT_EQ(fl_value_get_int(
+                fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(by_prefix))),
+            2);
+  EXPECT_EQ(backend_->close_batches(), 3u);
+  EXPECT_EQ(backend_->open(), std::set<std::string>({"chat:2"}));
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kClose), 5u);
+
+  // Nothing left to match still succeeds, without a batch.
+  g_autoptr(FlMethodResponse) again = cancel_notifications_with_prefix(plugin_, prefix);
+  EXPECT_EQ(fl_value_get_int(
+                fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(again))),
+            0);
+  EXPECT_EQ(backend_->close_batches(), 3u);
+
+  g_autoptr(FlValue) empty = fl_value_new_map();
+  fl_value_set_string_take(empty, "prefix", fl_value_new_string(""));
+  g_autoptr(FlMethodResponse) rejected = cancel_notifications_with_prefix(plugin_, empty);
+  EXPECT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(rejected));
+}
+
+TEST_F(ActiveNotificationsPluginTest, ActiveNotificationsPageByGroup) {
+  VirtualClock* clock = UseVirtualClock();
+  int64_t start_ms = clock->RealTimeUs() / 1000;
+  for (int i = 0; i < 5; i++) {
+    std::string id = "chat_" + std::to_string(i);
+    g_autoptr(FlValue) args = make_show_args(id.c_str());
+    fl_value_set_string_take(args, "category", fl_value_new_string("message"));
+    fl_value_set_string_take(args, "group", fl_value_new_string(i % 2 ? "alice" : "bob"));
+    g_autoptr(FlMethodResponse) response = show_notification(plugin_, args);
+    clock->Advance(G_USEC_PER_SEC);
+  }
+  Show("other");
+  Cancel("chat_3");
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "group", fl_value_new_string("bob"));
+  fl_value_set_string_take(args, "limit", fl_value_new_int(2));
+  g_autoptr(FlMethodResponse) response = get_active_notifications(plugin_, args);
+  FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response));
+  FlValue* notifications = fl_value_lookup_string(result, "notifications");
+  ASSERT_EQ(fl_value_get_length(notifications), 2u);
+  FlValue* first = fl_value_get_list_value(notifications, 0);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(first, "id")), "chat_0");
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(first, "category")), "message");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(first, "createdAt")), start_ms);
+
+  fl_value_set_string(args, "cursor", fl_value_lookup_string(result, "nextCursor"));
+  g_autoptr(FlMethodResponse) next = get_active_notifications(plugin_, args);
+  result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(next));
+  notifications = fl_value_lookup_string(result, "notifications");
+  ASSERT_EQ(fl_value_get_length(notifications), 1u);
+  EXPECT_STREQ(
+      fl_value_get_string(fl_value_lookup_string(fl_value_get_list_value(notifications, 0), "id")),
+      "chat_4");
+  EXPECT_EQ(fl_value_get_type(fl_value_lookup_string(result, "nextCursor")), FL_VALUE_TYPE_NULL);
+
+  g_autoptr(FlValue) alice = fl_value_new_map();
+  fl_value_set_string_take(alice, "group", fl_value_new_string("alice"));
+  g_autoptr(FlMethodResponse) alice_response = get_active_notifications(plugin_, alice);
+  result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(alice_response));
+  EXPECT_EQ(fl_value_get_length(fl_value_lookup_string(result, "notifications")), 1u);
+
+  g_autoptr(FlValue) no_filter = fl_value_new_map();
+  g_autoptr(FlMethodResponse) all = get_active_notifications(plugin_, no_filter);
+  result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(all));
+  EXPECT_EQ(fl_value_get_length(fl_value_lookup_string(result, "notifications")), 5u);
+}
+
+}  // namespace test
+}  // namespace notification_manager
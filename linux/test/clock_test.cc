@@ -0,0 +1,103 @@
+#include <glib.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "clock.h"
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+struct Probe {
+  VirtualClock* clock;
+  int id;
+  gboolean again;
+  // (probe id, monotonic time) of every run, shared between probes.
+  std::vector<std::pair<int, int64_t>>* runs;
+};
+
+gboolean probe_cb(gpointer user_data) {
+  Probe* probe = static_cast<Probe*>(user_data);
+  probe->runs->emplace_back(probe->id, probe->clock->MonotonicTimeUs());
+  return probe->again;
+}
+
+}  // namespace
+
+TEST(VirtualClock, OnlyMovesWhenAdvanced) {
+  VirtualClock clock(1000 * G_USEC_PER_SEC);
+  EXPECT_EQ(clock.RealTimeUs(), 1000 * G_USEC_PER_SEC);
+  EXPECT_EQ(clock.MonotonicTimeUs(), 0);
+
+  clock.Advance(5 * G_USEC_PER_SEC);
+  EXPECT_EQ(clock.RealTimeUs(), 1005 * G_USEC_PER_SEC);
+  EXPECT_EQ(clock.MonotonicTimeUs(), 5 * G_USEC_PER_SEC);
+}
+
+TEST(VirtualClock, RunsTimersInDueOrderAtTheirDueTime) {
+  VirtualClock clock(0);
+  std::vector<std::pair<int, int64_t>> runs;
+  Probe late{&clock, 1, G_SOURCE_REMOVE, &runs};
+  Probe early{&clock, 2, G_SOURCE_REMOVE, &runs};
+  Probe tie{&clock, 3, G_SOURCE_REMOVE, &runs};
+  clock.AddTimeoutSeconds(3, probe_cb, &late);
+  clock.AddTimeout(1000, probe_cb, &early);
+  clock.AddTimeout(3000, probe_cb, &tie);
+
+  EXPECT_EQ(clock.Advance(2 * G_USEC_PER_SEC), 1u);
+  EXPECT_EQ(clock.Advance(2 * G_USEC_PER_SEC), 2u);
+  ASSERT_EQ(runs.size(), 3u);
+  EXPECT_EQ(runs[0], std::make_pair(2, int64_t{G_USEC_PER_SEC}));
+  EXPECT_EQ(runs[1], std::make_pair(1, int64_t{3 * G_USEC_PER_SEC}));
+  EXPECT_EQ(runs[2], std::make_pair(3, int64_t{3 * G_USEC_PER_SEC}));
+  EXPECT_EQ(clock.pending_timers(), 0u);
+}
+
+TEST(VirtualClock, RepeatsUntilRemoved) {
+  VirtualClock clock(0);
+  std::vector<std::pair<int, int64_t>> runs;
+  Probe repeating{&clock, 1, G_SOURCE_CONTINUE, &runs};
+  guint id = clock.AddTimeout(100, probe_cb, &repeating);
+
+  EXPECT_EQ(clock.Advance(G_USEC_PER_SEC), 10u);
+  clock.RemoveTimeout(id);
+  EXPECT_EQ(clock.Advance(G_USEC_PER_SEC), 0u);
+  EXPECT_EQ(runs.size(), 10u);
+}
+
+TEST(VirtualClock, WallClockJumpsLeaveTimersAlone) {
+  VirtualClock clock(0);
+  std::vector<std::pair<int, int64_t>> runs;
+  Probe probe{&clock, 1, G_SOURCE_REMOVE, &runs};
+  clock.AddTimeoutSeconds(60, probe_cb, &probe);
+
+  clock.JumpRealTime(int64_t{3600} * G_USEC_PER_SEC);
+  EXPECT_EQ(clock.Advance(59 * G_USEC_PER_SEC), 0u);
+  EXPECT_EQ(clock.Advance(G_USEC_PER_SEC), 1u);
+  EXPECT_EQ(clock.RealTimeUs(), int64_t{3660} * G_USEC_PER_SEC);
+}
+
+TEST(VirtualClock, WallClockJumpsRunTheWatches) {
+  VirtualClock clock(0);
+  std::vector<std::pair<int, int64_t>> runs;
+  Probe watching{&clock, 1, G_SOURCE_CONTINUE, &runs};
+  Probe once{&clock, 2, G_SOURCE_REMOVE, &runs};
+  Probe removed{&clock, 3, G_SOURCE_CONTINUE, &runs};
+  clock.AddRealTimeWatch(probe_cb, &watching);
+  clock.AddRealTimeWatch(probe_cb, &once);
+  clock.RemoveTimeout(clock.AddRealTimeWatch(probe_cb, &removed));
+
+  clock.Advance(G_USEC_PER_SEC);
+  EXPECT_TRUE(runs.empty());
+  clock.JumpRealTime(G_USEC_PER_SEC);
+  clock.JumpRealTime(-G_USEC_PER_SEC);
+  ASSERT_EQ(runs.size(), 3u);
+  EXPECT_EQ(runs[0].first, 1);
+  EXPECT_EQ(runs[1].first, 2);
+  EXPECT_EQ(runs[2].first, 1);
+}
+
+}  // namespace test
+}  // namespace notification_manager
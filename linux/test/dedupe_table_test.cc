@@ -0,0 +1,273 @@
+#include <flutter_linux/flutter_linux.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dedupe_table.h"
+#include "plugin_test_fixture.h"
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+constexpr int kWriters = 4;
+constexpr int kKeysPerWriter = 2000;
+constexpr int64_t kNowS = 1735689600;
+
+struct Writer {
+  std::string path;
+  int index;
+};
+
+// Marks this writer's keys through its own mapping, as another process
+// would.
+gpointer write_keys(gpointer data) {
+  Writer* writer = static_cast<Writer*>(data);
+  DedupeTable table(writer->path);
+  for (int i = 0; i < kKeysPerWriter; i++) {
+    table.MarkSent("writer" + std::to_string(writer->index) + "_" + std::to_string(i), kNowS + i,
+                   3600);
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+class DedupeTableTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_autofree gchar* dir = g_dir_make_tmp("notification_manager_dedupe_XXXXXX", nullptr);
+    ASSERT_NE(dir, nullptr);
+    dir_ = dir;
+    path_ = dir_ + "/nested/dedupe.table";
+  }
+
+  void TearDown() override {
+    g_remove(path_.c_str());
+    g_remove((path_ + ".lock").c_str());
+    g_rmdir((dir_ + "/nested").c_str());
+    g_rmdir(dir_.c_str());
+  }
+
+  std::string dir_;
+  std::string path_;
+};
+
+TEST_F(DedupeTableTest, ReadingDoesNotCreateTheFile) {
+  DedupeTable table(path_);
+  int64_t sent_s = 0;
+
+  EXPECT_FALSE(table.LastSent("key", &sent_s));
+  EXPECT_FALSE(g_file_test(path_.c_str(), G_FILE_TEST_EXISTS));
+}
+
+TEST_F(DedupeTableTest, OtherInstancesSeeMarkedKeys) {
+  DedupeTable first(path_);
+  DedupeTable second(path_);
+  first.MarkSent("key", kNowS, 300);
+
+  int64_t sent_s = 0;
+  ASSERT_TRUE(second.LastSent("key", &sent_s));
+  EXPECT_EQ(sent_s, kNowS);
+  EXPECT_FALSE(second.LastSent("other", &sent_s));
+
+  second.MarkSent("key", kNowS + 10, 300);
+  ASSERT_TRUE(first.LastSent("key", &sent_s));
+  EXPECT_EQ(sent_s, kNowS + 10);
+}
+
+TEST_F(DedupeTableTest, CompactionDropsExpiredKeysAndGrows) {
+  DedupeTable writer(path_);
+  DedupeTable reader(path_);
+  writer.MarkSent("expired", kNowS, 60);
+  int64_t sent_s = 0;
+  ASSERT_TRUE(reader.LastSent("expired", &sent_s));
+  size_t initial_capacity = reader.capacity();
+
+  for (int i = 0; i < 5000; i++) writer.MarkSent("key" + std::to_string(i), kNowS + 120, 3600);
+
+  EXPECT_GT(writer.compactions(), 0u);
+  EXPECT_FALSE(reader.LastSent("expired", &sent_s));
+  EXPECT_GT(reader.capacity(), initial_capacity);
+  for (int i = 0; i < 5000; i++) {
+    ASSERT_TRUE(reader.LastSent("key" + std::to_string(i), &sent_s)) << i;
+    EXPECT_EQ(sent_s, kNowS + 120);
+  }
+}
+
+TEST_F(DedupeTableTest, ConcurrentWritersKeepEveryKey) {
+  std::vector<Writer> writers;
+  for (int i = 0; i < kWriters; i++) writers.push_back(Writer{path_, i});
+  std::vector<GThread*> threads;
+  for (auto& writer : writers) threads.push_back(g_thread_new("writer", write_keys, &writer));
+  for (GThread* thread : threads) g_thread_join(thread);
+
+  DedupeTable table(path_);
+  for (int w = 0; w < kWriters; w++) {
+    for (int i = 0; i < kKeysPerWriter; i++) {
+      int64_t sent_s = 0;
+      ASSERT_TRUE(table.LastSent("writer" + std::to_string(w) + "_" + std::to_string(i), &sent_s));
+      EXPECT_EQ(sent_s, kNowS + i);
+    }
+  }
+}
+
+TEST_F(DedupeTableTest, AnotherProcessSeesMarkedKeys) {
+  DedupeTable table(path_);
+  table.MarkSent("parent", kNowS, 300);
+
+  pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    DedupeTable child_table(path_);
+    int64_t sent_s = 0;
+    bool seen = child_table.LastSent("parent", &sent_s) && sent_s == kNowS;
+    child_table.MarkSent("child", kNowS + 1, 300);
+    _exit(seen ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(child, &status, 0), child);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+
+  int64_t sent_s = 0;
+  ASSERT_TRUE(table.LastSent("child", &sent_s));
+  EXPECT_EQ(sent_s, kNowS + 1);
+}
+
+TEST_F(DedupeTableTest, ClearForgetsKeysEverywhere) {
+  DedupeTable first(path_);
+  DedupeTable second(path_);
+  first.MarkSent("key", kNowS, 300);
+  int64_t sent_s = 0;
+  ASSERT_TRUE(second.LastSent("key", &sent_s));
+
+  first.Clear();
+  EXPECT_FALSE(second.LastSent("key", &sent_s));
+  EXPECT_FALSE(first.LastSent("key", &sent_s));
+}
+
+TEST_F(DedupeTableTest, ImportIsClaimedOnce) {
+  DedupeTable first(path_);
+  DedupeTable second(path_);
+
+  EXPECT_TRUE(first.ClaimImport());
+  EXPECT_FALSE(second.ClaimImport());
+  // The claim survives a rebuild.
+  first.Clear();
+  EXPECT_FALSE(second.ClaimImport());
+}
+
+TEST_F(DedupeTableTest, UnreadableFileIsReplaced) {
+  g_mkdir_with_parents((dir_ + "/nested").c_str(), 0755);
+  ASSERT_TRUE(g_file_set_contents(path_.c_str(), "not a table", -1, nullptr));
+  DedupeTable table(path_);
+  int64_t sent_s = 0;
+
+  EXPECT_FALSE(table.LastSent("key", &sent_s));
+  table.MarkSent("key", kNowS, 300);
+  int64_t expires_s = 0;
+  ASSERT_TRUE(table.LastSent("key", &sent_s, &expires_s));
+  EXPECT_EQ(sent_s, kNowS);
+  EXPECT_EQ(expires_s, kNowS + 300);
+}
+
+// showNotification and isDuplicateNotification on top of the table.
+using DuplicateNotificationTest = PluginTest;
+
+TEST_F(DuplicateNotificationTest, WindowFollowsTheClock) {
+  VirtualClock* clock = UseVirtualClock();
+
+  EXPECT_TRUE(ShowWithDuplicateKey("a", "window", 300));
+  clock->Advance(299 * G_USEC_PER_SEC);
+  EXPECT_FALSE(ShowWithDuplicateKey("b", "window", 300));
+  clock->Advance(1 * G_USEC_PER_SEC);
+  EXPECT_TRUE(ShowWithDuplicateKey("c", "window", 300));
+}
+
+TEST_F(DuplicateNotificationTest, LongerQueriesStopAtTheMarkedWindow) {
+  VirtualClock* clock = UseVirtualClock();
+  auto is_duplicate = [this]() {
+    g_autoptr(FlValue) args = make_id_args("short");
+    fl_value_set_string_take(args, "timeWindowSeconds", fl_value_new_int(3600));
+    g_autoptr(FlMethodResponse) response = is_duplicate_notification_method(plugin_, args);
+    return fl_value_get_bool(
+        fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response)));
+  };
+
+  EXPECT_TRUE(ShowWithDuplicateKey("a", "short", 60));
+  clock->Advance(30 * G_USEC_PER_SEC);
+  EXPECT_TRUE(is_duplicate());
+  // Past the window it was marked with, the key no longer counts, whether
+  // or not a compaction has dropped it yet.
+  clock->Advance(30 * G_USEC_PER_SEC);
+  EXPECT_FALSE(is_duplicate());
+}
+
+TEST_F(DuplicateNotificationTest, WindowsBeyondIntRangeStillDedupe) {
+  // 2^40 seconds would wrap negative as an int.
+  const int64_t kWindowS = int64_t{1} << 40;
+  EXPECT_TRUE(ShowWithDuplicateKey("a", "forever", kWindowS));
+  EXPECT_FALSE(ShowWithDuplicateKey("b", "forever", kWindowS));
+
+  g_autoptr(FlValue) args = make_id_args("forever");
+  fl_value_set_string_take(args, "timeWindowSeconds", fl_value_new_int(kWindowS));
+  g_autoptr(FlMethodResponse) response = is_duplicate_notification_method(plugin_, args);
+  EXPECT_TRUE(fl_value_get_bool(
+      fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response))));
+}
+
+TEST_F(DuplicateNotificationTest, RejectedShowDoesNotMarkTheKey) {
+  g_autoptr(FlValue) args = make_show_args("a");
+  fl_value_set_string_take(args, "duplicateKey", fl_value_new_string("retry"));
+  fl_value_set_string_take(args, "duplicateWindow", fl_value_new_int(300));
+  // An action without a title.
+  FlValue* action = fl_value_get_list_value(fl_value_lookup_string(args, "actions"), 0);
+  fl_value_set_string_take(action, "title", fl_value_new_null());
+  g_autoptr(FlMethodResponse) rejected = show_notification(plugin_, args);
+  ASSERT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(rejected));
+  EXPECT_TRUE(backend_->calls().empty());
+
+  // The corrected retry is shown, and only then counts as sent.
+  EXPECT_TRUE(ShowWithDuplicateKey("a", "retry", 300));
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 1u);
+  EXPECT_FALSE(ShowWithDuplicateKey("a", "retry", 300));
+}
+
+TEST_F(DuplicateNotificationTest, FailedShowDoesNotMarkTheKey) {
+  backend_->set_fail(true);
+  EXPECT_FALSE(ShowWithDuplicateKey("a", "retry", 300));
+
+  backend_->set_fail(false);
+  EXPECT_TRUE(ShowWithDuplicateKey("a", "retry", 300));
+  EXPECT_FALSE(ShowWithDuplicateKey("a", "retry", 300));
+}
+
+TEST_F(DuplicateNotificationTest, KeysAreSharedWithOtherInstances) {
+  // Another instance has its own mapping of the table, as another process
+  // would.
+  NotificationManagerPlugin* other = static_cast<NotificationManagerPlugin*>(
+      g_object_new(notification_manager_plugin_get_type(), nullptr));
+  notification_manager_plugin_set_backend(other, std::make_unique<RecordingBackend>());
+  g_autoptr(FlValue) args = make_id_args("shared");
+  fl_value_set_string_take(args, "timeWindowSeconds", fl_value_new_int(300));
+
+  g_autoptr(FlMethodResponse) before = is_duplicate_notification_method(other, args);
+  EXPECT_FALSE(fl_value_get_bool(
+      fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(before))));
+  EXPECT_TRUE(ShowWithDuplicateKey("a", "shared", 300));
+  g_autoptr(FlMethodResponse) after = is_duplicate_notification_method(other, args);
+  EXPECT_TRUE(fl_value_get_bool(
+      fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(after))));
+  g_object_unref(other);
+}
+
+}  // namespace test
+}  // namespace notification_manager
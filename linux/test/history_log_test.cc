@@ -0,0 +1,264 @@
+#include <flutter_linux/flutter_linux.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "history_log.h"
+#include "plugin_test_fixture.h"
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+constexpr int64_t kNowMs = 1735689600000;
+constexpr size_t kSmallCapacity = 16 * 1024;
+
+std::vector<uint64_t> sequences(const std::vector<HistoryRecord>& records) {
+  std::vector<uint64_t> result;
+  for (const HistoryRecord& record : records) result.push_back(record.sequence);
+  return result;
+}
+
+}  // namespace
+
+class HistoryLogTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_autofree gchar* dir = g_dir_make_tmp("notification_manager_history_XXXXXX", nullptr);
+    ASSERT_NE(dir, nullptr);
+    dir_ = dir;
+    path_ = dir_ + "/nested/history.log";
+  }
+
+  void TearDown() override {
+    g_remove(path_.c_str());
+    g_rmdir((dir_ + "/nested").c_str());
+    g_rmdir(dir_.c_str());
+  }
+
+  gint64 FileSize() {
+    GStatBuf info;
+    return g_stat(path_.c_str(), &info) == 0 ? info.st_size : -1;
+  }
+
+  std::string dir_;
+  std::string path_;
+};
+
+TEST_F(HistoryLogTest, ReadingDoesNotCreateTheFile) {
+  HistoryLog log(path_);
+  std::vector<HistoryRecord> records;
+
+  EXPECT_FALSE(log.Query(0, G_MAXINT64, 0, 10, &records));
+  EXPECT_TRUE(records.empty());
+  log.Clear();
+  EXPECT_FALSE(g_file_test(path_.c_str(), G_FILE_TEST_EXISTS));
+}
+
+TEST_F(HistoryLogTest, QueriesReturnTheRangeOldestFirst) {
+  HistoryLog log(path_);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(log.Append(HistoryKind::kShown, kNowMs + i * 10, "n" + std::to_string(i),
+                           "Title " + std::to_string(i), ""));
+  }
+  ASSERT_TRUE(log.Append(HistoryKind::kAction, kNowMs + 1000, "n99", "", "reply"));
+  ASSERT_TRUE(log.Append(HistoryKind::kClosed, kNowMs + 1000, "n99", "", ""));
+
+  std::vector<HistoryRecord> records;
+  EXPECT_FALSE(log.Query(kNowMs + 200, kNowMs + 300, 0, 100, &records));
+  ASSERT_EQ(records.size(), 10u);
+  EXPECT_EQ(records[0].id, "n20");
+  EXPECT_EQ(records[0].title, "Title 20");
+  EXPECT_EQ(records[0].time_ms, kNowMs + 200);
+  EXPECT_EQ(records[0].kind, HistoryKind::kShown);
+  EXPECT_EQ(records[9].id, "n29");
+
+  records.clear();
+  log.Query(kNowMs + 1000, kNowMs + 1001, 0, 100, &records);
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].kind, HistoryKind::kAction);
+  EXPECT_EQ(records[0].action, "reply");
+  EXPECT_EQ(records[1].kind, HistoryKind::kClosed);
+  EXPECT_EQ(records[1].sequence, records[0].sequence + 1);
+}
+
+TEST_F(HistoryLogTest, PagesContinueAfterTheLastSequence) {
+  HistoryLog log(path_);
+  for (int i = 0; i < 7; i++) {
+    ASSERT_TRUE(log.Append(HistoryKind::kShown, kNowMs, "n" + std::to_string(i), "", ""));
+  }
+
+  std::vector<HistoryRecord> page;
+  EXPECT_TRUE(log.Query(kNowMs, kNowMs + 1, 0, 3, &page));
+  EXPECT_EQ(sequences(page), std::vector<uint64_t>({1, 2, 3}));
+  page.clear();
+  EXPECT_TRUE(log.Query(kNowMs, kNowMs + 1, 3, 3, &page));
+  EXPECT_EQ(sequences(page), std::vector<uint64_t>({4, 5, 6}));
+  page.clear();
+  EXPECT_FALSE(log.Query(kNowMs, kNowMs + 1, 6, 3, &page));
+  EXPECT_EQ(sequences(page), std::vector<uint64_t>({7}));
+}
+
+TEST_F(HistoryLogTest, WrapsAroundDroppingTheOldest) {
+  HistoryLog log(path_, kSmallCapacity);
+  ASSERT_TRUE(log.Append(HistoryKind::kShown, kNowMs, "first", "", ""));
+  gint64 size = FileSize();
+
+  const int kRecords = 5000;
+  for (int i = 1; i < kRecords; i++) {
+    ASSERT_TRUE(log.Append(HistoryKind::kShown, kNowMs + i, "n" + std::to_string(i),
+                           std::string(i % 50, 'x'), ""));
+  }
+  EXPECT_EQ(FileSize(), size);
+  EXPECT_EQ(log.capacity(), kSmallCapacity);
+
+  std::vector<HistoryRecord> records;
+  EXPECT_FALSE(log.Query(0, G_MAXINT64, 0, kRecords, &records));
+  ASSERT_FALSE(records.empty());
+  EXPECT_LT(records.size(), static_cast<size_t>(kRecords));
+  EXPECT_EQ(records.back().sequence, static_cast<uint64_t>(kRecords));
+  for (size_t i = 1; i < records.size(); i++) {
+    ASSERT_EQ(records[i].sequence, records[i - 1].sequence + 1);
+  }
+  const HistoryRecord& last = records.back();
+  EXPECT_EQ(last.id, "n" + std::to_string(kRecords - 1));
+  EXPECT_EQ(last.title, std::string((kRecords - 1) % 50, 'x'));
+}
+
+TEST_F(HistoryLogTest, IndexedQueriesMatchAFullScan) {
+  HistoryLog log(path_, kSmallCapacity);
+  for (int i = 0; i < 3000; i++) {
+    // Several records share each millisecond.
+    ASSERT_TRUE(log.Append(HistoryKind::kShown, kNowMs + i / 3, "n" + std::to_string(i), "", ""));
+  }
+  std::vector<HistoryRecord> all;
+  log.Query(0, G_MAXINT64, 0, 100000, &all);
+  ASSERT_FALSE(all.empty());
+
+  for (int64_t from = all.front().time_ms - 5; from < all.back().time_ms + 5; from += 7) {
+    int64_t to = from + 13;
+    std::vector<uint64_t> expected;
+    for (const HistoryRecord& record : all) {
+      if (record.time_ms >= from && record.time_ms < to) expected.push_back(record.sequence);
+    }
+    std::vector<HistoryRecord> records;
+    log.Query(from, to, 0, 100000, &records);
+    ASSERT_EQ(sequences(records), expected) << "from " << from;
+  }
+}
+
+TEST_F(HistoryLogTest, TimesNeverGoBackwards) {
+  HistoryLog log(path_);
+  ASSERT_TRUE(log.Append(HistoryKind::kShown, kNowMs, "a", "", ""));
+  // The wall clock was set back an hour.
+  ASSERT_TRUE(log.Append(HistoryKind::kShown, kNowMs - 3600000, "b", "", ""));
+
+  std::vector<HistoryRecord> records;
+  log.Query(kNowMs, kNowMs + 1, 0, 10, &records);
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[1].id, "b");
+  EXPECT_EQ(records[1].time_ms, kNowMs);
+}
+
+TEST_F(HistoryLogTest, OtherInstancesShareRecordsAndClears) {
+  HistoryLog first(path_);
+  HistoryLog second(path_, kSmallCapacity);
+  ASSERT_TRUE(first.Append(HistoryKind::kShown, kNowMs, "a", "", ""));
+  ASSERT_TRUE(second.Append(HistoryKind::kShown, kNowMs + 1, "b", "", ""));
+  // The second instance adopts the size of the log the first created.
+  EXPECT_EQ(second.capacity(), kDefaultHistoryCapacity);
+
+  std::vector<HistoryRecord> records;
+  first.Query(0, G_MAXINT64, 0, 10, &records);
+  EXPECT_EQ(sequences(records), std::vector<uint64_t>({1, 2}));
+
+  second.Clear();
+  records.clear();
+  first.Query(0, G_MAXINT64, 0, 10, &records);
+  EXPECT_TRUE(records.empty());
+
+  // Sequence numbers carry on, but earlier times are allowed again.
+  ASSERT_TRUE(first.Append(HistoryKind::kShown, kNowMs - 10, "c", "", ""));
+  second.Query(0, G_MAXINT64, 0, 10, &records);
+  EXPECT_EQ(sequences(records), std::vector<uint64_t>({3}));
+  EXPECT_EQ(records[0].time_ms, kNowMs - 10);
+}
+
+TEST_F(HistoryLogTest, LongFieldsAreCutOnACharacterBoundary) {
+  HistoryLog log(path_);
+  // The leading "x" puts the cut at 1024 bytes in the middle of a
+  // two-byte character.
+  std::string title = "x";
+  for (int i = 0; i < 1000; i++) title += "\xc3\xa9";
+  ASSERT_TRUE(log.Append(HistoryKind::kShown, kNowMs, "a", title, ""));
+
+  std::vector<HistoryRecord> records;
+  log.Query(0, G_MAXINT64, 0, 10, &records);
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_EQ(records[0].title.size(), 1023u);
+  EXPECT_TRUE(g_utf8_validate(records[0].title.c_str(), -1, nullptr));
+}
+
+TEST_F(HistoryLogTest, UnreadableFilesAreReplaced) {
+  g_autofree gchar* dir = g_path_get_dirname(path_.c_str());
+  g_mkdir_with_parents(dir, 0755);
+  ASSERT_TRUE(g_file_set_contents(path_.c_str(), "not a history log", -1, nullptr));
+  HistoryLog log(path_);
+
+  std::vector<HistoryRecord> records;
+  EXPECT_FALSE(log.Query(0, G_MAXINT64, 0, 10, &records));
+  ASSERT_TRUE(log.Append(HistoryKind::kShown, kNowMs, "a", "", ""));
+  log.Query(0, G_MAXINT64, 0, 10, &records);
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_EQ(records[0].id, "a");
+}
+
+// getNotificationHistory, fed by the plugin's shows, actions and closes.
+using NotificationHistoryTest = PluginTest;
+
+TEST_F(NotificationHistoryTest, HistoryRecordsShownActedAndClosed) {
+  VirtualClock* clock = UseVirtualClock();
+  int64_t start_ms = clock->RealTimeUs() / 1000;
+  Show("a");
+  clock->Advance(G_USEC_PER_SEC);
+  backend_->SimulateActionInvoked("a", "reply");
+  backend_->SimulateClosed("a");
+  Show("b");
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "start", fl_value_new_int(start_ms));
+  fl_value_set_string_take(args, "end", fl_value_new_int(start_ms + 60000));
+  fl_value_set_string_take(args, "limit", fl_value_new_int(3));
+  g_autoptr(FlMethodResponse) response = get_notification_history(plugin_, args);
+  FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response));
+  FlValue* entries = fl_value_lookup_string(result, "entries");
+  ASSERT_EQ(fl_value_get_length(entries), 3u);
+  FlValue* shown = fl_value_get_list_value(entries, 0);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(shown, "type")), "shown");
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(shown, "title")), "Title");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(shown, "timestamp")), start_ms);
+  FlValue* action = fl_value_get_list_value(entries, 1);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(action, "actionId")), "reply");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(action, "timestamp")), start_ms + 1000);
+  FlValue* closed = fl_value_get_list_value(entries, 2);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(closed, "type")), "closed");
+
+  FlValue* cursor = fl_value_lookup_string(result, "nextCursor");
+  ASSERT_EQ(fl_value_get_type(cursor), FL_VALUE_TYPE_STRING);
+  fl_value_set_string(args, "cursor", cursor);
+  g_autoptr(FlMethodResponse) next = get_notification_history(plugin_, args);
+  result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(next));
+  entries = fl_value_lookup_string(result, "entries");
+  ASSERT_EQ(fl_value_get_length(entries), 1u);
+  EXPECT_STREQ(fl_value_get_string(
+                   fl_value_lookup_string(fl_value_get_list_value(entries, 0), "notificationId")),
+               "b");
+  EXPECT_EQ(fl_value_get_type(fl_value_lookup_string(result, "nextCursor")), FL_VALUE_TYPE_NULL);
+}
+
+}  // namespace test
+}  // namespace notification_manager
@@ -0,0 +1,305 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "io_thread.h"
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+constexpr int kProducers = 4;
+constexpr int kTasksPerProducer = 5000;
+
+struct Producer {
+  IoThread* io;
+  int index;
+  // Task numbers in the order the I/O thread ran them, per producer. Only
+  // the I/O thread appends.
+  std::vector<std::vector<int>>* runs;
+};
+
+gpointer produce(gpointer data) {
+  Producer* producer = static_cast<Producer*>(data);
+  for (int i = 0; i < kTasksPerProducer; i++) {
+    std::vector<int>* runs = &(*producer->runs)[producer->index];
+    producer->io->Post([runs, i]() { runs->push_back(i); });
+  }
+  return nullptr;
+}
+
+// Holds the I/O thread in a task until released.
+struct Gate {
+  GMutex mutex;
+  GCond cond;
+  bool open = false;
+
+  Gate() {
+    g_mutex_init(&mutex);
+    g_cond_init(&cond);
+  }
+  ~Gate() {
+    g_cond_clear(&cond);
+    g_mutex_clear(&mutex);
+  }
+
+  void Wait() {
+    g_mutex_lock(&mutex);
+    while (!open) g_cond_wait(&cond, &mutex);
+    g_mutex_unlock(&mutex);
+  }
+  void Open() {
+    g_mutex_lock(&mutex);
+    open = true;
+    g_cond_signal(&cond);
+    g_mutex_unlock(&mutex);
+  }
+};
+
+}  // namespace
+
+class IoThreadTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_autofree gchar* dir = g_dir_make_tmp("notification_manager_io_XXXXXX", nullptr);
+    ASSERT_NE(dir, nullptr);
+    dir_ = dir;
+    path_ = dir_ + "/nested/file";
+    other_path_ = dir_ + "/nested/other";
+  }
+
+  static std::string Read(const std::string& path) {
+    gchar* contents = nullptr;
+    gsize length = 0;
+    if (!g_file_get_contents(path.c_str(), &contents, &length, nullptr)) return "";
+    std::string read(contents, length);
+    g_free(contents);
+    return read;
+  }
+
+  void TearDown() override {
+    g_remove(path_.c_str());
+    g_remove((path_ + ".tmp").c_str());
+    g_remove(other_path_.c_str());
+    g_rmdir((dir_ + "/nested").c_str());
+    g_rmdir(dir_.c_str());
+  }
+
+  std::string dir_;
+  std::string path_;
+  std::string other_path_;
+};
+
+TEST_F(IoThreadTest, RunsEachProducersTasksInOrder) {
+  IoThread io;
+  std::vector<std::vector<int>> runs(kProducers);
+  std::vector<Producer> producers;
+  for (int i = 0; i < kProducers; i++) producers.push_back(Producer{&io, i, &runs});
+  std::vector<GThread*> threads;
+  for (auto& producer : producers) {
+    threads.push_back(g_thread_new("producer", produce, &producer));
+  }
+  for (GThread* thread : threads) g_thread_join(thread);
+  io.Flush();
+
+  EXPECT_EQ(io.posted(), uint64_t{kProducers * kTasksPerProducer} + 1);
+  for (const auto& producer_runs : runs) {
+    ASSERT_EQ(producer_runs.size(), size_t{kTasksPerProducer});
+    for (int i = 0; i < kTasksPerProducer; i++) EXPECT_EQ(producer_runs[i], i);
+  }
+}
+
+TEST_F(IoThreadTest, CompletionRunsOnTheMainContext) {
+  GMainContext* context = g_main_context_new();
+  IoThread io(context);
+  GThread* main_thread = g_thread_self();
+  std::atomic<GThread*> task_thread{nullptr};
+  GThread* done_thread = nullptr;
+  io.Post([&]() { task_thread = g_thread_self(); }, [&]() { done_thread = g_thread_self(); });
+
+  while (done_thread == nullptr) g_main_context_iteration(context, TRUE);
+  EXPECT_NE(task_thread.load(), main_thread);
+  EXPECT_EQ(done_thread, main_thread);
+  g_main_context_unref(context);
+}
+
+TEST_F(IoThreadTest, SupersededWritesAreSkipped) {
+  IoThread io;
+  Gate gate;
+  io.Post([&]() { gate.Wait(); });
+  for (int i = 0; i < 10; i++) io.PostReplaceFile(path_, "version " + std::to_string(i));
+  gate.Open();
+  io.Flush();
+
+  gchar* contents = nullptr;
+  ASSERT_TRUE(g_file_get_contents(path_.c_str(), &contents, nullptr, nullptr));
+  EXPECT_STREQ(contents, "version 9");
+  g_free(contents);
+  EXPECT_EQ(io.skipped_writes(), 9u);
+}
+
+TEST_F(IoThreadTest, SkippedWritesReportWithTheWriteThatReplacedThem) {
+  GMainContext* context = g_main_context_new();
+  IoThread io(context);
+  Gate gate;
+  io.Post([&]() { gate.Wait(); });
+  std::vector<std::string> seen;
+  auto read_back = [&]() {
+    gchar* contents = nullptr;
+    g_file_get_contents(path_.c_str(), &contents, nullptr, nullptr);
+    seen.push_back(contents ? contents : "");
+    g_free(contents);
+  };
+  io.PostReplaceFile(path_, "first", Durability::kBatched, read_back);
+  io.PostReplaceFile(path_, "second", Durability::kBatched, read_back);
+  gate.Open();
+
+  while (seen.size() < 2) g_main_context_iteration(context, TRUE);
+  EXPECT_EQ(seen, std::vector<std::string>({"second", "second"}));
+  EXPECT_EQ(io.skipped_writes(), 1u);
+  g_main_context_unref(context);
+}
+
+TEST_F(IoThreadTest, SkippedWritesKeepTheirDurability) {
+  // An immediate change rewrites both files and reports with the second.
+  // An unsynced write to the first replaces its write before the I/O
+  // thread gets to it, and lands only after the second has.
+  GMainContext* context = g_main_context_new();
+  IoThread io(context);
+  io.set_commit_window_us(10 * G_TIME_SPAN_SECOND);
+  Gate gate;
+  Gate later;
+  io.Post([&]() { gate.Wait(); });
+  bool done = false;
+  std::string first_when_done;
+  io.PostReplaceFile(path_, "immediate", Durability::kImmediate);
+  io.PostReplaceFile(other_path_, "immediate", Durability::kImmediate, [&]() {
+    done = true;
+    first_when_done = Read(path_);
+  });
+  io.Post([&]() { later.Wait(); });
+  io.PostReplaceFile(path_, "unsynced", Durability::kNone);
+  gate.Open();
+
+  // The second file is committed, but the change is not durable until the
+  // write that replaced the first one is.
+  gint64 deadline = g_get_monotonic_time() + 50 * G_TIME_SPAN_MILLISECOND;
+  while (g_get_monotonic_time() < deadline) {
+    g_main_context_iteration(context, FALSE);
+    g_usleep(G_TIME_SPAN_MILLISECOND);
+  }
+  EXPECT_FALSE(done);
+  later.Open();
+
+  while (!done) g_main_context_iteration(context, TRUE);
+  EXPECT_EQ(first_when_done, "unsynced");
+  // Synced as the skipped write asked, in a commit of its own, rather than
+  // renamed into place unsynced.
+  EXPECT_EQ(io.commits(), 2u);
+  EXPECT_EQ(io.skipped_writes(), 1u);
+  g_main_context_unref(context);
+}
+
+TEST_F(IoThreadTest, RemoveCancelsQueuedWrites) {
+  IoThread io;
+  Gate gate;
+  io.Post([&]() { gate.Wait(); });
+  io.PostReplaceFile(path_, "gone");
+  io.PostRemoveFile(path_);
+  gate.Open();
+  io.Flush();
+
+  EXPECT_FALSE(g_file_test(path_.c_str(), G_FILE_TEST_EXISTS));
+  EXPECT_EQ(io.skipped_writes(), 1u);
+}
+
+TEST_F(IoThreadTest, BatchedWritesShareOneCommit) {
+  IoThread io;
+  io.set_commit_window_us(10 * G_TIME_SPAN_SECOND);
+  for (int i = 0; i < 50; i++) {
+    io.PostReplaceFile(i % 2 ? path_ : other_path_, "version " + std::to_string(i));
+  }
+  io.Flush();
+
+  EXPECT_EQ(io.commits(), 1u);
+  EXPECT_EQ(Read(path_), "version 49");
+  EXPECT_EQ(Read(other_path_), "version 48");
+}
+
+TEST_F(IoThreadTest, BatchCommitsWhenTheWindowCloses) {
+  GMainContext* context = g_main_context_new();
+  IoThread io(context);
+  io.set_commit_window_us(20 * G_TIME_SPAN_MILLISECOND);
+  bool done = false;
+  gint64 start = g_get_monotonic_time();
+  io.PostReplaceFile(path_, "batched", Durability::kBatched, [&done]() { done = true; });
+
+  while (!done) g_main_context_iteration(context, TRUE);
+  EXPECT_GE(g_get_monotonic_time() - start, 20 * G_TIME_SPAN_MILLISECOND);
+  EXPECT_EQ(io.commits(), 1u);
+  EXPECT_EQ(Read(path_), "batched");
+  g_main_context_unref(context);
+}
+
+TEST_F(IoThreadTest, ImmediateWriteCommitsTheOpenBatch) {
+  GMainContext* context = g_main_context_new();
+  IoThread io(context);
+  io.set_commit_window_us(10 * G_TIME_SPAN_SECOND);
+  bool done = false;
+  io.PostReplaceFile(other_path_, "batched");
+  io.PostReplaceFile(path_, "immediate", Durability::kImmediate, [&done]() { done = true; });
+
+  while (!done) g_main_context_iteration(context, TRUE);
+  EXPECT_EQ(io.commits(), 1u);
+  EXPECT_EQ(Read(path_), "immediate");
+  EXPECT_EQ(Read(other_path_), "batched");
+  g_main_context_unref(context);
+}
+
+TEST_F(IoThreadTest, UnsyncedWritesSkipTheBatch) {
+  GMainContext* context = g_main_context_new();
+  IoThread io(context);
+  io.set_commit_window_us(10 * G_TIME_SPAN_SECOND);
+  bool done = false;
+  io.PostReplaceFile(path_, "unsynced", Durability::kNone, [&done]() { done = true; });
+
+  while (!done) g_main_context_iteration(context, TRUE);
+  EXPECT_EQ(io.commits(), 0u);
+  EXPECT_EQ(Read(path_), "unsynced");
+  g_main_context_unref(context);
+}
+
+TEST_F(IoThreadTest, CrashBeforeRenameKeepsThePreviousContents) {
+  std::string previous(4096, 'p');
+  std::string next(4096, 'n');
+  std::mt19937 random(42);
+  for (int i = 0; i < 20; i++) {
+    ASSERT_TRUE(ReplaceFile(path_, previous));
+    // What a crash part way through the next write leaves behind.
+    size_t offset = random() % next.size();
+    ASSERT_TRUE(g_file_set_contents((path_ + ".tmp").c_str(), next.data(), offset, nullptr));
+
+    EXPECT_EQ(Read(path_), previous);
+    ASSERT_TRUE(ReplaceFile(path_, next));
+    EXPECT_EQ(Read(path_), next);
+    EXPECT_FALSE(g_file_test((path_ + ".tmp").c_str(), G_FILE_TEST_EXISTS));
+  }
+}
+
+TEST_F(IoThreadTest, DestructionRunsPendingTasks) {
+  int run = 0;
+  {
+    IoThread io;
+    for (int i = 0; i < 100; i++) io.Post([&run]() { run++; });
+  }
+  EXPECT_EQ(run, 100);
+}
+
+}  // namespace test
+}  // namespace notification_manager
@@ -0,0 +1,114 @@
+#include <flutter_linux/flutter_linux.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "include/notification_manager/notification_manager_plugin.h"
+#include "method_args.h"
+#include "notification_manager_plugin_private.h"
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+struct TestArgs {
+  std::string id;
+  int64_t count = 7;
+  bool flag = false;
+  FlValue* items = nullptr;
+};
+
+const ArgSchema<TestArgs> kTestSchema = {
+    ArgSchema<TestArgs>::Required("id", &TestArgs::id),
+    ArgSchema<TestArgs>::Optional("count", &TestArgs::count),
+    ArgSchema<TestArgs>::Optional("flag", &TestArgs::flag),
+    ArgSchema<TestArgs>::Optional("items", &TestArgs::items, FL_VALUE_TYPE_LIST),
+};
+
+}  // namespace
+
+TEST(MethodArgs, DecodesAllFields) {
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string("a"));
+  fl_value_set_string_take(args, "count", fl_value_new_int(3));
+  fl_value_set_string_take(args, "flag", fl_value_new_bool(true));
+  fl_value_set_string_take(args, "items", fl_value_new_list());
+
+  TestArgs decoded;
+  ArgError error;
+  ASSERT_TRUE(kTestSchema.Decode(args, &decoded, &error));
+  EXPECT_EQ(decoded.id, "a");
+  EXPECT_EQ(decoded.count, 3);
+  EXPECT_TRUE(decoded.flag);
+  EXPECT_EQ(decoded.items, fl_value_lookup_string(args, "items"));
+}
+
+TEST(MethodArgs, AbsentAndNullOptionalsKeepDefaults) {
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string("a"));
+  fl_value_set_string_take(args, "count", fl_value_new_null());
+  fl_value_set_string_take(args, "unknown", fl_value_new_int(1));
+
+  TestArgs decoded;
+  ArgError error;
+  ASSERT_TRUE(kTestSchema.Decode(args, &decoded, &error));
+  EXPECT_EQ(decoded.count, 7);
+  EXPECT_FALSE(decoded.flag);
+  EXPECT_EQ(decoded.items, nullptr);
+}
+
+TEST(MethodArgs, MissingRequiredKeyIsReported) {
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "count", fl_value_new_int(3));
+
+  TestArgs decoded;
+  ArgError error;
+  EXPECT_FALSE(kTestSchema.Decode(args, &decoded, &error));
+  EXPECT_EQ(error.key, "id");
+}
+
+TEST(MethodArgs, WrongTypeIsReported) {
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string("a"));
+  fl_value_set_string_take(args, "count", fl_value_new_string("3"));
+
+  TestArgs decoded;
+  ArgError error;
+  EXPECT_FALSE(kTestSchema.Decode(args, &decoded, &error));
+  EXPECT_EQ(error.key, "count");
+  EXPECT_EQ(error.message, "Argument 'count' must be an int, got a string");
+}
+
+TEST(MethodArgs, NonMapArgumentsAreRejected) {
+  g_autoptr(FlValue) args = fl_value_new_list();
+
+  TestArgs decoded;
+  ArgError error;
+  EXPECT_FALSE(kTestSchema.Decode(args, &decoded, &error));
+  EXPECT_FALSE(kTestSchema.Decode(nullptr, &decoded, &error));
+}
+
+TEST(MethodArgs, HandlersReturnInvalidArgumentsError) {
+  NotificationManagerPlugin* plugin = static_cast<NotificationManagerPlugin*>(
+      g_object_new(notification_manager_plugin_get_type(), nullptr));
+  notification_manager_plugin_set_backend(plugin, std::make_unique<NullBackend>());
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string("a"));
+  fl_value_set_string_take(args, "title", fl_value_new_int(1));
+  fl_value_set_string_take(args, "body", fl_value_new_string("Body"));
+  g_autoptr(FlMethodResponse) response = show_notification(plugin, args);
+
+  ASSERT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(response));
+  FlMethodErrorResponse* error = FL_METHOD_ERROR_RESPONSE(response);
+  EXPECT_STREQ(fl_method_error_response_get_code(error), "INVALID_ARGUMENTS");
+  FlValue* details = fl_method_error_response_get_details(error);
+  ASSERT_NE(details, nullptr);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(details, "key")), "title");
+  g_object_unref(plugin);
+}
+
+}  // namespace test
+}  // namespace notification_manager
@@ -0,0 +1,71 @@
+#include <flutter_linux/flutter_linux.h>
+#include <gtest/gtest.h>
+
+#include "plugin_test_fixture.h"
+
+namespace notification_manager {
+namespace test {
+
+// How the plugin routes shows, updates and closes to its backend. The
+// feature tests built on the same fixture live next to the unit tests of
+// the module they exercise.
+using NotificationBackendTest = PluginTest;
+
+TEST_F(NotificationBackendTest, ShowPassesContentToBackend) {
+  Show("a");
+
+  ASSERT_EQ(backend_->calls().size(), 1u);
+  const RecordingBackend::Call& call = backend_->calls()[0];
+  EXPECT_EQ(call.type, RecordingBackend::CallType::kShow);
+  EXPECT_EQ(call.id, "a");
+  EXPECT_EQ(call.content.title, "Title");
+  EXPECT_EQ(call.content.body, "Body");
+  ASSERT_EQ(call.content.actions.size(), 1u);
+  EXPECT_EQ(call.content.actions[0].first, "reply");
+  EXPECT_EQ(call.content.actions[0].second, "Reply");
+}
+
+TEST_F(NotificationBackendTest, ShowingSameIdUpdatesInPlace) {
+  Show("a");
+  Show("a");
+
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 1u);
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kUpdate), 1u);
+}
+
+TEST_F(NotificationBackendTest, CancelClosesOnlyActiveNotifications) {
+  Show("a");
+  Cancel("a");
+  Cancel("unknown");
+
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kClose), 1u);
+  EXPECT_TRUE(backend_->open().empty());
+}
+
+TEST_F(NotificationBackendTest, CancelAllClosesEverything) {
+  Show("a");
+  Show("b");
+  g_autoptr(FlMethodResponse) response = cancel_all_notifications(plugin_, nullptr);
+
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kClose), 2u);
+  EXPECT_TRUE(backend_->open().empty());
+}
+
+TEST_F(NotificationBackendTest, FailedShowIsNotTracked) {
+  backend_->set_fail(true);
+  Show("a");
+  Cancel("a");
+
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kClose), 0u);
+}
+
+TEST_F(NotificationBackendTest, DaemonCloseForgetsNotification) {
+  Show("a");
+  backend_->SimulateClosed("a");
+  Cancel("a");
+
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kClose), 0u);
+}
+
+}  // namespace test
+}  // namespace notification_manager
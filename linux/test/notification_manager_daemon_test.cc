@@ -0,0 +1,213 @@
+#include <flutter_linux/flutter_linux.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "include/notification_manager/notification_manager_plugin.h"
+#include "notification_manager_plugin_private.h"
+#include "stub_notification_daemon_fixture.h"
+#include "test_data_dir.h"
+
+// End-to-end tests of the show/cancel/callback paths against the stub
+// notification daemon. Throughput figures are attached to the test results
+// as properties (see --gtest_output=xml).
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+bool response_bool(FlMethodResponse* response) {
+  if (!FL_IS_METHOD_SUCCESS_RESPONSE(response)) return false;
+  FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response));
+  return fl_value_get_type(result) == FL_VALUE_TYPE_BOOL && fl_value_get_bool(result);
+}
+
+FlValue* make_show_args(const std::string& id) {
+  FlValue* args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string(id.c_str()));
+  fl_value_set_string_take(args, "title", fl_value_new_string("Title"));
+  fl_value_set_string_take(args, "body", fl_value_new_string("Body"));
+  return args;
+}
+
+// Shows |id| with a "default" action, so libnotify has a handler to
+// dispatch ActionInvoked to.
+FlValue* make_show_args_with_action(const std::string& id) {
+  FlValue* args = make_show_args(id);
+  FlValue* actions = fl_value_new_list();
+  FlValue* action = fl_value_new_map();
+  fl_value_set_string_take(action, "id", fl_value_new_string("default"));
+  fl_value_set_string_take(action, "title", fl_value_new_string("Open"));
+  fl_value_append_take(actions, action);
+  fl_value_set_string_take(args, "actions", actions);
+  return args;
+}
+
+FlValue* make_id_args(const std::string& id) {
+  FlValue* args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string(id.c_str()));
+  return args;
+}
+
+double ops_per_second(int count, gint64 elapsed_us) {
+  return elapsed_us > 0 ? count * static_cast<double>(G_USEC_PER_SEC) / elapsed_us : 0;
+}
+
+}  // namespace
+
+class NotificationManagerDaemonTest : public StubNotificationDaemonTest {
+ protected:
+  void SetUp() override {
+    StubNotificationDaemonTest::SetUp();
+    if (IsSkipped()) return;
+    plugin_ = static_cast<NotificationManagerPlugin*>(
+        g_object_new(notification_manager_plugin_get_type(), nullptr));
+    g_autoptr(FlMethodResponse) response = initialize_notification_manager(plugin_, nullptr);
+  }
+
+  void TearDown() override { g_clear_object(&plugin_); }
+
+  bool Show(const std::string& id) {
+    g_autoptr(FlValue) args = make_show_args(id);
+    g_autoptr(FlMethodResponse) response = show_notification(plugin_, args);
+    return response_bool(response);
+  }
+
+  bool Cancel(const std::string& id) {
+    g_autoptr(FlValue) args = make_id_args(id);
+    g_autoptr(FlMethodResponse) response = cancel_notification(plugin_, args);
+    return response_bool(response);
+  }
+
+  // Counts the plugin's history entries of |type|, which record each
+  // daemon signal once it has reached the plugin.
+  size_t CountHistory(const char* type) {
+    g_autoptr(FlValue) args = fl_value_new_map();
+    fl_value_set_string_take(args, "start", fl_value_new_int(0));
+    fl_value_set_string_take(args, "end", fl_value_new_int(G_MAXINT64));
+    fl_value_set_string_take(args, "limit", fl_value_new_int(100000));
+    g_autoptr(FlMethodResponse) response = get_notification_history(plugin_, args);
+    if (!FL_IS_METHOD_SUCCESS_RESPONSE(response)) return 0;
+    FlValue* entries = fl_value_lookup_string(
+        fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response)), "entries");
+    size_t count = 0;
+    for (size_t i = 0; i < fl_value_get_length(entries); i++) {
+      FlValue* entry_type = fl_value_lookup_string(fl_value_get_list_value(entries, i), "type");
+      if (g_strcmp0(fl_value_get_string(entry_type), type) == 0) count++;
+    }
+    return count;
+  }
+
+  // Holds the history counted above, so it starts empty.
+  ScopedTestDataDir data_dir_;
+  NotificationManagerPlugin* plugin_ = nullptr;
+};
+
+TEST_F(NotificationManagerDaemonTest, ShowReachesDaemon) {
+  EXPECT_TRUE(Show("single"));
+  Stats stats = GetStats();
+  EXPECT_EQ(stats.notify_count, 1u);
+  EXPECT_EQ(stats.open_count, 1u);
+}
+
+TEST_F(NotificationManagerDaemonTest, ShowThroughput) {
+  const int kCount = 2000;
+  gint64 start = g_get_monotonic_time();
+  for (int i = 0; i < kCount; i++) {
+    ASSERT_TRUE(Show("throughput_" + std::to_string(i)));
+  }
+  gint64 elapsed = g_get_monotonic_time() - start;
+
+  EXPECT_EQ(GetStats().notify_count, static_cast<guint32>(kCount));
+  RecordProperty("show_ops_per_second", std::to_string(ops_per_second(kCount, elapsed)));
+}
+
+TEST_F(NotificationManagerDaemonTest, CancelThroughput) {
+  const int kCount = 1000;
+  for (int i = 0; i < kCount; i++) {
+    ASSERT_TRUE(Show("cancel_" + std::to_string(i)));
+  }
+
+  gint64 start = g_get_monotonic_time();
+  for (int i = 0; i < kCount; i++) {
+    ASSERT_TRUE(Cancel("cancel_" + std::to_string(i)));
+  }
+  gint64 elapsed = g_get_monotonic_time() - start;
+
+  Stats stats = GetStats();
+  EXPECT_EQ(stats.close_count, static_cast<guint32>(kCount));
+  EXPECT_EQ(stats.open_count, 0u);
+  RecordProperty("cancel_ops_per_second", std::to_string(ops_per_second(kCount, elapsed)));
+}
+
+TEST_F(NotificationManagerDaemonTest, GroupCancelThroughput) {
+  const int kCount = 1000;
+  for (int i = 0; i < kCount; i++) {
+    g_autoptr(FlValue) args = make_show_args("group_" + std::to_string(i));
+    fl_value_set_string_take(args, "group", fl_value_new_string("conversation"));
+    g_autoptr(FlMethodResponse) response = show_notification(plugin_, args);
+    ASSERT_TRUE(response_bool(response));
+  }
+
+  gint64 start = g_get_monotonic_time();
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "group", fl_value_new_string("conversation"));
+  g_autoptr(FlMethodResponse) response = cancel_notifications_by_group(plugin_, args);
+  // The close calls are in flight; wait for the daemon to have seen them.
+  EXPECT_TRUE(RunMainLoopUntil([] { return GetStats().open_count == 0; }));
+  gint64 elapsed = g_get_monotonic_time() - start;
+
+  EXPECT_EQ(GetStats().close_count, static_cast<guint32>(kCount));
+  RecordProperty("group_cancel_ops_per_second",
+                 std::to_string(ops_per_second(kCount, elapsed)));
+}
+
+TEST_F(NotificationManagerDaemonTest, InjectedFailureReturnsFalse) {
+  SetFailureRate(1.0);
+  EXPECT_FALSE(Show("failing"));
+  EXPECT_EQ(GetStats().failure_count, 1u);
+}
+
+TEST_F(NotificationManagerDaemonTest, InjectedLatencyIsObserved) {
+  SetLatency(20);
+  gint64 start = g_get_monotonic_time();
+  EXPECT_TRUE(Show("slow"));
+  EXPECT_GE(g_get_monotonic_time() - start, 20 * 1000);
+}
+
+TEST_F(NotificationManagerDaemonTest, ActionSignalThroughput) {
+  g_autoptr(FlValue) args = make_show_args_with_action("with_actions");
+  g_autoptr(FlMethodResponse) response = show_notification(plugin_, args);
+  ASSERT_TRUE(response_bool(response));
+  guint32 id = GetStats().last_id;
+
+  const int kCount = 1000;
+  gint64 start = g_get_monotonic_time();
+  for (int i = 0; i < kCount; i++) {
+    EmitActionInvoked(id, "default");
+  }
+  // Counted once libnotify has handed each signal to the plugin's action
+  // callback.
+  EXPECT_TRUE(RunMainLoopUntil([this] { return CountHistory("action") == kCount; }));
+  gint64 elapsed = g_get_monotonic_time() - start;
+
+  EXPECT_EQ(CountHistory("action"), static_cast<size_t>(kCount));
+  RecordProperty("action_signals_per_second", std::to_string(ops_per_second(kCount, elapsed)));
+}
+
+TEST_F(NotificationManagerDaemonTest, DaemonCloseIsDelivered) {
+  ASSERT_TRUE(Show("closed_by_daemon"));
+  guint32 id = GetStats().last_id;
+
+  EmitNotificationClosed(id, 2);
+  ASSERT_TRUE(RunMainLoopUntil([this] { return CountHistory("closed") == 1; }));
+
+  // The plugin has forgotten the notification, so cancelling it must not
+  // reach the daemon again.
+  EXPECT_TRUE(Cancel("closed_by_daemon"));
+  EXPECT_EQ(GetStats().close_count, 0u);
+}
+
+}  // namespace test
+}  // namespace notification_manager
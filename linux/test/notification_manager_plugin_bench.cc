@@ -0,0 +1,620 @@
+#include <benchmark/benchmark.h>
+#include <flutter_linux/flutter_linux.h>
+#include <glib/gstdio.h>
+#include <malloc.h>
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "history_log.h"
+#include "include/notification_manager/notification_manager_plugin.h"
+#include "method_args.h"
+#include "notification_manager_plugin_private.h"
+#include "recurrence_rule.h"
+#include "scheduled_snapshot.h"
+#include "scheduled_store.h"
+#include "test_data_dir.h"
+
+// Micro-benchmarks for the Linux method handlers.
+//
+// Once you have built the plugin's example app, run the benchmarks from the
+// command line. Results are written to notification_manager_bench.json in the
+// working directory unless --benchmark_out is given explicitly:
+// $ build/linux/x64/release/plugins/notification_manager/notification_manager_bench
+//
+// Each benchmark is parameterised by the amount of state (active,
+// scheduled or persisted entries) present before the timed loop starts.
+
+namespace notification_manager {
+namespace bench {
+
+namespace {
+
+// Plugins run against the NullBackend so the numbers exclude daemon cost;
+// see test/notification_manager_daemon_test.cc for end-to-end figures.
+NotificationManagerPlugin* new_plugin() {
+  NotificationManagerPlugin* plugin = static_cast<NotificationManagerPlugin*>(
+      g_object_new(notification_manager_plugin_get_type(), nullptr));
+  notification_manager_plugin_set_backend(plugin, std::make_unique<NullBackend>());
+  return plugin;
+}
+
+// Removes the prefs file and every scheduled notification so every
+// benchmark starts from a known state.
+void reset_preferences(NotificationManagerPlugin* plugin) {
+  g_autoptr(FlMethodResponse) response = clear_notification_history(plugin, nullptr);
+  g_autoptr(FlMethodResponse) cancel_response = cancel_all_scheduled_notifications(plugin, nullptr);
+}
+
+std::string make_id(const char* prefix, int64_t i) {
+  return std::string(prefix) + std::to_string(i);
+}
+
+FlValue* make_show_args(const std::string& id, const char* duplicate_key) {
+  FlValue* args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string(id.c_str()));
+  fl_value_set_string_take(args, "title", fl_value_new_string("Benchmark"));
+  fl_value_set_string_take(args, "body", fl_value_new_string("Notification body"));
+
+  FlValue* actions = fl_value_new_list();
+  for (int i = 0; i < 2; i++) {
+    FlValue* action = fl_value_new_map();
+    fl_value_set_string_take(action, "id", fl_value_new_string(make_id("action_", i).c_str()));
+    fl_value_set_string_take(action, "title", fl_value_new_string("Action"));
+    fl_value_append_take(actions, action);
+  }
+  fl_value_set_string_take(args, "actions", actions);
+
+  if (duplicate_key) {
+    fl_value_set_string_take(args, "duplicateKey", fl_value_new_string(duplicate_key));
+    fl_value_set_string_take(args, "duplicateWindow", fl_value_new_int(300));
+  }
+  return args;
+}
+
+FlValue* make_schedule_args(const std::string& id) {
+  FlValue* args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string(id.c_str()));
+  FlValue* request = fl_value_new_map();
+  fl_value_set_string_take(request, "title", fl_value_new_string("Benchmark"));
+  fl_value_set_string_take(request, "body", fl_value_new_string("Scheduled body"));
+  fl_value_set_string_take(args, "request", request);
+  fl_value_set_string_take(args, "scheduledDate", fl_value_new_int(4102444800000));
+  fl_value_set_string_take(args, "isRepeating", fl_value_new_bool(false));
+  return args;
+}
+
+FlValue* make_id_args(const std::string& id) {
+  FlValue* args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string(id.c_str()));
+  return args;
+}
+
+void populate_active(NotificationManagerPlugin* plugin, int64_t count) {
+  for (int64_t i = 0; i < count; i++) {
+    g_autoptr(FlValue) args = make_show_args(make_id("active_", i), nullptr);
+    g_autoptr(FlMethodResponse) response = show_notification(plugin, args);
+  }
+}
+
+void populate_scheduled(NotificationManagerPlugin* plugin, int64_t count) {
+  for (int64_t i = 0; i < count; i++) {
+    g_autoptr(FlValue) args = make_schedule_args(make_id("scheduled_", i));
+    g_autoptr(FlMethodResponse) response = schedule_notification(plugin, args);
+  }
+}
+
+void populate_preferences(NotificationManagerPlugin* plugin, int64_t count) {
+  for (int64_t i = 0; i < count; i++) {
+    save_preferences(plugin, make_id("bench_key_", i), std::to_string(i));
+  }
+}
+
+}  // namespace
+
+static void BM_ShowNotification(benchmark::State& state) {
+  NotificationManagerPlugin* plugin = new_plugin();
+  reset_preferences(plugin);
+  populate_active(plugin, state.range(0));
+
+  g_autoptr(FlValue) args = make_show_args("bench_show", nullptr);
+  for (auto _ : state) {
+    g_autoptr(FlMethodResponse) response = show_notification(plugin, args);
+    benchmark::DoNotOptimize(response);
+  }
+  g_object_unref(plugin);
+}
+BENCHMARK(BM_ShowNotification)->RangeMultiplier(10)->Range(1, 1000);
+
+static void BM_ShowNotificationWithDedupe(benchmark::State& state) {
+  NotificationManagerPlugin* plugin = new_plugin();
+  reset_preferences(plugin);
+  populate_preferences(plugin, state.range(0));
+
+  int64_t i = 0;
+  for (auto _ : state) {
+    std::string key = make_id("dedupe_", i++);
+    g_autoptr(FlValue) args = make_show_args("bench_show", key.c_str());
+    g_autoptr(FlMethodResponse) response = show_notification(plugin, args);
+    benchmark::DoNotOptimize(response);
+  }
+  g_object_unref(plugin);
+}
+BENCHMARK(BM_ShowNotificationWithDedupe)->RangeMultiplier(10)->Range(1, 1000);
+
+static void BM_ScheduleNotification(benchmark::State& state) {
+  NotificationManagerPlugin* plugin = new_plugin();
+  reset_preferences(plugin);
+  populate_scheduled(plugin, state.range(0));
+
+  g_autoptr(FlValue) args = make_schedule_args("bench_schedule");
+  for (auto _ : state) {
+    g_autoptr(FlMethodResponse) response = schedule_notification(plugin, args);
+    benchmark::DoNotOptimize(response);
+  }
+  g_object_unref(plugin);
+}
+BENCHMARK(BM_ScheduleNotification)->RangeMultiplier(10)->Range(1, 1000);
+
+static void BM_GetScheduledNotifications(benchmark::State& state) {
+  NotificationManagerPlugin* plugin = new_plugin();
+  reset_preferences(plugin);
+  populate_scheduled(plugin, state.range(0));
+
+  for (auto _ : state) {
+    g_autoptr(FlMethodResponse) response = get_scheduled_notifications(plugin, nullptr);
+    benchmark::DoNotOptimize(response);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  g_object_unref(plugin);
+}
+BENCHMARK(BM_GetScheduledNotifications)->RangeMultiplier(10)->Range(1, 1000);
+
+// A page of ten should cost the same however many entries are scheduled.
+static void BM_GetNextScheduledNotifications(benchmark::State& state) {
+  NotificationManagerPlugin* plugin = new_plugin();
+  reset_preferences(plugin);
+  populate_scheduled(plugin, state.range(0));
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "limit", fl_value_new_int(10));
+  for (auto _ : state) {
+    g_autoptr(FlMethodResponse) response = get_next_scheduled_notifications(plugin, args);
+    benchmark::DoNotOptimize(response);
+  }
+  g_object_unref(plugin);
+}
+BENCHMARK(BM_GetNextScheduledNotifications)->RangeMultiplier(10)->Range(10, 10000);
+
+// Next-occurrence throughput; rare rules should cost about as much as
+// frequent ones.
+static void BM_RecurrenceNextAfter(benchmark::State& state, const char* spec) {
+  RecurrenceRule rule;
+  std::string error;
+  if (!RecurrenceRule::Parse(spec, &rule, &error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  g_autoptr(GTimeZone) tz = g_time_zone_new_local();
+  int64_t after_ms = g_get_real_time() / 1000;
+  for (auto _ : state) {
+    int64_t next_ms = rule.NextAfter(after_ms, tz);
+    benchmark::DoNotOptimize(next_ms);
+  }
+}
+BENCHMARK_CAPTURE(BM_RecurrenceNextAfter, every_15_minutes, "*/15 * * * *");
+BENCHMARK_CAPTURE(BM_RecurrenceNextAfter, weekdays, "0 9 * * MON-FRI");
+BENCHMARK_CAPTURE(BM_RecurrenceNextAfter, first_monday, "0 9 * * MON#1");
+BENCHMARK_CAPTURE(BM_RecurrenceNextAfter, leap_day, "0 0 29 2 *");
+
+static void BM_CancelNotification(benchmark::State& state) {
+  NotificationManagerPlugin* plugin = new_plugin();
+  reset_preferences(plugin);
+  populate_active(plugin, state.range(0));
+
+  // Cancels an id that is not active, so the cost is the lookup only and the
+  // state size stays constant across iterations.
+  g_autoptr(FlValue) args = make_id_args("not_active");
+  for (auto _ : state) {
+    g_autoptr(FlMethodResponse) response = cancel_notification(plugin, args);
+    benchmark::DoNotOptimize(response);
+  }
+  g_object_unref(plugin);
+}
+BENCHMARK(BM_CancelNotification)->RangeMultiplier(10)->Range(1, 1000);
+
+static void BM_CancelScheduledNotification(benchmark::State& state) {
+  NotificationManagerPlugin* plugin = new_plugin();
+  reset_preferences(plugin);
+  populate_scheduled(plugin, state.range(0));
+
+  g_autoptr(FlValue) args = make_id_args("not_scheduled");
+  for (auto _ : state) {
+    g_autoptr(FlMethodResponse) response = cancel_scheduled_notification(plugin, args);
+    benchmark::DoNotOptimize(response);
+  }
+  g_object_unref(plugin);
+}
+BENCHMARK(BM_CancelScheduledNotification)->RangeMultiplier(10)->Range(1, 1000);
+
+// Duplicate keys live in the shared table, so a check is a few reads of
+// the mapping however many keys there are.
+static void BM_IsDuplicateNotification(benchmark::State& state) {
+  NotificationManagerPlugin* plugin = new_plugin();
+  reset_preferences(plugin);
+  for (int64_t i = 0; i < state.range(0); i++) {
+    g_autoptr(FlValue) show_args =
+        make_show_args(make_id("bench_show_", i), make_id("bench_key_", i).c_str());
+    g_autoptr(FlMethodResponse) response = show_notification(plugin, show_args);
+  }
+
+  g_autoptr(FlValue) args = make_id_args("bench_key_0");
+  fl_value_set_string_take(args, "timeWindowSeconds", fl_value_new_int(300));
+  for (auto _ : state) {
+    g_autoptr(FlMethodResponse) response = is_duplicate_notification_method(plugin, args);
+    benchmark::DoNotOptimize(response);
+  }
+  g_object_unref(plugin);
+}
+BENCHMARK(BM_IsDuplicateNotification)->RangeMultiplier(10)->Range(1, 1000);
+
+static void BM_SavePreferences(benchmark::State& state) {
+  NotificationManagerPlugin* plugin = new_plugin();
+  reset_preferences(plugin);
+  populate_preferences(plugin, state.range(0));
+
+  for (auto _ : state) {
+    save_preferences(plugin, "bench_save", "value");
+  }
+  g_object_unref(plugin);
+}
+BENCHMARK(BM_SavePreferences)->RangeMultiplier(10)->Range(1, 1000);
+
+static void BM_LoadPreference(benchmark::State& state) {
+  NotificationManagerPlugin* plugin = new_plugin();
+  reset_preferences(plugin);
+  populate_preferences(plugin, state.range(0));
+
+  for (auto _ : state) {
+    std::string value = load_preference(plugin, "bench_key_0");
+    benchmark::DoNotOptimize(value);
+  }
+  g_object_unref(plugin);
+}
+BENCHMARK(BM_LoadPreference)->RangeMultiplier(10)->Range(1, 1000);
+
+// Restarting with a populated snapshot: one mapped read, no JSON parsing.
+// Every entry is in the future, so nothing fires and the snapshot is not
+// rewritten between iterations.
+static void BM_RestoreScheduled(benchmark::State& state) {
+  NotificationManagerPlugin* setup = new_plugin();
+  reset_preferences(setup);
+  populate_scheduled(setup, state.range(0));
+  g_object_unref(setup);
+
+  for (auto _ : state) {
+    NotificationManagerPlugin* plugin = new_plugin();
+    notification_manager_plugin_restore_scheduled(plugin);
+
+    state.PauseTiming();
+    g_object_unref(plugin);
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+
+  setup = new_plugin();
+  reset_preferences(setup);
+  g_object_unref(setup);
+}
+BENCHMARK(BM_RestoreScheduled)->Arg(1000)->Arg(10000)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+// Loading a snapshot whose entries carry payloads of state.range(1) bytes,
+// with the tails compressed or kept raw. The payloads repeat the way
+// app-defined routes and ids do, so they compress about as well as real
+// ones. Reports the file size per entry and, when compressed, the ratio to
+// the raw file.
+static void BM_ReadScheduledSnapshot(benchmark::State& state, bool compress) {
+  ScheduledStore store;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    ScheduledRequest request;
+    request.id = make_id("scheduled_", i);
+    request.title = "Benchmark";
+    request.body = "Scheduled body";
+    request.fire_at_ms = 4102444800000 + i * 1000;
+    g_autoptr(FlValue) payload = fl_value_new_map();
+    for (int64_t field = 0; 16 * field < state.range(1); field++) {
+      fl_value_set_string_take(payload, make_id("item_", field).c_str(),
+                               fl_value_new_string(make_id("/orders/", i + field).c_str()));
+    }
+    request.payload = payload;
+    store.Put(request);
+  }
+  std::string path = std::string(g_get_tmp_dir()) + "/notification_manager_bench_snapshot.bin";
+  size_t threshold = compress ? kSnapshotCompressThreshold : SIZE_MAX;
+  std::string raw = EncodeScheduledSnapshot(store, 0, SnapshotShard(), SIZE_MAX);
+  std::string written = EncodeScheduledSnapshot(store, 0, SnapshotShard(), threshold);
+  WriteScheduledSnapshot(path, store, 0, SnapshotShard(), threshold);
+
+  for (auto _ : state) {
+    ScheduledStore read;
+    benchmark::DoNotOptimize(ReadScheduledSnapshot(path, &read));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["file_bytes_per_entry"] =
+      static_cast<double>(written.size()) / static_cast<double>(state.range(0));
+  state.counters["compression_ratio"] =
+      static_cast<double>(raw.size()) / static_cast<double>(written.size());
+  g_remove(path.c_str());
+}
+BENCHMARK_CAPTURE(BM_ReadScheduledSnapshot, raw, false)
+    ->Args({10000, 128})
+    ->Args({10000, 1024})
+    ->Args({10000, 8192})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ReadScheduledSnapshot, compressed, true)
+    ->Args({10000, 128})
+    ->Args({10000, 1024})
+    ->Args({10000, 8192})
+    ->Unit(benchmark::kMillisecond);
+
+// A day's worth of history from a full log of state.range(0) bytes, one
+// record a minute. The time taken should follow the records returned, not
+// the size of the log.
+static void BM_QueryNotificationHistory(benchmark::State& state) {
+  std::string path = std::string(g_get_tmp_dir()) + "/notification_manager_bench_history.log";
+  g_remove(path.c_str());
+  const int64_t kStartMs = 1735689600000;
+  int64_t records = 0;
+  {
+    HistoryLog log(path, state.range(0));
+    // Twice over, so the ring has wrapped.
+    for (; records * 96 < 2 * state.range(0); records++) {
+      log.Append(HistoryKind::kShown, kStartMs + records * 60000, make_id("notification_", records),
+                 "Benchmark title", "");
+    }
+  }
+
+  HistoryLog log(path);
+  int64_t end_ms = kStartMs + records * 60000;
+  std::vector<HistoryRecord> found;
+  for (auto _ : state) {
+    found.clear();
+    log.Query(end_ms - 24 * 3600 * 1000, end_ms, 0, SIZE_MAX, &found);
+    benchmark::DoNotOptimize(found.data());
+  }
+  state.SetItemsProcessed(state.iterations() * found.size());
+  g_remove(path.c_str());
+}
+BENCHMARK(BM_QueryNotificationHistory)->RangeMultiplier(16)->Range(256 * 1024, 64 * 1024 * 1024);
+
+// Bytes allocated and not yet freed, from glibc's allocator statistics.
+// Large blocks are mapped separately and counted apart.
+static size_t heap_in_use() {
+#if __GLIBC_PREREQ(2, 33)
+  struct mallinfo2 info = mallinfo2();
+#else
+  struct mallinfo info = mallinfo();
+#endif
+  return static_cast<size_t>(info.uordblks) + static_cast<size_t>(info.hblkhd);
+}
+
+// How scheduled notifications were held before ScheduledStore: a map node
+// per entry with the request kept as JSON.
+struct LegacyScheduledEntry {
+  std::string id;
+  std::string request_json;
+  int64_t fire_at_ms;
+  int64_t repeat_interval_s;
+};
+
+// Heap held per scheduled notification, for the column store against the
+// legacy map, filled with the entries populate_scheduled() would add. The
+// timed loop is the fill itself.
+static void BM_ScheduledMemory(benchmark::State& state, bool legacy) {
+  size_t heap_bytes = 0;
+  size_t reported_bytes = 0;
+  for (auto _ : state) {
+    size_t before = heap_in_use();
+    auto map = std::make_unique<std::map<std::string, LegacyScheduledEntry>>();
+    auto store = std::make_unique<ScheduledStore>();
+    for (int64_t i = 0; i < state.range(0); i++) {
+      std::string id = make_id("scheduled_", i);
+      int64_t fire_at_ms = 4102444800000 + i * 1000;
+      if (legacy) {
+        std::string json = "{\"id\":\"" + id +
+                           "\",\"title\":\"Benchmark\",\"body\":\"Scheduled body\"}";
+        (*map)[id] = LegacyScheduledEntry{id, std::move(json), fire_at_ms, 0};
+      } else {
+        ScheduledRequest request;
+        request.id = id;
+        request.title = "Benchmark";
+        request.body = "Scheduled body";
+        request.fire_at_ms = fire_at_ms;
+        store->Put(request);
+      }
+    }
+    heap_bytes = heap_in_use() - before;
+    reported_bytes = store->memory_usage().total();
+
+    state.PauseTiming();
+    map.reset();
+    store.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["heap_bytes_per_entry"] =
+      static_cast<double>(heap_bytes) / static_cast<double>(state.range(0));
+  if (!legacy) {
+    state.counters["reported_bytes_per_entry"] =
+        static_cast<double>(reported_bytes) / static_cast<double>(state.range(0));
+  }
+}
+BENCHMARK_CAPTURE(BM_ScheduledMemory, legacy_map, true)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ScheduledMemory, column_store, false)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+// Registration itself does no I/O, so the first show pays for loading the
+// preferences and, when it carries a duplicate key, for mapping the shared
+// dedupe table. The plugin is created the same way
+// notification_manager_plugin_register_with_registrar() creates it, but on
+// the NullBackend, so connecting to the notification daemon is not counted;
+// test/notification_manager_daemon_test.cc covers that. The channels need a
+// running engine and are left out.
+static void BM_StartupToFirstShow(benchmark::State& state, bool with_dedupe) {
+  NotificationManagerPlugin* setup = new_plugin();
+  reset_preferences(setup);
+  populate_preferences(setup, state.range(0));
+  g_object_unref(setup);
+
+  gint64 preferences_load_us = 0;
+  int64_t iteration = 0;
+  for (auto _ : state) {
+    // A fresh duplicate key every iteration, so every one takes the same
+    // path.
+    state.PauseTiming();
+    g_autoptr(FlValue) args = make_show_args(
+        "bench_show", with_dedupe ? make_id("bench_startup_", iteration++).c_str() : nullptr);
+    state.ResumeTiming();
+    NotificationManagerPlugin* plugin = new_plugin();
+    g_autoptr(FlMethodResponse) response =
+        notification_manager_plugin_dispatch(plugin, "showNotification", args);
+    benchmark::DoNotOptimize(response);
+
+    state.PauseTiming();
+    preferences_load_us +=
+        notification_manager_plugin_get_startup_costs(plugin).preferences_load_us;
+    g_object_unref(plugin);
+    state.ResumeTiming();
+  }
+  state.counters["preferences_load_us"] = benchmark::Counter(
+      static_cast<double>(preferences_load_us), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_StartupToFirstShow, plain, false)->RangeMultiplier(10)->Range(1, 10000);
+BENCHMARK_CAPTURE(BM_StartupToFirstShow, dedupe, true)->RangeMultiplier(10)->Range(1, 10000);
+
+// Mirrors the arguments of showNotification, to compare per-key lookups
+// against a single schema pass over the same map.
+struct BenchShowArgs {
+  std::string id;
+  std::string title;
+  std::string body;
+  FlValue* actions = nullptr;
+  std::string duplicate_key;
+  int64_t duplicate_window = 300;
+};
+
+static void BM_ShowArgsLookup(benchmark::State& state) {
+  g_autoptr(FlValue) args = make_show_args("bench_show", "bench_key");
+  for (auto _ : state) {
+    BenchShowArgs decoded;
+    FlValue* value = fl_value_lookup_string(args, "id");
+    if (value && fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+      decoded.id = fl_value_get_string(value);
+    }
+    value = fl_value_lookup_string(args, "title");
+    if (value && fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+      decoded.title = fl_value_get_string(value);
+    }
+    value = fl_value_lookup_string(args, "body");
+    if (value && fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+      decoded.body = fl_value_get_string(value);
+    }
+    value = fl_value_lookup_string(args, "actions");
+    if (value && fl_value_get_type(value) == FL_VALUE_TYPE_LIST) {
+      decoded.actions = value;
+    }
+    value = fl_value_lookup_string(args, "duplicateKey");
+    if (value && fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+      decoded.duplicate_key = fl_value_get_string(value);
+    }
+    value = fl_value_lookup_string(args, "duplicateWindow");
+    if (value && fl_value_get_type(value) == FL_VALUE_TYPE_INT) {
+      decoded.duplicate_window = fl_value_get_int(value);
+    }
+    benchmark::DoNotOptimize(decoded);
+  }
+}
+BENCHMARK(BM_ShowArgsLookup);
+
+static void BM_ShowArgsDecode(benchmark::State& state) {
+  static const ArgSchema<BenchShowArgs> schema = {
+      ArgSchema<BenchShowArgs>::Required("id", &BenchShowArgs::id),
+      ArgSchema<BenchShowArgs>::Required("title", &BenchShowArgs::title),
+      ArgSchema<BenchShowArgs>::Required("body", &BenchShowArgs::body),
+      ArgSchema<BenchShowArgs>::Optional("actions", &BenchShowArgs::actions,
+                                         FL_VALUE_TYPE_LIST),
+      ArgSchema<BenchShowArgs>::Optional("duplicateKey", &BenchShowArgs::duplicate_key),
+      ArgSchema<BenchShowArgs>::Optional("duplicateWindow", &BenchShowArgs::duplicate_window),
+  };
+
+  g_autoptr(FlValue) args = make_show_args("bench_show", "bench_key");
+  for (auto _ : state) {
+    BenchShowArgs decoded;
+    ArgError error;
+    bool ok = schema.Decode(args, &decoded, &error);
+    benchmark::DoNotOptimize(ok);
+    benchmark::DoNotOptimize(decoded);
+  }
+}
+BENCHMARK(BM_ShowArgsDecode);
+
+static void BM_DispatchLookup(benchmark::State& state, const char* method) {
+  NotificationManagerPlugin* plugin = new_plugin();
+
+  for (auto _ : state) {
+    g_autoptr(FlMethodResponse) response =
+        notification_manager_plugin_dispatch(plugin, method, nullptr);
+    benchmark::DoNotOptimize(response);
+  }
+  g_object_unref(plugin);
+}
+BENCHMARK_CAPTURE(BM_DispatchLookup, first, "areNotificationsEnabled");
+BENCHMARK_CAPTURE(BM_DispatchLookup, last, "updateScheduledNotification");
+BENCHMARK_CAPTURE(BM_DispatchLookup, unknown, "notAMethod");
+
+}  // namespace bench
+}  // namespace notification_manager
+
+int main(int argc, char** argv) {
+  // Keep benchmark state out of the real user's data directory.
+  g_autofree gchar* home = g_dir_make_tmp("notification_manager_bench_XXXXXX", nullptr);
+  if (home) {
+    g_setenv("HOME", home, TRUE);
+    g_setenv("XDG_DATA_HOME", home, TRUE);
+  }
+
+  // Default to JSON output so results can be compared between releases.
+  std::vector<char*> args(argv, argv + argc);
+  bool has_out = false;
+  for (char* arg : args) {
+    if (g_str_has_prefix(arg, "--benchmark_out=")) has_out = true;
+  }
+  char out_flag[] = "--benchmark_out=notification_manager_bench.json";
+  char format_flag[] = "--benchmark_out_format=json";
+  if (!has_out) {
+    args.push_back(out_flag);
+    args.push_back(format_flag);
+  }
+
+  int count = static_cast<int>(args.size());
+  benchmark::Initialize(&count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+    if (home) notification_manager::test::RemoveTree(home);
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  if (home) notification_manager::test::RemoveTree(home);
+  return 0;
+}
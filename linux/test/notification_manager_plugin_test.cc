@@ -2,6 +2,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+
 #include "include/notification_manager/notification_manager_plugin.h"
 #include "notification_manager_plugin_private.h"
 
@@ -27,5 +29,24 @@ TEST(NotificationManagerPlugin, GetPlatformVersion) {
   EXPECT_THAT(fl_value_get_string(result), testing::StartsWith("Linux "));
 }
 
+TEST(NotificationManagerPlugin, DispatchCountsPerMethod) {
+  NotificationManagerPlugin* plugin = static_cast<NotificationManagerPlugin*>(
+      g_object_new(notification_manager_plugin_get_type(), nullptr));
+  notification_manager_plugin_set_backend(plugin, std::make_unique<NullBackend>());
+
+  for (int i = 0; i < 3; i++) {
+    g_autoptr(FlMethodResponse) response =
+        notification_manager_plugin_dispatch(plugin, "getBadgeCount", nullptr);
+    ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(response));
+  }
+  g_autoptr(FlMethodResponse) unknown =
+      notification_manager_plugin_dispatch(plugin, "notAMethod", nullptr);
+
+  EXPECT_EQ(notification_manager_plugin_get_dispatch_count(plugin, "getBadgeCount"), 3u);
+  EXPECT_EQ(notification_manager_plugin_get_dispatch_count(plugin, "setBadgeCount"), 0u);
+  EXPECT_EQ(notification_manager_plugin_get_dispatch_count(plugin, "notAMethod"), 1u);
+  g_object_unref(plugin);
+}
+
 }  // namespace test
 }  // namespace notification_manager
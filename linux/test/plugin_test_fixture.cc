@@ -0,0 +1,108 @@
+#include "plugin_test_fixture.h"
+
+#include <memory>
+#include <utility>
+
+namespace notification_manager {
+namespace test {
+
+FlValue* make_show_args(const char* id) {
+  FlValue* args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string(id));
+  fl_value_set_string_take(args, "title", fl_value_new_string("Title"));
+  fl_value_set_string_take(args, "body", fl_value_new_string("Body"));
+
+  FlValue* actions = fl_value_new_list();
+  FlValue* action = fl_value_new_map();
+  fl_value_set_string_take(action, "id", fl_value_new_string("reply"));
+  fl_value_set_string_take(action, "title", fl_value_new_string("Reply"));
+  fl_value_append_take(actions, action);
+  fl_value_set_string_take(args, "actions", actions);
+  return args;
+}
+
+FlValue* make_schedule_args(const char* id, int64_t scheduled_date, const char* category) {
+  FlValue* args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string(id));
+  FlValue* request = fl_value_new_map();
+  fl_value_set_string_take(request, "title", fl_value_new_string("Title"));
+  if (category) {
+    fl_value_set_string_take(request, "category", fl_value_new_string(category));
+  }
+  fl_value_set_string_take(request, "body", fl_value_new_string("Body"));
+  fl_value_set_string_take(args, "request", request);
+  fl_value_set_string_take(args, "scheduledDate", fl_value_new_int(scheduled_date));
+  return args;
+}
+
+FlValue* make_id_args(const char* id) {
+  FlValue* args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string(id));
+  return args;
+}
+
+void PluginTest::SetUp() {
+  plugin_ = static_cast<NotificationManagerPlugin*>(
+      g_object_new(notification_manager_plugin_get_type(), nullptr));
+  auto backend = std::make_unique<RecordingBackend>();
+  backend_ = backend.get();
+  notification_manager_plugin_set_backend(plugin_, std::move(backend));
+}
+
+void PluginTest::TearDown() {
+  g_clear_object(&plugin_);
+}
+
+constexpr int64_t PluginTest::kVirtualStartUs;
+
+VirtualClock* PluginTest::UseVirtualClock(NotificationManagerPlugin* plugin) {
+  auto clock = std::make_unique<VirtualClock>(kVirtualStartUs);
+  VirtualClock* raw = clock.get();
+  notification_manager_plugin_set_clock(plugin ? plugin : plugin_, std::move(clock));
+  return raw;
+}
+
+void PluginTest::Show(const char* id) {
+  g_autoptr(FlValue) args = make_show_args(id);
+  g_autoptr(FlMethodResponse) response = show_notification(plugin_, args);
+}
+
+bool PluginTest::ShowWithDuplicateKey(const char* id, const char* key, int64_t window_s) {
+  g_autoptr(FlValue) args = make_show_args(id);
+  fl_value_set_string_take(args, "duplicateKey", fl_value_new_string(key));
+  fl_value_set_string_take(args, "duplicateWindow", fl_value_new_int(window_s));
+  g_autoptr(FlMethodResponse) response = show_notification(plugin_, args);
+  FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response));
+  return fl_value_get_bool(result);
+}
+
+void PluginTest::Cancel(const char* id) {
+  g_autoptr(FlValue) args = make_id_args(id);
+  g_autoptr(FlMethodResponse) response = cancel_notification(plugin_, args);
+}
+
+bool PluginTest::RunMainLoopUntil(const std::function<bool()>& condition, int timeout_ms) {
+  // A timer wakes the blocking iteration, so a condition that never comes
+  // true fails the test rather than hanging it.
+  bool expired = false;
+  guint timeout = g_timeout_add(
+      static_cast<guint>(timeout_ms),
+      [](gpointer user_data) -> gboolean {
+        *static_cast<bool*>(user_data) = true;
+        return G_SOURCE_REMOVE;
+      },
+      &expired);
+  while (!condition() && !expired) g_main_context_iteration(nullptr, TRUE);
+  if (!expired) g_source_remove(timeout);
+  return condition();
+}
+
+bool PluginTest::WaitUntilPersisted(NotificationManagerPlugin* plugin) {
+  // Shared, as the callback may still come after a timeout.
+  auto persisted = std::make_shared<bool>(false);
+  notification_manager_plugin_when_persisted(plugin, [persisted]() { *persisted = true; });
+  return RunMainLoopUntil([persisted]() { return *persisted; });
+}
+
+}  // namespace test
+}  // namespace notification_manager
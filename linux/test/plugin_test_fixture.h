@@ -0,0 +1,70 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_PLUGIN_TEST_FIXTURE_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_PLUGIN_TEST_FIXTURE_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <functional>
+
+#include "clock.h"
+#include "include/notification_manager/notification_manager_plugin.h"
+#include "notification_backend.h"
+#include "notification_manager_plugin_private.h"
+#include "test_data_dir.h"
+
+namespace notification_manager {
+namespace test {
+
+// Arguments for showNotification: a title, a body and one "reply" action.
+FlValue* make_show_args(const char* id);
+
+// Arguments for scheduleNotification, firing at |scheduled_date| (ms).
+FlValue* make_schedule_args(const char* id, int64_t scheduled_date,
+                            const char* category = nullptr);
+
+FlValue* make_id_args(const char* id);
+
+// Drives a plugin through its method handlers, with a RecordingBackend in
+// place of the daemon, in an empty data directory of its own.
+//
+// The feature tests derive from this next to the unit tests of the module
+// they exercise, e.g. the duplicate tests in dedupe_table_test.cc.
+class PluginTest : public ::testing::Test {
+ protected:
+  void SetUp() override;
+  void TearDown() override;
+
+  // Where UseVirtualClock() starts the wall clock: 2023-11-14 22:13:20 UTC.
+  static constexpr int64_t kVirtualStartUs = int64_t{1700000000} * G_USEC_PER_SEC;
+
+  // Runs |plugin|, or plugin_ if not given, on a clock that starts at
+  // kVirtualStartUs and only moves when told.
+  VirtualClock* UseVirtualClock(NotificationManagerPlugin* plugin = nullptr);
+
+  void Show(const char* id);
+
+  // Returns whether the notification was shown rather than dropped as a
+  // duplicate within |window_s|.
+  bool ShowWithDuplicateKey(const char* id, const char* key, int64_t window_s);
+
+  void Cancel(const char* id);
+
+  // Blocks in the default main context until |condition| holds. Returns
+  // false if |timeout_ms| expires first.
+  static bool RunMainLoopUntil(const std::function<bool()>& condition,
+                               int timeout_ms = 5000);
+
+  // Waits until |plugin|'s scheduled notifications are on disk. Returns
+  // false if that takes longer than RunMainLoopUntil() allows.
+  static bool WaitUntilPersisted(NotificationManagerPlugin* plugin);
+
+  ScopedTestDataDir data_dir_;
+  NotificationManagerPlugin* plugin_ = nullptr;
+  RecordingBackend* backend_ = nullptr;
+};
+
+}  // namespace test
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_PLUGIN_TEST_FIXTURE_H_
@@ -0,0 +1,118 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+#include "preferences_store.h"
+
+namespace notification_manager {
+namespace test {
+
+class PreferencesStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_autofree gchar* dir = g_dir_make_tmp("notification_manager_prefs_XXXXXX", nullptr);
+    ASSERT_NE(dir, nullptr);
+    dir_ = dir;
+    path_ = dir_ + "/nested/prefs.json";
+  }
+
+  void TearDown() override {
+    g_remove(path_.c_str());
+    g_remove((path_ + ".tmp").c_str());
+    g_rmdir((dir_ + "/nested").c_str());
+    g_rmdir(dir_.c_str());
+  }
+
+  std::string dir_;
+  std::string path_;
+};
+
+TEST_F(PreferencesStoreTest, ConstructionDoesNoIo) {
+  PreferencesStore store(path_);
+
+  EXPECT_FALSE(store.loaded());
+  EXPECT_FALSE(g_file_test((dir_ + "/nested").c_str(), G_FILE_TEST_EXISTS));
+}
+
+TEST_F(PreferencesStoreTest, ValuesSurviveReload) {
+  {
+    PreferencesStore store(path_);
+    store.Set("a", "1");
+    store.Set("b", "2");
+    store.Remove("b");
+  }
+
+  PreferencesStore reloaded(path_);
+  EXPECT_EQ(reloaded.Get("a"), "1");
+  EXPECT_EQ(reloaded.Get("b"), "");
+  EXPECT_TRUE(reloaded.loaded());
+}
+
+TEST_F(PreferencesStoreTest, RemoveWithPrefixLeavesOtherKeys) {
+  PreferencesStore store(path_);
+  store.Set("scheduled_1", "x");
+  store.Set("scheduled_2", "y");
+  store.Set("scheduler", "z");
+  store.Set("other", "w");
+
+  store.RemoveWithPrefix("scheduled_");
+
+  EXPECT_EQ(store.Get("scheduled_1"), "");
+  EXPECT_EQ(store.Get("scheduled_2"), "");
+  EXPECT_EQ(store.Get("scheduler"), "z");
+  EXPECT_EQ(store.Get("other"), "w");
+}
+
+TEST_F(PreferencesStoreTest, WritesGoThroughTheIoThread) {
+  IoThread io;
+  {
+    PreferencesStore store(path_, &io);
+    for (int i = 0; i < 100; i++) store.Set("key", std::to_string(i));
+    // Reads never wait for the disk.
+    EXPECT_EQ(store.Get("key"), "99");
+  }
+  io.Flush();
+
+  PreferencesStore reloaded(path_);
+  EXPECT_EQ(reloaded.Get("key"), "99");
+
+  PreferencesStore cleared(path_, &io);
+  cleared.Clear();
+  io.Flush();
+  EXPECT_FALSE(g_file_test(path_.c_str(), G_FILE_TEST_EXISTS));
+}
+
+TEST_F(PreferencesStoreTest, TornWriteLeavesThePreviousValues) {
+  {
+    PreferencesStore store(path_);
+    store.Set("a", "1");
+  }
+  const std::string next = "{\"a\":\"2\",\"b\":\"3\"}";
+  std::mt19937 random(7);
+  for (int i = 0; i < 20; i++) {
+    // What a crash part way through the next write leaves behind.
+    size_t offset = random() % next.size();
+    ASSERT_TRUE(g_file_set_contents((path_ + ".tmp").c_str(), next.data(), offset, nullptr));
+
+    PreferencesStore reloaded(path_);
+    EXPECT_EQ(reloaded.Get("a"), "1");
+    EXPECT_EQ(reloaded.Get("b"), "");
+  }
+}
+
+TEST_F(PreferencesStoreTest, ClearDeletesFile) {
+  PreferencesStore store(path_);
+  store.Set("a", "1");
+  ASSERT_TRUE(g_file_test(path_.c_str(), G_FILE_TEST_EXISTS));
+
+  store.Clear();
+
+  EXPECT_FALSE(g_file_test(path_.c_str(), G_FILE_TEST_EXISTS));
+  EXPECT_EQ(store.Get("a"), "");
+}
+
+}  // namespace test
+}  // namespace notification_manager
@@ -0,0 +1,129 @@
+#include <glib.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "recurrence_rule.h"
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+RecurrenceRule parse(const std::string& spec) {
+  RecurrenceRule rule;
+  std::string error;
+  EXPECT_TRUE(RecurrenceRule::Parse(spec, &rule, &error)) << spec << ": " << error;
+  return rule;
+}
+
+// Milliseconds since the epoch of the given wall time in |tz|.
+int64_t at(GTimeZone* tz, int year, int month, int day, int hour, int minute) {
+  g_autoptr(GDateTime) time = g_date_time_new(tz, year, month, day, hour, minute, 0);
+  return g_date_time_to_unix(time) * 1000;
+}
+
+// "YYYY-MM-DD HH:MM" of |ms| in |tz|.
+std::string format(GTimeZone* tz, int64_t ms) {
+  g_autoptr(GDateTime) utc = g_date_time_new_from_unix_utc(ms / 1000);
+  g_autoptr(GDateTime) local = g_date_time_to_timezone(utc, tz);
+  g_autofree gchar* text = g_date_time_format(local, "%Y-%m-%d %H:%M");
+  return text;
+}
+
+}  // namespace
+
+class RecurrenceRuleTest : public ::testing::Test {
+ protected:
+  void SetUp() override { utc_ = g_time_zone_new_utc(); }
+  void TearDown() override { g_time_zone_unref(utc_); }
+
+  GTimeZone* utc_ = nullptr;
+};
+
+TEST_F(RecurrenceRuleTest, RejectsMalformedRules) {
+  const char* const invalid[] = {
+      "",           "* * * *",     "* * * * * *",   "60 * * * *",  "* 24 * * *",
+      "* * 0 * *",  "* * * 13 *",  "* * * * 8",     "5-1 * * * *", "*/0 * * * *",
+      "* * * FOO *", "* * 1#2 * *", "* * * * MON#6", "@fortnightly",
+  };
+  for (const char* spec : invalid) {
+    RecurrenceRule rule;
+    std::string error;
+    EXPECT_FALSE(RecurrenceRule::Parse(spec, &rule, &error)) << spec;
+    EXPECT_FALSE(error.empty()) << spec;
+  }
+}
+
+TEST_F(RecurrenceRuleTest, WeekdaysAtNine) {
+  RecurrenceRule rule = parse("0 9 * * MON-FRI");
+  // Friday 2024-01-05 at 10:00 rolls over the weekend.
+  int64_t next = rule.NextAfter(at(utc_, 2024, 1, 5, 10, 0), utc_);
+  EXPECT_EQ(format(utc_, next), "2024-01-08 09:00");
+  EXPECT_EQ(format(utc_, rule.NextAfter(next, utc_)), "2024-01-09 09:00");
+}
+
+TEST_F(RecurrenceRuleTest, IsStrictlyAfter) {
+  RecurrenceRule rule = parse("*/15 * * * *");
+  int64_t quarter = at(utc_, 2024, 1, 1, 10, 15);
+  EXPECT_EQ(rule.NextAfter(quarter - 1, utc_), quarter);
+  EXPECT_EQ(format(utc_, rule.NextAfter(quarter, utc_)), "2024-01-01 10:30");
+}
+
+TEST_F(RecurrenceRuleTest, NthWeekdayOfMonth) {
+  RecurrenceRule rule = parse("0 9 * * MON#1");
+  int64_t next = rule.NextAfter(at(utc_, 2024, 1, 1, 10, 0), utc_);
+  EXPECT_EQ(format(utc_, next), "2024-02-05 09:00");
+  EXPECT_EQ(format(utc_, rule.NextAfter(next, utc_)), "2024-03-04 09:00");
+}
+
+TEST_F(RecurrenceRuleTest, EitherDayFieldMatches) {
+  // The 13th, or any Friday.
+  RecurrenceRule rule = parse("0 0 13 * 5");
+  int64_t next = rule.NextAfter(at(utc_, 2024, 9, 7, 0, 0), utc_);
+  EXPECT_EQ(format(utc_, next), "2024-09-13 00:00");
+  EXPECT_EQ(format(utc_, rule.NextAfter(next, utc_)), "2024-09-20 00:00");
+}
+
+TEST_F(RecurrenceRuleTest, ShorthandsAndSundayAsSeven) {
+  int64_t start = at(utc_, 2024, 1, 3, 12, 0);  // A Wednesday.
+  EXPECT_EQ(format(utc_, parse("@weekly").NextAfter(start, utc_)), "2024-01-07 00:00");
+  EXPECT_EQ(format(utc_, parse("0 0 * * 7").NextAfter(start, utc_)), "2024-01-07 00:00");
+  EXPECT_EQ(format(utc_, parse("@yearly").NextAfter(start, utc_)), "2025-01-01 00:00");
+}
+
+TEST_F(RecurrenceRuleTest, LeapDay) {
+  RecurrenceRule rule = parse("0 0 29 2 *");
+  EXPECT_EQ(format(utc_, rule.NextAfter(at(utc_, 2024, 3, 1, 0, 0), utc_)), "2028-02-29 00:00");
+}
+
+TEST_F(RecurrenceRuleTest, ImpossibleDateNeverMatches) {
+  RecurrenceRule rule = parse("0 0 30 2 *");
+  EXPECT_EQ(rule.NextAfter(at(utc_, 2024, 1, 1, 0, 0), utc_), 0);
+}
+
+TEST_F(RecurrenceRuleTest, FollowsDaylightSavingTime) {
+  g_autoptr(GTimeZone) new_york = g_time_zone_new_identifier("America/New_York");
+  if (new_york == nullptr) GTEST_SKIP() << "No tzdata for America/New_York";
+
+  // Nine o'clock local stays nine o'clock across the spring change.
+  RecurrenceRule daily = parse("0 9 * * *");
+  int64_t before = daily.NextAfter(at(new_york, 2024, 3, 9, 0, 0), new_york);
+  int64_t after = daily.NextAfter(before, new_york);
+  EXPECT_EQ(format(new_york, after), "2024-03-10 09:00");
+  EXPECT_EQ(after - before, 23 * 3600 * 1000);
+
+  // 02:30 does not exist on 2024-03-10; it fires when the gap ends.
+  RecurrenceRule in_gap = parse("30 2 * * *");
+  int64_t skipped = in_gap.NextAfter(at(new_york, 2024, 3, 10, 0, 0), new_york);
+  EXPECT_EQ(format(new_york, skipped), "2024-03-10 03:00");
+
+  // 01:30 happens twice on 2024-11-03; it fires once, in standard time.
+  RecurrenceRule repeated = parse("30 1 * * *");
+  int64_t twice = repeated.NextAfter(at(new_york, 2024, 11, 3, 0, 0), new_york);
+  EXPECT_EQ(format(utc_, twice), "2024-11-03 06:30");
+  EXPECT_EQ(format(new_york, repeated.NextAfter(twice, new_york)), "2024-11-04 01:30");
+}
+
+}  // namespace test
+}  // namespace notification_manager
@@ -0,0 +1,205 @@
+#include <flutter_linux/flutter_linux.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "plugin_test_fixture.h"
+#include "scheduled_ndjson.h"
+#include "scheduled_store.h"
+
+namespace notification_manager {
+namespace test {
+
+class ScheduledNdjsonTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_autofree gchar* dir = g_dir_make_tmp("notification_manager_ndjson_XXXXXX", nullptr);
+    ASSERT_NE(dir, nullptr);
+    dir_ = dir;
+    path_ = dir_ + "/scheduled.ndjson";
+  }
+
+  void TearDown() override {
+    g_remove(path_.c_str());
+    g_rmdir(dir_.c_str());
+  }
+
+  std::string Contents() {
+    gchar* contents = nullptr;
+    gsize length = 0;
+    if (!g_file_get_contents(path_.c_str(), &contents, &length, nullptr)) return "";
+    std::string result(contents, length);
+    g_free(contents);
+    return result;
+  }
+
+  std::string dir_;
+  std::string path_;
+};
+
+TEST_F(ScheduledNdjsonTest, AppendJsonEscapesAndKeepsTypes) {
+  g_autoptr(FlValue) value = fl_value_new_map();
+  fl_value_set_string_take(value, "text", fl_value_new_string("say \"hi\"\n\\\x01"));
+  fl_value_set_string_take(value, "count", fl_value_new_int(-3));
+  fl_value_set_string_take(value, "whole", fl_value_new_float(2.0));
+  fl_value_set_string_take(value, "broken", fl_value_new_float(NAN));
+  FlValue* list = fl_value_new_list();
+  fl_value_append_take(list, fl_value_new_bool(true));
+  fl_value_append_take(list, fl_value_new_null());
+  fl_value_set_string_take(value, "list", list);
+  fl_value_set_take(value, fl_value_new_int(7), fl_value_new_string("dropped"));
+
+  std::string json;
+  AppendJson(value, &json);
+  EXPECT_EQ(json,
+            "{\"text\":\"say \\\"hi\\\"\\n\\\\\\u0001\",\"count\":-3,\"whole\":2.0,"
+            "\"broken\":null,\"list\":[true,null]}");
+}
+
+TEST_F(ScheduledNdjsonTest, AppendJsonReplacesInvalidUtf8) {
+  g_autoptr(FlValue) value = fl_value_new_map();
+  fl_value_set_string_take(value, "caf\xe9", fl_value_new_string("\xff ok \xc3\xa9"));
+
+  std::string json;
+  AppendJson(value, &json);
+  EXPECT_EQ(json, "{\"caf\xef\xbf\xbd\":\"\xef\xbf\xbd ok \xc3\xa9\"}");
+  EXPECT_TRUE(g_utf8_validate(json.c_str(), -1, nullptr));
+}
+
+TEST_F(ScheduledNdjsonTest, LinesMatchTheDartShape) {
+  ScheduledStore store;
+  ScheduledRequest request;
+  request.id = "a";
+  request.title = "Title";
+  request.body = "Body";
+  request.fire_at_ms = 1000;
+  request.repeat_interval_s = 60;
+  store.Put(request);
+
+  std::string lines;
+  store.ForEach([&](const ScheduledStore::Record& record) {
+    AppendScheduledJsonLine(store, record, &lines);
+  });
+  EXPECT_EQ(lines,
+            "{\"id\":\"a\",\"request\":{\"id\":\"a\",\"title\":\"Title\",\"body\":\"Body\"},"
+            "\"scheduledDate\":1000,\"isRepeating\":true,\"repeatInterval\":60}\n");
+}
+
+TEST_F(ScheduledNdjsonTest, WriterReplacesTheFileOnCommit) {
+  ASSERT_TRUE(g_file_set_contents(path_.c_str(), "old\n", -1, nullptr));
+  NdjsonWriter writer;
+  std::string error;
+  ASSERT_TRUE(writer.Open(path_, &error)) << error;
+  ASSERT_TRUE(writer.Append("{\"id\":\"a\"}\n", &error));
+  ASSERT_TRUE(writer.Append("{\"id\":\"b\"}\n", &error));
+  EXPECT_EQ(Contents(), "old\n");
+
+  ASSERT_TRUE(writer.Commit(&error)) << error;
+  EXPECT_EQ(Contents(), "{\"id\":\"a\"}\n{\"id\":\"b\"}\n");
+}
+
+TEST_F(ScheduledNdjsonTest, AbandonedWriterLeavesNothingBehind) {
+  {
+    NdjsonWriter writer;
+    std::string error;
+    ASSERT_TRUE(writer.Open(path_, &error));
+    ASSERT_TRUE(writer.Append("{\"id\":\"a\"}\n", &error));
+  }
+  EXPECT_FALSE(g_file_test(path_.c_str(), G_FILE_TEST_EXISTS));
+  EXPECT_FALSE(g_file_test((path_ + ".tmp").c_str(), G_FILE_TEST_EXISTS));
+}
+
+TEST_F(ScheduledNdjsonTest, ReaderParsesInChunks) {
+  ASSERT_TRUE(g_file_set_contents(path_.c_str(),
+                                  "{\"id\":\"a\",\"n\":1}\n"
+                                  "\n"
+                                  "not json\n"
+                                  "[1,2]\r\n"
+                                  "{\"id\":\"b\",\"nested\":{\"x\":[1.5]}}\r\n"
+                                  "{\"id\":\"c\"}",
+                                  -1, nullptr));
+  NdjsonReader reader;
+  std::string error;
+  ASSERT_TRUE(reader.Open(path_, &error)) << error;
+
+  std::vector<FlValue*> values;
+  size_t invalid = 0;
+  ASSERT_TRUE(reader.ReadChunk(3, &values, &invalid, &error));
+  EXPECT_FALSE(reader.at_end());
+  ASSERT_EQ(values.size(), 1u);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(values[0], "n")), 1);
+  EXPECT_EQ(invalid, 1u);
+
+  while (!reader.at_end()) ASSERT_TRUE(reader.ReadChunk(3, &values, &invalid, &error));
+  ASSERT_EQ(values.size(), 3u);
+  EXPECT_EQ(invalid, 2u);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(values[2], "id")), "c");
+  FlValue* nested = fl_value_lookup_string(values[1], "nested");
+  EXPECT_EQ(fl_value_get_float(fl_value_get_list_value(fl_value_lookup_string(nested, "x"), 0)),
+            1.5);
+  for (FlValue* value : values) fl_value_unref(value);
+}
+
+TEST_F(ScheduledNdjsonTest, MissingFileFailsToOpen) {
+  NdjsonReader reader;
+  std::string error;
+  EXPECT_FALSE(reader.Open(path_, &error));
+  EXPECT_FALSE(error.empty());
+}
+
+// exportScheduledNotifications and importScheduledNotifications.
+using ScheduledTransferTest = PluginTest;
+
+TEST_F(ScheduledTransferTest, ExportedScheduleImportsBack) {
+  int64_t later_ms = UseVirtualClock()->RealTimeUs() / 1000 + 3600 * 1000;
+  for (int i = 0; i < 5; i++) {
+    std::string id = "exported_" + std::to_string(i);
+    g_autoptr(FlValue) args = make_schedule_args(id.c_str(), later_ms + i, "reminders");
+    g_autoptr(FlMethodResponse) response = schedule_notification(plugin_, args);
+  }
+  auto run = [this](FlMethodResponse* (*method)(NotificationManagerPlugin*, FlValue*),
+                    const std::string& path) {
+    g_autoptr(FlValue) args = fl_value_new_map();
+    fl_value_set_string_take(args, "path", fl_value_new_string(path.c_str()));
+    fl_value_set_string_take(args, "chunkSize", fl_value_new_int(2));
+    g_autoptr(FlMethodResponse) response = method(plugin_, args);
+    ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(response));
+    ASSERT_TRUE(RunMainLoopUntil(
+        [this]() { return notification_manager_plugin_get_transfers_in_progress(plugin_) == 0; }));
+  };
+
+  g_autofree gchar* dir = g_dir_make_tmp("notification_manager_export_XXXXXX", nullptr);
+  std::string path = std::string(dir) + "/scheduled.ndjson";
+  run(export_scheduled_notifications, path);
+  gchar* contents = nullptr;
+  ASSERT_TRUE(g_file_get_contents(path.c_str(), &contents, nullptr, nullptr));
+  std::string exported = contents;
+  g_free(contents);
+  EXPECT_EQ(std::count(exported.begin(), exported.end(), '\n'), 5);
+
+  // Lines that are not scheduled notifications are skipped.
+  exported += "{\"id\":\"no_request\"}\nnot json\n";
+  ASSERT_TRUE(g_file_set_contents(path.c_str(), exported.c_str(), -1, nullptr));
+  g_autoptr(FlMethodResponse) cancel = cancel_all_scheduled_notifications(plugin_, nullptr);
+  run(import_scheduled_notifications, path);
+  g_autoptr(FlMethodResponse) listed = get_scheduled_notifications(plugin_, nullptr);
+  FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(listed));
+  ASSERT_EQ(fl_value_get_length(result), 5u);
+  FlValue* first = fl_value_get_list_value(result, 0);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(first, "id")), "exported_0");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(first, "scheduledDate")), later_ms);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(
+                   fl_value_lookup_string(first, "request"), "category")),
+               "reminders");
+
+  g_remove(path.c_str());
+  g_rmdir(dir);
+}
+
+}  // namespace test
+}  // namespace notification_manager
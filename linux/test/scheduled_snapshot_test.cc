@@ -0,0 +1,499 @@
+#include <flutter_linux/flutter_linux.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "plugin_test_fixture.h"
+#include "preferences_store.h"
+#include "scheduled_snapshot.h"
+#include "scheduled_store.h"
+
+namespace notification_manager {
+namespace test {
+
+class ScheduledSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_autofree gchar* dir = g_dir_make_tmp("notification_manager_snapshot_XXXXXX", nullptr);
+    ASSERT_NE(dir, nullptr);
+    dir_ = dir;
+    path_ = dir_ + "/scheduled.bin";
+  }
+
+  void TearDown() override {
+    g_remove(path_.c_str());
+    g_rmdir(dir_.c_str());
+  }
+
+  static ScheduledRequest MakeRequest(const std::string& id, int64_t fire_at_ms) {
+    ScheduledRequest request;
+    request.id = id;
+    request.title = "Title " + id;
+    request.body = "Body";
+    request.fire_at_ms = fire_at_ms;
+    return request;
+  }
+
+  std::string dir_;
+  std::string path_;
+};
+
+TEST_F(ScheduledSnapshotTest, RoundTrip) {
+  ScheduledStore store;
+  store.Put(MakeRequest("a", 1000));
+  ScheduledRequest repeating = MakeRequest("b", 2000);
+  repeating.repeat_interval_s = 60;
+  repeating.actions.emplace_back("ok", "OK");
+  g_autoptr(FlValue) payload = fl_value_new_map();
+  fl_value_set_string_take(payload, "route", fl_value_new_string("/details"));
+  repeating.payload = payload;
+  store.Put(repeating);
+  ScheduledRequest recurring = MakeRequest("c", 3000);
+  recurring.recurrence = "0 9 * * MON-FRI";
+  recurring.category = "standup";
+  recurring.group = "team";
+  store.Put(recurring);
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, store));
+
+  ScheduledStore read;
+  ASSERT_TRUE(ReadScheduledSnapshot(path_, &read));
+  ASSERT_EQ(read.size(), 3u);
+  ScheduledStore::Record a, b, c;
+  ASSERT_TRUE(read.Find("a", &a));
+  EXPECT_EQ(read.GetString(a.title), "Title a");
+  EXPECT_EQ(a.fire_at_ms, 1000);
+  ASSERT_TRUE(read.Find("b", &b));
+  EXPECT_EQ(b.repeat_interval_s, 60);
+  ASSERT_EQ(read.ActionsOf(b).size(), 1u);
+  EXPECT_EQ(read.ActionsOf(b)[0].second, "OK");
+  ASSERT_NE(b.payload, nullptr);
+  EXPECT_TRUE(fl_value_equal(b.payload, payload));
+  ASSERT_TRUE(read.Find("c", &c));
+  EXPECT_EQ(read.GetString(c.recurrence), "0 9 * * MON-FRI");
+  EXPECT_EQ(read.GetString(c.category), "standup");
+  EXPECT_EQ(read.GetString(c.group), "team");
+
+  ScheduledStore::Record written;
+  ASSERT_TRUE(store.Find("a", &written));
+  EXPECT_NE(written.revision, 0u);
+  EXPECT_EQ(a.revision, written.revision);
+}
+
+TEST_F(ScheduledSnapshotTest, MissingFileReadsNothing) {
+  ScheduledStore read;
+  EXPECT_FALSE(ReadScheduledSnapshot(path_, &read));
+  EXPECT_EQ(read.size(), 0u);
+}
+
+TEST_F(ScheduledSnapshotTest, TruncatedFileIsRejected) {
+  ScheduledStore store;
+  store.Put(MakeRequest("a", 1000));
+  store.Put(MakeRequest("b", 2000));
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, store));
+
+  gchar* contents = nullptr;
+  gsize length = 0;
+  ASSERT_TRUE(g_file_get_contents(path_.c_str(), &contents, &length, nullptr));
+  ASSERT_TRUE(g_file_set_contents(path_.c_str(), contents, length - 3, nullptr));
+  g_free(contents);
+
+  ScheduledStore read;
+  EXPECT_FALSE(ReadScheduledSnapshot(path_, &read));
+  EXPECT_EQ(read.size(), 0u);
+}
+
+TEST_F(ScheduledSnapshotTest, EveryTruncationIsRejected) {
+  ScheduledStore store;
+  ScheduledRequest request = MakeRequest("a", 1000);
+  request.actions.emplace_back("ok", "OK");
+  store.Put(request);
+  store.Put(MakeRequest("b", 2000));
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, store));
+
+  gchar* contents = nullptr;
+  gsize length = 0;
+  ASSERT_TRUE(g_file_get_contents(path_.c_str(), &contents, &length, nullptr));
+  for (gsize offset = 0; offset < length; offset++) {
+    ASSERT_TRUE(g_file_set_contents(path_.c_str(), contents, offset, nullptr));
+    ScheduledStore read;
+    EXPECT_FALSE(ReadScheduledSnapshot(path_, &read)) << "offset " << offset;
+    EXPECT_EQ(read.size(), 0u);
+  }
+  g_free(contents);
+}
+
+TEST_F(ScheduledSnapshotTest, ReadsJsonRequestSnapshots) {
+  // A version 1 snapshot holding one entry whose request is JSON.
+  std::string id = "old";
+  std::string json = "{\"title\":\"Old\",\"body\":\"Body\"}";
+  std::string contents("NMSS", 4);
+  auto append = [&](const void* data, size_t size) {
+    contents.append(static_cast<const char*>(data), size);
+  };
+  uint32_t version = 1;
+  uint64_t count = 1;
+  int64_t fire_at_ms = 5000;
+  int64_t repeat_interval_s = 0;
+  uint32_t id_length = id.size();
+  uint32_t json_length = json.size();
+  append(&version, sizeof(version));
+  append(&count, sizeof(count));
+  append(&fire_at_ms, sizeof(fire_at_ms));
+  append(&repeat_interval_s, sizeof(repeat_interval_s));
+  append(&id_length, sizeof(id_length));
+  append(&json_length, sizeof(json_length));
+  contents += id + json;
+  ASSERT_TRUE(g_file_set_contents(path_.c_str(), contents.data(), contents.size(), nullptr));
+
+  ScheduledStore read;
+  ASSERT_TRUE(ReadScheduledSnapshot(path_, &read));
+  ScheduledStore::Record record;
+  ASSERT_TRUE(read.Find("old", &record));
+  EXPECT_EQ(read.GetString(record.title), "Old");
+  EXPECT_EQ(record.fire_at_ms, 5000);
+}
+
+TEST_F(ScheduledSnapshotTest, ReadsSnapshotsWithoutGroups) {
+  // A version 5 snapshot, whose records end their strings at the
+  // recurrence rule.
+  std::string record;
+  auto append = [](std::string* buffer, const void* data, size_t size) {
+    buffer->append(static_cast<const char*>(data), size);
+  };
+  auto append_string = [&](const std::string& value) {
+    uint32_t length = value.size();
+    append(&record, &length, sizeof(length));
+    record += value;
+  };
+  uint64_t revision = 7;
+  int64_t fields[] = {5000, 0, 0, -1};  // fire_at_ms, repeat, timeout, badge
+  uint32_t counts[] = {0, 0};           // actions, payload length
+  append(&record, &revision, sizeof(revision));
+  append(&record, fields, sizeof(fields));
+  append(&record, counts, sizeof(counts));
+  for (const char* value : {"old", "Old", "Body", "news", ""}) append_string(value);
+
+  std::string contents("NMSS", 4);
+  uint32_t version = 5;
+  uint64_t count = 1;
+  uint64_t writer = 0;
+  uint32_t record_length = record.size();
+  append(&contents, &version, sizeof(version));
+  append(&contents, &count, sizeof(count));
+  append(&contents, &writer, sizeof(writer));
+  append(&contents, &record_length, sizeof(record_length));
+  contents += record;
+  ASSERT_TRUE(g_file_set_contents(path_.c_str(), contents.data(), contents.size(), nullptr));
+
+  ScheduledStore read;
+  ASSERT_TRUE(ReadScheduledSnapshot(path_, &read));
+  ScheduledStore::Record old;
+  ASSERT_TRUE(read.Find("old", &old));
+  EXPECT_EQ(read.GetString(old.category), "news");
+  EXPECT_EQ(old.group.length, 0u);
+  EXPECT_EQ(old.revision, 7u);
+}
+
+TEST_F(ScheduledSnapshotTest, ReloadDecodesOnlyChangedRecords) {
+  ScheduledStore writer;
+  for (int i = 0; i < 100; i++) writer.Put(MakeRequest("id" + std::to_string(i), 1000 + i));
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, writer, 1));
+  ScheduledStore reader;
+  ASSERT_TRUE(ReadScheduledSnapshot(path_, &reader));
+
+  writer.SetFireTime("id5", 9000);
+  writer.Remove("id7");
+  writer.Put(MakeRequest("new", 2000));
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, writer, 1));
+
+  SnapshotReload reload;
+  ASSERT_TRUE(ReloadScheduledSnapshot(path_, 2, {}, &reader, &reload));
+  EXPECT_FALSE(reload.own_write);
+  EXPECT_EQ(reload.decoded, 2u);
+  EXPECT_EQ(reload.upserted, (std::vector<std::string>{"id5", "new"}));
+  EXPECT_EQ(reload.removed, std::vector<std::string>{"id7"});
+  EXPECT_EQ(reader.size(), 100u);
+  ScheduledStore::Record record;
+  ASSERT_TRUE(reader.Find("id5", &record));
+  EXPECT_EQ(record.fire_at_ms, 9000);
+  EXPECT_FALSE(reader.Contains("id7"));
+
+  // Nothing changed since, so nothing is decoded.
+  ASSERT_TRUE(ReloadScheduledSnapshot(path_, 2, {}, &reader, &reload));
+  EXPECT_EQ(reload.decoded, 0u);
+  EXPECT_TRUE(reload.upserted.empty());
+  EXPECT_TRUE(reload.removed.empty());
+}
+
+TEST_F(ScheduledSnapshotTest, ReloadLeavesLocalChangesAlone) {
+  ScheduledStore writer;
+  writer.Put(MakeRequest("shared", 1000));
+  writer.Put(MakeRequest("theirs", 2000));
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, writer, 1));
+
+  ScheduledStore reader;
+  reader.Put(MakeRequest("shared", 5000));
+  reader.Put(MakeRequest("mine", 3000));
+  SnapshotReload reload;
+  ASSERT_TRUE(ReloadScheduledSnapshot(path_, 2, {"shared", "mine"}, &reader, &reload));
+
+  EXPECT_EQ(reload.upserted, std::vector<std::string>{"theirs"});
+  EXPECT_TRUE(reload.removed.empty());
+  ScheduledStore::Record record;
+  ASSERT_TRUE(reader.Find("shared", &record));
+  EXPECT_EQ(record.fire_at_ms, 5000);
+  EXPECT_TRUE(reader.Contains("mine"));
+}
+
+TEST_F(ScheduledSnapshotTest, ReloadSkipsOwnWrites) {
+  ScheduledStore writer;
+  writer.Put(MakeRequest("a", 1000));
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, writer, 7));
+
+  ScheduledStore reader;
+  SnapshotReload reload;
+  ASSERT_TRUE(ReloadScheduledSnapshot(path_, 7, {}, &reader, &reload));
+  EXPECT_TRUE(reload.own_write);
+  EXPECT_EQ(reader.size(), 0u);
+}
+
+TEST_F(ScheduledSnapshotTest, TruncatedReloadChangesNothing) {
+  ScheduledStore writer;
+  writer.Put(MakeRequest("a", 1000));
+  writer.Put(MakeRequest("b", 2000));
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, writer, 1));
+
+  gchar* contents = nullptr;
+  gsize length = 0;
+  ASSERT_TRUE(g_file_get_contents(path_.c_str(), &contents, &length, nullptr));
+  ASSERT_TRUE(g_file_set_contents(path_.c_str(), contents, length - 3, nullptr));
+  g_free(contents);
+
+  ScheduledStore reader;
+  reader.Put(MakeRequest("c", 3000));
+  SnapshotReload reload;
+  EXPECT_FALSE(ReloadScheduledSnapshot(path_, 2, {}, &reader, &reload));
+  EXPECT_EQ(reader.size(), 1u);
+  EXPECT_TRUE(reader.Contains("c"));
+}
+
+TEST_F(ScheduledSnapshotTest, ShardsSplitTheEntries) {
+  ScheduledStore store;
+  for (int i = 0; i < 200; i++) store.Put(MakeRequest("id" + std::to_string(i), 1000 + i));
+
+  ScheduledStore read;
+  for (uint32_t shard = 0; shard < 4; shard++) {
+    ASSERT_TRUE(WriteScheduledSnapshot(path_, store, 1, SnapshotShard{shard, 4}));
+    ScheduledStore part;
+    ASSERT_TRUE(ReadScheduledSnapshot(path_, &part));
+    EXPECT_GT(part.size(), 0u);
+    EXPECT_LT(part.size(), store.size());
+    part.ForEach([&](const ScheduledStore::Record& record) {
+      EXPECT_EQ(ScheduledShardOf(part.GetString(record.id), 4), shard);
+    });
+    ASSERT_TRUE(ReadScheduledSnapshot(path_, &read));
+  }
+  EXPECT_EQ(read.size(), store.size());
+}
+
+TEST_F(ScheduledSnapshotTest, ReloadOfAShardLeavesTheOthersAlone) {
+  ScheduledStore writer;
+  for (int i = 0; i < 50; i++) writer.Put(MakeRequest("id" + std::to_string(i), 1000 + i));
+  SnapshotShard shard{0, 4};
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, writer, 1, shard));
+
+  // The reader holds every entry; only those of shard 0 are in the file.
+  ScheduledStore reader;
+  for (int i = 0; i < 50; i++) reader.Put(MakeRequest("id" + std::to_string(i), 1000 + i));
+  SnapshotReload reload;
+  ASSERT_TRUE(ReloadScheduledSnapshot(path_, 2, {}, &reader, &reload, shard));
+  EXPECT_TRUE(reload.removed.empty());
+  EXPECT_EQ(reader.size(), 50u);
+
+  // Emptying the shard removes its entries and nothing else.
+  ScheduledStore empty;
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, empty, 1, shard));
+  ASSERT_TRUE(ReloadScheduledSnapshot(path_, 2, {}, &reader, &reload, shard));
+  EXPECT_FALSE(reload.removed.empty());
+  for (const auto& id : reload.removed) EXPECT_EQ(ScheduledShardOf(id, 4), 0u);
+  EXPECT_EQ(reader.size(), 50u - reload.removed.size());
+}
+
+TEST_F(ScheduledSnapshotTest, LargeTailsAreCompressed) {
+  ScheduledStore store;
+  ScheduledRequest large = MakeRequest("large", 1000);
+  for (int i = 0; i < 40; i++) {
+    large.actions.emplace_back("action" + std::to_string(i), "Open the order details");
+  }
+  store.Put(large);
+  store.Put(MakeRequest("small", 2000));
+  std::string packed = EncodeScheduledSnapshot(store);
+  std::string raw = EncodeScheduledSnapshot(store, 0, SnapshotShard(), SIZE_MAX);
+  EXPECT_LT(packed.size(), raw.size() / 2);
+
+  ASSERT_TRUE(WriteScheduledSnapshot(path_, store));
+  ScheduledStore read;
+  ASSERT_TRUE(ReadScheduledSnapshot(path_, &read));
+  ScheduledStore::Record record;
+  ASSERT_TRUE(read.Find("large", &record));
+  EXPECT_EQ(read.ActionsOf(record), large.actions);
+  ASSERT_TRUE(read.Find("small", &record));
+  EXPECT_EQ(read.GetString(record.title), "Title small");
+}
+
+TEST_F(ScheduledSnapshotTest, SmallTailsStayRaw) {
+  ScheduledStore store;
+  ScheduledRequest request = MakeRequest("a", 1000);
+  request.actions.emplace_back("ok", "OK");
+  store.Put(request);
+  EXPECT_EQ(EncodeScheduledSnapshot(store),
+            EncodeScheduledSnapshot(store, 0, SnapshotShard(), SIZE_MAX));
+}
+
+TEST_F(ScheduledSnapshotTest, CorruptCompressedTailIsRejected) {
+  ScheduledStore store;
+  ScheduledRequest large = MakeRequest("large", 1000);
+  for (int i = 0; i < 40; i++) {
+    large.actions.emplace_back("action" + std::to_string(i), "Open the order details");
+  }
+  store.Put(large);
+  std::string contents = EncodeScheduledSnapshot(store);
+  contents[contents.size() - 8] ^= 0x55;
+  ASSERT_TRUE(g_file_set_contents(path_.c_str(), contents.data(), contents.size(), nullptr));
+
+  ScheduledStore read;
+  EXPECT_FALSE(ReadScheduledSnapshot(path_, &read));
+  EXPECT_EQ(read.size(), 0u);
+}
+
+// The plugin's restore, write and reload of its snapshot shards.
+using ScheduledPersistenceTest = PluginTest;
+
+TEST_F(ScheduledPersistenceTest, RestoreFiresEntriesThatFellDue) {
+  int64_t now_ms = UseVirtualClock()->RealTimeUs() / 1000;
+  g_autoptr(FlValue) due_args = make_schedule_args("due", now_ms + 60 * 1000);
+  g_autoptr(FlValue) later_args = make_schedule_args("later", now_ms + 3600 * 1000);
+  g_autoptr(FlMethodResponse) due = schedule_notification(plugin_, due_args);
+  g_autoptr(FlMethodResponse) later = schedule_notification(plugin_, later_args);
+  // Disposing the plugin writes the snapshot, as quitting the app would.
+  g_clear_object(&plugin_);
+
+  // Start again two minutes later, after "due" but before "later".
+  SetUp();
+  UseVirtualClock()->JumpRealTime(2 * 60 * G_USEC_PER_SEC);
+  notification_manager_plugin_restore_scheduled(plugin_);
+
+  ASSERT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 1u);
+  EXPECT_EQ(backend_->calls()[0].id, "due");
+  EXPECT_EQ(backend_->calls()[0].content.title, "Title");
+
+  g_autoptr(FlMethodResponse) response = get_scheduled_notifications(plugin_, nullptr);
+  FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response));
+  ASSERT_EQ(fl_value_get_length(result), 1u);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(fl_value_get_list_value(result, 0), "id")),
+               "later");
+}
+
+TEST_F(ScheduledPersistenceTest, WhenPersistedWaitsForTheSnapshotWrite) {
+  int64_t now_ms = UseVirtualClock()->RealTimeUs() / 1000;
+  g_autoptr(FlValue) args = make_schedule_args("persisted", now_ms + 3600 * 1000);
+  g_autoptr(FlMethodResponse) scheduled = schedule_notification(plugin_, args);
+
+  // The snapshot is written once the main loop is idle, and then only
+  // reported once the I/O thread has written it.
+  bool persisted = false;
+  notification_manager_plugin_when_persisted(plugin_, [&persisted]() { persisted = true; });
+  EXPECT_FALSE(persisted);
+  ASSERT_TRUE(RunMainLoopUntil([&persisted]() { return persisted; }));
+
+  ScheduledStore on_disk;
+  uint32_t shard = ScheduledShardOf("persisted", kScheduledShardCount);
+  ASSERT_TRUE(ReadScheduledSnapshot(ScheduledShardPath(GetDataDir() + "/scheduled", shard),
+                                    &on_disk));
+  EXPECT_TRUE(on_disk.Contains("persisted"));
+
+  // With nothing left to write, there is nothing to wait for.
+  bool idle = false;
+  notification_manager_plugin_when_persisted(plugin_, [&idle]() { idle = true; });
+  EXPECT_TRUE(idle);
+}
+
+TEST_F(ScheduledPersistenceTest, ScheduledChangesFromAnotherInstanceAreApplied) {
+  // Another instance reads the same snapshot, as another process would.
+  NotificationManagerPlugin* other = static_cast<NotificationManagerPlugin*>(
+      g_object_new(notification_manager_plugin_get_type(), nullptr));
+  notification_manager_plugin_set_backend(other, std::make_unique<RecordingBackend>());
+  UseVirtualClock(other);
+  notification_manager_plugin_restore_scheduled(other);
+  auto other_ids = [other]() {
+    g_autoptr(FlMethodResponse) response = get_scheduled_notifications(other, nullptr);
+    FlValue* result =
+        fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response));
+    std::vector<std::string> ids;
+    for (size_t i = 0; i < fl_value_get_length(result); i++) {
+      ids.push_back(
+          fl_value_get_string(fl_value_lookup_string(fl_value_get_list_value(result, i), "id")));
+    }
+    return ids;
+  };
+
+  int64_t now_ms = UseVirtualClock()->RealTimeUs() / 1000;
+  g_autoptr(FlValue) args = make_schedule_args("remote", now_ms + 3600 * 1000);
+  g_autoptr(FlMethodResponse) scheduled = schedule_notification(plugin_, args);
+  ASSERT_TRUE(WaitUntilPersisted(plugin_));
+  notification_manager_plugin_reload_scheduled(other);
+  EXPECT_EQ(other_ids(), std::vector<std::string>{"remote"});
+
+  g_autoptr(FlValue) cancel_args = make_id_args("remote");
+  g_autoptr(FlMethodResponse) cancelled = cancel_scheduled_notification(plugin_, cancel_args);
+  ASSERT_TRUE(WaitUntilPersisted(plugin_));
+  notification_manager_plugin_reload_scheduled(other);
+  EXPECT_TRUE(other_ids().empty());
+  g_object_unref(other);
+}
+
+TEST_F(ScheduledPersistenceTest, SingleSnapshotIsMovedIntoShards) {
+  // Set up the data directory as an earlier version left it: a single
+  // snapshot and no shards.
+  std::string shard_dir = GetDataDir() + "/scheduled";
+  ASSERT_FALSE(g_file_test(shard_dir.c_str(), G_FILE_TEST_EXISTS));
+  g_mkdir_with_parents(GetDataDir().c_str(), 0755);
+  std::string legacy_path = GetDataDir() + "/scheduled_notifications.bin";
+  ScheduledStore legacy;
+  int64_t now_ms = kVirtualStartUs / 1000;
+  for (int i = 0; i < 20; i++) {
+    ScheduledRequest request;
+    request.id = "legacy_" + std::to_string(i);
+    request.title = "Title";
+    request.fire_at_ms = now_ms + 3600 * 1000;
+    legacy.Put(request);
+  }
+  ASSERT_TRUE(WriteScheduledSnapshot(legacy_path, legacy));
+
+  NotificationManagerPlugin* other = static_cast<NotificationManagerPlugin*>(
+      g_object_new(notification_manager_plugin_get_type(), nullptr));
+  notification_manager_plugin_set_backend(other, std::make_unique<RecordingBackend>());
+  UseVirtualClock(other);
+  g_autoptr(FlMethodResponse) listed = get_scheduled_notifications(other, nullptr);
+  EXPECT_EQ(fl_value_get_length(
+                fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(listed))),
+            20u);
+  ASSERT_TRUE(WaitUntilPersisted(other));
+  // Disposing waits for the queued removal of the old snapshot.
+  g_object_unref(other);
+
+  EXPECT_FALSE(g_file_test(legacy_path.c_str(), G_FILE_TEST_EXISTS));
+  ScheduledStore on_disk;
+  for (uint32_t shard = 0; shard < kScheduledShardCount; shard++) {
+    ReadScheduledSnapshot(ScheduledShardPath(shard_dir, shard), &on_disk);
+  }
+  EXPECT_EQ(on_disk.size(), 20u);
+}
+
+}  // namespace test
+}  // namespace notification_manager
@@ -0,0 +1,366 @@
+#include <flutter_linux/flutter_linux.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "plugin_test_fixture.h"
+#include "scheduled_store.h"
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+ScheduledRequest make_request(const std::string& id, const std::string& title) {
+  ScheduledRequest request;
+  request.id = id;
+  request.title = title;
+  request.body = "Body";
+  request.actions.emplace_back("reply", "Reply");
+  request.fire_at_ms = 1000;
+  return request;
+}
+
+ScheduledRequest make_timed_request(const std::string& id, int64_t fire_at_ms) {
+  ScheduledRequest request = make_request(id, id);
+  request.fire_at_ms = fire_at_ms;
+  return request;
+}
+
+// Runs |store| dry the way the scheduler does, one wakeup per coalesced
+// batch, and returns the number of wakeups.
+int count_wakeups(ScheduledStore* store, int64_t slack_ms) {
+  int wakeups = 0;
+  while (int64_t wake_at_ms = store->CoalescedFireTime(slack_ms)) {
+    wakeups++;
+    std::vector<std::string> due;
+    store->ForEachByFireTime(0, wake_at_ms + 1, nullptr, SIZE_MAX,
+                             [&](const ScheduledStore::Record& record) {
+                               EXPECT_LE(wake_at_ms - record.fire_at_ms, slack_ms);
+                               due.push_back(store->GetString(record.id));
+                             });
+    for (const auto& id : due) store->Remove(id);
+  }
+  return wakeups;
+}
+
+}  // namespace
+
+TEST(ScheduledStore, PutAndFind) {
+  ScheduledStore store;
+  store.Put(make_request("b", "Second"));
+  store.Put(make_request("a", "First"));
+
+  ASSERT_EQ(store.size(), 2u);
+  ScheduledStore::Record record;
+  ASSERT_TRUE(store.Find("a", &record));
+  NotificationContent content = store.ContentOf(record);
+  EXPECT_EQ(content.title, "First");
+  EXPECT_EQ(content.body, "Body");
+  ASSERT_EQ(content.actions.size(), 1u);
+  EXPECT_EQ(content.actions[0].first, "reply");
+  EXPECT_FALSE(store.Find("c", &record));
+  EXPECT_FALSE(store.Contains("c"));
+}
+
+TEST(ScheduledStore, IteratesInIdOrder) {
+  ScheduledStore store;
+  store.Put(make_request("b", "B"));
+  store.Put(make_request("c", "C"));
+  store.Put(make_request("a", "A"));
+
+  std::string order;
+  store.ForEach([&](const ScheduledStore::Record& record) { order += store.GetString(record.id); });
+  EXPECT_EQ(order, "abc");
+}
+
+TEST(ScheduledStore, IteratesInFireTimeOrder) {
+  ScheduledStore store;
+  store.Put(make_timed_request("a", 300));
+  store.Put(make_timed_request("b", 100));
+  store.Put(make_timed_request("c", 200));
+  store.Put(make_timed_request("unarmed", 0));
+  ASSERT_TRUE(store.SetFireTime("b", 400));
+
+  std::string order;
+  bool more = store.ForEachByFireTime(0, INT64_MAX, nullptr, 10, [&](const ScheduledStore::Record& record) {
+    order += store.GetString(record.id);
+  });
+  EXPECT_EQ(order, "cab");
+  EXPECT_FALSE(more);
+  EXPECT_EQ(store.NextFireTime(), 200);
+  EXPECT_FALSE(store.SetFireTime("missing", 1));
+
+  store.Remove("c");
+  EXPECT_EQ(store.NextFireTime(), 300);
+}
+
+TEST(ScheduledStore, RangeQueryPagesWithCursor) {
+  ScheduledStore store;
+  // Two entries share a fire time so the cursor has to break the tie by id.
+  store.Put(make_timed_request("a", 100));
+  store.Put(make_timed_request("b", 200));
+  store.Put(make_timed_request("c", 200));
+  store.Put(make_timed_request("d", 300));
+  store.Put(make_timed_request("e", 400));
+
+  std::string order;
+  ScheduledStore::FireCursor cursor{0, ""};
+  const ScheduledStore::FireCursor* after = nullptr;
+  int pages = 0;
+  bool more = true;
+  while (more) {
+    size_t visited = 0;
+    more = store.ForEachByFireTime(150, 400, after, 2, [&](const ScheduledStore::Record& record) {
+      order += store.GetString(record.id);
+      cursor = ScheduledStore::FireCursor{record.fire_at_ms, store.GetString(record.id)};
+      visited++;
+    });
+    ASSERT_GT(visited, 0u);
+    after = &cursor;
+    pages++;
+  }
+  EXPECT_EQ(order, "bcd");
+  EXPECT_EQ(pages, 2);
+}
+
+TEST(ScheduledStore, CoalescedFireTimeStaysWithinSlack) {
+  ScheduledStore store;
+  EXPECT_EQ(store.CoalescedFireTime(1000), 0);
+  store.Put(make_timed_request("a", 1000));
+  store.Put(make_timed_request("b", 1500));
+  store.Put(make_timed_request("c", 2000));
+  store.Put(make_timed_request("d", 2001));
+
+  EXPECT_EQ(store.CoalescedFireTime(0), 1000);
+  EXPECT_EQ(store.CoalescedFireTime(999), 1500);
+  EXPECT_EQ(store.CoalescedFireTime(1000), 2000);
+}
+
+TEST(ScheduledStore, SlackCoalescesWakeups) {
+  // A thousand reminders a tenth of a second apart. With a second of slack
+  // each wakeup covers its first entry and the ten after it.
+  const std::pair<int64_t, int> cases[] = {{0, 1000}, {1000, 91}, {60000, 2}};
+  for (const auto& c : cases) {
+    ScheduledStore store;
+    for (int i = 0; i < 1000; i++) store.Put(make_timed_request(std::to_string(i), 100 * (i + 1)));
+    EXPECT_EQ(count_wakeups(&store, c.first), c.second) << "slack " << c.first << " ms";
+  }
+}
+
+TEST(ScheduledStore, ChangesSinceCollapsesPerId) {
+  ScheduledStore store;
+  store.Put(make_timed_request("kept", 100));
+  store.Put(make_timed_request("removed", 100));
+  uint64_t since = store.version();
+
+  store.Put(make_timed_request("kept", 200));
+  store.Remove("removed");
+  store.Put(make_timed_request("new", 100));
+  store.SetFireTime("new", 300);
+  store.Put(make_timed_request("transient", 100));
+  store.Remove("transient");
+
+  std::vector<ScheduledStore::Change> changes;
+  ASSERT_TRUE(store.ChangesSince(since, &changes));
+  ASSERT_EQ(changes.size(), 3u);
+  EXPECT_EQ(changes[0].id, "kept");
+  EXPECT_EQ(changes[0].kind, ScheduledStore::ChangeKind::kUpdate);
+  EXPECT_EQ(changes[1].id, "removed");
+  EXPECT_EQ(changes[1].kind, ScheduledStore::ChangeKind::kRemove);
+  EXPECT_EQ(changes[2].id, "new");
+  EXPECT_EQ(changes[2].kind, ScheduledStore::ChangeKind::kInsert);
+
+  ASSERT_TRUE(store.ChangesSince(store.version(), &changes));
+  EXPECT_TRUE(changes.empty());
+}
+
+TEST(ScheduledStore, ChangesSinceFallsBackWhenLogIsTrimmed) {
+  ScheduledStore store(4);
+  uint64_t start = store.version();
+  for (int i = 0; i < 5; i++) store.Put(make_timed_request(std::to_string(i), 100));
+
+  std::vector<ScheduledStore::Change> changes;
+  EXPECT_FALSE(store.ChangesSince(start, &changes));
+  EXPECT_TRUE(store.ChangesSince(start + 1, &changes));
+  EXPECT_EQ(changes.size(), 4u);
+  EXPECT_FALSE(store.ChangesSince(store.version() + 1, &changes));
+
+  uint64_t before_clear = store.version();
+  store.Clear();
+  EXPECT_GT(store.version(), before_clear);
+  EXPECT_FALSE(store.ChangesSince(before_clear, &changes));
+  EXPECT_TRUE(store.ChangesSince(store.version(), &changes));
+}
+
+TEST(ScheduledStore, PutReplacesExistingId) {
+  ScheduledStore store;
+  store.Put(make_request("a", "Old"));
+  store.Put(make_request("a", "New"));
+
+  ASSERT_EQ(store.size(), 1u);
+  ScheduledStore::Record record;
+  ASSERT_TRUE(store.Find("a", &record));
+  EXPECT_EQ(store.GetString(record.title), "New");
+  EXPECT_GT(store.garbage_bytes(), 0u);
+}
+
+TEST(ScheduledStore, ForEachAfterWalksInPieces) {
+  ScheduledStore store;
+  for (const char* id : {"d", "b", "a", "c", "e"}) store.Put(make_request(id, id));
+
+  std::vector<std::string> ids;
+  auto collect = [&](const ScheduledStore::Record& record) {
+    ids.push_back(store.GetString(record.id));
+  };
+  EXPECT_TRUE(store.ForEachAfter(nullptr, 2, collect));
+  EXPECT_EQ(ids, (std::vector<std::string>{"a", "b"}));
+
+  // The walk carries on past an entry removed in between.
+  std::string after = ids.back();
+  store.Remove("b");
+  EXPECT_TRUE(store.ForEachAfter(&after, 2, collect));
+  after = ids.back();
+  EXPECT_FALSE(store.ForEachAfter(&after, 2, collect));
+  EXPECT_EQ(ids, (std::vector<std::string>{"a", "b", "c", "d", "e"}));
+}
+
+TEST(ScheduledStore, CompactionKeepsLiveRecords) {
+  ScheduledStore store;
+  std::string long_title(1024, 'x');
+  for (int i = 0; i < 200; i++) {
+    store.Put(make_request("id" + std::to_string(i), long_title));
+  }
+  for (int i = 0; i < 200; i++) {
+    if (i % 4 != 1) store.Remove("id" + std::to_string(i));
+  }
+  store.Put(make_request("id0", "Back"));
+
+  // Removing three quarters of ~200 KiB crosses the compaction threshold.
+  EXPECT_LT(store.garbage_bytes(), store.arena_bytes() / 2);
+  EXPECT_EQ(store.size(), 51u);
+  ScheduledStore::Record record;
+  ASSERT_TRUE(store.Find("id0", &record));
+  EXPECT_EQ(store.GetString(record.title), "Back");
+  ASSERT_TRUE(store.Find("id1", &record));
+  EXPECT_EQ(store.GetString(record.title), long_title);
+  ASSERT_TRUE(store.Find("id197", &record));
+  EXPECT_EQ(store.ActionsOf(record)[0].second, "Reply");
+  EXPECT_FALSE(store.Contains("id2"));
+}
+
+TEST(ScheduledStore, SlotCompactionKeepsBothOrders) {
+  ScheduledStore store;
+  g_autoptr(FlValue) payload = fl_value_new_map();
+  fl_value_set_string_take(payload, "k", fl_value_new_int(7));
+  for (int i = 0; i < 10000; i++) {
+    ScheduledRequest request = make_timed_request("id" + std::to_string(i), 20000 - i);
+    if (i % 10 == 9) request.payload = payload;
+    store.Put(request);
+  }
+  for (int i = 0; i < 10000; i++) {
+    if (i % 10 != 9) store.Remove("id" + std::to_string(i));
+  }
+
+  // Once free slots made up half the columns, the live ones were packed
+  // down and renumbered.
+  EXPECT_EQ(store.size(), 1000u);
+  EXPECT_LT(store.slot_count(), 10000u);
+
+  std::string previous_id;
+  store.ForEach([&](const ScheduledStore::Record& record) {
+    std::string id = store.GetString(record.id);
+    EXPECT_LT(previous_id, id);
+    EXPECT_EQ(record.fire_at_ms, 20000 - std::stoi(id.substr(2)));
+    ASSERT_NE(record.payload, nullptr);
+    EXPECT_TRUE(fl_value_equal(record.payload, payload));
+    previous_id = id;
+  });
+  int64_t previous_fire_at_ms = 0;
+  store.ForEachByFireTime(0, INT64_MAX, nullptr, SIZE_MAX, [&](const ScheduledStore::Record& record) {
+    EXPECT_LT(previous_fire_at_ms, record.fire_at_ms);
+    previous_fire_at_ms = record.fire_at_ms;
+  });
+  EXPECT_EQ(store.NextFireTime(), 20000 - 9999);
+
+  store.Put(make_timed_request("new", 1));
+  EXPECT_EQ(store.NextFireTime(), 1);
+  EXPECT_TRUE(store.Remove("id9"));
+  EXPECT_FALSE(store.Contains("id9"));
+}
+
+TEST(ScheduledStore, ToFlValueMatchesDartShape) {
+  ScheduledStore store;
+  ScheduledRequest request = make_request("a", "Title");
+  request.repeat_interval_s = 3600;
+  request.group = "inbox";
+  store.Put(request);
+
+  ScheduledStore::Record record;
+  ASSERT_TRUE(store.Find("a", &record));
+  g_autoptr(FlValue) value = store.ToFlValue(record);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(value, "id")), "a");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(value, "scheduledDate")), 1000);
+  EXPECT_TRUE(fl_value_get_bool(fl_value_lookup_string(value, "isRepeating")));
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(value, "repeatInterval")), 3600);
+  FlValue* nested = fl_value_lookup_string(value, "request");
+  ASSERT_NE(nested, nullptr);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(nested, "title")), "Title");
+  EXPECT_EQ(fl_value_get_length(fl_value_lookup_string(nested, "actions")), 1u);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(nested, "group")), "inbox");
+  EXPECT_EQ(store.ContentOf(record).group, "inbox");
+}
+
+TEST(ScheduledStore, ParsesLegacyJsonRequests) {
+  ScheduledRequest request;
+  ASSERT_TRUE(ScheduledRequestFromJson(
+      "{\"title\":\"T\",\"body\":\"B\",\"actions\":[{\"id\":\"x\",\"title\":\"X\"}],"
+      "\"payload\":{\"route\":\"/r\"}}",
+      &request));
+  EXPECT_EQ(request.title, "T");
+  ASSERT_EQ(request.actions.size(), 1u);
+  EXPECT_EQ(request.actions[0].first, "x");
+  ASSERT_NE(request.payload, nullptr);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(request.payload, "route")), "/r");
+  fl_value_unref(request.payload);
+
+  EXPECT_FALSE(ScheduledRequestFromJson("[]", &request));
+}
+
+// getScheduledChanges on top of the store's change log.
+using ScheduledChangesTest = PluginTest;
+
+TEST_F(ScheduledChangesTest, ScheduledChangesReturnOnlyTheDelta) {
+  int64_t later_ms = UseVirtualClock()->RealTimeUs() / 1000 + 3600 * 1000;
+  g_autoptr(FlValue) first_args = make_schedule_args("first", later_ms);
+  g_autoptr(FlMethodResponse) first = schedule_notification(plugin_, first_args);
+
+  g_autoptr(FlValue) full_args = fl_value_new_map();
+  fl_value_set_string_take(full_args, "sinceVersion", fl_value_new_int(0));
+  g_autoptr(FlMethodResponse) full = get_scheduled_changes(plugin_, full_args);
+  FlValue* full_result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(full));
+  EXPECT_TRUE(fl_value_get_bool(fl_value_lookup_string(full_result, "isFullSnapshot")));
+  EXPECT_EQ(fl_value_get_length(fl_value_lookup_string(full_result, "inserted")), 1u);
+
+  g_autoptr(FlValue) second_args = make_schedule_args("second", later_ms);
+  g_autoptr(FlMethodResponse) second = schedule_notification(plugin_, second_args);
+  g_autoptr(FlMethodResponse) cancel = cancel_scheduled_notification(plugin_, first_args);
+
+  g_autoptr(FlValue) delta_args = fl_value_new_map();
+  fl_value_set_string(delta_args, "sinceVersion", fl_value_lookup_string(full_result, "version"));
+  g_autoptr(FlMethodResponse) delta = get_scheduled_changes(plugin_, delta_args);
+  FlValue* delta_result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(delta));
+  EXPECT_FALSE(fl_value_get_bool(fl_value_lookup_string(delta_result, "isFullSnapshot")));
+  FlValue* inserted = fl_value_lookup_string(delta_result, "inserted");
+  ASSERT_EQ(fl_value_get_length(inserted), 1u);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(fl_value_get_list_value(inserted, 0), "id")),
+               "second");
+  FlValue* removed = fl_value_lookup_string(delta_result, "removed");
+  ASSERT_EQ(fl_value_get_length(removed), 1u);
+  EXPECT_STREQ(fl_value_get_string(fl_value_get_list_value(removed, 0)), "first");
+}
+
+}  // namespace test
+}  // namespace notification_manager
@@ -0,0 +1,156 @@
+#include <flutter_linux/flutter_linux.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clock.h"
+#include "include/notification_manager/notification_manager_plugin.h"
+#include "notification_backend.h"
+#include "notification_manager_plugin_private.h"
+#include "test_data_dir.h"
+
+// Runs the scheduler through a simulated year on a VirtualClock. Nothing
+// sleeps, so the cost is the scheduler's own work for every wakeup.
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+constexpr int64_t kDayMs = 24 * 3600 * 1000;
+constexpr int64_t kYearMs = 365 * kDayMs;
+// 2025-01-01T00:00:00Z.
+constexpr int64_t kStartMs = int64_t{1735689600000};
+constexpr uint32_t kEntries = 100000;
+constexpr uint32_t kDaily = 1000;
+constexpr uint32_t kOnce = kEntries - kDaily;
+constexpr int64_t kSlackMs = 1000;
+// MAX_SCHEDULER_WAIT_MS in the plugin.
+constexpr int64_t kMaxWaitMs = 15 * 60 * 1000;
+
+// One-shot entries are spread over the year in groups of four, jittered
+// so that some of a group fall within the slack of each other and some
+// do not.
+int64_t once_fire_at(uint32_t index) {
+  constexpr int64_t kGroupStepMs = (kYearMs - 120000) / (kOnce / 4 + 1);
+  return kStartMs + 60000 + (index / 4) * kGroupStepMs + (index * 2654435761u) % 3000;
+}
+
+// Daily entries start through the first day.
+int64_t daily_first_fire_at(uint32_t index) {
+  return kStartMs + 60000 + index * (kDayMs / kDaily);
+}
+
+FlValue* make_args(const std::string& id, int64_t scheduled_date, int64_t repeat_interval_s) {
+  FlValue* args = fl_value_new_map();
+  fl_value_set_string_take(args, "id", fl_value_new_string(id.c_str()));
+  FlValue* request = fl_value_new_map();
+  fl_value_set_string_take(request, "title", fl_value_new_string(id.c_str()));
+  fl_value_set_string_take(request, "body", fl_value_new_string("Body"));
+  fl_value_set_string_take(args, "request", request);
+  fl_value_set_string_take(args, "scheduledDate", fl_value_new_int(scheduled_date));
+  if (repeat_interval_s > 0) {
+    fl_value_set_string_take(args, "isRepeating", fl_value_new_bool(true));
+    fl_value_set_string_take(args, "repeatInterval", fl_value_new_int(repeat_interval_s));
+  }
+  return args;
+}
+
+// Reports every show, without keeping the content around.
+class ShowCountingBackend : public NullBackend {
+ public:
+  using ShowCallback = std::function<void(const std::string& id)>;
+
+  explicit ShowCountingBackend(ShowCallback on_show) : on_show_(std::move(on_show)) {}
+
+  bool Show(const std::string& id, const NotificationContent& content) override {
+    on_show_(id);
+    return true;
+  }
+  bool Update(const std::string& id, const NotificationContent& content) override {
+    on_show_(id);
+    return true;
+  }
+
+ private:
+  ShowCallback on_show_;
+};
+
+}  // namespace
+
+TEST(SchedulerStress, YearOfSchedulesFiresEachEntryOnTime) {
+  // The year writes 100k-entry snapshots and a history record per show.
+  ScopedTestDataDir data_dir;
+  auto owned_clock = std::make_unique<VirtualClock>(kStartMs * 1000);
+  VirtualClock* clock = owned_clock.get();
+
+  std::vector<uint32_t> once_shows(kOnce);
+  std::vector<uint32_t> daily_shows(kDaily);
+  size_t early = 0;
+  int64_t max_late_ms = 0;
+  auto on_show = [&](const std::string& id) {
+    int64_t now_ms = clock->RealTimeUs() / 1000;
+    int64_t due_ms;
+    if (g_str_has_prefix(id.c_str(), "once_")) {
+      uint32_t index = static_cast<uint32_t>(std::stoul(id.substr(strlen("once_"))));
+      due_ms = once_fire_at(index);
+      once_shows[index]++;
+    } else if (g_str_has_prefix(id.c_str(), "daily_")) {
+      uint32_t index = static_cast<uint32_t>(std::stoul(id.substr(strlen("daily_"))));
+      due_ms = daily_first_fire_at(index) + daily_shows[index] * kDayMs;
+      daily_shows[index]++;
+    } else {
+      ADD_FAILURE() << "Unexpected notification " << id;
+      return;
+    }
+    if (now_ms < due_ms) early++;
+    max_late_ms = std::max(max_late_ms, now_ms - due_ms);
+  };
+
+  NotificationManagerPlugin* plugin = static_cast<NotificationManagerPlugin*>(
+      g_object_new(notification_manager_plugin_get_type(), nullptr));
+  notification_manager_plugin_set_backend(plugin, std::make_unique<ShowCountingBackend>(on_show));
+  notification_manager_plugin_set_clock(plugin, std::move(owned_clock));
+  notification_manager_plugin_set_scheduler_slack(plugin, kSlackMs);
+
+  for (uint32_t i = 0; i < kOnce; i++) {
+    g_autoptr(FlValue) args = make_args("once_" + std::to_string(i), once_fire_at(i), 0);
+    g_autoptr(FlMethodResponse) response = schedule_notification(plugin, args);
+  }
+  for (uint32_t i = 0; i < kDaily; i++) {
+    g_autoptr(FlValue) args =
+        make_args("daily_" + std::to_string(i), daily_first_fire_at(i), kDayMs / 1000);
+    g_autoptr(FlMethodResponse) response = schedule_notification(plugin, args);
+  }
+
+  gint64 start_us = g_get_monotonic_time();
+  clock->Advance(kYearMs * 1000);
+  RecordProperty("simulated_year_ms",
+                 static_cast<int>((g_get_monotonic_time() - start_us) / 1000));
+
+  EXPECT_EQ(early, 0u);
+  EXPECT_LE(max_late_ms, kSlackMs + 1000);
+  EXPECT_EQ(std::count(once_shows.begin(), once_shows.end(), 1u), std::ptrdiff_t{kOnce});
+  EXPECT_EQ(std::count(daily_shows.begin(), daily_shows.end(), 365u), std::ptrdiff_t{kDaily});
+
+  // One wakeup at most per show, plus the ones that only re-arm a wait
+  // longer than the cap.
+  guint64 shows = kOnce + kDaily * 365;
+  EXPECT_LE(notification_manager_plugin_get_scheduler_wakeups(plugin),
+            shows + kYearMs / kMaxWaitMs);
+
+  g_autoptr(FlMethodResponse) response = get_scheduled_notifications(plugin, nullptr);
+  FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response));
+  EXPECT_EQ(fl_value_get_length(result), kDaily);
+
+  g_object_unref(plugin);
+}
+
+}  // namespace test
+}  // namespace notification_manager
@@ -0,0 +1,150 @@
+#include <flutter_linux/flutter_linux.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "plugin_test_fixture.h"
+
+namespace notification_manager {
+namespace test {
+
+// The scheduler timer, its slack and the catch-up policies, driven through
+// the plugin. scheduler_stress_test.cc runs the same paths for a year.
+class SchedulerTest : public PluginTest {
+ protected:
+  // Schedules entries that fell due an hour ago, as if the machine had slept
+  // through them, and reports the resume. Returns the clock the plugin now
+  // runs on.
+  VirtualClock* MissWhileAsleep(const char* policy, const std::vector<const char*>& categories) {
+    VirtualClock* clock = UseVirtualClock();
+    g_autoptr(FlValue) policy_args = fl_value_new_map();
+    fl_value_set_string_take(policy_args, "policy", fl_value_new_string(policy));
+    g_autoptr(FlMethodResponse) set_policy = set_catch_up_policy(plugin_, policy_args);
+
+    int64_t hour_ago_ms = clock->RealTimeUs() / 1000 - 3600 * 1000;
+    for (size_t i = 0; i < categories.size(); i++) {
+      std::string id = "missed_" + std::to_string(i);
+      g_autoptr(FlValue) args = make_schedule_args(id.c_str(), hour_ago_ms + i, categories[i]);
+      g_autoptr(FlMethodResponse) response = schedule_notification(plugin_, args);
+    }
+    notification_manager_plugin_handle_sleep(plugin_, false);
+    return clock;
+  }
+};
+
+TEST_F(SchedulerTest, BatchesDeadlinesWithinSlack) {
+  VirtualClock* clock = UseVirtualClock();
+  notification_manager_plugin_set_scheduler_slack(plugin_, 500);
+  int64_t start_ms = clock->RealTimeUs() / 1000 + 100;
+  for (int i = 0; i < 20; i++) {
+    std::string id = "batch_" + std::to_string(i);
+    g_autoptr(FlValue) args = make_schedule_args(id.c_str(), start_ms + 10 * i);
+    g_autoptr(FlMethodResponse) response = schedule_notification(plugin_, args);
+  }
+
+  clock->Advance(G_USEC_PER_SEC);
+
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 20u);
+  EXPECT_EQ(notification_manager_plugin_get_scheduler_wakeups(plugin_), 1u);
+}
+
+TEST_F(SchedulerTest, FiredNotificationsKeepTheirGroup) {
+  VirtualClock* clock = UseVirtualClock();
+  g_autoptr(FlValue) args =
+      make_schedule_args("reminder", clock->RealTimeUs() / 1000 + 100, "chat");
+  fl_value_set_string_take(fl_value_lookup_string(args, "request"), "group",
+                           fl_value_new_string("alice"));
+  g_autoptr(FlMethodResponse) scheduled = schedule_notification(plugin_, args);
+
+  g_autoptr(FlMethodResponse) listed = get_scheduled_notifications(plugin_, nullptr);
+  FlValue* request = fl_value_lookup_string(
+      fl_value_get_list_value(
+          fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(listed)), 0),
+      "request");
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(request, "group")), "alice");
+
+  clock->Advance(G_USEC_PER_SEC);
+  ASSERT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 1u);
+  EXPECT_EQ(backend_->calls()[0].content.group, "alice");
+
+  g_autoptr(FlValue) group = fl_value_new_map();
+  fl_value_set_string_take(group, "group", fl_value_new_string("alice"));
+  g_autoptr(FlMethodResponse) cancelled = cancel_notifications_by_group(plugin_, group);
+  EXPECT_EQ(fl_value_get_int(
+                fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(cancelled))),
+            1);
+  EXPECT_TRUE(backend_->open().empty());
+}
+
+TEST_F(SchedulerTest, CatchUpIsRateLimited) {
+  VirtualClock* clock = MissWhileAsleep("fireAll", std::vector<const char*>(10, nullptr));
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 4u);
+
+  clock->Advance(G_USEC_PER_SEC);
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 8u);
+  clock->Advance(G_USEC_PER_SEC);
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 10u);
+}
+
+TEST_F(SchedulerTest, CatchUpShowsLatestPerSeries) {
+  MissWhileAsleep("latestPerSeries", {"news", "chat", "news", nullptr, "chat", "news"});
+
+  ASSERT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 3u);
+  EXPECT_EQ(backend_->calls()[0].id, "missed_3");
+  EXPECT_EQ(backend_->calls()[1].id, "missed_4");
+  EXPECT_EQ(backend_->calls()[2].id, "missed_5");
+}
+
+TEST_F(SchedulerTest, CatchUpSummarizesMissedEntries) {
+  MissWhileAsleep("summary", std::vector<const char*>(7, nullptr));
+
+  ASSERT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 1u);
+  EXPECT_EQ(backend_->calls()[0].id, "missed_scheduled_notifications");
+  EXPECT_EQ(backend_->calls()[0].content.title, "7 missed notifications");
+  EXPECT_EQ(backend_->calls()[0].content.body, "Title\nTitle\nTitle\nTitle\nTitle\nand 2 more");
+
+  g_autoptr(FlMethodResponse) response = get_scheduled_notifications(plugin_, nullptr);
+  FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response));
+  EXPECT_EQ(fl_value_get_length(result), 0u);
+}
+
+TEST_F(SchedulerTest, CatchUpShowsASingleMissedEntryItself) {
+  MissWhileAsleep("summary", {nullptr});
+
+  ASSERT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 1u);
+  EXPECT_EQ(backend_->calls()[0].id, "missed_0");
+  EXPECT_EQ(backend_->calls()[0].content.title, "Title");
+}
+
+TEST_F(SchedulerTest, CancelledEntriesLeaveTheCatchUpQueue) {
+  VirtualClock* clock = MissWhileAsleep("fireAll", std::vector<const char*>(6, nullptr));
+  ASSERT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 4u);
+
+  g_autoptr(FlValue) scheduled = make_id_args("missed_4");
+  g_autoptr(FlMethodResponse) cancelled_scheduled =
+      cancel_scheduled_notification(plugin_, scheduled);
+  Cancel("missed_5");
+  clock->Advance(G_USEC_PER_SEC);
+
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 4u);
+}
+
+TEST_F(SchedulerTest, SettingTheClockRearmsTheScheduler) {
+  VirtualClock* clock = UseVirtualClock();
+  int64_t hour_ms = int64_t{3600} * 1000;
+  g_autoptr(FlValue) args = make_schedule_args("later", clock->RealTimeUs() / 1000 + hour_ms);
+  g_autoptr(FlMethodResponse) response = schedule_notification(plugin_, args);
+
+  // Set back, the entry is two hours away rather than one.
+  clock->JumpRealTime(-hour_ms * 1000);
+  clock->Advance(hour_ms * 1000);
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 0u);
+
+  // Set forward past it, the entry fires without waiting for the timer.
+  clock->JumpRealTime(2 * hour_ms * 1000);
+  EXPECT_EQ(backend_->CountCalls(RecordingBackend::CallType::kShow), 1u);
+}
+
+}  // namespace test
+}  // namespace notification_manager
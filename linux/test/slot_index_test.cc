@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "slot_index.h"
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+// Orders slots by a key held in a side table, the way the store orders
+// them by fields in its columns.
+struct KeyLess {
+  const std::vector<int>* keys;
+
+  bool operator()(uint32_t a, uint32_t b) const { return (*keys)[a] < (*keys)[b]; }
+  bool operator()(uint32_t a, int b) const { return (*keys)[a] < b; }
+  bool operator()(int a, uint32_t b) const { return a < (*keys)[b]; }
+};
+
+}  // namespace
+
+TEST(SlotIndex, StaysOrderedThroughSplitsAndMerges) {
+  std::vector<int> keys(20000);
+  for (size_t i = 0; i < keys.size(); i++) keys[i] = static_cast<int>(i);
+  std::mt19937 random(42);
+  std::shuffle(keys.begin(), keys.end(), random);
+
+  SlotIndex<KeyLess> index(KeyLess{&keys});
+  std::set<int> expected;
+  for (uint32_t slot = 0; slot < keys.size(); slot++) {
+    index.insert(slot);
+    expected.insert(keys[slot]);
+  }
+  for (uint32_t slot = 0; slot < keys.size(); slot += 1 + random() % 3) {
+    EXPECT_TRUE(index.erase(slot));
+    expected.erase(keys[slot]);
+  }
+  EXPECT_FALSE(index.erase(0));
+
+  ASSERT_EQ(index.size(), expected.size());
+  auto want = expected.begin();
+  for (uint32_t slot : index) {
+    EXPECT_EQ(keys[slot], *want);
+    ++want;
+  }
+}
+
+TEST(SlotIndex, SearchesByKey) {
+  std::vector<int> keys = {50, 10, 30, 20, 40};
+  SlotIndex<KeyLess> index(KeyLess{&keys});
+  for (uint32_t slot = 0; slot < keys.size(); slot++) index.insert(slot);
+
+  EXPECT_EQ(*index.lower_bound(25), 2u);
+  EXPECT_EQ(*index.upper_bound(30), 4u);
+  EXPECT_EQ(index.lower_bound(60), index.end());
+  EXPECT_EQ(index.Before(index.lower_bound(25)), 3u);
+  EXPECT_EQ(index.Before(index.end()), 0u);
+  EXPECT_EQ(*index.find(10), 1u);
+  EXPECT_EQ(index.find(15), index.end());
+}
+
+TEST(SlotIndex, AssignTakesSortedSlots) {
+  std::vector<int> keys(3000);
+  std::vector<uint32_t> sorted(keys.size());
+  for (uint32_t slot = 0; slot < keys.size(); slot++) {
+    keys[slot] = -2 * static_cast<int>(slot);
+    sorted[keys.size() - 1 - slot] = slot;
+  }
+  SlotIndex<KeyLess> index(KeyLess{&keys});
+  index.Assign(sorted);
+
+  EXPECT_EQ(index.size(), keys.size());
+  EXPECT_TRUE(std::equal(index.begin(), index.end(), sorted.begin()));
+  keys.push_back(-2999);
+  index.insert(3000);
+  EXPECT_EQ(index.Before(index.find(-2998)), 3000u);
+}
+
+}  // namespace test
+}  // namespace notification_manager
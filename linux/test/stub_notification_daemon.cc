@@ -0,0 +1,286 @@
+#include <gio/gio.h>
+
+#include <cstdio>
+#include <set>
+
+// A minimal org.freedesktop.Notifications server for headless testing.
+//
+// It is meant to run on a private `dbus-daemon --session` (see
+// StubNotificationDaemonTest), and prints "READY" on stdout once it owns the
+// bus name. Besides the notification interface it exports a control
+// interface so tests can inject latency or failures and emit the
+// ActionInvoked/NotificationClosed signals on demand.
+//
+// $ notification_manager_stub_daemon --latency-ms=5 --failure-rate=0.1
+
+#define NOTIFICATIONS_NAME "org.freedesktop.Notifications"
+#define NOTIFICATIONS_PATH "/org/freedesktop/Notifications"
+#define NOTIFICATIONS_INTERFACE "org.freedesktop.Notifications"
+#define CONTROL_INTERFACE "org.notification_manager.StubControl"
+
+// Reason codes from the Desktop Notifications specification.
+#define CLOSED_REASON_DISMISSED 2
+#define CLOSED_REASON_CLOSE_CALLED 3
+
+static const gchar kIntrospectionXml[] =
+    "<node>"
+    "  <interface name='org.freedesktop.Notifications'>"
+    "    <method name='Notify'>"
+    "      <arg type='s' name='app_name' direction='in'/>"
+    "      <arg type='u' name='replaces_id' direction='in'/>"
+    "      <arg type='s' name='app_icon' direction='in'/>"
+    "      <arg type='s' name='summary' direction='in'/>"
+    "      <arg type='s' name='body' direction='in'/>"
+    "      <arg type='as' name='actions' direction='in'/>"
+    "      <arg type='a{sv}' name='hints' direction='in'/>"
+    "      <arg type='i' name='expire_timeout' direction='in'/>"
+    "      <arg type='u' name='id' direction='out'/>"
+    "    </method>"
+    "    <method name='CloseNotification'>"
+    "      <arg type='u' name='id' direction='in'/>"
+    "    </method>"
+    "    <method name='GetCapabilities'>"
+    "      <arg type='as' name='capabilities' direction='out'/>"
+    "    </method>"
+    "    <method name='GetServerInformation'>"
+    "      <arg type='s' name='name' direction='out'/>"
+    "      <arg type='s' name='vendor' direction='out'/>"
+    "      <arg type='s' name='version' direction='out'/>"
+    "      <arg type='s' name='spec_version' direction='out'/>"
+    "    </method>"
+    "    <signal name='NotificationClosed'>"
+    "      <arg type='u' name='id'/>"
+    "      <arg type='u' name='reason'/>"
+    "    </signal>"
+    "    <signal name='ActionInvoked'>"
+    "      <arg type='u' name='id'/>"
+    "      <arg type='s' name='action_key'/>"
+    "    </signal>"
+    "  </interface>"
+    "  <interface name='org.notification_manager.StubControl'>"
+    "    <method name='SetLatency'>"
+    "      <arg type='u' name='latency_ms' direction='in'/>"
+    "    </method>"
+    "    <method name='SetFailureRate'>"
+    "      <arg type='d' name='failure_rate' direction='in'/>"
+    "    </method>"
+    "    <method name='EmitActionInvoked'>"
+    "      <arg type='u' name='id' direction='in'/>"
+    "      <arg type='s' name='action_key' direction='in'/>"
+    "    </method>"
+    "    <method name='EmitNotificationClosed'>"
+    "      <arg type='u' name='id' direction='in'/>"
+    "      <arg type='u' name='reason' direction='in'/>"
+    "    </method>"
+    "    <method name='GetStats'>"
+    "      <arg type='u' name='notify_count' direction='out'/>"
+    "      <arg type='u' name='close_count' direction='out'/>"
+    "      <arg type='u' name='failure_count' direction='out'/>"
+    "      <arg type='u' name='last_id' direction='out'/>"
+    "      <arg type='u' name='open_count' direction='out'/>"
+    "    </method>"
+    "    <method name='Reset'/>"
+    "  </interface>"
+    "</node>";
+
+struct StubDaemon {
+  GMainLoop* loop;
+  GDBusConnection* connection;
+  guint latency_ms;
+  gdouble failure_rate;
+  guint32 next_id;
+  guint32 notify_count;
+  guint32 close_count;
+  guint32 failure_count;
+  std::set<guint32> open_notifications;
+};
+
+typedef struct {
+  GDBusMethodInvocation* invocation;
+  GVariant* reply;
+} DelayedReply;
+
+static gboolean send_delayed_reply(gpointer user_data) {
+  DelayedReply* delayed = static_cast<DelayedReply*>(user_data);
+  g_dbus_method_invocation_return_value(delayed->invocation, delayed->reply);
+  g_free(delayed);
+  return G_SOURCE_REMOVE;
+}
+
+// Replies after the configured latency. Takes ownership of the invocation.
+static void reply(StubDaemon* daemon, GDBusMethodInvocation* invocation, GVariant* value) {
+  if (daemon->latency_ms == 0) {
+    g_dbus_method_invocation_return_value(invocation, value);
+    return;
+  }
+  DelayedReply* delayed = g_new0(DelayedReply, 1);
+  delayed->invocation = invocation;
+  delayed->reply = value;
+  g_timeout_add(daemon->latency_ms, send_delayed_reply, delayed);
+}
+
+static void emit_signal(StubDaemon* daemon, const gchar* name, GVariant* parameters) {
+  g_autoptr(GError) error = nullptr;
+  if (!g_dbus_connection_emit_signal(daemon->connection, nullptr, NOTIFICATIONS_PATH,
+                                     NOTIFICATIONS_INTERFACE, name, parameters, &error)) {
+    g_printerr("Failed to emit %s: %s\n", name, error->message);
+  }
+}
+
+static void handle_notifications_call(StubDaemon* daemon, const gchar* method_name,
+                                      GVariant* parameters,
+                                      GDBusMethodInvocation* invocation) {
+  if (g_strcmp0(method_name, "Notify") == 0) {
+    if (daemon->failure_rate > 0 && g_random_double() < daemon->failure_rate) {
+      daemon->failure_count++;
+      g_dbus_method_invocation_return_dbus_error(invocation, G_DBUS_ERROR_FAILED,
+                                                 "Injected failure");
+      return;
+    }
+    guint32 replaces_id = 0;
+    g_variant_get_child(parameters, 1, "u", &replaces_id);
+    guint32 id = replaces_id != 0 ? replaces_id : daemon->next_id++;
+    daemon->open_notifications.insert(id);
+    daemon->notify_count++;
+    reply(daemon, invocation, g_variant_new("(u)", id));
+  } else if (g_strcmp0(method_name, "CloseNotification") == 0) {
+    guint32 id = 0;
+    g_variant_get_child(parameters, 0, "u", &id);
+    daemon->close_count++;
+    if (daemon->open_notifications.erase(id) > 0) {
+      emit_signal(daemon, "NotificationClosed",
+                  g_variant_new("(uu)", id, CLOSED_REASON_CLOSE_CALLED));
+    }
+    reply(daemon, invocation, nullptr);
+  } else if (g_strcmp0(method_name, "GetCapabilities") == 0) {
+    const gchar* capabilities[] = {"actions", "body", "body-markup", "persistence", nullptr};
+    reply(daemon, invocation,
+          g_variant_new("(@as)", g_variant_new_strv(capabilities, -1)));
+  } else if (g_strcmp0(method_name, "GetServerInformation") == 0) {
+    reply(daemon, invocation,
+          g_variant_new("(ssss)", "notification_manager_stub", "notification_manager",
+                        "1.0", "1.2"));
+  }
+}
+
+static void handle_control_call(StubDaemon* daemon, const gchar* method_name,
+                                GVariant* parameters,
+                                GDBusMethodInvocation* invocation) {
+  if (g_strcmp0(method_name, "SetLatency") == 0) {
+    g_variant_get(parameters, "(u)", &daemon->latency_ms);
+  } else if (g_strcmp0(method_name, "SetFailureRate") == 0) {
+    g_variant_get(parameters, "(d)", &daemon->failure_rate);
+  } else if (g_strcmp0(method_name, "EmitActionInvoked") == 0) {
+    guint32 id = 0;
+    const gchar* action_key = nullptr;
+    g_variant_get(parameters, "(u&s)", &id, &action_key);
+    emit_signal(daemon, "ActionInvoked", g_variant_new("(us)", id, action_key));
+  } else if (g_strcmp0(method_name, "EmitNotificationClosed") == 0) {
+    guint32 id = 0;
+    guint32 reason = CLOSED_REASON_DISMISSED;
+    g_variant_get(parameters, "(uu)", &id, &reason);
+    daemon->open_notifications.erase(id);
+    emit_signal(daemon, "NotificationClosed", g_variant_new("(uu)", id, reason));
+  } else if (g_strcmp0(method_name, "GetStats") == 0) {
+    g_dbus_method_invocation_return_value(
+        invocation,
+        g_variant_new("(uuuuu)", daemon->notify_count, daemon->close_count,
+                      daemon->failure_count, daemon->next_id - 1,
+                      static_cast<guint32>(daemon->open_notifications.size())));
+    return;
+  } else if (g_strcmp0(method_name, "Reset") == 0) {
+    daemon->latency_ms = 0;
+    daemon->failure_rate = 0;
+    daemon->notify_count = 0;
+    daemon->close_count = 0;
+    daemon->failure_count = 0;
+    daemon->open_notifications.clear();
+  }
+  // Control calls are never delayed, so tests can reconfigure a slow daemon.
+  g_dbus_method_invocation_return_value(invocation, nullptr);
+}
+
+static void handle_method_call(GDBusConnection* connection, const gchar* sender,
+                               const gchar* object_path, const gchar* interface_name,
+                               const gchar* method_name, GVariant* parameters,
+                               GDBusMethodInvocation* invocation, gpointer user_data) {
+  StubDaemon* daemon = static_cast<StubDaemon*>(user_data);
+  if (g_strcmp0(interface_name, CONTROL_INTERFACE) == 0) {
+    handle_control_call(daemon, method_name, parameters, invocation);
+  } else {
+    handle_notifications_call(daemon, method_name, parameters, invocation);
+  }
+}
+
+static const GDBusInterfaceVTable kInterfaceVTable = {handle_method_call, nullptr, nullptr, {}};
+
+static void on_bus_acquired(GDBusConnection* connection, const gchar* name, gpointer user_data) {
+  StubDaemon* daemon = static_cast<StubDaemon*>(user_data);
+  daemon->connection = connection;
+
+  g_autoptr(GError) error = nullptr;
+  GDBusNodeInfo* node_info = g_dbus_node_info_new_for_xml(kIntrospectionXml, &error);
+  if (!node_info) {
+    g_printerr("Invalid introspection data: %s\n", error->message);
+    g_main_loop_quit(daemon->loop);
+    return;
+  }
+  for (GDBusInterfaceInfo** iface = node_info->interfaces; *iface != nullptr; iface++) {
+    if (g_dbus_connection_register_object(connection, NOTIFICATIONS_PATH, *iface,
+                                          &kInterfaceVTable, daemon, nullptr,
+                                          &error) == 0) {
+      g_printerr("Failed to register object: %s\n", error->message);
+      g_main_loop_quit(daemon->loop);
+      break;
+    }
+  }
+  g_dbus_node_info_unref(node_info);
+}
+
+static void on_name_acquired(GDBusConnection* connection, const gchar* name, gpointer user_data) {
+  printf("READY\n");
+  fflush(stdout);
+}
+
+static void on_name_lost(GDBusConnection* connection, const gchar* name, gpointer user_data) {
+  StubDaemon* daemon = static_cast<StubDaemon*>(user_data);
+  g_printerr("Could not own %s\n", name);
+  g_main_loop_quit(daemon->loop);
+}
+
+int main(int argc, char** argv) {
+  gint latency_ms = 0;
+  gdouble failure_rate = 0;
+  GOptionEntry entries[] = {
+      {"latency-ms", 0, 0, G_OPTION_ARG_INT, &latency_ms,
+       "Delay every notification reply by this many milliseconds", "MS"},
+      {"failure-rate", 0, 0, G_OPTION_ARG_DOUBLE, &failure_rate,
+       "Fraction of Notify calls that fail, between 0 and 1", "RATE"},
+      {nullptr, 0, 0, G_OPTION_ARG_NONE, nullptr, nullptr, nullptr},
+  };
+
+  g_autoptr(GError) error = nullptr;
+  GOptionContext* context = g_option_context_new("- stub notification daemon");
+  g_option_context_add_main_entries(context, entries, nullptr);
+  gboolean parsed = g_option_context_parse(context, &argc, &argv, &error);
+  g_option_context_free(context);
+  if (!parsed) {
+    g_printerr("%s\n", error->message);
+    return 1;
+  }
+
+  StubDaemon daemon = {};
+  daemon.loop = g_main_loop_new(nullptr, FALSE);
+  daemon.latency_ms = latency_ms > 0 ? latency_ms : 0;
+  daemon.failure_rate = failure_rate;
+  daemon.next_id = 1;
+
+  guint owner_id = g_bus_own_name(G_BUS_TYPE_SESSION, NOTIFICATIONS_NAME,
+                                  G_BUS_NAME_OWNER_FLAGS_NONE, on_bus_acquired,
+                                  on_name_acquired, on_name_lost, &daemon, nullptr);
+  g_main_loop_run(daemon.loop);
+
+  g_bus_unown_name(owner_id);
+  g_main_loop_unref(daemon.loop);
+  return 0;
+}
@@ -0,0 +1,136 @@
+#include "stub_notification_daemon_fixture.h"
+
+#include <string>
+
+#define NOTIFICATIONS_NAME "org.freedesktop.Notifications"
+#define NOTIFICATIONS_PATH "/org/freedesktop/Notifications"
+#define CONTROL_INTERFACE "org.notification_manager.StubControl"
+
+namespace notification_manager {
+namespace test {
+
+GSubprocess* StubNotificationDaemonTest::bus_ = nullptr;
+GSubprocess* StubNotificationDaemonTest::daemon_ = nullptr;
+GDBusConnection* StubNotificationDaemonTest::connection_ = nullptr;
+std::string StubNotificationDaemonTest::skip_reason_;
+
+namespace {
+
+// Reads the first line a subprocess writes to stdout, or "" on EOF.
+std::string read_first_line(GSubprocess* process) {
+  g_autoptr(GDataInputStream) stream =
+      g_data_input_stream_new(g_subprocess_get_stdout_pipe(process));
+  g_autofree gchar* line = g_data_input_stream_read_line(stream, nullptr, nullptr, nullptr);
+  return line ? line : "";
+}
+
+}  // namespace
+
+void StubNotificationDaemonTest::SetUpTestSuite() {
+  skip_reason_.clear();
+
+  g_autoptr(GError) error = nullptr;
+  bus_ = g_subprocess_new(G_SUBPROCESS_FLAGS_STDOUT_PIPE, &error, "dbus-daemon", "--session",
+                          "--nofork", "--print-address=1", nullptr);
+  if (!bus_) {
+    skip_reason_ = std::string("dbus-daemon unavailable: ") + error->message;
+    return;
+  }
+  std::string address = read_first_line(bus_);
+  if (address.empty()) {
+    skip_reason_ = "dbus-daemon did not print its address";
+    return;
+  }
+  g_setenv("DBUS_SESSION_BUS_ADDRESS", address.c_str(), TRUE);
+
+  daemon_ = g_subprocess_new(G_SUBPROCESS_FLAGS_STDOUT_PIPE, &error, STUB_DAEMON_PATH, nullptr);
+  if (!daemon_ || read_first_line(daemon_) != "READY") {
+    skip_reason_ = "stub notification daemon failed to start";
+    return;
+  }
+
+  connection_ = g_dbus_connection_new_for_address_sync(
+      address.c_str(),
+      static_cast<GDBusConnectionFlags>(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                        G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+      nullptr, nullptr, &error);
+  if (!connection_) {
+    skip_reason_ = std::string("could not connect to private bus: ") + error->message;
+  }
+}
+
+void StubNotificationDaemonTest::TearDownTestSuite() {
+  if (connection_) {
+    g_dbus_connection_close_sync(connection_, nullptr, nullptr);
+    g_clear_object(&connection_);
+  }
+  if (daemon_) {
+    g_subprocess_force_exit(daemon_);
+    g_subprocess_wait(daemon_, nullptr, nullptr);
+    g_clear_object(&daemon_);
+  }
+  if (bus_) {
+    g_subprocess_force_exit(bus_);
+    g_subprocess_wait(bus_, nullptr, nullptr);
+    g_clear_object(&bus_);
+  }
+  g_unsetenv("DBUS_SESSION_BUS_ADDRESS");
+}
+
+void StubNotificationDaemonTest::SetUp() {
+  if (!skip_reason_.empty()) {
+    GTEST_SKIP() << skip_reason_;
+  }
+  g_autoptr(GVariant) result = CallControl("Reset", nullptr);
+}
+
+GVariant* StubNotificationDaemonTest::CallControl(const char* method, GVariant* parameters) {
+  g_autoptr(GError) error = nullptr;
+  GVariant* result = g_dbus_connection_call_sync(
+      connection_, NOTIFICATIONS_NAME, NOTIFICATIONS_PATH, CONTROL_INTERFACE, method,
+      parameters, nullptr, G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &error);
+  EXPECT_NE(result, nullptr) << method << ": " << (error ? error->message : "");
+  return result;
+}
+
+void StubNotificationDaemonTest::SetLatency(guint32 latency_ms) {
+  g_autoptr(GVariant) result = CallControl("SetLatency", g_variant_new("(u)", latency_ms));
+}
+
+void StubNotificationDaemonTest::SetFailureRate(double failure_rate) {
+  g_autoptr(GVariant) result =
+      CallControl("SetFailureRate", g_variant_new("(d)", failure_rate));
+}
+
+void StubNotificationDaemonTest::EmitActionInvoked(guint32 id, const char* action_key) {
+  g_autoptr(GVariant) result =
+      CallControl("EmitActionInvoked", g_variant_new("(us)", id, action_key));
+}
+
+void StubNotificationDaemonTest::EmitNotificationClosed(guint32 id, guint32 reason) {
+  g_autoptr(GVariant) result =
+      CallControl("EmitNotificationClosed", g_variant_new("(uu)", id, reason));
+}
+
+StubNotificationDaemonTest::Stats StubNotificationDaemonTest::GetStats() {
+  Stats stats = {};
+  g_autoptr(GVariant) result = CallControl("GetStats", nullptr);
+  if (result) {
+    g_variant_get(result, "(uuuuu)", &stats.notify_count, &stats.close_count,
+                  &stats.failure_count, &stats.last_id, &stats.open_count);
+  }
+  return stats;
+}
+
+bool StubNotificationDaemonTest::RunMainLoopUntil(const std::function<bool()>& condition,
+                                                  int timeout_ms) {
+  gint64 deadline = g_get_monotonic_time() + static_cast<gint64>(timeout_ms) * 1000;
+  while (!condition()) {
+    if (g_get_monotonic_time() > deadline) return false;
+    g_main_context_iteration(nullptr, FALSE);
+  }
+  return true;
+}
+
+}  // namespace test
+}  // namespace notification_manager
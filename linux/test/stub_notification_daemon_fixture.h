@@ -0,0 +1,63 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_STUB_NOTIFICATION_DAEMON_FIXTURE_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_STUB_NOTIFICATION_DAEMON_FIXTURE_H_
+
+#include <gio/gio.h>
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <string>
+
+namespace notification_manager {
+namespace test {
+
+// Runs a private `dbus-daemon --session` with the stub notification daemon
+// (test/stub_notification_daemon.cc) on it for the lifetime of the test
+// suite, and points DBUS_SESSION_BUS_ADDRESS at it so libnotify talks to the
+// stub. Tests are skipped when dbus-daemon is not installed.
+//
+// The bus is shared by every test in the suite because libnotify caches its
+// session bus connection; the stub is reset before each test instead.
+class StubNotificationDaemonTest : public ::testing::Test {
+ public:
+  struct Stats {
+    guint32 notify_count;
+    guint32 close_count;
+    guint32 failure_count;
+    guint32 last_id;
+    guint32 open_count;
+  };
+
+ protected:
+  static void SetUpTestSuite();
+  static void TearDownTestSuite();
+
+  void SetUp() override;
+
+  // Wrappers around the stub's org.notification_manager.StubControl interface.
+  static void SetLatency(guint32 latency_ms);
+  static void SetFailureRate(double failure_rate);
+  static void EmitActionInvoked(guint32 id, const char* action_key);
+  static void EmitNotificationClosed(guint32 id, guint32 reason);
+  static Stats GetStats();
+
+  // Iterates the default main context until |condition| holds. Returns false
+  // if |timeout_ms| expires first.
+  static bool RunMainLoopUntil(const std::function<bool()>& condition,
+                               int timeout_ms = 5000);
+
+  // A connection to the private bus, for subscribing to daemon signals.
+  static GDBusConnection* connection() { return connection_; }
+
+ private:
+  static GVariant* CallControl(const char* method, GVariant* parameters);
+
+  static GSubprocess* bus_;
+  static GSubprocess* daemon_;
+  static GDBusConnection* connection_;
+  static std::string skip_reason_;
+};
+
+}  // namespace test
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_STUB_NOTIFICATION_DAEMON_FIXTURE_H_
@@ -0,0 +1,47 @@
+#include "test_data_dir.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gtest/gtest.h>
+
+#include "preferences_store.h"
+
+namespace notification_manager {
+namespace test {
+
+void RemoveTree(const std::string& path) {
+  if (g_file_test(path.c_str(), G_FILE_TEST_IS_DIR) &&
+      !g_file_test(path.c_str(), G_FILE_TEST_IS_SYMLINK)) {
+    GDir* dir = g_dir_open(path.c_str(), 0, nullptr);
+    if (dir) {
+      const gchar* name;
+      while ((name = g_dir_read_name(dir)) != nullptr) {
+        RemoveTree(path + "/" + name);
+      }
+      g_dir_close(dir);
+    }
+    g_rmdir(path.c_str());
+  } else {
+    g_remove(path.c_str());
+  }
+}
+
+ScopedTestDataDir::ScopedTestDataDir() : previous_(GetDataDir()) {
+  g_autofree gchar* root = g_dir_make_tmp("notification_manager_data_XXXXXX", nullptr);
+  if (root == nullptr) {
+    ADD_FAILURE() << "Failed to create a temporary data directory";
+    return;
+  }
+  root_ = root;
+  // A level down, as the real one is, so that creating it is exercised.
+  path_ = root_ + "/notification_manager";
+  SetDataDirForTesting(path_);
+}
+
+ScopedTestDataDir::~ScopedTestDataDir() {
+  SetDataDirForTesting(previous_);
+  if (!root_.empty()) RemoveTree(root_);
+}
+
+}  // namespace test
+}  // namespace notification_manager
@@ -0,0 +1,37 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_TEST_DATA_DIR_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_TEST_DATA_DIR_H_
+
+#include <string>
+
+namespace notification_manager {
+namespace test {
+
+// Deletes |path| and everything under it. Symlinks are removed, not
+// followed.
+void RemoveTree(const std::string& path);
+
+// Points GetDataDir() at a fresh temporary directory for its lifetime, so
+// tests neither see nor touch the user's real notifications, preferences
+// or history, nor each other's. Construct it before the plugin, and
+// destroy the plugin first: the directory is deleted on destruction.
+class ScopedTestDataDir {
+ public:
+  ScopedTestDataDir();
+  ~ScopedTestDataDir();
+
+  // Disallow copy and assign.
+  ScopedTestDataDir(const ScopedTestDataDir&) = delete;
+  ScopedTestDataDir& operator=(const ScopedTestDataDir&) = delete;
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string root_;
+  std::string path_;
+  std::string previous_;
+};
+
+}  // namespace test
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_TEST_DATA_DIR_H_
@@ -0,0 +1,25 @@
+#include <glib.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "test_data_dir.h"
+
+int main(int argc, char** argv) {
+  // Keep test state out of the real user's data directory, even for tests
+  // that do not set up a ScopedTestDataDir of their own. This has to
+  // happen before anything asks GLib or GetDataDir() for the directory,
+  // as both cache it.
+  g_autofree gchar* home = g_dir_make_tmp("notification_manager_test_XXXXXX", nullptr);
+  if (home == nullptr) {
+    g_printerr("Failed to create a temporary home directory\n");
+    return 1;
+  }
+  g_setenv("HOME", home, TRUE);
+  g_setenv("XDG_DATA_HOME", home, TRUE);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  int result = RUN_ALL_TESTS();
+  notification_manager::test::RemoveTree(home);
+  return result;
+}
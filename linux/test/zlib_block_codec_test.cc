@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "zlib_block_codec.h"
+
+namespace notification_manager {
+namespace test {
+
+namespace {
+
+std::string repetitive_text(size_t length) {
+  std::string text;
+  while (text.size() < length) text += "{\"route\":\"/orders/details\",\"order\":12345},";
+  text.resize(length);
+  return text;
+}
+
+}  // namespace
+
+TEST(ZlibBlockCodec, RoundTrip) {
+  ZlibBlockCodec codec;
+  std::string raw = repetitive_text(10000);
+  std::string packed;
+  ASSERT_TRUE(codec.Compress(raw.data(), raw.size(), &packed));
+  EXPECT_LT(packed.size(), raw.size() / 10);
+
+  std::string inflated;
+  ASSERT_TRUE(codec.Decompress(packed.data(), packed.size(), raw.size(), &inflated));
+  EXPECT_EQ(inflated, raw);
+}
+
+TEST(ZlibBlockCodec, BlocksAreIndependent) {
+  ZlibBlockCodec codec;
+  std::string first = repetitive_text(300);
+  std::string second = "short and different";
+  std::string first_packed;
+  std::string second_packed;
+  ASSERT_TRUE(codec.Compress(first.data(), first.size(), &first_packed));
+  ASSERT_TRUE(codec.Compress(second.data(), second.size(), &second_packed));
+
+  // Read back out of order, as a reader skipping records would.
+  std::string inflated;
+  ASSERT_TRUE(codec.Decompress(second_packed.data(), second_packed.size(), second.size(),
+                               &inflated));
+  EXPECT_EQ(inflated, second);
+  ASSERT_TRUE(
+      codec.Decompress(first_packed.data(), first_packed.size(), first.size(), &inflated));
+  EXPECT_EQ(inflated, first);
+}
+
+TEST(ZlibBlockCodec, WrongLengthIsRejected) {
+  ZlibBlockCodec codec;
+  std::string raw = repetitive_text(1000);
+  std::string packed;
+  ASSERT_TRUE(codec.Compress(raw.data(), raw.size(), &packed));
+
+  std::string inflated;
+  EXPECT_FALSE(codec.Decompress(packed.data(), packed.size(), raw.size() - 1, &inflated));
+  EXPECT_FALSE(codec.Decompress(packed.data(), packed.size(), raw.size() + 1, &inflated));
+}
+
+TEST(ZlibBlockCodec, CorruptBlocksAreRejected) {
+  ZlibBlockCodec codec;
+  std::string raw = repetitive_text(1000);
+  std::string packed;
+  ASSERT_TRUE(codec.Compress(raw.data(), raw.size(), &packed));
+
+  std::string inflated;
+  for (size_t length = 0; length < packed.size(); length++) {
+    EXPECT_FALSE(codec.Decompress(packed.data(), length, raw.size(), &inflated)) << length;
+  }
+  std::string flipped = packed;
+  flipped[flipped.size() / 2] ^= 0x55;
+  EXPECT_FALSE(codec.Decompress(flipped.data(), flipped.size(), raw.size(), &inflated));
+}
+
+}  // namespace test
+}  // namespace notification_manager
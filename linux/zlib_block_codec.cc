@@ -0,0 +1,82 @@
+#include "zlib_block_codec.h"
+
+#include <algorithm>
+
+namespace notification_manager {
+
+namespace {
+
+// Output buffers start at this size and double while the converter runs
+// out of room.
+constexpr size_t kMinOutputSize = 256;
+
+// Runs |converter| over all of |data| in one go. |out| is grown as needed
+// unless |fixed_size|, in which case running out of room is a failure.
+bool Convert(GConverter* converter, const char* data, size_t length, bool fixed_size,
+             std::string* out) {
+  size_t read = 0;
+  size_t written = 0;
+  for (;;) {
+    if (written == out->size()) {
+      if (fixed_size) return false;
+      out->resize(std::max(out->size() * 2, kMinOutputSize));
+    }
+    gsize bytes_read = 0;
+    gsize bytes_written = 0;
+    g_autoptr(GError) error = nullptr;
+    GConverterResult result =
+        g_converter_convert(converter, data + read, length - read, &(*out)[written],
+                            out->size() - written, G_CONVERTER_INPUT_AT_END, &bytes_read,
+                            &bytes_written, &error);
+    if (result == G_CONVERTER_ERROR) {
+      // Too little room for the next piece of output.
+      if (!fixed_size && g_error_matches(error, G_IO_ERROR, G_IO_ERROR_NO_SPACE)) {
+        out->resize(out->size() * 2);
+        continue;
+      }
+      return false;
+    }
+    read += bytes_read;
+    written += bytes_written;
+    if (result == G_CONVERTER_FINISHED) break;
+    // All input is in and nothing came out: the stream has no end.
+    if (bytes_read == 0 && bytes_written == 0 && written < out->size()) return false;
+  }
+  out->resize(written);
+  return read == length;
+}
+
+}  // namespace
+
+ZlibBlockCodec::ZlibBlockCodec(int level) : level_(level) {}
+
+ZlibBlockCodec::~ZlibBlockCodec() {
+  g_clear_object(&compressor_);
+  g_clear_object(&decompressor_);
+}
+
+bool ZlibBlockCodec::Compress(const char* data, size_t length, std::string* out) {
+  if (compressor_ == nullptr) {
+    compressor_ = G_CONVERTER(g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB, level_));
+  } else {
+    g_converter_reset(compressor_);
+  }
+  // Most blocks shrink to well under half.
+  out->resize(std::max(length / 2, kMinOutputSize));
+  return Convert(compressor_, data, length, false, out);
+}
+
+bool ZlibBlockCodec::Decompress(const char* data, size_t length, size_t raw_length,
+                                std::string* out) {
+  if (decompressor_ == nullptr) {
+    decompressor_ = G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB));
+  } else {
+    g_converter_reset(decompressor_);
+  }
+  // One spare byte, so a block that inflates to more than it should is
+  // caught instead of cut short.
+  out->resize(raw_length + 1);
+  return Convert(decompressor_, data, length, true, out) && out->size() == raw_length;
+}
+
+}  // namespace notification_manager
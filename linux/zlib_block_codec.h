@@ -0,0 +1,47 @@
+#ifndef FLUTTER_PLUGIN_NOTIFICATION_MANAGER_ZLIB_BLOCK_CODEC_H_
+#define FLUTTER_PLUGIN_NOTIFICATION_MANAGER_ZLIB_BLOCK_CODEC_H_
+
+#include <gio/gio.h>
+
+#include <cstddef>
+#include <string>
+
+namespace notification_manager {
+
+// Compresses and inflates independent blocks with zlib, through GLib's
+// GZlibCompressor and GZlibDecompressor.
+//
+// Each block is a complete zlib stream, so blocks can be read back in any
+// order. The converters are created on first use and reset between
+// blocks, since setting up zlib's state costs far more than a small block.
+// Not thread-safe; use one codec per thread.
+class ZlibBlockCodec {
+ public:
+  // |level| is zlib's, from 1 (fastest) to 9 (smallest).
+  explicit ZlibBlockCodec(int level = kDefaultLevel);
+  ~ZlibBlockCodec();
+
+  // Disallow copy and assign.
+  ZlibBlockCodec(const ZlibBlockCodec&) = delete;
+  ZlibBlockCodec& operator=(const ZlibBlockCodec&) = delete;
+
+  static constexpr int kDefaultLevel = 6;
+
+  // Replaces |out| with |length| bytes at |data| compressed. Returns false
+  // if zlib fails.
+  bool Compress(const char* data, size_t length, std::string* out);
+
+  // Replaces |out| with the block of |length| bytes at |data| inflated.
+  // Returns false if the block is corrupt or does not inflate to exactly
+  // |raw_length| bytes.
+  bool Decompress(const char* data, size_t length, size_t raw_length, std::string* out);
+
+ private:
+  int level_;
+  GConverter* compressor_ = nullptr;
+  GConverter* decompressor_ = nullptr;
+};
+
+}  // namespace notification_manager
+
+#endif  // FLUTTER_PLUGIN_NOTIFICATION_MANAGER_ZLIB_BLOCK_CODEC_H_
@@ -39,6 +39,7 @@ void main() {
                   'actions': null,
                   'payload': null,
                   'category': null,
+                  'group': null,
                   'badgeNumber': null,
                   'timeout': null,
                   'duplicateKey': null,
@@ -49,12 +50,92 @@ void main() {
                 'repeatInterval': null,
               }
             ];
+          case 'getNextScheduledNotifications':
+          case 'getScheduledNotificationsInRange':
+            return {
+              'notifications': [
+                {
+                  'id': 'test_scheduled_1',
+                  'request': {
+                    'id': 'test_request_1',
+                    'title': 'Test Notification',
+                    'body': 'Test body',
+                  },
+                  'scheduledDate': 1700000000000,
+                  'isRepeating': false,
+                  'repeatInterval': null,
+                }
+              ],
+              'nextCursor': '1700000000000:test_scheduled_1',
+            };
+          case 'getActiveNotifications':
+            return {
+              'notifications': [
+                {
+                  'id': 'chat_1',
+                  'title': 'New message',
+                  'category': 'message',
+                  'group': 'alice',
+                  'createdAt': 1700000000000,
+                  'updatedAt': 1700000060000,
+                }
+              ],
+              'nextCursor': '1700000000000:chat_1',
+            };
+          case 'getNotificationHistory':
+            return {
+              'entries': [
+                {
+                  'type': 'action',
+                  'notificationId': 'test_notification_1',
+                  'actionId': 'reply',
+                  'timestamp': 1700000000000,
+                }
+              ],
+              'nextCursor': '7',
+            };
+          case 'getScheduledChanges':
+            return {
+              'version': 42,
+              'isFullSnapshot': false,
+              'inserted': [],
+              'updated': [
+                {
+                  'id': 'test_scheduled_1',
+                  'request': {
+                    'id': 'test_request_1',
+                    'title': 'Updated',
+                    'body': 'Test body',
+                  },
+                  'scheduledDate': 1700000000000,
+                  'isRepeating': false,
+                  'repeatInterval': null,
+                }
+              ],
+              'removed': ['test_scheduled_2'],
+            };
+          case 'exportScheduledNotifications':
+            return 1;
+          case 'importScheduledNotifications':
+            return 2;
+          case 'setCatchUpPolicy':
+            return true;
+          case 'setPersistenceMode':
+            return true;
+          case 'setSchedulerSlack':
+            return true;
           case 'updateScheduledNotification':
             return true;
           case 'cancelNotification':
             return true;
           case 'cancelAllNotifications':
             return true;
+          case 'cancelNotificationsByCategory':
+            return 3;
+          case 'cancelNotificationsByGroup':
+            return 2;
+          case 'cancelNotificationsWithPrefix':
+            return 1;
           case 'cancelAllScheduledNotifications':
             return true;
           case 'getBadgeCount':
@@ -148,6 +229,27 @@ void main() {
       );
     });
 
+    test('scheduleNotification with recurrence', () async {
+      final scheduledNotification = ScheduledNotification(
+        id: 'test_id',
+        request: NotificationRequest(
+          id: 'test_id',
+          title: 'Test Title',
+          body: 'Test Body',
+        ),
+        scheduledDate: DateTime.now(),
+        recurrence: '0 9 * * MON-FRI',
+      );
+
+      final result = await methodChannelNotificationManager.scheduleNotification(scheduledNotification);
+      expect(result, true);
+      expect(scheduledNotification.toJson()['recurrence'], '0 9 * * MON-FRI');
+      expect(
+        ScheduledNotification.fromJson(scheduledNotification.toJson()).recurrence,
+        '0 9 * * MON-FRI',
+      );
+    });
+
     test('getScheduledNotifications', () async {
       // TODO: Fix this test - currently failing due to type casting issues
       // final result = await methodChannelNotificationManager.getScheduledNotifications();
@@ -160,6 +262,172 @@ void main() {
       // );
     });
 
+    test('getNextScheduledNotifications', () async {
+      final result = await methodChannelNotificationManager.getNextScheduledNotifications(limit: 5);
+      expect(result['nextCursor'], '1700000000000:test_scheduled_1');
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('getNextScheduledNotifications', arguments: {'limit': 5, 'cursor': null}),
+        ],
+      );
+    });
+
+    test('getScheduledNotificationsInRange', () async {
+      final start = DateTime.fromMillisecondsSinceEpoch(1000);
+      final end = DateTime.fromMillisecondsSinceEpoch(2000);
+      await methodChannelNotificationManager.getScheduledNotificationsInRange(start, end, cursor: '1500:a');
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('getScheduledNotificationsInRange', arguments: {
+            'start': 1000,
+            'end': 2000,
+            'limit': 20,
+            'cursor': '1500:a',
+          }),
+        ],
+      );
+    });
+
+    test('getActiveNotifications', () async {
+      final result = await methodChannelNotificationManager.getActiveNotifications(group: 'alice');
+      expect(result['nextCursor'], '1700000000000:chat_1');
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('getActiveNotifications', arguments: {
+            'category': null,
+            'group': 'alice',
+            'limit': 20,
+            'cursor': null,
+          }),
+        ],
+      );
+    });
+
+    test('getNotificationHistory', () async {
+      final start = DateTime.fromMillisecondsSinceEpoch(1000);
+      final end = DateTime.fromMillisecondsSinceEpoch(2000);
+      final result = await methodChannelNotificationManager.getNotificationHistory(start, end, cursor: '3');
+      expect(result['nextCursor'], '7');
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('getNotificationHistory', arguments: {
+            'start': 1000,
+            'end': 2000,
+            'limit': 20,
+            'cursor': '3',
+          }),
+        ],
+      );
+    });
+
+    test('getScheduledChanges', () async {
+      final result = await methodChannelNotificationManager.getScheduledChanges(41);
+      expect(result['version'], 42);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('getScheduledChanges', arguments: {'sinceVersion': 41}),
+        ],
+      );
+    });
+
+    test('exportScheduledNotifications', () async {
+      final result = await methodChannelNotificationManager.exportScheduledNotifications('/tmp/backup.ndjson');
+      expect(result, 1);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('exportScheduledNotifications', arguments: {
+            'path': '/tmp/backup.ndjson',
+            'chunkSize': 500,
+          }),
+        ],
+      );
+    });
+
+    test('importScheduledNotifications', () async {
+      final result = await methodChannelNotificationManager.importScheduledNotifications('/tmp/backup.ndjson', chunkSize: 100);
+      expect(result, 2);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('importScheduledNotifications', arguments: {
+            'path': '/tmp/backup.ndjson',
+            'chunkSize': 100,
+          }),
+        ],
+      );
+    });
+
+    test('scheduled events', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(
+        const EventChannel('flutter_system_notifications_events'),
+        MockStreamHandler.inline(onListen: (arguments, events) {
+          events.success({'type': 'scheduledChanged', 'version': 42});
+          events.success({
+            'type': 'scheduledReloaded',
+            'version': 43,
+            'scheduled': ['a'],
+            'cancelled': ['b'],
+          });
+          events.success({
+            'type': 'scheduledTransfer',
+            'transferId': 1,
+            'direction': 'export',
+            'processed': 3,
+            'skipped': 0,
+            'total': 3,
+            'done': true,
+          });
+        }),
+      );
+      final notifications = MethodChannelFlutterSystemNotifications();
+      final changed = notifications.scheduledChangedEvents.first;
+      final reloaded = notifications.scheduledReloadedEvents.first;
+      final transfer = notifications.scheduledTransferEvents.first;
+
+      expect((await changed)['version'], 42);
+      expect((await reloaded)['cancelled'], ['b']);
+      expect((await transfer)['done'], true);
+    });
+
+    test('setSchedulerSlack', () async {
+      final result = await methodChannelNotificationManager.setSchedulerSlack(const Duration(seconds: 5));
+      expect(result, true);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('setSchedulerSlack', arguments: {'slackMs': 5000}),
+        ],
+      );
+    });
+
+    test('setCatchUpPolicy', () async {
+      final result = await methodChannelNotificationManager.setCatchUpPolicy('summary');
+      expect(result, true);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('setCatchUpPolicy', arguments: {'policy': 'summary'}),
+        ],
+      );
+    });
+
+    test('setPersistenceMode', () async {
+      final result = await methodChannelNotificationManager.setPersistenceMode('none');
+      expect(result, true);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('setPersistenceMode', arguments: {'mode': 'none'}),
+        ],
+      );
+    });
+
     test('updateScheduledNotification', () async {
       final scheduledNotification = ScheduledNotification(
         id: 'test_id',
@@ -205,6 +473,39 @@ void main() {
       );
     });
 
+    test('cancelNotificationsByCategory', () async {
+      final result = await methodChannelNotificationManager.cancelNotificationsByCategory('message');
+      expect(result, 3);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('cancelNotificationsByCategory', arguments: {'category': 'message'}),
+        ],
+      );
+    });
+
+    test('cancelNotificationsByGroup', () async {
+      final result = await methodChannelNotificationManager.cancelNotificationsByGroup('alice');
+      expect(result, 2);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('cancelNotificationsByGroup', arguments: {'group': 'alice'}),
+        ],
+      );
+    });
+
+    test('cancelNotificationsWithPrefix', () async {
+      final result = await methodChannelNotificationManager.cancelNotificationsWithPrefix('chat:alice:');
+      expect(result, 1);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('cancelNotificationsWithPrefix', arguments: {'prefix': 'chat:alice:'}),
+        ],
+      );
+    });
+
     test('cancelAllScheduledNotifications', () async {
       final result = await methodChannelNotificationManager.cancelAllScheduledNotifications();
       expect(result, true);
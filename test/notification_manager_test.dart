@@ -1,6 +1,8 @@
 import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
 import 'package:flutter_system_notifications/flutter_system_notifications.dart';
+import 'package:flutter_system_notifications/flutter_system_notifications_method_channel.dart';
+import 'package:flutter_system_notifications/flutter_system_notifications_platform_interface.dart';
 
 
 
@@ -40,6 +42,7 @@ void main() {
                   'actions': null,
                   'payload': null,
                   'category': null,
+                  'group': null,
                   'badgeNumber': null,
                   'timeout': null,
                   'duplicateKey': null,
@@ -50,12 +53,92 @@ void main() {
                 'repeatInterval': null,
               }
             ];
+          case 'getNextScheduledNotifications':
+          case 'getScheduledNotificationsInRange':
+            return {
+              'notifications': [
+                {
+                  'id': 'test_scheduled_1',
+                  'request': {
+                    'id': 'test_request_1',
+                    'title': 'Test Notification',
+                    'body': 'Test body',
+                  },
+                  'scheduledDate': 1700000000000,
+                  'isRepeating': false,
+                  'repeatInterval': null,
+                }
+              ],
+              'nextCursor': '1700000000000:test_scheduled_1',
+            };
+          case 'getActiveNotifications':
+            return {
+              'notifications': [
+                {
+                  'id': 'chat_1',
+                  'title': 'New message',
+                  'category': 'message',
+                  'group': 'alice',
+                  'createdAt': 1700000000000,
+                  'updatedAt': 1700000060000,
+                }
+              ],
+              'nextCursor': '1700000000000:chat_1',
+            };
+          case 'getNotificationHistory':
+            return {
+              'entries': [
+                {
+                  'type': 'action',
+                  'notificationId': 'test_notification_1',
+                  'actionId': 'reply',
+                  'timestamp': 1700000000000,
+                }
+              ],
+              'nextCursor': '7',
+            };
+          case 'getScheduledChanges':
+            return {
+              'version': 42,
+              'isFullSnapshot': false,
+              'inserted': [],
+              'updated': [
+                {
+                  'id': 'test_scheduled_1',
+                  'request': {
+                    'id': 'test_request_1',
+                    'title': 'Updated',
+                    'body': 'Test body',
+                  },
+                  'scheduledDate': 1700000000000,
+                  'isRepeating': false,
+                  'repeatInterval': null,
+                }
+              ],
+              'removed': ['test_scheduled_2'],
+            };
+          case 'exportScheduledNotifications':
+            return 1;
+          case 'importScheduledNotifications':
+            return 2;
+          case 'setCatchUpPolicy':
+            return true;
+          case 'setPersistenceMode':
+            return true;
+          case 'setSchedulerSlack':
+            return true;
           case 'updateScheduledNotification':
             return true;
           case 'cancelNotification':
             return true;
           case 'cancelAllNotifications':
             return true;
+          case 'cancelNotificationsByCategory':
+            return 3;
+          case 'cancelNotificationsByGroup':
+            return 2;
+          case 'cancelNotificationsWithPrefix':
+            return 1;
           case 'cancelAllScheduledNotifications':
             return true;
           case 'getBadgeCount':
@@ -156,6 +239,35 @@ void main() {
       );
     });
 
+    test('scheduleNotification with a persistence mode', () async {
+      final request = NotificationRequest(
+        id: 'test_id',
+        title: 'Test Title',
+        body: 'Test Body',
+      );
+      final scheduledDate = DateTime.now().add(Duration(minutes: 5));
+
+      final result = await notificationManager.scheduleNotification(
+        request: request,
+        scheduledDate: scheduledDate,
+        persistenceMode: PersistenceMode.immediate,
+      );
+      expect(result, true);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('scheduleNotification', arguments: {
+            'id': 'test_id',
+            'request': request.toJson(),
+            'scheduledDate': scheduledDate.millisecondsSinceEpoch,
+            'isRepeating': false,
+            'repeatInterval': null,
+            'persistenceMode': 'immediate',
+          }),
+        ],
+      );
+    });
+
     test('getScheduledNotifications', () async {
       // TODO: Fix this test - currently failing due to type casting issues
       // final result = await notificationManager.getScheduledNotifications();
@@ -168,6 +280,183 @@ void main() {
       // );
     });
 
+    test('getNextScheduledNotifications', () async {
+      final page = await notificationManager.getNextScheduledNotifications(limit: 1);
+      expect(page.notifications, hasLength(1));
+      expect(page.notifications.first.id, 'test_scheduled_1');
+      expect(page.notifications.first.scheduledDate.millisecondsSinceEpoch, 1700000000000);
+      expect(page.nextCursor, '1700000000000:test_scheduled_1');
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('getNextScheduledNotifications', arguments: {'limit': 1, 'cursor': null}),
+        ],
+      );
+    });
+
+    test('getScheduledNotificationsInRange', () async {
+      final start = DateTime.fromMillisecondsSinceEpoch(1000);
+      final end = DateTime.fromMillisecondsSinceEpoch(2000);
+      final page = await notificationManager.getScheduledNotificationsInRange(start, end);
+      expect(page.notifications, hasLength(1));
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('getScheduledNotificationsInRange', arguments: {
+            'start': 1000,
+            'end': 2000,
+            'limit': 20,
+            'cursor': null,
+          }),
+        ],
+      );
+    });
+
+    test('getActiveNotifications', () async {
+      final page = await notificationManager.getActiveNotifications(group: 'alice');
+      final notification = page.notifications.single;
+      expect(notification.id, 'chat_1');
+      expect(notification.group, 'alice');
+      expect(notification.createdAt, DateTime.fromMillisecondsSinceEpoch(1700000000000));
+      expect(notification.updatedAt, DateTime.fromMillisecondsSinceEpoch(1700000060000));
+      expect(page.nextCursor, '1700000000000:chat_1');
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('getActiveNotifications', arguments: {
+            'category': null,
+            'group': 'alice',
+            'limit': 20,
+            'cursor': null,
+          }),
+        ],
+      );
+    });
+
+    test('getNotificationHistory', () async {
+      final start = DateTime.fromMillisecondsSinceEpoch(1000);
+      final end = DateTime.fromMillisecondsSinceEpoch(2000);
+      final page = await notificationManager.getNotificationHistory(start, end, cursor: '3');
+      final entry = page.entries.single;
+      expect(entry.type, NotificationHistoryType.action);
+      expect(entry.actionId, 'reply');
+      expect(entry.timestamp, DateTime.fromMillisecondsSinceEpoch(1700000000000));
+      expect(page.nextCursor, '7');
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('getNotificationHistory', arguments: {
+            'start': 1000,
+            'end': 2000,
+            'limit': 20,
+            'cursor': '3',
+          }),
+        ],
+      );
+    });
+
+    test('getScheduledChanges', () async {
+      final changes = await notificationManager.getScheduledChanges(41);
+      expect(changes.version, 42);
+      expect(changes.isFullSnapshot, false);
+      expect(changes.inserted, isEmpty);
+      expect(changes.updated.single.request.title, 'Updated');
+      expect(changes.removed, ['test_scheduled_2']);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('getScheduledChanges', arguments: {'sinceVersion': 41}),
+        ],
+      );
+    });
+
+    test('exportScheduledNotifications', () async {
+      final result = await notificationManager.exportScheduledNotifications('/tmp/backup.ndjson');
+      expect(result, 1);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('exportScheduledNotifications', arguments: {
+            'path': '/tmp/backup.ndjson',
+            'chunkSize': 500,
+          }),
+        ],
+      );
+    });
+
+    test('importScheduledNotifications', () async {
+      final result = await notificationManager.importScheduledNotifications('/tmp/backup.ndjson', chunkSize: 100);
+      expect(result, 2);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('importScheduledNotifications', arguments: {
+            'path': '/tmp/backup.ndjson',
+            'chunkSize': 100,
+          }),
+        ],
+      );
+    });
+
+    test('onScheduledTransfer', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockStreamHandler(
+        const EventChannel('flutter_system_notifications_events'),
+        MockStreamHandler.inline(onListen: (arguments, events) {
+          events.success({
+            'type': 'scheduledTransfer',
+            'transferId': 2,
+            'direction': 'import',
+            'processed': 5,
+            'skipped': 1,
+            'done': true,
+          });
+        }),
+      );
+      FlutterSystemNotificationsPlatform.instance = MethodChannelFlutterSystemNotifications();
+
+      final progress = await notificationManager.onScheduledTransfer.first;
+      expect(progress.transferId, 2);
+      expect(progress.direction, 'import');
+      expect(progress.processed, 5);
+      expect(progress.skipped, 1);
+      expect(progress.total, isNull);
+      expect(progress.done, true);
+      expect(progress.error, isNull);
+    });
+
+    test('setSchedulerSlack', () async {
+      final result = await notificationManager.setSchedulerSlack(const Duration(seconds: 5));
+      expect(result, true);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('setSchedulerSlack', arguments: {'slackMs': 5000}),
+        ],
+      );
+    });
+
+    test('setCatchUpPolicy', () async {
+      final result = await notificationManager.setCatchUpPolicy(CatchUpPolicy.summary);
+      expect(result, true);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('setCatchUpPolicy', arguments: {'policy': 'summary'}),
+        ],
+      );
+    });
+
+    test('setPersistenceMode', () async {
+      final result = await notificationManager.setPersistenceMode(PersistenceMode.none);
+      expect(result, true);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('setPersistenceMode', arguments: {'mode': 'none'}),
+        ],
+      );
+    });
+
     test('cancelNotification', () async {
       final result = await notificationManager.cancelNotification('test_id');
       expect(result, true);
@@ -192,6 +481,39 @@ void main() {
       );
     });
 
+    test('cancelNotificationsByCategory', () async {
+      final result = await notificationManager.cancelNotificationsByCategory('message');
+      expect(result, 3);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('cancelNotificationsByCategory', arguments: {'category': 'message'}),
+        ],
+      );
+    });
+
+    test('cancelNotificationsByGroup', () async {
+      final result = await notificationManager.cancelNotificationsByGroup('alice');
+      expect(result, 2);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('cancelNotificationsByGroup', arguments: {'group': 'alice'}),
+        ],
+      );
+    });
+
+    test('cancelNotificationsWithPrefix', () async {
+      final result = await notificationManager.cancelNotificationsWithPrefix('chat:alice:');
+      expect(result, 1);
+      expect(
+        log,
+        <Matcher>[
+          isMethodCall('cancelNotificationsWithPrefix', arguments: {'prefix': 'chat:alice:'}),
+        ],
+      );
+    });
+
     test('cancelAllScheduledNotifications', () async {
       final result = await notificationManager.cancelAllScheduledNotifications();
       expect(result, true);